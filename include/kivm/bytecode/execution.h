@@ -53,6 +53,12 @@ namespace kivm {
 
         static void loadIntArrayElement(Stack &stack);
 
+        static void loadShortArrayElement(Stack &stack);
+
+        static void loadCharArrayElement(Stack &stack);
+
+        static void loadByteArrayElement(Stack &stack);
+
         static void loadFloatArrayElement(Stack &stack);
 
         static void loadDoubleArrayElement(Stack &stack);
@@ -63,6 +69,12 @@ namespace kivm {
 
         static void storeIntArrayElement(Stack &stack);
 
+        static void storeShortArrayElement(Stack &stack);
+
+        static void storeCharArrayElement(Stack &stack);
+
+        static void storeByteArrayElement(Stack &stack);
+
         static void storeFloatArrayElement(Stack &stack);
 
         static void storeDoubleArrayElement(Stack &stack);
@@ -81,13 +93,16 @@ namespace kivm {
 
         static bool instanceOf(Klass *ref, Klass *klass);
 
-        static instanceOop newInstance(JavaThread *thread, RuntimeConstantPool *rt, int constantIndex);
+        static instanceOop newInstance(JavaThread *thread, RuntimeConstantPool *rt, int constantIndex,
+                                       AllocationSite *site = nullptr);
 
         static typeArrayOop newPrimitiveArray(JavaThread *thread,
-                                              int arrayType, int length);
+                                              int arrayType, int length,
+                                              AllocationSite *site = nullptr);
 
         static objectArrayOop newObjectArray(JavaThread *thread, RuntimeConstantPool *rt,
-                                             int constantIndex, int length);
+                                             int constantIndex, int length,
+                                             AllocationSite *site = nullptr);
 
         static arrayOop newMultiObjectArray(JavaThread *thread, RuntimeConstantPool *rt,
                                             int constantIndex, int dimension, const std::deque<int> &length);
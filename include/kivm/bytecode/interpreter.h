@@ -9,6 +9,14 @@
 
 namespace kivm {
     class ByteCodeInterpreter {
+    private:
+        /**
+         * Perform a requested collection and stop at a pending safepoint.
+         * Called at method entry and backward branches, before the instruction at pc,
+         * where no references are held in places invisible to the collector.
+         */
+        static void pollAtInstructionStart(JavaThread *thread);
+
     public:
         static oop interp(JavaThread *thread);
     };
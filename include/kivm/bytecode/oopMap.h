@@ -0,0 +1,166 @@
+//
+// Created by kiva on 2018/4/21.
+//
+#pragma once
+
+#include <kivm/kivm.h>
+#include <shared/concurrentTable.h>
+#include <vector>
+
+namespace kivm {
+    class Method;
+
+    /**
+     * Which slots of a frame hold references at a safepoint pc.
+     */
+    class OopMap {
+        friend class OopMapBuilder;
+
+        friend class OopMapStore;
+
+    private:
+        u4 _startPc;
+        u4 _endPc;
+        int _maxLocals;
+        int _stackDepth;
+
+        // locals first, then operand stack
+        std::vector<bool> _references;
+
+    public:
+        u4 getStartPc() const {
+            return _startPc;
+        }
+
+        u4 getEndPc() const {
+            return _endPc;
+        }
+
+        /**
+         * @return {@code true} if pc is inside the instruction this map describes
+         */
+        bool covers(u4 pc) const {
+            return pc >= _startPc && pc < _endPc;
+        }
+
+        /**
+         * @return operand stack depth before the instruction executes
+         */
+        int getStackDepth() const {
+            return _stackDepth;
+        }
+
+        bool isLocalReference(int index) const {
+            return _references[index];
+        }
+
+        bool isStackReference(int index) const {
+            return _references[_maxLocals + index];
+        }
+    };
+
+    /**
+     * Reference maps of all safepoint pcs in a method.
+     * Safepoint pcs are method entry, backward branch targets,
+     * and instructions that may call into Java or allocate.
+     */
+    class MethodOopMaps {
+        friend class OopMapBuilder;
+
+        friend class OopMapStore;
+
+    private:
+        // false when the analysis gave up (for example jsr/ret),
+        // frames of such methods must be scanned conservatively.
+        bool _precise;
+
+        // sorted by pc
+        std::vector<OopMap> _maps;
+
+    public:
+        /**
+         * Version of the analysis computing the maps, kept with stored maps.
+         * Bump it with every change to what {@code OopMapBuilder} computes,
+         * so that maps stored by an older analysis are never read.
+         */
+        static const u4 ANALYSIS_VERSION = 1;
+
+        bool isPrecise() const {
+            return _precise;
+        }
+
+        /**
+         * Find the map of the instruction containing pc.
+         * @param pc current pc or return pc of the frame
+         * @return the map, or {@code nullptr} if pc is not a safepoint
+         */
+        const OopMap *find(u4 pc) const;
+
+        /**
+         * Find the map of the instruction ending at pc.
+         * Handlers consume the operands of an instruction before they call
+         * into Java or allocate, so a frame stopped inside an instruction
+         * has its pc at the next one, the return pc of a call included.
+         * @param pc end of the instruction
+         * @return the map, or {@code nullptr} if the instruction is not a safepoint
+         */
+        const OopMap *findEndingAt(u4 pc) const;
+    };
+
+    class OopMapStore;
+
+    /**
+     * Reference maps of all methods run so far.
+     * Maps are prepared when a method is first invoked, outside any safepoint,
+     * so that the collector only looks them up, without locking.
+     */
+    class OopMapCache {
+    private:
+        static const size_t INITIAL_CAPACITY = 1024;
+
+        struct Entry {
+            size_t hash;
+            Method *method;
+            MethodOopMaps *maps;
+
+            inline size_t getHash() const {
+                return hash;
+            }
+        };
+
+        ConcurrentTable<Entry> _entries;
+        OopMapStore *_store;
+
+    public:
+        /**
+         * @return the cache of the VM, backed by {@code OopMapStore::get()}
+         */
+        static OopMapCache *get();
+
+        /**
+         * @param store where maps of earlier runs are read from and new maps written to,
+         *        {@code nullptr} to compute them in memory only
+         */
+        explicit OopMapCache(OopMapStore *store = nullptr);
+
+        OopMapCache(const OopMapCache &) = delete;
+
+        ~OopMapCache();
+
+        /**
+         * Get reference maps of a method, read them from the store
+         * or compute them when missing. Takes no lock while doing so,
+         * callers must not hold up a safepoint meanwhile.
+         * @param method Java method with code
+         * @return reference maps
+         */
+        const MethodOopMaps *prepare(Method *method);
+
+        /**
+         * Find the reference maps of a method, without locking.
+         * @param method Java method with code
+         * @return reference maps, or {@code nullptr} if they are not prepared yet
+         */
+        const MethodOopMaps *lookup(Method *method) const;
+    };
+}
@@ -0,0 +1,124 @@
+//
+// Created by kiva on 2018/4/25.
+//
+#pragma once
+
+#include <kivm/kivm.h>
+#include <kivm/bytecode/oopMap.h>
+#include <shared/lock.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace kivm {
+    class InstanceKlass;
+
+    class Method;
+
+    /**
+     * Reference maps of methods kept on disk across runs,
+     * so that a restarted VM does not analyse unchanged code again.
+     *
+     * There is one file per method, named after a hash of the class file bytes
+     * and the analysis version, and the index of the method in the class file.
+     * The file repeats both and is ignored when either differs, or when
+     * its maps do not fit the code. Files are written to a temporary name
+     * and renamed, so that VMs sharing a directory never read half a file.
+     */
+    class OopMapStore {
+    private:
+        struct Header {
+            char magic[8];
+            u4 version;
+            u4 methodIndex;
+            u8 contentHash;
+            u4 contentLength;
+            u4 codeLength;
+            u4 analysisVersion;
+            u4 precise;
+            u4 mapCount;
+        };
+
+        // followed by (maxLocals + stackDepth) reference bits, padded to a byte
+        struct MapRecord {
+            u4 startPc;
+            u4 endPc;
+            u4 maxLocals;
+            u4 stackDepth;
+        };
+
+        static const char MAGIC[8];
+        static const u4 VERSION = 2;
+
+        std::string _directory;
+        u4 _analysisVersion;
+        bool _directoryCreated;
+
+        std::unordered_map<InstanceKlass *, u8> _contentHashes;
+        Lock _lock;
+
+        int _loadCount;
+        int _storeCount;
+        int _rejectCount;
+
+        /**
+         * @return the file of the method, empty if the method cannot be stored
+         */
+        std::string getPath(Method *method, u8 *contentHash, u4 *methodIndex);
+
+        bool readMaps(const std::vector<u1> &bytes, Method *method,
+                      u8 contentHash, u4 methodIndex, MethodOopMaps *maps);
+
+    public:
+        /**
+         * @return the store of {@code RuntimeConfig::oopMapCacheDirectory},
+         *         or {@code nullptr} if there is none
+         */
+        static OopMapStore *get();
+
+        /**
+         * @param analysisVersion files of other analysis versions are never read
+         */
+        explicit OopMapStore(const std::string &directory,
+                             u4 analysisVersion = MethodOopMaps::ANALYSIS_VERSION);
+
+        OopMapStore(const OopMapStore &) = delete;
+
+        inline const std::string &getDirectory() const {
+            return _directory;
+        }
+
+        /**
+         * @return files read and used
+         */
+        inline int getLoadCount() const {
+            return _loadCount;
+        }
+
+        /**
+         * @return files written
+         */
+        inline int getStoreCount() const {
+            return _storeCount;
+        }
+
+        /**
+         * @return files found but not used, because they are stale or corrupt
+         */
+        inline int getRejectCount() const {
+            return _rejectCount;
+        }
+
+        /**
+         * Read the reference maps of a method.
+         * @return the maps, or {@code nullptr} if there is no usable file
+         */
+        MethodOopMaps *load(Method *method);
+
+        /**
+         * Write the reference maps of a method, replacing any earlier file.
+         * @return {@code false} if they cannot be written
+         */
+        bool store(Method *method, const MethodOopMaps *maps);
+    };
+}
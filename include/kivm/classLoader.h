@@ -6,6 +6,9 @@
 
 #include <kivm/kivm.h>
 #include <kivm/system.h>
+#include <condition_variable>
+#include <thread>
+#include <unordered_map>
 
 namespace kivm {
     class Klass;
@@ -30,7 +33,37 @@ namespace kivm {
         Klass *loadClass(const String &className) override;
     };
 
+    /**
+     * Loads classes of the class path.
+     * Loaded classes are looked up without locking.
+     * A class being loaded has a placeholder naming its loading thread:
+     * different classes load in parallel, threads racing to load
+     * the same class wait for the one which got there first.
+     *
+     * Linking loads the types of fields and exceptions, which may refer back
+     * to the class being linked. Such references get the class still being linked,
+     * from its own thread, or from a thread which the linking thread waits for.
+     * Array classes have no placeholder, racing threads create them
+     * and the first one in the dictionary wins.
+     */
     class BootstrapClassLoader : public BaseClassLoader {
+    private:
+        struct Placeholder {
+            std::thread::id owner;
+            // set once parsed, while linking
+            Klass *klass;
+        };
+
+        Lock _placeholderLock;
+        std::condition_variable _placeholderRemoved;
+        std::unordered_map<String, Placeholder> _placeholders;
+        // thread -> name of the class it waits for
+        std::unordered_map<std::thread::id, String> _waiting;
+
+        bool isWaitingFor(std::thread::id owner, std::thread::id current);
+
+        Klass *loadArrayClass(const String &className);
+
     public:
         static BootstrapClassLoader *get();
 
@@ -89,6 +89,7 @@ namespace kivm {
         u2 max_locals;
 
         u4 code_length;
+        // points into the mapped class file
         u1 *code;
 
         u2 exception_table_length;
@@ -99,8 +100,6 @@ namespace kivm {
 
         Code_attribute();
 
-        ~Code_attribute() override;
-
         void init(ClassFileStream &stream, cp_info **constant_pool);
     };
 
@@ -160,8 +159,6 @@ namespace kivm {
          */
         struct same_locals_1_stack_item_frame : public stack_map_frame {
             verification_type_info *stack[1];
-
-            ~same_locals_1_stack_item_frame() override;
         };
 
         /**
@@ -170,8 +167,6 @@ namespace kivm {
         struct same_locals_1_stack_item_frame_extended : public stack_map_frame {
             u2 offset_delta;
             verification_type_info *stack[1];
-
-            ~same_locals_1_stack_item_frame_extended() override;
         };
 
         /**
@@ -200,8 +195,6 @@ namespace kivm {
             verification_type_info **locals;
 
             append_frame();
-
-            ~append_frame() override;
         };
 
         /**
@@ -215,8 +208,6 @@ namespace kivm {
             verification_type_info **stack;
 
             full_frame();
-
-            ~full_frame() override;
         };
 
         u2 number_of_entries;
@@ -224,8 +215,6 @@ namespace kivm {
         stack_map_frame **entries;
 
         StackMapTable_attribute();
-
-        ~StackMapTable_attribute() override;
     };
 
     struct Exceptions_attribute : public attribute_info {
@@ -237,8 +226,6 @@ namespace kivm {
         u2 *exception_index_table;
 
         Exceptions_attribute();
-
-        ~Exceptions_attribute() override;
     };
 
     struct classes_t {
@@ -254,8 +241,6 @@ namespace kivm {
         classes_t *classes;
 
         InnerClasses_attribute();
-
-        ~InnerClasses_attribute() override;
     };
 
     struct EnclosingMethod_attribute : public attribute_info {
@@ -276,13 +261,11 @@ namespace kivm {
 
     struct SourceDebugExtension_attribute : public attribute_info {
         /**
-         * Length: attribute_length
+         * Length: attribute_length, points into the mapped class file
          */
         u1 *debug_extension;
 
         SourceDebugExtension_attribute();
-
-        ~SourceDebugExtension_attribute() override;
     };
 
     struct line_number_table_t {
@@ -296,8 +279,6 @@ namespace kivm {
         line_number_table_t *line_number_table;
 
         LineNumberTable_attribute();
-
-        ~LineNumberTable_attribute() override;
     };
 
     struct local_variable_table_t {
@@ -314,8 +295,6 @@ namespace kivm {
         local_variable_table_t *local_variable_table;
 
         LocalVariableTable_attribute();
-
-        ~LocalVariableTable_attribute() override;
     };
 
     struct local_variable_type_table_t {
@@ -332,8 +311,6 @@ namespace kivm {
         local_variable_type_table_t *local_variable_type_table;
 
         LocalVariableTypeTable_attribute();
-
-        ~LocalVariableTypeTable_attribute() override;
     };
 
     struct Deprecated_attribute : public attribute_info {
@@ -345,8 +322,6 @@ namespace kivm {
         u2 *bootstrap_arguments;
 
         bootstrap_methods_t();
-
-        ~bootstrap_methods_t();
     };
 
     struct BootstrapMethods_attribute : public attribute_info {
@@ -355,8 +330,6 @@ namespace kivm {
         bootstrap_methods_t *bootstrap_methods;
 
         BootstrapMethods_attribute();
-
-        ~BootstrapMethods_attribute() override;
     };
 
     struct parameters_t {
@@ -370,8 +343,6 @@ namespace kivm {
         parameters_t *parameters;
 
         MethodParameters_attribute();
-
-        ~MethodParameters_attribute() override;
     };
 
 
@@ -395,8 +366,6 @@ namespace kivm {
     struct element_value {
         u1 tag;
         value_t *value = nullptr;
-
-        ~element_value();
     };
 
     struct element_value_pairs_t {
@@ -408,15 +377,11 @@ namespace kivm {
         u2 type_index;
         u2 num_element_value_pairs;
         element_value_pairs_t *element_value_pairs = nullptr;
-
-        ~annotation() override;
     };
 
     struct array_value_t : public value_t {
         u2 num_values;
         element_value *values = nullptr;
-
-        ~array_value_t() override;
     };
 
     struct type_annotation {
@@ -458,8 +423,6 @@ namespace kivm {
         struct localvar_target : target_info_t {
             u2 table_length;
             table_t *table = nullptr;
-
-            ~localvar_target() override;
         };
 
         struct catch_target : target_info_t {
@@ -484,8 +447,6 @@ namespace kivm {
         struct type_path {
             u1 path_length;
             path_t *path = nullptr;
-
-            ~type_path();
         };
 
         // basic
@@ -493,15 +454,11 @@ namespace kivm {
         target_info_t *target_info = nullptr;
         type_path target_path;
         annotation *annotations = nullptr;
-
-        ~type_annotation();
     };
 
     struct parameter_annotations_t {
         u2 num_annotations;
         annotation *annotations = nullptr;
-
-        ~parameter_annotations_t();
     };
 
     struct RuntimeVisibleAnnotations_attribute : public attribute_info {
@@ -515,29 +472,21 @@ namespace kivm {
     struct RuntimeVisibleParameterAnnotations_attribute : public attribute_info {
         u1 num_parameters;
         parameter_annotations_t *parameter_annotations = nullptr;
-
-        ~RuntimeVisibleParameterAnnotations_attribute() override;
     };
 
     struct RuntimeInvisibleParameterAnnotations_attribute : public attribute_info {
         u1 num_parameters;
         parameter_annotations_t *parameter_annotations = nullptr;
-
-        ~RuntimeInvisibleParameterAnnotations_attribute() override;
     };
 
     struct RuntimeVisibleTypeAnnotations_attribute : public attribute_info {
         u2 num_annotations;
         type_annotation *annotations = nullptr;
-
-        ~RuntimeVisibleTypeAnnotations_attribute() override;
     };
 
     struct RuntimeInvisibleTypeAnnotations_attribute : public attribute_info {
         u2 num_annotations;
         type_annotation *annotations = nullptr;
-
-        ~RuntimeInvisibleTypeAnnotations_attribute() override;
     };
 
     struct AnnotationDefault_attribute : public attribute_info {
@@ -549,8 +498,6 @@ namespace kivm {
         static void readAttributes(attribute_info ***p, u2 count,
                                    ClassFileStream &stream, cp_info **constant_pool);
 
-        static void deallocAttributes(attribute_info ***p, u2 count);
-
         static u2 toAttributeTag(u2 attribute_name_index, cp_info **constant_pool);
 
         static attribute_info *parseAttribute(ClassFileStream &stream, cp_info **constant_pool);
@@ -0,0 +1,124 @@
+//
+// Created by kiva on 2018/4/25.
+//
+#pragma once
+
+#include <kivm/kivm.h>
+#include <kivm/classfile/classFile.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace kivm {
+    class ClassPath;
+
+    /**
+     * Class data sharing: the class files of a class list,
+     * located and validated once by a dump run and written into one archive.
+     * Later runs map the archive and parse its classes in place,
+     * without searching the class path or opening, mapping
+     * or inflating a file per class.
+     *
+     * Only the class file bytes are shared, not parsed metadata:
+     * classes are still parsed, linked and initialized on every run.
+     *
+     * The archive only holds offsets, so it maps anywhere.
+     * It records the class path it was dumped with and is ignored
+     * when the class path differs. It also records the size and modification
+     * time of the file each class came from, a class file or an archive,
+     * and a class whose file changed is loaded from the class path instead.
+     */
+    class ClassDataArchive {
+    private:
+        struct Header {
+            char magic[8];
+            u4 version;
+            u4 classCount;
+            u4 classPathLength;
+            u4 reserved;
+        };
+
+        // followed by the name, the source file and the class file, each 8-byte aligned
+        struct ClassRecord {
+            u4 nameLength;
+            u4 contentLength;
+            u4 sourceLength;
+            u4 reserved;
+            u8 sourceSize;
+            u8 sourceModificationTime;
+        };
+
+        static const char MAGIC[8];
+        static const u4 VERSION = 2;
+
+        std::string _path;
+        u1 *_content;
+        size_t _contentLength;
+        // class name in internal form -> class file inside the mapping
+        std::unordered_map<std::string, std::pair<u1 *, size_t>> _classes;
+        // classes left out because their source changed since the dump
+        size_t _staleClassCount;
+
+        ClassDataArchive(const std::string &path, u1 *content, size_t contentLength);
+
+        bool readClasses(const std::string &classPath);
+
+    public:
+        /**
+         * Read a class list, one class name in internal form per line.
+         * Empty lines and lines starting with {@code #} are skipped.
+         * @return {@code false} if the file cannot be read
+         */
+        static bool readClassList(const std::string &path, std::vector<String> *classNames);
+
+        /**
+         * Write an archive of the listed classes, as found on a class path.
+         * Classes which cannot be found or parsed are left out.
+         * @return {@code false} if the archive cannot be written
+         */
+        static bool dump(const std::string &path, ClassPath *classPath,
+                         const std::vector<String> &classNames);
+
+        /**
+         * Map an archive.
+         * @param classPath the class path of this run
+         * @return the archive, or {@code nullptr} if it is missing, corrupt,
+         *         or was dumped with a different class path.
+         *         Classes whose source files changed are left out of it.
+         */
+        static ClassDataArchive *open(const std::string &path, const std::string &classPath);
+
+        ClassDataArchive(const ClassDataArchive &) = delete;
+
+        ~ClassDataArchive();
+
+        inline const std::string &getPath() const {
+            return _path;
+        }
+
+        /**
+         * @return classes usable from the archive
+         */
+        inline size_t getClassCount() const {
+            return _classes.size();
+        }
+
+        /**
+         * @return classes in the archive whose source changed, left to the class path
+         */
+        inline size_t getStaleClassCount() const {
+            return _staleClassCount;
+        }
+
+        inline bool contains(const void *p) const {
+            return p >= _content && p < _content + _contentLength;
+        }
+
+        /**
+         * Parse an archived class.
+         * @return the parsed class file pointing into the archive,
+         *         or {@code nullptr} if the class is not archived
+         */
+        ClassFile *loadClassFile(const std::string &className);
+    };
+}
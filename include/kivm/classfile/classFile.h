@@ -6,6 +6,7 @@
 
 #include <kivm/kivm.h>
 #include <kivm/classfile/attributeInfo.h>
+#include <kivm/classfile/classFileArena.h>
 #include <kivm/classfile/constantPool.h>
 #include <iosfwd>
 
@@ -55,8 +56,6 @@ namespace kivm {
 
         field_info();
 
-        ~field_info();
-
         void init(ClassFileStream &stream, cp_info **constant_pool);
     };
 
@@ -107,8 +106,6 @@ namespace kivm {
 
         method_info();
 
-        ~method_info();
-
         void init(ClassFileStream &stream, cp_info **constant_pool);
     };
 
@@ -160,5 +157,24 @@ namespace kivm {
 
         u2 attributes_count;
         attribute_info **attributes;
+
+        /**
+         * The class file bytes, read-only. Not part of the class file format.
+         * UTF-8 constants, bytecode and other byte payloads point into it,
+         * so it lives as long as this structure.
+         */
+        u1 *content;
+        size_t content_length;
+
+        /**
+         * Frees {@code content}, {@code nullptr} if it is owned elsewhere.
+         */
+        void (*release_content)(u1 *content, size_t content_length);
+
+        /**
+         * Holds this structure and everything parsed into it.
+         * Not part of the class file format.
+         */
+        ClassFileArena *arena;
     };
 }
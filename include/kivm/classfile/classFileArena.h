@@ -0,0 +1,87 @@
+//
+// Created by kiva on 2018/4/25.
+//
+
+#pragma once
+
+#include <kivm/kivm.h>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+
+namespace kivm {
+    /**
+     * Memory of one parsed class file.
+     * Constant pool entries, attributes and tables are bumped out of
+     * a few chunks and released with them at once. Nothing is freed
+     * on its own and destructors do not run, so whatever lives here
+     * must not own memory elsewhere (see {@code CONSTANT_Utf8_info}).
+     */
+    class ClassFileArena {
+    private:
+        static const size_t MIN_CHUNK_SIZE = 4 * 1024;
+
+        struct Chunk {
+            Chunk *next;
+            size_t size;
+        };
+
+        Chunk *_chunks;
+        u1 *_top;
+        u1 *_end;
+        size_t _used;
+        size_t _reserved;
+
+        void addChunk(size_t size);
+
+        void *allocateInNewChunk(size_t size, size_t alignment);
+
+    public:
+        /**
+         * @param sizeHint expected bytes in use, the size of the first chunk
+         */
+        explicit ClassFileArena(size_t sizeHint);
+
+        ClassFileArena(const ClassFileArena &) = delete;
+
+        ~ClassFileArena();
+
+        inline void *allocate(size_t size, size_t alignment) {
+            auto top = (u1 *) (((uintptr_t) _top + alignment - 1) & ~(uintptr_t) (alignment - 1));
+            if (top + size > _end) {
+                return allocateInNewChunk(size, alignment);
+            }
+            _top = top + size;
+            _used += size;
+            return top;
+        }
+
+        template<typename T>
+        T *newObject() {
+            return new(allocate(sizeof(T), alignof(T))) T;
+        }
+
+        template<typename T>
+        T *newArray(size_t count) {
+            auto *array = (T *) allocate(sizeof(T) * count, alignof(T));
+            for (size_t i = 0; i < count; ++i) {
+                new(array + i) T;
+            }
+            return array;
+        }
+
+        /**
+         * @return bytes handed out
+         */
+        inline size_t getUsed() const {
+            return _used;
+        }
+
+        /**
+         * @return bytes of all chunks
+         */
+        inline size_t getReserved() const {
+            return _reserved;
+        }
+    };
+}
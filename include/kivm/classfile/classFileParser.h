@@ -10,16 +10,18 @@
 namespace kivm {
     class ClassFileParser {
     public:
-        static ClassFile *alloc();
+        static ClassFile *alloc(ClassFileArena *arena);
 
         static void dealloc(ClassFile *class_file);
 
     private:
         ClassFile *_classFile;
         ClassFileStream _classFileStream;
-        FILE *_file;
 
+        // owned by the parser until handed to the parsed class file
         u1 *_content;
+        size_t _contentLength;
+        void (*_releaseContent)(u1 *content, size_t contentLength);
 
         ClassFile *parse();
 
@@ -34,8 +36,22 @@ namespace kivm {
         void parseAttributes(ClassFile *classFile);
 
     public:
+        /**
+         * Parse a class file on disk, which is mapped read-only.
+         */
         explicit ClassFileParser(const char *filePath);
 
+        /**
+         * Parse a class file in memory.
+         * @param source where the bytes came from
+         * @param content class file bytes, which the parsed class file points into
+         * @param contentLength size of content
+         * @param releaseContent called to free content when it is no longer used,
+         *                       {@code nullptr} if content outlives all class files
+         */
+        ClassFileParser(const char *source, u1 *content, size_t contentLength,
+                        void (*releaseContent)(u1 *content, size_t contentLength));
+
         ~ClassFileParser();
 
         ClassFile *getParsedClassFile();
@@ -7,6 +7,7 @@
 #include <kivm/kivm.h>
 #include <kivm/classfile/constantPool.h>
 #include <kivm/classfile/classFile.h>
+#include <kivm/classfile/classFileArena.h>
 
 /**
  * Ugly but useful
@@ -30,6 +31,7 @@ namespace kivm {
         u1 *_current;      // Current buffer position
         const char *_source;       // Source of stream (directory name, ZIP/JAR archive name)
         bool _need_verify;  // True if verification is on for the class file
+        ClassFileArena *_arena;    // Where parsed structures are allocated
 
         void guaranteeMore(int size) {
             auto remaining = (size_t) (_buffer_end - _current);
@@ -59,6 +61,10 @@ namespace kivm {
 
         void setSource(const char *source) { _source = source; }
 
+        ClassFileArena *getArena() const { return _arena; }
+
+        void setArena(ClassFileArena *arena) { _arena = arena; }
+
         // Peek u1
         u1 peek1() const {
             return *_current;
@@ -110,6 +116,10 @@ namespace kivm {
         // Copy `count` u1 bytes from current position to `to`
         void getBytes(u1 *to, int count);
 
+        // Get direct pointer to `count` u1 bytes at current position and skip them.
+        // The bytes belong to the buffer and must not be written.
+        u1 *getBytesInPlace(int count);
+
         // Get direct pointer into stream at current position.
         // Returns NULL if length elements are not remaining. The caller is
         // responsible for calling skip below if buffer contents is used.
@@ -0,0 +1,165 @@
+//
+// Created by kiva on 2018/4/25.
+//
+#pragma once
+
+#include <kivm/kivm.h>
+#include <kivm/classfile/classFile.h>
+#include <kivm/classfile/zipArchive.h>
+#include <shared/files.h>
+#include <shared/lock.h>
+#include <atomic>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace kivm {
+    class ClassDataArchive;
+
+    /**
+     * Where the bootstrap class loader looks for class files.
+     * A list of directories and JAR or ZIP archives,
+     * separated by {@code :} ({@code ;} on Windows) and searched in order.
+     * Archives are opened once and stay mapped,
+     * classes stored uncompressed in them are parsed in place.
+     *
+     * All entries are scanned once for the packages they hold,
+     * so a lookup probes the package index and then
+     * only the entries which have the package.
+     * Directories can be watched: when a lookup misses and a watched directory
+     * has changed, the index is rebuilt and the lookup retried.
+     * A class data archive, if attached, is tried before all entries.
+     * Class files are parsed outside of the lock, so threads load in parallel.
+     */
+    class ClassPath {
+    private:
+        // packages deeper than this are not indexed, guards against symlink loops
+        static const int MAX_PACKAGE_DEPTH = 32;
+
+        struct Entry {
+            std::string directory;
+            // nullptr for directories
+            ZipArchive *archive;
+        };
+
+        Lock _lock;
+        std::string _paths;
+        std::vector<Entry> _entries;
+        // package in internal form, like java/lang -> indexes of entries which have it
+        std::unordered_map<std::string, std::vector<size_t>> _packages;
+
+        // nullptr unless watching
+        files::DirectoryWatcher *_watcher;
+        std::unordered_set<std::string> _watchedDirectories;
+
+        // nullptr unless sharing class data
+        ClassDataArchive *_archive;
+
+        std::atomic<u8> _lookups;
+        std::atomic<u8> _misses;
+        // classes found in the class data archive
+        std::atomic<u8> _sharedHits;
+        // class files tried to open or read
+        std::atomic<u8> _probes;
+        std::atomic<u8> _lookupNanos;
+        std::atomic<u8> _indexNanos;
+
+        void addPackage(const std::string &package, size_t index);
+
+        void indexDirectory(size_t index, const std::string &path,
+                            const std::string &package, int depth);
+
+        void buildIndex();
+
+        // indexes of entries which have the package
+        std::vector<size_t> findEntries(const std::string &package);
+
+        ClassFile *findClassFile(const std::vector<size_t> &entries, const std::string &fileName,
+                                 std::string *source);
+
+    public:
+        /**
+         * @return the class path given by the {@code KLASSPATH} environment variable,
+         *         the current directory if it is not set,
+         *         with the configured class data archive attached
+         */
+        static ClassPath *get();
+
+        /**
+         * @param paths entries separated by the path separator
+         * @param watch rebuild the index when directories change
+         */
+        explicit ClassPath(const std::string &paths, bool watch = false);
+
+        ClassPath(const ClassPath &) = delete;
+
+        ~ClassPath();
+
+        inline const std::string &getPaths() const {
+            return _paths;
+        }
+
+        inline ClassDataArchive *getArchive() const {
+            return _archive;
+        }
+
+        /**
+         * Look up classes in a class data archive first.
+         * Attached before classes are loaded.
+         * @param archive an archive dumped with this class path, never unmapped
+         */
+        void setArchive(ClassDataArchive *archive);
+
+        inline size_t getEntryCount() const {
+            return _entries.size();
+        }
+
+        inline size_t getPackageCount() const {
+            return _packages.size();
+        }
+
+        inline u8 getLookupCount() const {
+            return _lookups;
+        }
+
+        inline u8 getMissCount() const {
+            return _misses;
+        }
+
+        inline u8 getSharedHitCount() const {
+            return _sharedHits;
+        }
+
+        inline u8 getProbeCount() const {
+            return _probes;
+        }
+
+        inline u8 getLookupNanos() const {
+            return _lookupNanos;
+        }
+
+        inline u8 getIndexNanos() const {
+            return _indexNanos;
+        }
+
+        /**
+         * Find and parse a class file.
+         * @param className binary name in internal form, like {@code java/lang/Object}
+         * @param source if given, set to the file the class was read from:
+         *               the class file, or the archive holding it
+         * @return the parsed class file, or {@code nullptr} if not found
+         */
+        ClassFile *loadClassFile(const String &className, std::string *source = nullptr);
+
+        /**
+         * Rescan all entries.
+         */
+        void refresh();
+
+        /**
+         * Print lookup counts and timings to stderr.
+         */
+        void printStatistics() const;
+    };
+}
@@ -0,0 +1,123 @@
+//
+// Created by kiva on 2018/4/25.
+//
+#pragma once
+
+#include <kivm/kivm.h>
+#include <kivm/classfile/classFile.h>
+#include <shared/lock.h>
+#include <condition_variable>
+#include <deque>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace kivm {
+    class ClassPath;
+
+    /**
+     * Parses class files on worker threads before the class loader asks for them.
+     *
+     * Loading a class only reveals its superclass, interfaces and the classes
+     * it refers to once it is parsed, so classes load one after another.
+     * Here every parsed class queues its superclass and interfaces, which are
+     * certain to be loaded next, and the classes in its constant pool,
+     * which are likely to be. Referred classes of those are not followed,
+     * keeping speculation to one step. A class list can be queued up front.
+     *
+     * The class loader takes parsed class files out of the staging area,
+     * waits for ones being parsed, and parses itself what is still queued.
+     */
+    class ClassPrefetcher {
+    private:
+        enum SlotState {
+            QUEUED,
+            PARSING,
+            // parsed, or not found if the class file is nullptr
+            STAGED,
+            // handed out or given up, never queued again
+            TAKEN,
+        };
+
+        struct Slot {
+            SlotState state;
+            // whether classes it refers to are queued, not only its supers
+            bool certain;
+            ClassFile *classFile;
+        };
+
+        ClassPath *_classPath;
+        Lock _lock;
+        std::condition_variable _changed;
+        std::unordered_map<String, Slot> _slots;
+        std::deque<String> _queue;
+        std::vector<std::thread> _workers;
+        int _parsing;
+        bool _stopping;
+
+        u8 _hits;
+        u8 _waits;
+        u8 _misses;
+
+        void run();
+
+        // with the lock held
+        void enqueue(const String &className, bool certain);
+
+        // with the lock held
+        void enqueueReferences(ClassFile *classFile, bool certain);
+
+    public:
+        /**
+         * @return the prefetcher of the bootstrap class path,
+         *         {@code nullptr} unless prefetching classes
+         */
+        static ClassPrefetcher *get();
+
+        ClassPrefetcher(ClassPath *classPath, int threads);
+
+        ClassPrefetcher(const ClassPrefetcher &) = delete;
+
+        ~ClassPrefetcher();
+
+        /**
+         * Queue classes which will be loaded, like those of a class list.
+         */
+        void prefetch(const std::vector<String> &classNames);
+
+        /**
+         * Queue the classes a class loaded just now refers to.
+         */
+        void prefetchReferences(ClassFile *classFile);
+
+        /**
+         * Take a parsed class file, waiting if it is being parsed.
+         * @return the parsed class file, or {@code nullptr} if it was not parsed ahead,
+         *         then the caller parses it
+         * @param parsed set to whether the class was parsed ahead, even if not found
+         */
+        ClassFile *take(const String &className, bool *parsed);
+
+        /**
+         * Wait until all queued classes are parsed.
+         */
+        void drain();
+
+        inline u8 getHitCount() const {
+            return _hits;
+        }
+
+        inline u8 getWaitCount() const {
+            return _waits;
+        }
+
+        inline u8 getMissCount() const {
+            return _misses;
+        }
+
+        /**
+         * Log how many classes were found parsed.
+         */
+        void printStatistics() const;
+    };
+}
@@ -251,6 +251,7 @@ namespace kivm {
          * The bytes array (whose length is {@code length})
          * contains the bytes of the string. No byte may have the value
          * {@code (byte)0} or lie in the range {@code (byte)0xf0} - {@code (byte)0xff}.
+         * Points into the mapped class file.
          */
         u1 *bytes;
 
@@ -267,7 +268,7 @@ namespace kivm {
 
         ~CONSTANT_Utf8_info() override;
 
-        String get_constant();
+        const String &get_constant();
     };
 
     struct CONSTANT_MethodHandle_info : public cp_info {
@@ -0,0 +1,97 @@
+//
+// Created by kiva on 2018/4/25.
+//
+#pragma once
+
+#include <kivm/kivm.h>
+#include <string>
+#include <unordered_map>
+
+namespace kivm {
+    /**
+     * A ZIP or JAR file, mapped read-only.
+     * The central directory is read once into a hash index when the archive is opened,
+     * entries are located through the index only when they are read.
+     * Stored entries are read in place, deflated ones are inflated with
+     * a per-thread inflater.
+     * ZIP64 archives are not supported.
+     */
+    class ZipArchive {
+    private:
+        // entry name inside the mapping, not null-terminated
+        struct Name {
+            const char *data;
+            size_t length;
+
+            bool operator==(const Name &other) const;
+        };
+
+        struct NameHash {
+            size_t operator()(const Name &name) const;
+        };
+
+        struct Entry {
+            u4 localHeaderOffset;
+            u4 compressedSize;
+            u4 uncompressedSize;
+            u2 method;
+        };
+
+        std::string _path;
+        u1 *_content;
+        size_t _contentLength;
+        std::unordered_map<Name, Entry, NameHash> _entries;
+
+        ZipArchive(const std::string &path, u1 *content, size_t contentLength);
+
+        bool readCentralDirectory();
+
+        const Entry *find(const std::string &name) const;
+
+    public:
+        /**
+         * Map an archive and index its central directory.
+         * @return the archive, or {@code nullptr} if it cannot be read
+         */
+        static ZipArchive *open(const std::string &path);
+
+        ZipArchive(const ZipArchive &) = delete;
+
+        ~ZipArchive();
+
+        inline const std::string &getPath() const {
+            return _path;
+        }
+
+        inline size_t getEntryCount() const {
+            return _entries.size();
+        }
+
+        inline bool contains(const std::string &name) const {
+            return find(name) != nullptr;
+        }
+
+        /**
+         * Visit the names of all entries, in no particular order.
+         * @param fn called with a name and its length, the name is not null-terminated
+         */
+        template<typename Fn>
+        inline void iterateEntries(Fn fn) const {
+            for (const auto &entry : _entries) {
+                fn(entry.first.data, entry.first.length);
+            }
+        }
+
+        /**
+         * Read an entry.
+         * @param name entry name, like {@code java/lang/Object.class}
+         * @param length set to the entry size
+         * @param allocated set to {@code true} if the result was inflated into
+         *                  a {@code new u1[]} the caller must delete,
+         *                  {@code false} if it points into the archive
+         * @return entry bytes, or {@code nullptr} if there is no such entry
+         *         or it cannot be decompressed
+         */
+        u1 *read(const std::string &name, size_t *length, bool *allocated) const;
+    };
+}
@@ -5,7 +5,9 @@
 
 #include <kivm/kivm.h>
 #include <kivm/oop/oopfwd.h>
+#include <kivm/symbol.h>
 #include <list>
+#include <atomic>
 
 namespace kivm {
     class Klass;
@@ -18,6 +20,30 @@ namespace kivm {
 
     class ConstantValue_attribute;
 
+    /**
+     * (declaring class name, name, descriptor) of a field.
+     * Subclasses may hide a field with one of the same name and descriptor,
+     * so the declaring class is part of the key.
+     */
+    struct FieldKey {
+        Symbol *className;
+        Symbol *name;
+        Symbol *descriptor;
+
+        inline bool operator==(const FieldKey &other) const {
+            return className == other.className
+                   && name == other.name
+                   && descriptor == other.descriptor;
+        }
+    };
+
+    struct FieldKeyHash {
+        inline size_t operator()(const FieldKey &key) const {
+            return (key.className->getHash() * 31 + key.name->getHash()) * 31
+                   + key.descriptor->getHash();
+        }
+    };
+
     class Field {
         friend InstanceKlass;
 
@@ -28,9 +54,9 @@ namespace kivm {
 
     private:
         InstanceKlass *_klass;
-        String _name;
-        String _descriptor;
-        String _signature;
+        Symbol *_name;
+        Symbol *_descriptor;
+        Symbol *_signature;
         u2 _accessFlag;
 
         ValueType _valueType;
@@ -45,6 +71,11 @@ namespace kivm {
 
         bool _linked;
 
+        /**
+         * GETFIELD/PUTFIELD executions, only counted when recording a field profile.
+         */
+        std::atomic<u4> _accessCount;
+
         void linkAttributes(cp_info **pool);
 
         void linkValueType();
@@ -58,17 +89,30 @@ namespace kivm {
             return _klass;
         }
 
-        const String &getName() const {
+        String getName() const {
+            return _name->toString();
+        }
+
+        String getDescriptor() const {
+            return _descriptor->toString();
+        }
+
+        String getSignature() const {
+            return _signature != nullptr ? _signature->toString() : String();
+        }
+
+        Symbol *getNameSymbol() const {
             return _name;
         }
 
-        const String &getDescriptor() const {
+        Symbol *getDescriptorSymbol() const {
             return _descriptor;
         }
 
-        const String &getSignature() const {
-            return _signature;
-        }
+        /**
+         * @return key of this field in field tables
+         */
+        FieldKey getKey() const;
 
         ConstantValue_attribute *getConstantAttribute() const {
             return _constantAttr;
@@ -86,6 +130,14 @@ namespace kivm {
             return _linked;
         }
 
+        inline void countAccess() {
+            _accessCount.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        u4 getAccessCount() const {
+            return _accessCount.load(std::memory_order_relaxed);
+        }
+
         bool isPublic() const {
             return (getAccessFlag() & ACC_PUBLIC) == ACC_PUBLIC;
         }
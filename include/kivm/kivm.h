@@ -119,6 +119,11 @@
        exit(1); \
     } while (false)
 
+#if defined(__GNUC__)
+#define KIVM_NOINLINE __attribute__((noinline))
+#else
+#define KIVM_NOINLINE
+#endif
 
 #define JVM_ENTRY_NAME(nameAndSignature) jvm##jvm_##nameAndSignature
 #define JVM_ENTRY(returnType, nameAndSignature) returnType JVM_ENTRY_NAME(nameAndSignature)
@@ -0,0 +1,139 @@
+//
+// Created by kiva on 2018/4/25.
+//
+#pragma once
+
+#include <kivm/kivm.h>
+#include <shared/lock.h>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace kivm {
+    class Method;
+
+    /**
+     * A NEW, NEWARRAY or ANEWARRAY instruction, with the survival
+     * statistics of the objects it allocates.
+     * Objects remember their site in the forwarding slot of their block header
+     * until their first collection, which is when survival is counted.
+     */
+    class AllocationSite {
+        friend class AllocationSiteTable;
+
+    private:
+        Method *_method;
+        int _bci;
+        u4 _id;
+
+        // since the last collection, updated under the heap lock
+        u4 _allocated;
+        // found alive by the running collection
+        u4 _survived;
+
+        u8 _totalAllocated;
+        u8 _totalSurvived;
+        volatile bool _tenured;
+
+        AllocationSite(Method *method, int bci, u4 id, bool tenured);
+
+    public:
+        inline Method *getMethod() const {
+            return _method;
+        }
+
+        inline int getBci() const {
+            return _bci;
+        }
+
+        inline u4 getId() const {
+            return _id;
+        }
+
+        /**
+         * @return {@code true} if objects from this site go to the tenured space
+         */
+        inline bool isTenured() const {
+            return _tenured;
+        }
+
+        inline void countAllocation() {
+            ++_allocated;
+        }
+
+        inline u8 getTotalAllocated() const {
+            return _totalAllocated;
+        }
+
+        inline u8 getTotalSurvived() const {
+            return _totalSurvived;
+        }
+    };
+
+    /**
+     * All allocation sites, and the pretenuring decisions made from their statistics.
+     * A site whose objects almost always survive their first collection
+     * allocates in the tenured space from then on, where nothing short-lived
+     * is left behind for the compactor to slide long-lived objects over.
+     *
+     * Decisions can be saved at exit and loaded by the next run,
+     * a text file with one tenured site per line:
+     * {@code <class> <method name> <descriptor> <bci>}
+     */
+    class AllocationSiteTable {
+    private:
+        // objects a site must have allocated before it is judged
+        static const u4 MIN_SAMPLES = 64;
+        // percentage of objects which must survive
+        static const u4 SURVIVAL_PERCENT = 90;
+
+        Lock _lock;
+        std::unordered_map<Method *, std::unordered_map<int, AllocationSite *>> _sites;
+        // index is the site id, 0 is no site
+        std::vector<AllocationSite *> _sitesById;
+        // identities of sites tenured by a loaded profile
+        std::unordered_set<String> _profiledSites;
+        bool _enabled;
+
+        AllocationSiteTable();
+
+        static String makeIdentity(Method *method, int bci);
+
+    public:
+        static AllocationSiteTable *get();
+
+        /**
+         * Find or create the site of an instruction.
+         * @return the site, or {@code nullptr} if pretenuring is disabled
+         */
+        AllocationSite *lookup(Method *method, int bci);
+
+        /**
+         * Count a survivor of its first collection, called by the collector.
+         * @param id site id from the block header, not 0
+         */
+        inline void recordSurvivor(u4 id) {
+            if (id < _sitesById.size()) {
+                ++_sitesById[id]->_survived;
+            }
+        }
+
+        /**
+         * Fold the statistics of a finished collection in and tenure long-lived sites.
+         * Called at a safepoint with the heap locked.
+         */
+        void endCollection();
+
+        /**
+         * Read tenured sites of an earlier run.
+         * @return false if the file cannot be read
+         */
+        bool load(const std::string &path);
+
+        /**
+         * Write all tenured sites.
+         * @return false if the file cannot be written
+         */
+        bool save(const std::string &path);
+    };
+}
@@ -0,0 +1,107 @@
+//
+// Created by kiva on 2018/4/25.
+//
+#pragma once
+
+#include <kivm/kivm.h>
+#include <kivm/oop/oopfwd.h>
+
+namespace kivm {
+    class Klass;
+
+    typedef u4 narrowOop;
+    typedef u4 narrowKlass;
+
+    /**
+     * 32-bit encodings of heap references and class pointers, for 64-bit builds.
+     *
+     * A narrow oop is the offset of an object from the heap base in 8-byte units,
+     * so a heap of up to 32 GB can be addressed. 0 is null: the first object
+     * follows its block header and never sits at the base.
+     * A narrow klass is encoded in the same way, relative to a class space
+     * which all {@code Klass} objects are allocated from.
+     *
+     * Reference fields, array elements and static fields hold narrow oops
+     * when compressed oops are enabled. References outside the heap,
+     * like stack slots and native structures, always take a full pointer.
+     * Both modes are chosen from {@code RuntimeConfig} before
+     * the first class is allocated and never change afterwards.
+     */
+    class CompressedOops {
+    private:
+        static bool _useCompressedOops;
+        static bool _useCompressedClassPointers;
+        static char *_oopBase;
+        static char *_klassBase;
+
+        static bool doInitialize();
+
+    public:
+        static const int SHIFT = 3;
+        static const u8 MAX_ENCODABLE_SIZE = (u8) 1 << (32 + SHIFT);
+
+        /**
+         * Read the configuration, only the first call does anything.
+         */
+        static void initialize();
+
+        static void setOopBase(void *base) {
+            _oopBase = (char *) base;
+        }
+
+        /**
+         * Allocate memory for a {@code Klass}, in the class space
+         * when class pointers are compressed.
+         */
+        static void *allocateKlass(size_t size);
+
+        static void deallocateKlass(void *ptr);
+
+        static inline bool useCompressedOops() {
+            return _useCompressedOops;
+        }
+
+        static inline bool useCompressedClassPointers() {
+            return _useCompressedClassPointers;
+        }
+
+        /**
+         * Bytes taken by a reference field or a reference array element.
+         */
+        static inline int getReferenceSize() {
+            return _useCompressedOops ? (int) sizeof(narrowOop) : (int) sizeof(oop);
+        }
+
+        static inline narrowOop encode(oop object) {
+            return object == nullptr
+                   ? 0 : (narrowOop) (((char *) object - _oopBase) >> SHIFT);
+        }
+
+        static inline oop decode(narrowOop value) {
+            return value == 0 ? nullptr : (oop) (_oopBase + ((size_t) value << SHIFT));
+        }
+
+        static inline narrowKlass encodeKlass(Klass *klass) {
+            return (narrowKlass) (((char *) klass - _klassBase) >> SHIFT);
+        }
+
+        static inline Klass *decodeKlass(narrowKlass value) {
+            return (Klass *) (_klassBase + ((size_t) value << SHIFT));
+        }
+
+        /**
+         * Read a reference slot inside the heap or a static field block.
+         */
+        static inline oop loadReference(const void *slot) {
+            return _useCompressedOops ? decode(*(const narrowOop *) slot) : *(const oop *) slot;
+        }
+
+        static inline void storeReference(void *slot, oop object) {
+            if (_useCompressedOops) {
+                *(narrowOop *) slot = encode(object);
+            } else {
+                *(oop *) slot = object;
+            }
+        }
+    };
+}
@@ -0,0 +1,173 @@
+//
+// Created by kiva on 2018/4/20.
+//
+#pragma once
+
+#include <kivm/kivm.h>
+#include <kivm/oop/oopfwd.h>
+#include <kivm/memory/space.h>
+#include <kivm/memory/largeObjectSpace.h>
+#include <kivm/memory/oopClosure.h>
+#include <shared/lock.h>
+
+namespace kivm {
+    /**
+     * The Java heap.
+     * Address space is reserved once when the heap is created,
+     * objects live in a mark-compact old space inside it.
+     * Objects of at least {@code RuntimeConfig::largeObjectThreshold} bytes
+     * are mapped one by one in a large-object space instead.
+     *
+     * The top quarter of the range is a tenured space for objects of
+     * pretenured allocation sites (see {@code AllocationSiteTable}).
+     * It is collected the same way, but holds little garbage,
+     * so compacting it moves next to nothing.
+     */
+    class Heap {
+        friend class MarkCompactCollector;
+
+    public:
+        /**
+         * Forwarding addresses are 32-bit word offsets from the heap base,
+         * so larger reservations are cut down to this.
+         */
+        static const u8 MAX_RESERVED_SIZE = (u8) HEAP_WORD_SIZE << 32;
+
+    private:
+        char *_base;
+        size_t _reservedSize;
+        size_t _initialCapacity;
+
+        MarkCompactSpace *_oldSpace;
+        // nullptr when pretenuring is disabled
+        MarkCompactSpace *_tenuredSpace;
+        size_t _initialTenuredCapacity;
+        LargeObjectSpace *_largeObjectSpace;
+        size_t _largeObjectThreshold;
+        // soft limit of the large-object space, crossing it requests a collection
+        size_t _largeObjectLimit;
+        Lock _lock;
+
+        volatile bool _collectionRequested;
+        int _collections;
+
+        Heap(size_t initialCapacity, size_t reservedSize);
+
+        void doCollect();
+
+        void collectAtSafepoint(bool onlyIfRequested);
+
+        /**
+         * @return the block, or {@code nullptr} if the heap is full
+         */
+        HeapBlock *tryAllocate(size_t blockSize, AllocationSite *site);
+
+        HeapBlock *allocateLarge(size_t blockSize);
+
+        HeapBlock *allocateBlock(size_t blockSize, AllocationSite *site);
+
+    public:
+        static Heap *get();
+
+        Heap(const Heap &) = delete;
+
+        Heap(Heap &&) noexcept = delete;
+
+        /**
+         * Allocate zero-filled memory for an object.
+         * When the heap grows beyond its capacity a collection is requested
+         * and performed at the next {@code collectIfRequested()}.
+         * When the heap is full, it is collected at once and the allocation retried,
+         * so callers must hold no references invisible to the collector, as for {@code collect()}.
+         * @param size object size in bytes
+         * @param site allocating instruction, may be {@code nullptr}
+         * @return memory for the object
+         */
+        void *allocate(size_t size, AllocationSite *site = nullptr);
+
+        /**
+         * Stop all other threads at a safepoint and perform a full compacting collection.
+         * Must be called where the caller holds no references invisible to the collector.
+         */
+        void collect();
+
+        inline void collectIfRequested() {
+            if (_collectionRequested) {
+                collectAtSafepoint(true);
+            }
+        }
+
+        /**
+         * Destroy all objects in the heap.
+         */
+        void destroyAll();
+
+        inline bool contains(const void *p) const {
+            return _oldSpace->contains(p)
+                   || (_tenuredSpace != nullptr && _tenuredSpace->contains(p))
+                   || _largeObjectSpace->contains(p);
+        }
+
+        inline u4 toWordOffset(const void *p) const {
+            return (u4) (((const char *) p - _base) / HEAP_WORD_SIZE);
+        }
+
+        inline void *fromWordOffset(u4 offset) const {
+            return _base + (size_t) offset * HEAP_WORD_SIZE;
+        }
+
+        inline MarkCompactSpace *getOldSpace() const {
+            return _oldSpace;
+        }
+
+        /**
+         * @return the tenured space, {@code nullptr} if pretenuring is disabled
+         */
+        inline MarkCompactSpace *getTenuredSpace() const {
+            return _tenuredSpace;
+        }
+
+        inline size_t getReservedSize() const {
+            return _reservedSize;
+        }
+
+        inline int getCollections() const {
+            return _collections;
+        }
+
+        inline LargeObjectSpace *getLargeObjectSpace() const {
+            return _largeObjectSpace;
+        }
+
+        inline size_t getUsed() const {
+            return _oldSpace->getUsed()
+                   + (_tenuredSpace != nullptr ? _tenuredSpace->getUsed() : 0)
+                   + _largeObjectSpace->getUsed();
+        }
+
+        inline size_t getCapacity() const {
+            return _oldSpace->getCapacity();
+        }
+
+        /**
+         * Visit all roots of the object graph:
+         * classes, interned strings, thread objects and Java frames,
+         * and the native stack of the current thread.
+         * @param closure root visitor
+         */
+        static void iterateRoots(RootClosure *closure);
+
+        /**
+         * Visit all reference slots inside an object.
+         * @param object the object
+         * @param closure reference visitor
+         */
+        static void iterateObject(oop object, OopClosure *closure);
+
+        /**
+         * Run destructor of a dead object and release its monitor.
+         * @param object the object
+         */
+        static void destroyObject(oop object);
+    };
+}
@@ -0,0 +1,87 @@
+//
+// Created by kiva on 2018/4/25.
+//
+#pragma once
+
+#include <kivm/memory/space.h>
+#include <map>
+
+namespace kivm {
+    /**
+     * Objects too large to be worth sliding, in practice big arrays.
+     * Every object gets a mapping of its own and never moves.
+     * The collector unmaps it as soon as it finds the object dead,
+     * so its memory goes back to the operating system at once.
+     */
+    class LargeObjectSpace {
+    private:
+        // block address -> mapped size
+        std::map<char *, size_t> _blocks;
+        size_t _used;
+
+        void release(char *block, size_t mappedSize);
+
+    public:
+        LargeObjectSpace();
+
+        /**
+         * Map a block, the caller must hold the heap lock.
+         * Fresh mappings are zero-filled, so the block is too.
+         * @param blockSize block size including header
+         * @return the block if succeeded, otherwise {@code nullptr}
+         */
+        HeapBlock *allocate(size_t blockSize);
+
+        /**
+         * Find the block an address points into, interior pointers included.
+         * @return the block, or {@code nullptr} if the address is not in this space
+         */
+        HeapBlock *findBlock(const void *p) const;
+
+        inline bool contains(const void *p) const {
+            return findBlock(p) != nullptr;
+        }
+
+        /**
+         * Mapped bytes, a multiple of the page size per object.
+         */
+        inline size_t getUsed() const {
+            return _used;
+        }
+
+        inline size_t getObjectCount() const {
+            return _blocks.size();
+        }
+
+        template<typename Fn>
+        inline void iterateBlocks(Fn fn) {
+            for (const auto &e : _blocks) {
+                fn((HeapBlock *) e.first);
+            }
+        }
+
+        /**
+         * Unmap every block that is not marked, and clear the marks of the rest.
+         * @param destroy called with every dead object before its block is unmapped
+         * @return number of unmapped blocks
+         */
+        template<typename Fn>
+        size_t sweep(Fn destroy) {
+            size_t released = 0;
+            for (auto iter = _blocks.begin(); iter != _blocks.end();) {
+                auto *block = (HeapBlock *) iter->first;
+                if (block->isMarked()) {
+                    block->clearCollectorStates();
+                    ++iter;
+                    continue;
+                }
+
+                destroy(block->getObject());
+                release(iter->first, iter->second);
+                iter = _blocks.erase(iter);
+                ++released;
+            }
+            return released;
+        }
+    };
+}
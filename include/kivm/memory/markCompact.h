@@ -0,0 +1,79 @@
+//
+// Created by kiva on 2018/4/20.
+//
+#pragma once
+
+#include <kivm/memory/heap.h>
+#include <vector>
+
+namespace kivm {
+    /**
+     * Sliding mark-compact collector (Lisp-2 style) for the old and tenured spaces.
+     *
+     * 1. Mark all objects reachable from roots.
+     *    Objects reached only from conservative roots are pinned.
+     * 2. Compute forwarding addresses by sliding live objects
+     *    towards the bottom of the space, keeping pinned objects in place.
+     * 3. Update all references (roots and inside live objects).
+     * 4. Move objects, fill holes left before pinned objects,
+     *    and return the pages above the new top to the operating system.
+     *
+     * Large objects are marked too, but never moved:
+     * dead ones are unmapped right after marking.
+     *
+     * Objects marked for the first time report to their allocation site,
+     * which decides whether the site is pretenured.
+     */
+    class MarkCompactCollector {
+        friend class MarkClosure;
+
+    private:
+        struct CompactedSpace {
+            MarkCompactSpace *space;
+            // holes between compacted objects and pinned objects: <start, size>
+            std::vector<std::pair<char *, size_t>> holes;
+            char *compactTop;
+
+            explicit CompactedSpace(MarkCompactSpace *space)
+                : space(space), compactTop(nullptr) {
+            }
+        };
+
+        Heap *_heap;
+        std::vector<CompactedSpace> _spaces;
+        LargeObjectSpace *_largeObjects;
+
+        std::vector<oop> _markStack;
+        std::vector<void *> _conservativeRoots;
+
+        size_t _liveBytes;
+        size_t _pinnedBlocks;
+        size_t _destroyedObjects;
+        size_t _releasedLargeObjects;
+
+        MarkCompactSpace *findSpace(const void *p) const;
+
+        void markObject(oop object);
+
+        void drainMarkStack();
+
+        void pinConservativeRoots();
+
+        void mark();
+
+        void sweepLargeObjects();
+
+        void computeForwardingAddresses(CompactedSpace &compacted);
+
+        void adjustPointers();
+
+        void compact(CompactedSpace &compacted);
+
+    public:
+        explicit MarkCompactCollector(Heap *heap);
+
+        void collect();
+
+        oop forward(oop object) const;
+    };
+}
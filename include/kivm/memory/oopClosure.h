@@ -0,0 +1,51 @@
+//
+// Created by kiva on 2018/4/20.
+//
+#pragma once
+
+#include <kivm/oop/oopfwd.h>
+#include <kivm/memory/compressedOops.h>
+
+namespace kivm {
+    class OopClosure {
+    public:
+        virtual ~OopClosure() = default;
+
+        /**
+         * Visit a reference slot.
+         * The closure may update the slot when the referenced object moved.
+         * @param p address of the slot
+         */
+        virtual void doOop(oop *p) = 0;
+
+        /**
+         * Visit a reference field, array element or static field,
+         * which holds a narrow oop when compressed oops are enabled.
+         * @param slot address of the slot
+         */
+        inline void doHeapOop(void *slot) {
+            if (!CompressedOops::useCompressedOops()) {
+                doOop((oop *) slot);
+                return;
+            }
+
+            oop object = CompressedOops::loadReference(slot);
+            oop updated = object;
+            doOop(&updated);
+            if (updated != object) {
+                CompressedOops::storeReference(slot, updated);
+            }
+        }
+    };
+
+    class RootClosure : public OopClosure {
+    public:
+        /**
+         * Visit a word which may or may not be a reference,
+         * for example a word on the native stack.
+         * Objects reached in this way must not be moved.
+         * @param word the value of the word
+         */
+        virtual void doConservativeRoot(void *word) = 0;
+    };
+}
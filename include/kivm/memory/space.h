@@ -0,0 +1,201 @@
+//
+// Created by kiva on 2018/4/20.
+//
+#pragma once
+
+#include <kivm/kivm.h>
+
+namespace kivm {
+    using HeapWord = u8;
+
+    static constexpr size_t HEAP_WORD_SIZE = sizeof(HeapWord);
+
+    /**
+     * Every object in the heap is preceded by a block header,
+     * which records the block size and collector states.
+     * Blocks are laid out one by one so the heap is parsable.
+     */
+    class HeapBlock {
+    private:
+        enum {
+            FLAG_MARKED = 1,
+            FLAG_PINNED = 2,
+            FLAG_FILLER = 4,
+            FLAG_BITS = 3,
+        };
+
+        // new location (in heap words relative to heap base) during compaction
+        u4 _forwardee;
+        // size in heap words, above the flags
+        u4 _sizeAndFlags;
+
+    public:
+        /**
+         * Blocks are smaller than this, so that their size fits the header.
+         */
+        static const u8 SIZE_LIMIT = (u8) HEAP_WORD_SIZE << (32 - FLAG_BITS);
+
+        static inline HeapBlock *fromObject(const void *object) {
+            return ((HeapBlock *) object) - 1;
+        }
+
+        static inline size_t blockSizeFor(size_t objectSize) {
+            return (objectSize + sizeof(HeapBlock) + HEAP_WORD_SIZE - 1) & ~(HEAP_WORD_SIZE - 1);
+        }
+
+        inline void initialize(size_t blockSize, bool filler) {
+            this->_forwardee = 0;
+            this->_sizeAndFlags = (u4) (blockSize / HEAP_WORD_SIZE) << FLAG_BITS;
+            if (filler) {
+                this->_sizeAndFlags |= FLAG_FILLER;
+            }
+        }
+
+        /**
+         * Cover a free range with filler blocks, more than one if it is too large.
+         * @param start start of the range
+         * @param size size in bytes, a multiple of the heap word
+         */
+        static inline void fill(void *start, size_t size) {
+            auto *block = (HeapBlock *) start;
+            while (size != 0) {
+                size_t blockSize = (u8) size < SIZE_LIMIT ? size : (size_t) (SIZE_LIMIT - HEAP_WORD_SIZE);
+                block->initialize(blockSize, true);
+                block = block->next();
+                size -= blockSize;
+            }
+        }
+
+        inline void *getObject() {
+            return this + 1;
+        }
+
+        inline size_t getSize() const {
+            return (size_t) (_sizeAndFlags >> FLAG_BITS) * HEAP_WORD_SIZE;
+        }
+
+        inline HeapBlock *next() {
+            return (HeapBlock *) ((char *) this + getSize());
+        }
+
+        inline bool isFiller() const {
+            return (_sizeAndFlags & FLAG_FILLER) != 0;
+        }
+
+        inline bool isMarked() const {
+            return (_sizeAndFlags & FLAG_MARKED) != 0;
+        }
+
+        inline bool isPinned() const {
+            return (_sizeAndFlags & FLAG_PINNED) != 0;
+        }
+
+        inline void setMarked() {
+            _sizeAndFlags |= FLAG_MARKED;
+        }
+
+        inline void setPinned() {
+            _sizeAndFlags |= FLAG_PINNED;
+        }
+
+        inline void clearCollectorStates() {
+            _sizeAndFlags &= ~(u4) (FLAG_MARKED | FLAG_PINNED);
+        }
+
+        inline u4 getForwardee() const {
+            return _forwardee;
+        }
+
+        inline void setForwardee(u4 forwardee) {
+            this->_forwardee = forwardee;
+        }
+    };
+
+    /**
+     * A contiguous space which allocates by bumping a pointer
+     * and is collected by sliding live objects towards its bottom.
+     * Memory is committed in chunks as top grows, and stays committed.
+     */
+    class MarkCompactSpace {
+    private:
+        static constexpr size_t COMMIT_CHUNK = 2 * 1024 * 1024;
+
+        char *_bottom;
+        char *_top;
+        // soft limit, crossing it requests a collection
+        char *_end;
+        char *_committedEnd;
+        char *_reservedEnd;
+
+        bool expandCommitted(char *top);
+
+    public:
+        /**
+         * @param bottom start of a reserved range
+         * @param reservedSize size of the range
+         * @param capacity committed up front
+         */
+        MarkCompactSpace(void *bottom, size_t reservedSize, size_t capacity);
+
+        /**
+         * Allocate a block, the caller must hold the heap lock.
+         * Memory above top is always zero-filled, so the block is too.
+         * @param blockSize block size including header
+         * @return the block if succeeded, otherwise {@code nullptr}
+         */
+        HeapBlock *allocate(size_t blockSize);
+
+        inline bool contains(const void *p) const {
+            return p >= _bottom && p < _top;
+        }
+
+        inline bool isOverCapacity() const {
+            return _top > _end;
+        }
+
+        inline char *getBottom() const {
+            return _bottom;
+        }
+
+        inline char *getTop() const {
+            return _top;
+        }
+
+        /**
+         * Memory above top must be zero-filled when it is given back,
+         * because allocation does not clear blocks.
+         */
+        inline void setTop(char *top) {
+            this->_top = top;
+        }
+
+        inline size_t getUsed() const {
+            return (size_t) (_top - _bottom);
+        }
+
+        inline size_t getCapacity() const {
+            return (size_t) (_end - _bottom);
+        }
+
+        inline size_t getCommittedSize() const {
+            return (size_t) (_committedEnd - _bottom);
+        }
+
+        inline size_t getReservedSize() const {
+            return (size_t) (_reservedEnd - _bottom);
+        }
+
+        void setCapacity(size_t capacity);
+
+        template<typename Fn>
+        inline void iterateBlocks(Fn fn) {
+            auto *block = (HeapBlock *) _bottom;
+            while ((char *) block < _top) {
+                // fn may overwrite the block, so step first
+                HeapBlock *next = block->next();
+                fn(block);
+                block = next;
+            }
+        }
+    };
+}
@@ -7,6 +7,7 @@
 #include <kivm/oop/oopfwd.h>
 #include <kivm/bytecode/codeBlob.h>
 #include <kivm/classfile/attributeInfo.h>
+#include <kivm/symbol.h>
 #include <list>
 #include <unordered_map>
 #include <vector>
@@ -26,13 +27,11 @@ namespace kivm {
     public:
         static bool isSame(const Method *lhs, const Method *rhs);
 
-        static String makeIdentity(const Method *m);
-
     private:
         InstanceKlass *_klass;
-        String _name;
-        String _descriptor;
-        String _signature;
+        Symbol *_name;
+        Symbol *_descriptor;
+        Symbol *_signature;
         u2 _accessFlag;
 
         /**
@@ -42,6 +41,7 @@ namespace kivm {
         method_info *_methodInfo;
         Exceptions_attribute *_exceptionAttr;
         Code_attribute *_codeAttr;
+        StackMapTable_attribute *_stackMapTableAttr;
 
         /**
          * only available when this method is a native method
@@ -130,16 +130,31 @@ namespace kivm {
             return _klass;
         }
 
-        const String &getName() const {
+        String getName() const {
+            return _name->toString();
+        }
+
+        String getDescriptor() const {
+            return _descriptor->toString();
+        }
+
+        String getSignature() const {
+            return _signature != nullptr ? _signature->toString() : String();
+        }
+
+        Symbol *getNameSymbol() const {
             return _name;
         }
 
-        const String &getDescriptor() const {
+        Symbol *getDescriptorSymbol() const {
             return _descriptor;
         }
 
-        const String &getSignature() const {
-            return _signature;
+        /**
+         * @return key of this method in method tables
+         */
+        SymbolPair getIdentity() const {
+            return std::make_pair(_name, _descriptor);
         }
 
         u2 getAccessFlag() const {
@@ -186,6 +201,21 @@ namespace kivm {
             return (getAccessFlag() & ACC_NATIVE) == ACC_NATIVE;
         }
 
+        method_info *getMethodInfo() const {
+            return _methodInfo;
+        }
+
+        Code_attribute *getCodeAttribute() const {
+            return _codeAttr;
+        }
+
+        /**
+         * @return StackMapTable of the code, or {@code nullptr} for old class files
+         */
+        StackMapTable_attribute *getStackMapTable() const {
+            return _stackMapTableAttr;
+        }
+
         int getMaxLocals() const {
             return _codeAttr != nullptr ? _codeAttr->max_locals : 0;
         }
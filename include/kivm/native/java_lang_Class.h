@@ -9,6 +9,8 @@
 #include <unordered_map>
 
 namespace kivm {
+    class OopClosure;
+
     namespace java {
         namespace lang {
             class Class {
@@ -27,6 +29,8 @@ namespace kivm {
                 static void initialize();
 
                 static void mirrorCoreClasses();
+
+                static void iterateOops(OopClosure *closure);
             };
         }
     }
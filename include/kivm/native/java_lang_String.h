@@ -8,6 +8,8 @@
 #include <unordered_map>
 
 namespace kivm {
+    class OopClosure;
+
     namespace java {
         namespace lang {
             class InternStringPool {
@@ -19,6 +21,8 @@ namespace kivm {
                 static InternStringPool *getGlobal();
 
                 instanceOop findOrNew(const kivm::String &string);
+
+                void iterateOops(OopClosure *closure);
             };
 
             class String {
@@ -14,6 +14,9 @@ namespace kivm {
 
         int _dimension;
 
+    protected:
+        int _elementSize;
+
     public:
         ArrayKlass(ClassLoader *classLoader, mirrorOop javaLoader,
                    int dimension, ClassType classType);
@@ -26,12 +29,21 @@ namespace kivm {
             return _dimension;
         }
 
+        /**
+         * Bytes taken by one element in array objects of this class.
+         */
+        int getElementSize() const {
+            return _elementSize;
+        }
+
         mirrorOop getJavaLoader() {
             return _javaLoader;
         }
 
         void linkAndInit() override;
 
+        void iterateOops(OopClosure *closure) override;
+
         virtual bool isObjectArray() = 0;
     };
 
@@ -60,7 +72,7 @@ namespace kivm {
             return _downDimensionType;
         }
 
-        typeArrayOop newInstance(int length);
+        typeArrayOop newInstance(int length, AllocationSite *site = nullptr);
     };
 
     class ObjectArrayKlass : public ArrayKlass {
@@ -88,6 +100,6 @@ namespace kivm {
             return _downDimensionType;
         }
 
-        objectArrayOop newInstance(int length);
+        objectArrayOop newInstance(int length, AllocationSite *site = nullptr);
     };
 }
@@ -6,28 +6,106 @@
 
 #include <kivm/oop/instanceOop.h>
 #include <kivm/oop/arrayKlass.h>
-#include <vector>
 
 namespace kivm {
+    class OopClosure;
+
+    /**
+     * The length follows the header, then elements are stored contiguously
+     * from the next 8-byte boundary.
+     * Each element takes {@code ArrayKlass::getElementSize()} bytes:
+     * the real width of primitive components, or one reference for
+     * object arrays and multi-dimensional primitive arrays.
+     */
     class arrayOopDesc : public oopDesc {
-    private:
-        std::vector<oop> _elements;
+    protected:
+        inline u1 *getElementBase() const {
+            return (u1 *) this + getBaseOffset();
+        }
+
+        inline void checkIndex(int position) const {
+            if (position < 0 || position >= getLength()) {
+                // TODO: throw ArrayIndexOutOfBoundsException
+                PANIC("java.lang.ArrayIndexOutOfBoundsException");
+            }
+        }
 
     public:
+        /**
+         * Allocate an array of {@code length} elements of {@code arrayClass}.
+         * Elements start zeroed, which is the default value of every Java type.
+         * @param site allocating instruction, may be {@code nullptr}
+         */
+        static void *operator new(size_t size, ArrayKlass *arrayClass, int length,
+                                  AllocationSite *site) noexcept;
+
+        static void operator delete(void *ptr, ArrayKlass *arrayClass, int length, AllocationSite *site) {}
+
         explicit arrayOopDesc(ArrayKlass *arrayClass, oopType type, int length);
 
+        static inline int getLengthOffset() {
+            return oopDesc::getHeaderSize();
+        }
+
+        /**
+         * @return byte offset of the first element
+         */
+        static inline int getBaseOffset() {
+            return (getLengthOffset() + (int) sizeof(jint) + 7) & ~7;
+        }
+
         int getDimension() const;
 
-        int getLength() const;
+        inline int getLength() const {
+            return *(const jint *) ((const u1 *) this + getLengthOffset());
+        }
 
+        /**
+         * Whether elements are references, which is also when
+         * {@code getElementAt()} and {@code setElementAt()} need no boxing.
+         */
+        bool hasReferenceElements() const;
+
+        /**
+         * Get an element, primitive values are boxed.
+         */
         oop getElementAt(int position) const;
 
+        /**
+         * Set an element, primitive values are unboxed.
+         */
         void setElementAt(int position, oop element);
+
+        /**
+         * Visit all elements in this array.
+         * @param closure reference visitor
+         */
+        void iterateOops(OopClosure *closure);
     };
 
     class typeArrayOopDesc : public arrayOopDesc {
     public:
         typeArrayOopDesc(TypeArrayKlass *arrayClass, int length);
+
+        template <typename T>
+        inline T getValueAt(int position) const {
+            checkIndex(position);
+            return ((const T *) getElementBase())[position];
+        }
+
+        template <typename T>
+        inline void setValueAt(int position, T value) {
+            checkIndex(position);
+            ((T *) getElementBase())[position] = value;
+        }
+
+        /**
+         * Raw element storage, valid until the next safepoint.
+         */
+        template <typename T>
+        inline T *getValues() {
+            return (T *) getElementBase();
+        }
     };
 
     class objectArrayOopDesc : public arrayOopDesc {
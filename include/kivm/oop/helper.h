@@ -3,40 +3,103 @@
 //
 #pragma once
 
-#include <vector>
 #include <kivm/oop/primitiveOop.h>
 #include <kivm/field.h>
 #include <kivm/native/java_lang_String.h>
 
 namespace kivm {
-    inline void helperInitField(std::vector<oop> &values, int offset, Field *field) {
-        if (values.size() <= offset) {
-            values.resize((unsigned long) offset + 1);
-        }
-        switch (field->getValueType()) {
+    /**
+     * Bytes taken by an unboxed value of {@code valueType}.
+     */
+    inline int helperValueSize(ValueType valueType) {
+        switch (valueType) {
+            case ValueType::LONG:
+            case ValueType::DOUBLE:
+                return sizeof(jlong);
+            case ValueType::OBJECT:
+            case ValueType::ARRAY:
+                return CompressedOops::getReferenceSize();
             case ValueType::INT:
+            case ValueType::FLOAT:
+                return sizeof(jint);
             case ValueType::SHORT:
             case ValueType::CHAR:
+                return sizeof(jshort);
             case ValueType::BOOLEAN:
             case ValueType::BYTE:
-                values[offset] = new intOopDesc(0);
+                return sizeof(jbyte);
+            case ValueType::VOID:
+                PANIC("Field cannot be typed void");
                 break;
-            case ValueType::LONG:
-                values[offset] = new longOopDesc(0L);
+            default:
+                PANIC("Unrecognized field value type");
                 break;
+        }
+    }
+
+    /**
+     * Read an unboxed value, primitive values are boxed.
+     */
+    inline oop helperLoadValue(ValueType valueType, const u1 *address) {
+        switch (valueType) {
+            case ValueType::OBJECT:
+            case ValueType::ARRAY:
+                return CompressedOops::loadReference(address);
+            case ValueType::INT:
+                return new intOopDesc(*(const jint *) address);
+            case ValueType::SHORT:
+                return new intOopDesc(*(const jshort *) address);
+            case ValueType::CHAR:
+                return new intOopDesc(*(const jchar *) address);
+            case ValueType::BOOLEAN:
+                return new intOopDesc(*(const jboolean *) address);
+            case ValueType::BYTE:
+                return new intOopDesc(*(const jbyte *) address);
+            case ValueType::LONG:
+                return new longOopDesc(*(const jlong *) address);
             case ValueType::FLOAT:
-                values[offset] = new floatOopDesc(0.0f);
-                break;
+                return new floatOopDesc(*(const jfloat *) address);
             case ValueType::DOUBLE:
-                values[offset] = new doubleOopDesc(0.0);
+                return new doubleOopDesc(*(const jdouble *) address);
+            default:
+                PANIC("Unrecognized field value type");
                 break;
+        }
+    }
+
+    /**
+     * Write an unboxed value, boxed primitive values are unboxed.
+     * A null primitive value is stored as zero.
+     */
+    inline void helperStoreValue(ValueType valueType, u1 *address, oop value) {
+        switch (valueType) {
             case ValueType::OBJECT:
             case ValueType::ARRAY:
-                values[offset] = nullptr;
+                CompressedOops::storeReference(address, value);
                 break;
-
-            case ValueType::VOID:
-                PANIC("Field cannot be typed void");
+            case ValueType::INT:
+                *(jint *) address = value == nullptr ? 0 : ((intOop) value)->getValue();
+                break;
+            case ValueType::SHORT:
+                *(jshort *) address = (jshort) (value == nullptr ? 0 : ((intOop) value)->getValue());
+                break;
+            case ValueType::CHAR:
+                *(jchar *) address = (jchar) (value == nullptr ? 0 : ((intOop) value)->getValue());
+                break;
+            case ValueType::BOOLEAN:
+                *(jboolean *) address = (jboolean) (value == nullptr ? 0 : ((intOop) value)->getValue());
+                break;
+            case ValueType::BYTE:
+                *(jbyte *) address = (jbyte) (value == nullptr ? 0 : ((intOop) value)->getValue());
+                break;
+            case ValueType::LONG:
+                *(jlong *) address = value == nullptr ? 0 : ((longOop) value)->getValue();
+                break;
+            case ValueType::FLOAT:
+                *(jfloat *) address = value == nullptr ? 0 : ((floatOop) value)->getValue();
+                break;
+            case ValueType::DOUBLE:
+                *(jdouble *) address = value == nullptr ? 0 : ((doubleOop) value)->getValue();
                 break;
             default:
                 PANIC("Unrecognized field value type");
@@ -44,46 +107,69 @@ namespace kivm {
         }
     }
 
-    inline bool helperInitConstantField(std::vector<oop> &values,
+    /**
+     * Write the ConstantValue attribute of a static field into its slot.
+     * @return {@code false} if the field has no ConstantValue attribute
+     */
+    inline bool helperInitConstantField(u1 *address,
                                         cp_info **pool,
                                         Field *field) {
         ConstantValue_attribute *attr = field->getConstantAttribute();
-        if (attr != nullptr) {
-            cp_info *constant_info = pool[attr->constant_index];
-            switch (constant_info->tag) {
-                case CONSTANT_Long: {
-                    auto *info = (CONSTANT_Long_info *) constant_info;
-                    values.push_back(new longOopDesc(info->get_constant()));
-                    break;
-                }
-                case CONSTANT_Float: {
-                    auto *info = (CONSTANT_Float_info *) constant_info;
-                    values.push_back(new floatOopDesc(info->get_constant()));
-                    break;
-                }
-                case CONSTANT_Double: {
-                    auto *info = (CONSTANT_Double_info *) constant_info;
-                    values.push_back(new doubleOopDesc(info->get_constant()));
-                    break;
-                }
-                case CONSTANT_Integer: {
-                    auto *info = (CONSTANT_Integer_info *) constant_info;
-                    values.push_back(new intOopDesc(info->get_constant()));
-                    break;
-                }
-                case CONSTANT_String: {
-                    // TODO: use runtime constant pool
-                    auto *info = (CONSTANT_String_info *) constant_info;
-                    auto *utf8 = (CONSTANT_Utf8_info *) pool[info->string_index];
-                    values.push_back(java::lang::String::intern(utf8->get_constant()));
-                    break;
-                }
-                default: {
-                    assert(false);
+        if (attr == nullptr) {
+            return false;
+        }
+
+        cp_info *constant_info = pool[attr->constant_index];
+        switch (constant_info->tag) {
+            case CONSTANT_Long: {
+                auto *info = (CONSTANT_Long_info *) constant_info;
+                *(jlong *) address = info->get_constant();
+                break;
+            }
+            case CONSTANT_Float: {
+                auto *info = (CONSTANT_Float_info *) constant_info;
+                *(jfloat *) address = info->get_constant();
+                break;
+            }
+            case CONSTANT_Double: {
+                auto *info = (CONSTANT_Double_info *) constant_info;
+                *(jdouble *) address = info->get_constant();
+                break;
+            }
+            case CONSTANT_Integer: {
+                // int, short, char, byte and boolean constants
+                auto *info = (CONSTANT_Integer_info *) constant_info;
+                jint value = info->get_constant();
+                switch (field->getValueType()) {
+                    case ValueType::SHORT:
+                        *(jshort *) address = (jshort) value;
+                        break;
+                    case ValueType::CHAR:
+                        *(jchar *) address = (jchar) value;
+                        break;
+                    case ValueType::BOOLEAN:
+                        *(jboolean *) address = (jboolean) value;
+                        break;
+                    case ValueType::BYTE:
+                        *(jbyte *) address = (jbyte) value;
+                        break;
+                    default:
+                        *(jint *) address = value;
+                        break;
                 }
+                break;
+            }
+            case CONSTANT_String: {
+                // TODO: use runtime constant pool
+                auto *info = (CONSTANT_String_info *) constant_info;
+                auto *utf8 = (CONSTANT_Utf8_info *) pool[info->string_index];
+                CompressedOops::storeReference(address, java::lang::String::intern(utf8->get_constant()));
+                break;
+            }
+            default: {
+                assert(false);
             }
         }
         return true;
     }
 }
-
@@ -7,6 +7,7 @@
 #include <kivm/oop/oopfwd.h>
 #include <kivm/oop/reflectionSupport.h>
 #include <kivm/runtime/constantPool.h>
+#include <kivm/memory/compressedOops.h>
 #include <shared/monitor.h>
 #include <unordered_map>
 #include <vector>
@@ -43,46 +44,64 @@ namespace kivm {
 
         int _nInstanceFields;
 
+        /**
+         * object size in bytes, header included.
+         * Instance fields are laid out inline after the header.
+         */
+        int _instanceSize;
+
+        /**
+         * byte offsets of all reference fields, including inherited ones.
+         */
+        std::vector<int> _referenceFieldOffsets;
+
         /**
          * all methods in this class.
-         * map<name + " " + descriptor, method>
+         * map<(name, descriptor), method>
          */
-        std::unordered_map<String, Method *> _allMethods;
+        std::unordered_map<SymbolPair, Method *, SymbolPairHash> _allMethods;
 
         /**
          * virtual methods (public or protected methods).
-         * map<name + " " + descriptor, method>
+         * map<(name, descriptor), method>
          */
-        std::unordered_map<String, Method *> _vtable;
+        std::unordered_map<SymbolPair, Method *, SymbolPairHash> _vtable;
 
         /**
          * private or final methods.
-         * map<name + " " + descriptor, method>
+         * map<(name, descriptor), method>
          */
-        std::unordered_map<String, Method *> _pftable;
+        std::unordered_map<SymbolPair, Method *, SymbolPairHash> _pftable;
 
         /**
          * static methods.
-         * map<name + " " + descriptor, method>
+         * map<(name, descriptor), method>
          */
-        std::unordered_map<String, Method *> _stable;
+        std::unordered_map<SymbolPair, Method *, SymbolPairHash> _stable;
 
         /**
          * static fields.
-         * map<className + " " + name + " " + descriptor, <vector-offset, Field*>>
+         * map<(className, name, descriptor), <byte-offset, Field*>>
          */
-        std::unordered_map<String, FieldID *> _staticFields;
+        std::unordered_map<FieldKey, FieldID *, FieldKeyHash> _staticFields;
 
         /**
          * instance fields.
-         * map<className + " " + name + " " + descriptor, <vector-offset, Field*>>
+         * map<(className, name, descriptor), <byte-offset, Field*>>
          */
-        std::unordered_map<String, FieldID *> _instanceFields;
+        std::unordered_map<FieldKey, FieldID *, FieldKeyHash> _instanceFields;
 
         /**
-         * static fields' values.
+         * static fields' values, unboxed and addressed by byte offset.
          */
-        std::vector<oop> _staticFieldValues;
+        u1 *_staticFieldBlock;
+
+        int _staticFieldBlockSize;
+
+        /**
+         * byte offsets of static reference fields in {@code _staticFieldBlock}.
+         */
+        std::vector<int> _staticReferenceOffsets;
 
         /**
          * interfaces
@@ -103,6 +122,13 @@ namespace kivm {
 
         void linkFields(cp_info **pool);
 
+        /**
+         * Move the most accessed fields out of {@code fields},
+         * as many as fit in one cache line from {@code offset}.
+         * @return hot fields, empty without a field profile
+         */
+        std::vector<Field *> selectHotFields(std::vector<Field *> &fields, int offset);
+
         void linkAttributes(cp_info **pool);
 
     public:
@@ -121,16 +147,44 @@ namespace kivm {
             return _signature;
         }
 
+        ClassFile *getClassFile() const {
+            return _classFile;
+        }
+
         RuntimeConstantPool *getRuntimeConstantPool() {
             return &this->_runtimePool;
         }
 
         void linkAndInit() override;
 
-        const std::unordered_map<String, Method *> &getVtable() const {
+        void iterateOops(OopClosure *closure) override;
+
+        const std::unordered_map<SymbolPair, Method *, SymbolPairHash> &getVtable() const {
             return _vtable;
         }
 
+        int getInstanceSize() const {
+            return _instanceSize;
+        }
+
+        const std::vector<int> &getReferenceFieldOffsets() const {
+            return _referenceFieldOffsets;
+        }
+
+        u1 *getStaticFieldBlock() const {
+            return _staticFieldBlock;
+        }
+
+        template <typename T>
+        inline T getStaticFieldAt(int offset) const {
+            return *(const T *) (_staticFieldBlock + offset);
+        }
+
+        template <typename T>
+        inline void setStaticFieldAt(int offset, T value) {
+            *(T *) (_staticFieldBlock + offset) = value;
+        }
+
         /**
          * Search field in this class.
          * @param name Field name
@@ -140,12 +194,20 @@ namespace kivm {
         FieldID *getThisClassField(const String &name,
                                    const String &descriptor) const;
 
+        /**
+         * Search field in this class, as resolution does.
+         * @param name Field name
+         * @param descriptor Field descriptor
+         * @return FieldID if found, otherwise {@code nullptr}
+         */
+        FieldID *getThisClassField(Symbol *name, Symbol *descriptor) const;
+
         /**
          * Get static field offset.
          * @param className Where the wanted field belongs to
          * @param name Field name
          * @param descriptor Field descriptor
-         * @return vector offset if found, otherwise -1
+         * @return byte offset in the static field block if found, otherwise -1
          */
         int getStaticFieldOffset(const String &className,
                                  const String &name,
@@ -162,12 +224,19 @@ namespace kivm {
                                     const String &name,
                                     const String &descriptor) const;
 
+        /**
+         * Get static field info.
+         * @param key Where the wanted field belongs to, its name and descriptor
+         * @return FieldID if found, otherwise {@code nullptr}
+         */
+        FieldID *getStaticFieldInfo(const FieldKey &key) const;
+
         /**
          * Get instance field offset.
          * @param className Where the wanted field belongs to
          * @param name Field name
          * @param descriptor Field descriptor
-         * @return vector offset if found, otherwise -1
+         * @return byte offset in the object if found, otherwise -1
          */
         int getInstanceFieldOffset(const String &className,
                                    const String &name,
@@ -184,6 +253,13 @@ namespace kivm {
                                       const String &name,
                                       const String &descriptor) const;
 
+        /**
+         * Get instance field info.
+         * @param key Where the wanted field belongs to, its name and descriptor
+         * @return FieldID if found, otherwise {@code nullptr}
+         */
+        FieldID *getInstanceFieldInfo(const FieldKey &key) const;
+
         /**
          * Search method in this class.
          * @param name Method name
@@ -192,6 +268,14 @@ namespace kivm {
          */
         Method *getThisClassMethod(const String &name, const String &descriptor) const;
 
+        /**
+         * Search method in this class, as resolution does.
+         * @param name Method name
+         * @param descriptor Method descriptor
+         * @return method pointer if found, otherwise {@code nullptr}
+         */
+        Method *getThisClassMethod(Symbol *name, Symbol *descriptor) const;
+
         /**
          * Get virtual method.
          * @param name Method name
@@ -309,6 +393,16 @@ namespace kivm {
          */
         bool getInstanceFieldValue(instanceOop receiver, FieldID *fieldID, oop *result);
 
-        instanceOop newInstance();
+        instanceOop newInstance(AllocationSite *site = nullptr);
     };
+
+    template <>
+    inline oop InstanceKlass::getStaticFieldAt<oop>(int offset) const {
+        return CompressedOops::loadReference(_staticFieldBlock + offset);
+    }
+
+    template <>
+    inline void InstanceKlass::setStaticFieldAt<oop>(int offset, oop value) {
+        CompressedOops::storeReference(_staticFieldBlock + offset, value);
+    }
 }
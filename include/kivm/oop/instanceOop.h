@@ -5,23 +5,49 @@
 
 #include <kivm/oop/oop.h>
 #include <kivm/oop/instanceKlass.h>
-#include <vector>
 
 namespace kivm {
+    class OopClosure;
+
+    /**
+     * Instance fields are stored unboxed right after the header,
+     * at the byte offsets computed by {@code InstanceKlass::linkFields()}.
+     */
     class instanceOopDesc : public oopDesc {
         friend class InstanceKlass;
 
-        std::vector<oop> _instanceFieldValues;
-
     public:
+        /**
+         * Allocate an object large enough for all fields of {@code klass}.
+         * Fields start zeroed, which is the default value of every Java type.
+         * @param site allocating instruction, may be {@code nullptr}
+         */
+        static void *operator new(size_t size, InstanceKlass *klass, AllocationSite *site) noexcept;
+
+        static void operator delete(void *ptr, InstanceKlass *klass, AllocationSite *site) {}
+
         explicit instanceOopDesc(InstanceKlass *klass);
 
-        ~instanceOopDesc() override = default;
+        template <typename T>
+        inline T getFieldAt(int offset) const {
+            return *(const T *) ((const u1 *) this + offset);
+        }
+
+        template <typename T>
+        inline void setFieldAt(int offset, T value) {
+            *(T *) ((u1 *) this + offset) = value;
+        }
 
         inline InstanceKlass *getInstanceClass() const {
             return (InstanceKlass *) getClass();
         }
 
+        /**
+         * Visit all reference slots in this object.
+         * @param closure reference visitor
+         */
+        void iterateOops(OopClosure *closure);
+
         /**
          * Mirrored from {@code InstanceKlass}
          * Set instance field's value.
@@ -75,4 +101,14 @@ namespace kivm {
             return getInstanceClass()->getInstanceFieldValue(this, fieldID, result);
         }
     };
+
+    template <>
+    inline oop instanceOopDesc::getFieldAt<oop>(int offset) const {
+        return CompressedOops::loadReference((const u1 *) this + offset);
+    }
+
+    template <>
+    inline void instanceOopDesc::setFieldAt<oop>(int offset, oop value) {
+        CompressedOops::storeReference((u1 *) this + offset, value);
+    }
 }
\ No newline at end of file
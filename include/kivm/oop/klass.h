@@ -8,8 +8,11 @@
 #include <kivm/classfile/classFile.h>
 #include <kivm/classLoader.h>
 #include <kivm/oop/oopfwd.h>
+#include <kivm/symbol.h>
 
 namespace kivm {
+    class OopClosure;
+
     enum ClassType {
         INSTANCE_CLASS,
         OBJECT_ARRAY_CLASS,
@@ -32,6 +35,7 @@ namespace kivm {
 
     protected:
         String _name;
+        Symbol *_nameSymbol;
         ClassType _type;
 
         mirrorOop _javaMirror;
@@ -66,8 +70,13 @@ namespace kivm {
             return _name;
         }
 
+        Symbol *getNameSymbol() const {
+            return _nameSymbol;
+        }
+
         void setName(const String &name) {
             this->_name = name;
+            this->_nameSymbol = SymbolTable::get()->lookup(name);
         }
 
         ClassType getClassType() const {
@@ -111,11 +120,24 @@ namespace kivm {
         }
 
     public:
+        /**
+         * Classes live in the class space when class pointers are compressed.
+         */
+        static void *operator new(size_t size);
+
+        static void operator delete(void *ptr);
+
         Klass();
 
         virtual ~Klass() = default;
 
         virtual void linkAndInit() = 0;
+
+        /**
+         * Visit all references held by this class.
+         * @param closure reference visitor
+         */
+        virtual void iterateOops(OopClosure *closure);
     };
 }
 
@@ -8,40 +8,35 @@
 #include <kivm/oop/oopfwd.h>
 #include <kivm/oop/klass.h>
 #include <shared/lock.h>
-#include <shared/monitor.h>
-#include <list>
+#include <kivm/runtime/objectMonitor.h>
+#include <kivm/memory/compressedOops.h>
+#include <atomic>
 
 // Forward declaration
 
 namespace kivm {
-    class oopPool {
-    public:
-        static std::list<oop> &getOopHandlerPool() {
-            static std::list<oop> handlerPool;
-            return handlerPool;
-        }
-    };
-
     class oopBase {
-    private:
-        static Lock &getOopMemoryLock() {
-            static Lock memLock;
-            return memLock;
-        }
-
     public:
         oopBase() = default;
 
-        virtual ~oopBase() = default;
-
-        static void *allocate(size_t size, bool addToPool);
-
+        /**
+         * Allocate memory for an object in the Java heap.
+         * @param size object size
+         * @param site allocating instruction, may be {@code nullptr}
+         * @return zero-filled memory
+         */
+        static void *allocate(size_t size, AllocationSite *site = nullptr);
+
+        /**
+         * Objects are reclaimed by the garbage collector,
+         * so this does nothing.
+         */
         static void deallocate(void *ptr);
 
-        static void *operator new(size_t size, bool = true) noexcept;
+        static void *operator new(size_t size) noexcept;
 
         static void *operator new(size_t size, const std::nothrow_t &) noexcept { exit(-2); }        // do not use it.
-        static void *operator new[](size_t size, bool = true) throw();
+        static void *operator new[](size_t size) throw();
 
         static void *operator new[](size_t size, const std::nothrow_t &) noexcept { exit(-2); }        // do not use it.
         static void operator delete(void *ptr);
@@ -51,51 +46,180 @@ namespace kivm {
         static void cleanup();
     };
 
+    /**
+     * The mark word, stored inline in every object header.
+     *
+     *  63              56 55           39 38            8 7     4 3         2 1      0
+     *  [ recursions:8    | owner:17      | hash:31       | age:4 | oopType:2 | lock:2 ]  thin locked
+     *  [ monitor index:25                | hash:31       | age:4 | oopType:2 | lock:2 ]  inflated
+     *
+     * A lock is thin until it is contended, waited on or nested too deep.
+     * Then a heavyweight monitor is taken from {@code MonitorTable}.
+     * The identity hash is installed on first use, 0 means not yet hashed.
+     */
     class markOopDesc {
+    public:
+        enum LockState {
+            UNLOCKED = 0,
+            THIN_LOCKED = 1,
+            INFLATED = 2,
+        };
+
     private:
-        oopType _type;
-        Monitor _monitor;
+        static const u8 LOCK_MASK = 0x3;
+        static const int TYPE_SHIFT = 2;
+        static const u8 TYPE_MASK = 0x3;
+        static const int AGE_SHIFT = 4;
+        static const u8 AGE_MASK = 0xf;
+        static const int HASH_SHIFT = 8;
+        static const u8 HASH_MASK = 0x7fffffff;
+        static const int MONITOR_SHIFT = 39;
+        static const u8 MONITOR_MASK = 0x1ffffff;
+        static const int OWNER_SHIFT = 39;
+        static const u8 OWNER_MASK = 0x1ffff;
+        static const int RECURSION_SHIFT = 56;
+        static const u8 RECURSION_MASK = 0xff;
+
+        // bits shared by thin lock owner and monitor index
+        static const u8 LOCK_FIELDS = LOCK_MASK | (MONITOR_MASK << MONITOR_SHIFT);
+
+        std::atomic<u8> _value;
+
+        static inline u4 getOwner(u8 value) {
+            return (u4) ((value >> OWNER_SHIFT) & OWNER_MASK);
+        }
+
+        static inline u4 getRecursions(u8 value) {
+            return (u4) ((value >> RECURSION_SHIFT) & RECURSION_MASK);
+        }
+
+        ObjectMonitor *inflate();
+
+        void monitorEnterSlow();
+
+        void monitorExitSlow();
+
+        u4 installIdentityHash();
 
     public:
-        markOopDesc(oopType type);
+        static const int MAX_AGE = (int) AGE_MASK;
+
+        explicit markOopDesc(oopType type)
+            : _value((u8) type << TYPE_SHIFT) {
+        }
+
+        oopType getOopType() const {
+            return (oopType) ((_value.load(std::memory_order_relaxed) >> TYPE_SHIFT) & TYPE_MASK);
+        }
+
+        LockState getLockState() const {
+            return (LockState) (_value.load() & LOCK_MASK);
+        }
+
+        int getAge() const {
+            return (int) ((_value.load(std::memory_order_relaxed) >> AGE_SHIFT) & AGE_MASK);
+        }
+
+        void setAge(int age);
+
+        /**
+         * Get the identity hash, generating and installing one if the object has none.
+         * Objects move together with their header, so the hash survives compaction.
+         * Locking never touches the hash bits, so this does not inflate.
+         * @return a positive hash, stable for the lifetime of the object
+         */
+        inline u4 getIdentityHash() {
+            u4 hash = (u4) ((_value.load(std::memory_order_relaxed) >> HASH_SHIFT) & HASH_MASK);
+            return hash != 0 ? hash : installIdentityHash();
+        }
+
+        bool isInflated() const {
+            return getLockState() == INFLATED;
+        }
 
-        oopType getOopType() const { return _type; }
+        u4 getMonitorIndex() const {
+            return (u4) ((_value.load() >> MONITOR_SHIFT) & MONITOR_MASK);
+        }
 
-        void monitorEnter() {
-            _monitor.enter();
-            D("MonitorEntered");
+        /**
+         * @return {@code true} if current thread holds the lock
+         */
+        bool isLockedByCurrentThread();
+
+        /**
+         * Return the monitor of a dead object to the monitor table.
+         */
+        void deflate();
+
+        inline void monitorEnter() {
+            u8 value = _value.load(std::memory_order_relaxed);
+            if ((value & LOCK_MASK) == UNLOCKED) {
+                u8 self = currentLockOwner();
+                if (self <= OWNER_MASK
+                    && _value.compare_exchange_strong(value, value | THIN_LOCKED | (self << OWNER_SHIFT),
+                                                      std::memory_order_acquire)) {
+                    return;
+                }
+            }
+            monitorEnterSlow();
         }
 
-        void monitorExit() {
-            _monitor.leave();
-            D("MonitorExited");
+        inline void monitorExit() {
+            u8 value = _value.load(std::memory_order_relaxed);
+            if ((value & (LOCK_MASK | (RECURSION_MASK << RECURSION_SHIFT))) == THIN_LOCKED
+                && getOwner(value) == currentLockOwner()
+                && _value.compare_exchange_strong(value, value & ~LOCK_FIELDS,
+                                                  std::memory_order_release)) {
+                return;
+            }
+            monitorExitSlow();
         }
 
-        void wait() { _monitor.wait(); }
+        void wait() { wait(0); }
 
-        void wait(long macro_sec) { _monitor.wait(macro_sec); }
+        void wait(long macro_sec);
 
-        void notify() { _monitor.notify(); }
+        void notify();
 
-        void notifyAll() { _monitor.notify_all(); }
+        void notifyAll();
 
-        void forceUnlockWhenExceptionOccurred() { _monitor.force_unlock_when_athrow(); }
+        void forceUnlockWhenExceptionOccurred();
     };
 
     typedef markOopDesc *markOop;
 
+    /**
+     * Object header: the mark word and the class pointer, nothing else.
+     * Objects have no vtable, the heap dispatches on oopType instead.
+     * A compressed class pointer takes only the first half of its slot,
+     * the other half is given to fields or the array length.
+     */
     class oopDesc : public oopBase {
     private:
-        markOop _mark;
-        Klass *_klass;
+        markOopDesc _mark;
+        union {
+            Klass *_klass;
+            narrowKlass _narrowKlass;
+        } _metadata;
 
     public:
         explicit oopDesc(Klass *klass, oopType type);
 
-        ~oopDesc() override;
+        /**
+         * @return bytes taken by the header, where fields or the array length start
+         */
+        static inline int getHeaderSize() {
+            return CompressedOops::useCompressedClassPointers()
+                   ? (int) (sizeof(markOopDesc) + sizeof(narrowKlass))
+                   : (int) sizeof(oopDesc);
+        }
 
-        markOop getMarkOop() const { return _mark; }
+        markOop getMarkOop() { return &_mark; }
 
-        Klass *getClass() const { return _klass; }
+        Klass *getClass() const {
+            return CompressedOops::useCompressedClassPointers()
+                   ? CompressedOops::decodeKlass(_metadata._narrowKlass)
+                   : _metadata._klass;
+        }
     };
 }
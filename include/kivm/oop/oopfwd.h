@@ -45,6 +45,8 @@ namespace kivm {
 
     class doubleOopDesc;
 
+    class AllocationSite;
+
     using oop = oopDesc *;
     using instanceOop = instanceOopDesc *;
     using mirrorOop = mirrorOopDesc *;
@@ -15,6 +15,8 @@
 namespace kivm {
     class Klass;
 
+    class OopClosure;
+
     class InstanceKlass;
 
     class RuntimeConstantPool;
@@ -25,7 +27,8 @@ namespace kivm {
         using MethodPoolEntry = Method *;
         using FieldPoolEntry = FieldID *;
         using Utf8PoolEntry = String;
-        using NameAndTypePoolEntry = std::pair<Utf8PoolEntry, Utf8PoolEntry>;
+        using SymbolPoolEntry = Symbol *;
+        using NameAndTypePoolEntry = SymbolPair;
 
         template<typename T, typename Creator, int CONSTANT_TAG>
         class Pool {
@@ -54,6 +57,13 @@ namespace kivm {
                 _pool.insert(std::make_pair(index, created));
                 return created;
             }
+
+            template<typename Fn>
+            inline void forEach(Fn fn) {
+                for (auto &entry : _pool) {
+                    fn(entry.second);
+                }
+            }
         };
 
         template<typename PrimitiveType, typename EntryType>
@@ -80,6 +90,10 @@ namespace kivm {
             FieldPoolEntry operator()(RuntimeConstantPool *rt, cp_info **pool, int index);
         };
 
+        struct SymbolCreator {
+            SymbolPoolEntry operator()(RuntimeConstantPool *rt, cp_info **pool, int index);
+        };
+
         struct NameAndTypeCreator {
             NameAndTypePoolEntry operator()(RuntimeConstantPool *rt, cp_info **pool, int index);
         };
@@ -89,6 +103,7 @@ namespace kivm {
         using LongPool = Pool<jlong, PrimitiveConstantCreator<jlong, CONSTANT_Long_info>, CONSTANT_Long>;
         using DoublePool = Pool<jdouble, PrimitiveConstantCreator<jdouble, CONSTANT_Double_info>, CONSTANT_Double>;
         using Utf8Pool = Pool<Utf8PoolEntry, PrimitiveConstantCreator<Utf8PoolEntry, CONSTANT_Utf8_info>, CONSTANT_Utf8>;
+        using SymbolPool = Pool<SymbolPoolEntry, SymbolCreator, CONSTANT_Utf8>;
         using NameAndTypePool = Pool<NameAndTypePoolEntry, NameAndTypeCreator, CONSTANT_NameAndType>;
 
         using ClassPool = Pool<ClassPoolEntey, ClassCreator, CONSTANT_Class>;
@@ -109,6 +124,7 @@ namespace kivm {
         pools::InterfaceMethodPool _interfaceMethodPool;
         pools::NameAndTypePool _nameAndTypePool;
         pools::Utf8Pool _utf8Pool;
+        pools::SymbolPool _symbolPool;
         pools::IntegerPool _intPool;
         pools::FloatPool _floatPool;
         pools::LongPool _longPool;
@@ -129,9 +145,20 @@ namespace kivm {
             _longPool.setRawPool(pool);
             _doublePool.setRawPool(pool);
             _utf8Pool.setRawPool(pool);
+            _symbolPool.setRawPool(pool);
             _nameAndTypePool.setRawPool(pool);
         }
 
+        /**
+         * Visit all resolved string constants.
+         * @param closure reference visitor
+         */
+        void iterateOops(OopClosure *closure);
+
+        inline cp_info **getRawPool() {
+            return _rawPool;
+        }
+
         inline int getConstantTag(int index) {
             return _rawPool[index]->tag;
         }
@@ -166,6 +193,11 @@ namespace kivm {
             return _utf8Pool.findOrNew(this, index);
         }
 
+        inline pools::SymbolPoolEntry getSymbol(int index) {
+            assert(this->_rawPool != nullptr);
+            return _symbolPool.findOrNew(this, index);
+        }
+
         inline pools::NameAndTypePoolEntry getNameAndType(int index) {
             assert(this->_rawPool != nullptr);
             return _nameAndTypePool.findOrNew(this, index);
@@ -0,0 +1,59 @@
+//
+// Created by kiva on 2018/4/25.
+//
+#pragma once
+
+#include <kivm/kivm.h>
+#include <unordered_map>
+
+namespace kivm {
+    class Field;
+
+    class InstanceKlass;
+
+    /**
+     * Per-field access counts, written at exit by one run
+     * and read back by a later one to pick the fields
+     * that share a cache line with the object header.
+     *
+     * The profile is a text file with one field per line:
+     * {@code <count> <class> <name> <descriptor>}
+     */
+    class FieldProfile {
+    private:
+        std::unordered_map<String, u8> _counts;
+        bool _recording;
+
+        FieldProfile();
+
+    public:
+        static const int CACHE_LINE_SIZE = 64;
+
+        static FieldProfile *get();
+
+        inline bool isRecording() const {
+            return _recording;
+        }
+
+        bool hasProfile() const {
+            return !_counts.empty();
+        }
+
+        /**
+         * @return recorded accesses of a field declared in {@code klass}, 0 if never seen
+         */
+        u8 getCount(InstanceKlass *klass, const Field *field) const;
+
+        /**
+         * Read a profile, adding its counts to the ones already loaded.
+         * @return false if the file cannot be read
+         */
+        bool load(const std::string &path);
+
+        /**
+         * Write the counts of every linked field that was accessed.
+         * @return false if the file cannot be written
+         */
+        bool save(const std::string &path) const;
+    };
+}
@@ -9,6 +9,8 @@
 namespace kivm {
     class Method;
 
+    class RootClosure;
+
     class Frame {
         friend class FrameList;
 
@@ -30,6 +32,10 @@ namespace kivm {
             return _method;
         }
 
+        Frame *getPrevious() const {
+            return _previous;
+        }
+
         bool isNativeFrame() const {
             return _nativeFrame;
         }
@@ -65,6 +71,18 @@ namespace kivm {
         void setReturnPc(u4 _return_pc) {
             this->_returnPc = _return_pc;
         }
+
+        /**
+         * Visit all slots that may hold references.
+         * Slots are untyped, so reference maps of the method tell which
+         * slots hold references at pc. Frames without a precise map
+         * are reported as conservative roots.
+         * @param closure root visitor
+         * @param pc pc of the frame
+         * @param atInstructionStart {@code true} if the frame stopped before the instruction at pc,
+         *        {@code false} if it stopped inside the instruction ending at pc
+         */
+        void iterateRoots(RootClosure *closure, u4 pc, bool atInstructionStart);
     };
 
     struct FrameList {
@@ -110,6 +128,10 @@ namespace kivm {
             return _current;
         }
 
+        inline Frame *getCurrentFrameOrNull() const {
+            return _current;
+        }
+
         inline int getSize() const {
             return this->_size;
         }
@@ -0,0 +1,59 @@
+//
+// Created by kiva on 2018/4/23.
+//
+#pragma once
+
+#include <kivm/kivm.h>
+#include <shared/lock.h>
+#include <kivm/runtime/objectMonitor.h>
+#include <atomic>
+#include <vector>
+
+namespace kivm {
+    /**
+     * Side table of heavyweight monitors.
+     * Objects refer to their monitor by index in the mark word,
+     * so monitors stay valid when the collector moves objects.
+     */
+    class MonitorTable {
+    private:
+        static const u4 CHUNK_SHIFT = 10;
+        static const u4 CHUNK_SIZE = 1u << CHUNK_SHIFT;
+
+        // Chunks are never freed, so lookups need no lock.
+        std::atomic<ObjectMonitor *> *_chunks;
+        u4 _maxChunks;
+        u4 _nextIndex;
+        std::vector<u4> _freeList;
+        Lock _lock;
+
+        explicit MonitorTable(u4 maxMonitors);
+
+    public:
+        /**
+         * Indexes must fit in the monitor field of the mark word.
+         */
+        static const u4 MAX_MONITORS = 1u << 25;
+
+        static MonitorTable *get();
+
+        /**
+         * Take an unused monitor.
+         * @return index of the monitor, never 0
+         */
+        u4 allocate();
+
+        /**
+         * Return a monitor of a dead object to the table.
+         * @param index monitor index
+         */
+        void release(u4 index);
+
+        inline ObjectMonitor *getMonitor(u4 index) const {
+            ObjectMonitor *chunk = _chunks[index >> CHUNK_SHIFT].load(std::memory_order_acquire);
+            return &chunk[index & (CHUNK_SIZE - 1)];
+        }
+
+        u4 getInUseCount();
+    };
+}
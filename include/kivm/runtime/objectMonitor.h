@@ -0,0 +1,69 @@
+//
+// Created by kiva on 2018/4/23.
+//
+#pragma once
+
+#include <kivm/kivm.h>
+#include <condition_variable>
+#include <mutex>
+
+namespace kivm {
+    /**
+     * Small integer identifying the current native thread as a lock owner.
+     * Ids are recycled when threads exit.
+     * @return id of current thread, never 0
+     */
+    u4 currentLockOwner();
+
+    /**
+     * Heavyweight monitor of an inflated lock.
+     * Reentrant, with an entry queue for contenders and a wait set.
+     */
+    class ObjectMonitor {
+    private:
+        std::mutex _mutex;
+        std::condition_variable _entryQueue;
+        std::condition_variable _waitSet;
+
+        u4 _owner;
+        u4 _recursions;
+        u4 _contenders;
+        u4 _waiters;
+
+        void acquire(std::unique_lock<std::mutex> &guard, u4 self);
+
+    public:
+        ObjectMonitor();
+
+        ObjectMonitor(const ObjectMonitor &) = delete;
+
+        /**
+         * Called when the monitor is inflated from a thin lock,
+         * before other threads can see it.
+         * @param owner owner of the thin lock, or 0 when unlocked
+         * @param recursions times the owner entered besides the first
+         */
+        void reset(u4 owner, u4 recursions);
+
+        void enter();
+
+        void leave();
+
+        /**
+         * Release the monitor completely and wait for a notification.
+         * @param millis timeout, 0 to wait forever
+         */
+        void wait(long millis);
+
+        void notify();
+
+        void notifyAll();
+
+        /**
+         * Release the monitor whatever the recursion count is.
+         */
+        void forceLeave();
+
+        bool isOwnedBy(u4 owner);
+    };
+}
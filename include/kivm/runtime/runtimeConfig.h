@@ -3,14 +3,163 @@
 //
 #pragma once
 
+#include <cstddef>
+#include <string>
+
 namespace kivm {
+    enum class SharingMode {
+        OFF,
+        // use the class data archive if it matches the class path
+        AUTO,
+        // write the class data archive and exit
+        DUMP,
+    };
+
     struct RuntimeConfig {
         int threadInitialStackSize;
         int threadMaxStackSize;
 
+        /**
+         * The heap reserves {@code maxHeapSize} of address space up front,
+         * 32 GB at most, and commits {@code initialHeapSize} of it, the rest as it grows.
+         */
+        size_t initialHeapSize;
+        size_t maxHeapSize;
+
+        /**
+         * Objects of at least this many bytes, in practice arrays,
+         * are mapped one by one and never moved. 0 disables it.
+         * Ignored with compressed oops, which need every object inside the heap range.
+         */
+        size_t largeObjectThreshold;
+
+        /**
+         * Back the heap with transparent huge pages where the system supports them.
+         */
+        bool useTransparentHugePages;
+
+        /**
+         * Touch the initial heap at startup instead of faulting it in on first use.
+         */
+        bool alwaysPreTouch;
+
+        /**
+         * Store references in the heap as 32-bit offsets from the heap base.
+         * Ignored when {@code maxHeapSize} exceeds 32 GB.
+         */
+        bool useCompressedOops;
+
+        /**
+         * Store class pointers in object headers as 32-bit offsets
+         * into a class space of {@code compressedClassSpaceSize} bytes.
+         */
+        bool useCompressedClassPointers;
+        size_t compressedClassSpaceSize;
+
+        /**
+         * Where to write GETFIELD/PUTFIELD counts when the VM exits.
+         * Empty disables recording.
+         */
+        std::string fieldProfileOutput;
+
+        /**
+         * Field profile of an earlier run, used to lay out hot fields first.
+         * Empty keeps the default layout.
+         */
+        std::string fieldProfileInput;
+
+        /**
+         * Allocate objects of sites whose objects tend to survive
+         * straight into the tenured space.
+         */
+        bool usePretenuring;
+
+        /**
+         * Where to write the pretenured allocation sites when the VM exits.
+         * Empty disables writing.
+         */
+        std::string pretenureProfileOutput;
+
+        /**
+         * Pretenured allocation sites of an earlier run, tenured from the start.
+         */
+        std::string pretenureProfileInput;
+
+        /**
+         * Print each allocation site when it starts to be pretenured.
+         */
+        bool printPretenuring;
+
+        /**
+         * Rebuild the class path index when class path directories change.
+         */
+        bool watchClassPath;
+
+        /**
+         * Whether to use a class data archive, or to write one and exit.
+         */
+        SharingMode sharingMode;
+
+        /**
+         * The class data archive, mapped at startup or written by a dump.
+         * Empty disables class data sharing.
+         */
+        std::string sharedArchiveFile;
+
+        /**
+         * Classes to write into the class data archive, one per line.
+         * Also prefetched at startup when prefetching classes.
+         */
+        std::string sharedClassListFile;
+
+        /**
+         * Parse class files on worker threads before they are asked for.
+         */
+        bool prefetchClasses;
+
+        /**
+         * Worker threads parsing prefetched class files.
+         */
+        int prefetchThreads;
+
+        /**
+         * Where reference maps of methods are kept across runs,
+         * keyed by the class file they were computed from.
+         * Empty computes them in every run.
+         */
+        std::string oopMapCacheDirectory;
+
+        /**
+         * Print class path lookup counts and timings when the VM exits.
+         */
+        bool printClassPathStatistics;
+
+        /**
+         * Print safepoint counts and pause times when the VM exits.
+         */
+        bool printSafepointStatistics;
+
         static RuntimeConfig& get();
 
+        /**
+         * Parse a size like {@code 512m}, with an optional k, m or g suffix.
+         * @return size in bytes, 0 if malformed
+         */
+        static size_t parseSize(const std::string &value);
+
         RuntimeConfig();
+
+        /**
+         * Apply a command line option:
+         * {@code -Xms<size>}, {@code -Xmx<size>},
+         * {@code -XX:CompressedClassSpaceSize=<size>}, {@code -XX:LargeObjectThreshold=<size>},
+         * {@code -Xshare:off|auto|dump}, {@code -XX:SharedArchiveFile=<path>},
+         * {@code -XX:SharedClassListFile=<path>}, {@code -XX:PrefetchThreads=<count>},
+         * {@code -XX:OopMapCacheDirectory=<path>} or {@code -XX:[+-]<flag>}
+         * for the boolean options above.
+         * @return {@code false} if the option is unknown or malformed
+         */
+        bool parseOption(const std::string &option);
     };
 }
 
@@ -0,0 +1,128 @@
+//
+// Created by kiva on 2018/4/22.
+//
+#pragma once
+
+#include <kivm/kivm.h>
+#include <kivm/runtime/thread.h>
+#include <atomic>
+
+namespace kivm {
+    struct SafepointStatistics {
+        u8 safepoints;
+
+        /**
+         * Nanoseconds from the request until all other threads stopped.
+         */
+        u8 totalTimeToSafepoint;
+        u8 maxTimeToSafepoint;
+
+        /**
+         * Nanoseconds from the request until other threads resumed.
+         */
+        u8 totalPauseTime;
+        u8 maxPauseTime;
+    };
+
+    /**
+     * Brings all Java threads to a known state.
+     *
+     * The requesting thread raises a global flag. Threads running Java code
+     * poll the flag at method entry and backward branches, threads in safe states
+     * (see {@code ExecutionState}) are stopped already and block when they leave.
+     * Once all threads are stopped, their frames and native stacks can be walked.
+     */
+    class Safepoint {
+    private:
+        static std::atomic<bool> _pollRequested;
+
+        static void stop(Thread *thread);
+
+        static void park(Thread *thread, ExecutionState previous);
+
+        static void publishState(Thread *thread, ExecutionState state);
+
+        static bool allThreadsStopped(Thread *requester);
+
+    public:
+        static inline bool isPollRequested() {
+            // The slow path rechecks the flag, a stale read only delays the stop.
+            return _pollRequested.load(std::memory_order_relaxed);
+        }
+
+        /**
+         * Stop here if a safepoint is requested.
+         * Only called where frames of the thread can be walked,
+         * before the instruction at the pc of the thread.
+         */
+        static inline void poll(Thread *thread) {
+            if (isPollRequested()) {
+                stop(thread);
+            }
+        }
+
+        /**
+         * Change execution state of the current thread.
+         * Entering a safe state records the native stack, all references
+         * must be held in frames or on the stack before that.
+         * Leaving a safe state waits for the running safepoint to end.
+         */
+        static void transition(Thread *thread, ExecutionState state);
+
+        /**
+         * Stop all other threads. Returns when they are all in safe states.
+         * Safepoints are serialized, a second requester waits in a safe state.
+         */
+        static void begin();
+
+        /**
+         * Resume all threads stopped by {@code begin()}.
+         */
+        static void end();
+
+        static SafepointStatistics getStatistics();
+
+        /**
+         * Print safepoint counts and timings to stderr.
+         */
+        static void printStatistics();
+    };
+
+    class SafepointScope {
+    public:
+        SafepointScope() {
+            Safepoint::begin();
+        }
+
+        ~SafepointScope() {
+            Safepoint::end();
+        }
+
+        SafepointScope(const SafepointScope &) = delete;
+    };
+
+    /**
+     * Change execution state of a thread in current scope.
+     */
+    class ThreadStateTransition {
+    private:
+        Thread *_thread;
+        ExecutionState _previous;
+
+    public:
+        ThreadStateTransition(Thread *thread, ExecutionState state)
+            : _thread(thread), _previous(thread->getExecutionState()) {
+            if (_previous != state) {
+                Safepoint::transition(_thread, state);
+            }
+        }
+
+        ~ThreadStateTransition() {
+            if (_thread->getExecutionState() != _previous) {
+                Safepoint::transition(_thread, _previous);
+            }
+        }
+
+        ThreadStateTransition(const ThreadStateTransition &) = delete;
+    };
+}
@@ -83,6 +83,14 @@ namespace kivm {
             return _elements[position].ref;
         }
 
+        inline jobject *getReferenceAddress(int position) {
+            return &_elements[position].ref;
+        }
+
+        inline int getSize() const {
+            return _size;
+        }
+
     public:
         virtual ~SlotArray();
     };
@@ -132,6 +140,18 @@ namespace kivm {
         inline void dropTop() {
             --_sp;
         }
+
+        inline int getSp() const {
+            return _sp;
+        }
+
+        inline jobject getReference(int position) {
+            return _array.getReference(position);
+        }
+
+        inline jobject *getReferenceAddress(int position) {
+            return _array.getReferenceAddress(position);
+        }
     };
 
     class Locals {
@@ -182,6 +202,14 @@ namespace kivm {
         inline jobject getReference(int position) {
             return _array.getReference(position);
         }
+
+        inline jobject *getReferenceAddress(int position) {
+            return _array.getReferenceAddress(position);
+        }
+
+        inline int getSize() const {
+            return _array.getSize();
+        }
     };
 }
 
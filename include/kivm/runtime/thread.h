@@ -6,17 +6,37 @@
 #include <kivm/oop/instanceOop.h>
 #include <kivm/runtime/stack.h>
 #include <kivm/runtime/frame.h>
+#include <atomic>
+#include <csetjmp>
 #include <list>
 #include <thread>
 
 namespace kivm {
+    class RootClosure;
+
     enum ThreadState {
         RUNNING, BLOCKED, DIED
     };
 
+    /**
+     * What a thread is executing, used by the safepoint protocol.
+     * NEW, IN_NATIVE, BLOCKED and TERMINATED are safe states:
+     * the thread does not touch the heap until it leaves them,
+     * so the VM may stop the world without its cooperation.
+     */
+    enum class ExecutionState {
+        NEW,
+        IN_VM,
+        IN_JAVA,
+        IN_NATIVE,
+        BLOCKED,
+        TERMINATED,
+    };
+
     class Thread {
         friend class Threads;
         friend class ByteCodeInterpreter;
+        friend class Safepoint;
 
     protected:
         instanceOop _javaThreadObject;
@@ -28,6 +48,24 @@ namespace kivm {
         std::list<oop> _args;
         u4 _pc;
 
+        /**
+         * {@code true} while the thread stops before the instruction at {@code _pc},
+         * at method entry or a backward branch. Anywhere else, the interpreter
+         * is inside the instruction ending at {@code _pc}.
+         */
+        bool _pcAtInstructionStart;
+
+        std::atomic<ExecutionState> _executionState;
+
+        /**
+         * Native stack of a thread in a safe state:
+         * callee-saved registers and the stack range [_stackAnchor, _stackBase).
+         * Scanned conservatively while the thread is stopped.
+         */
+        jmp_buf _savedRegisters;
+        void *_stackAnchor;
+        void *_stackBase;
+
         virtual void start() = 0;
 
         virtual bool shouldRecordInThreadTable();
@@ -42,6 +80,12 @@ namespace kivm {
         }
 
     public:
+        /**
+         * Get the VM thread running on current native thread.
+         * @return current thread, or {@code nullptr} if it is not created by VM
+         */
+        static Thread *current();
+
         Thread(Method *method, const std::list<oop> &args);
 
         virtual ~Thread();
@@ -63,6 +107,20 @@ namespace kivm {
         void setThreadState(ThreadState threadState) {
             Thread::_state = threadState;
         }
+
+        ExecutionState getExecutionState() const {
+            return _executionState.load();
+        }
+
+        static bool isSafeState(ExecutionState state) {
+            return state != ExecutionState::IN_VM && state != ExecutionState::IN_JAVA;
+        }
+
+        /**
+         * Visit the thread object, arguments and all Java frames.
+         * @param closure root visitor
+         */
+        void iterateRoots(RootClosure *closure);
     };
 
     // The Java app thread
@@ -93,13 +151,15 @@ namespace kivm {
     };
 
     class Threads {
+        friend class Safepoint;
+
     private:
         static int &getAppThreadCount() {
             static int appThreadCount;
             return appThreadCount;
         }
 
-        static std::list<Thread *> getAppThreadList() {
+        static std::list<Thread *> &getAppThreadList() {
             static std::list<Thread *> appThreads;
             return appThreads;
         }
@@ -107,6 +167,12 @@ namespace kivm {
     public:
         static void initializeJVM(JavaMainThread *thread);
 
+        /**
+         * Visit roots of all recorded threads and the current thread.
+         * @param closure root visitor
+         */
+        static void iterateRoots(RootClosure *closure);
+
         static Lock &appThreadLock() {
             static Lock lock;
             return lock;
@@ -117,10 +183,16 @@ namespace kivm {
             return lock;
         }
 
-        static void add(Thread *javaThread) {
+        /**
+         * Record a thread, safepoints stop and scan it from now on.
+         * @param appThread whether the VM waits for the thread to finish
+         */
+        static void add(Thread *javaThread, bool appThread = true) {
             appThreadLock().lock();
             getAppThreadList().push_back(javaThread);
-            ++getAppThreadCount();
+            if (appThread) {
+                ++getAppThreadCount();
+            }
             appThreadLock().unlock();
         }
 
@@ -0,0 +1,115 @@
+//
+// Created by kiva on 2018/4/25.
+//
+#pragma once
+
+#include <kivm/kivm.h>
+#include <shared/concurrentTable.h>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+namespace kivm {
+    /**
+     * An interned name or descriptor, kept as the modified UTF-8 bytes
+     * of the class file. There is one symbol per distinct string,
+     * so symbols compare by address. Symbols are never freed.
+     */
+    class Symbol {
+        friend class SymbolTable;
+
+    private:
+        size_t _hash;
+        u2 _length;
+        u1 _bytes[1];
+
+        Symbol() = default;
+
+    public:
+        static size_t hashBytes(const u1 *bytes, size_t length);
+
+        Symbol(const Symbol &) = delete;
+
+        inline size_t getHash() const {
+            return _hash;
+        }
+
+        inline int getLength() const {
+            return _length;
+        }
+
+        inline const u1 *getBytes() const {
+            return _bytes;
+        }
+
+        inline bool equals(const u1 *bytes, size_t length) const {
+            return _length == length && memcmp(_bytes, bytes, length) == 0;
+        }
+
+        /**
+         * @return the decoded string, built on every call
+         */
+        String toString() const;
+    };
+
+    /**
+     * (name, descriptor) of a method.
+     */
+    using SymbolPair = std::pair<Symbol *, Symbol *>;
+
+    struct SymbolPairHash {
+        inline size_t operator()(const SymbolPair &pair) const {
+            return pair.first->getHash() * 31 + pair.second->getHash();
+        }
+    };
+
+    /**
+     * All symbols, looked up without locking like classes of {@code SystemDictionary}.
+     */
+    class SymbolTable {
+    private:
+        static const size_t INITIAL_CAPACITY = 8192;
+
+        ConcurrentTable<Symbol> _symbols;
+        // written under the lock of the table only
+        size_t _bytes;
+
+    public:
+        static SymbolTable *get();
+
+        SymbolTable();
+
+        SymbolTable(const SymbolTable &) = delete;
+
+        ~SymbolTable();
+
+        inline size_t getSize() const {
+            return _symbols.getSize();
+        }
+
+        /**
+         * @return memory taken by all symbols
+         */
+        inline size_t getBytes() const {
+            return _bytes;
+        }
+
+        /**
+         * Intern modified UTF-8 bytes.
+         * @return the symbol, which is created if there is none
+         */
+        Symbol *lookup(const u1 *bytes, size_t length);
+
+        /**
+         * Intern a string.
+         * @return the symbol, which is created if there is none
+         */
+        Symbol *lookup(const String &string);
+
+        /**
+         * Find a symbol without creating it.
+         * @return the symbol, or {@code nullptr} if the string was never interned
+         */
+        Symbol *probe(const String &string);
+    };
+}
@@ -4,22 +4,62 @@
 #pragma once
 
 #include <kivm/kivm.h>
-#include <shared/lock.h>
-#include <unordered_map>
+#include <shared/concurrentTable.h>
 
 namespace kivm {
     class Klass;
 
+    class OopClosure;
+
+    /**
+     * All loaded classes by name.
+     * Classes are never removed, so lookups take no lock.
+     */
     class SystemDictionary {
     private:
-        std::unordered_map<String, Klass *> _classes;
-        Lock _lock;
+        static const size_t INITIAL_CAPACITY = 1024;
+
+        struct Entry {
+            size_t hash;
+            String name;
+            Klass *klass;
+
+            inline size_t getHash() const {
+                return hash;
+            }
+        };
+
+        ConcurrentTable<Entry> _entries;
 
     public:
         static SystemDictionary *get();
 
+        SystemDictionary();
+
+        SystemDictionary(const SystemDictionary &) = delete;
+
+        ~SystemDictionary();
+
+        inline size_t getSize() const {
+            return _entries.getSize();
+        }
+
+        /**
+         * Find a loaded class, without locking.
+         * @return the class, or {@code nullptr} if it is not loaded
+         */
         Klass *find(const String &name);
 
-        void put(const String &name, Klass *klass);
+        /**
+         * Add a class, unless one of that name is already there.
+         * @return the class in the dictionary
+         */
+        Klass *put(const String &name, Klass *klass);
+
+        /**
+         * Visit references held by all loaded classes.
+         * @param closure reference visitor
+         */
+        void iterateOops(OopClosure *closure);
     };
 }
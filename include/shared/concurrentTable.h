@@ -0,0 +1,154 @@
+//
+// Created by kiva on 2018/4/25.
+//
+#pragma once
+
+#include <shared/lock.h>
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+namespace kivm {
+    /**
+     * A set of pointers which are only ever added, looked up without locking.
+     * Buckets of an open addressing table are published with release stores.
+     * Writers serialize on a lock and grow the table by copying it,
+     * outgrown tables are kept until this one dies since readers may still probe them.
+     *
+     * Elements tell their hash with {@code size_t getHash() const}
+     * and are owned by the user of the table.
+     */
+    template<typename E>
+    class ConcurrentTable {
+    private:
+        struct Table {
+            // power of two, at least twice the number of elements
+            size_t capacity;
+            std::atomic<E *> *buckets;
+
+            explicit Table(size_t capacity)
+                : capacity(capacity), buckets(new std::atomic<E *>[capacity]) {
+                for (size_t i = 0; i < capacity; ++i) {
+                    buckets[i].store(nullptr, std::memory_order_relaxed);
+                }
+            }
+
+            ~Table() {
+                delete[] buckets;
+            }
+
+            template<typename Matches>
+            E *find(size_t hash, const Matches &matches) const {
+                size_t mask = capacity - 1;
+                for (size_t index = hash & mask;; index = (index + 1) & mask) {
+                    E *element = buckets[index].load(std::memory_order_acquire);
+                    if (element == nullptr) {
+                        return nullptr;
+                    }
+                    if (element->getHash() == hash && matches(element)) {
+                        return element;
+                    }
+                }
+            }
+
+            // for writers only
+            void insert(E *element) {
+                size_t mask = capacity - 1;
+                size_t index = element->getHash() & mask;
+                while (buckets[index].load(std::memory_order_relaxed) != nullptr) {
+                    index = (index + 1) & mask;
+                }
+                buckets[index].store(element, std::memory_order_release);
+            }
+        };
+
+        std::atomic<Table *> _table;
+        std::vector<Table *> _outgrownTables;
+        size_t _size;
+        Lock _lock;
+
+    public:
+        /**
+         * @param initialCapacity a power of two
+         */
+        explicit ConcurrentTable(size_t initialCapacity)
+            : _table(new Table(initialCapacity)), _size(0) {
+        }
+
+        ConcurrentTable(const ConcurrentTable &) = delete;
+
+        ~ConcurrentTable() {
+            delete _table.load(std::memory_order_relaxed);
+            for (Table *outgrown : _outgrownTables) {
+                delete outgrown;
+            }
+        }
+
+        inline size_t getSize() const {
+            return _size;
+        }
+
+        /**
+         * Find an element, without locking.
+         * @param matches tells whether an element of the same hash is the one looked for
+         * @return the element, or {@code nullptr} if there is none
+         */
+        template<typename Matches>
+        E *find(size_t hash, const Matches &matches) const {
+            return _table.load(std::memory_order_acquire)->find(hash, matches);
+        }
+
+        /**
+         * Find an element, or add one made by {@code create} under the lock.
+         * @param create returns the new element, which has the given hash
+         * @return the element in the table
+         */
+        template<typename Matches, typename Create>
+        E *findOrInsert(size_t hash, const Matches &matches, const Create &create) {
+            E *element = find(hash, matches);
+            if (element != nullptr) {
+                return element;
+            }
+
+            LockGuard lockGuard(_lock);
+            Table *table = _table.load(std::memory_order_relaxed);
+            element = table->find(hash, matches);
+            if (element != nullptr) {
+                return element;
+            }
+
+            if ((_size + 1) * 2 > table->capacity) {
+                auto *grown = new Table(table->capacity * 2);
+                for (size_t i = 0; i < table->capacity; ++i) {
+                    E *each = table->buckets[i].load(std::memory_order_relaxed);
+                    if (each != nullptr) {
+                        grown->insert(each);
+                    }
+                }
+                _table.store(grown, std::memory_order_release);
+                _outgrownTables.push_back(table);
+                table = grown;
+            }
+
+            element = create();
+            table->insert(element);
+            ++_size;
+            return element;
+        }
+
+        /**
+         * Visit all elements, holding off writers.
+         */
+        template<typename Visitor>
+        void forEach(const Visitor &visitor) {
+            LockGuard lockGuard(_lock);
+            Table *table = _table.load(std::memory_order_relaxed);
+            for (size_t i = 0; i < table->capacity; ++i) {
+                E *element = table->buckets[i].load(std::memory_order_relaxed);
+                if (element != nullptr) {
+                    visitor(element);
+                }
+            }
+        }
+    };
+}
@@ -0,0 +1,86 @@
+//
+// Created by kiva on 2018/4/25.
+//
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace kivm {
+    namespace files {
+        struct DirectoryEntry {
+            std::string name;
+            bool directory;
+        };
+
+        struct FileStatus {
+            uint64_t size;
+            // in nanoseconds, since an epoch of the platform
+            int64_t modificationTime;
+        };
+
+        /**
+         * @return {@code true} if the path names an existing directory
+         */
+        bool isDirectory(const std::string &path);
+
+        /**
+         * @return {@code false} if the file does not exist
+         */
+        bool getStatus(const std::string &path, FileStatus *status);
+
+        /**
+         * List a directory, without {@code .} and {@code ..}.
+         * @param path directory path
+         * @param entries filled with the entries, in no particular order
+         * @return {@code false} if the directory cannot be read
+         */
+        bool listDirectory(const std::string &path, std::vector<DirectoryEntry> *entries);
+
+        /**
+         * Create a directory, not its parents.
+         * @return {@code true} if the directory exists now
+         */
+        bool makeDirectory(const std::string &path);
+
+        /**
+         * Write a file through a temporary file of a unique name, renamed over it,
+         * so that readers and other writers never see half a file.
+         * @return {@code false} if it cannot be written
+         */
+        bool replaceFile(const std::string &path, const void *data, size_t length);
+
+        /**
+         * Tells whether files were added to, removed from or renamed in
+         * watched directories, without blocking.
+         * Unsupported on some systems, where nothing is ever reported.
+         */
+        class DirectoryWatcher {
+        private:
+            // platform handles: an inotify descriptor, or one change notification per directory
+            std::vector<intptr_t> _handles;
+
+        public:
+            DirectoryWatcher();
+
+            DirectoryWatcher(const DirectoryWatcher &) = delete;
+
+            ~DirectoryWatcher();
+
+            bool isSupported() const;
+
+            /**
+             * Watch a directory, not its subdirectories.
+             * Each directory should be watched once.
+             */
+            void watch(const std::string &path);
+
+            /**
+             * @return {@code true} if something changed since the last call
+             */
+            bool pollChanges();
+        };
+    }
+}
@@ -0,0 +1,97 @@
+//
+// Created by kiva on 2018/4/20.
+//
+#pragma once
+
+#include <cstddef>
+
+namespace kivm {
+    namespace memory {
+        /**
+         * Get the size of a virtual memory page.
+         * @return page size in bytes
+         */
+        size_t getPageSize();
+
+        /**
+         * Reserve a range of address space, which is inaccessible until committed.
+         * @param size Size in bytes, should be aligned to page size
+         * @param alignment Alignment of the start address, a power of two;
+         *                  0 means page size
+         * @return start address if succeeded, otherwise {@code nullptr}
+         */
+        void *reserve(size_t size, size_t alignment = 0);
+
+        /**
+         * Make part of a reserved range readable and writable.
+         * Physical pages are taken when first touched and read as zero.
+         * @param address Page aligned address inside a reserved range
+         * @param size Size in bytes, should be aligned to page size
+         * @return {@code false} if the system is out of memory
+         */
+        bool commit(void *address, size_t size);
+
+        /**
+         * Ask for the range to be backed by transparent huge pages,
+         * which needs far fewer TLB entries. A hint, ignored where unsupported.
+         * @param address Page aligned address
+         * @param size Size in bytes, should be aligned to page size
+         */
+        void adviseHugePages(void *address, size_t size);
+
+        /**
+         * Touch every page of a committed range, so it is backed by physical memory
+         * before it is used. Contents stay zero.
+         * @param address Page aligned address
+         * @param size Size in bytes, should be aligned to page size
+         */
+        void pretouch(void *address, size_t size);
+
+        /**
+         * Return the whole range to the operating system.
+         * @param address Address returned by {@code reserve()}
+         * @param size Size passed to {@code reserve()}
+         */
+        void release(void *address, size_t size);
+
+        /**
+         * Drop the physical pages backing the range but keep the range reserved.
+         * Next access to the range reads zero-filled pages.
+         * @param address Page aligned address
+         * @param size Size in bytes, should be aligned to page size
+         */
+        void discard(void *address, size_t size);
+
+        /**
+         * Map a whole file read-only.
+         * @param path file path
+         * @param size set to the file size
+         * @param readAhead whether the whole file will be read soon,
+         *        so the system may start reading it in at once
+         * @return start address if succeeded, otherwise {@code nullptr},
+         *         also for empty files
+         */
+        void *mapFile(const char *path, size_t *size, bool readAhead = false);
+
+        /**
+         * Unmap a file mapped by {@code mapFile()}.
+         * @param address Address returned by {@code mapFile()}
+         * @param size File size
+         */
+        void unmapFile(void *address, size_t size);
+
+        /**
+         * Get the highest address of the current native thread's stack.
+         * @return stack base if known, otherwise {@code nullptr}
+         */
+        void *getCurrentStackBase();
+
+        inline size_t alignUp(size_t size, size_t alignment) {
+            return (size + alignment - 1) & ~(alignment - 1);
+        }
+
+        inline size_t alignDown(size_t size, size_t alignment) {
+            return size & ~(alignment - 1);
+        }
+    }
+}
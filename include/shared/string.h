@@ -11,7 +11,7 @@ namespace kivm {
     namespace strings {
         using String  = std::wstring;
 
-        String fromBytes(u1 *bytes, size_t length);
+        String fromBytes(const u1 *bytes, size_t length);
 
         String fromStdString(const std::string &str);
 
@@ -1,9 +1,35 @@
 #include <kivm/classLoader.h>
+#include <kivm/classfile/classDataArchive.h>
+#include <kivm/classfile/classPath.h>
 #include <kivm/oop/instanceKlass.h>
 #include <kivm/runtime/thread.h>
+#include <kivm/runtime/runtimeConfig.h>
+#include <cstdio>
 
-int main() {
+int main(int argc, const char **argv) {
     using namespace kivm;
+    for (int i = 1; i < argc; ++i) {
+        if (!RuntimeConfig::get().parseOption(argv[i])) {
+            fprintf(stderr, "Unrecognized option: %s\n", argv[i]);
+            return 1;
+        }
+    }
+
+    const RuntimeConfig &config = RuntimeConfig::get();
+    if (config.sharingMode == SharingMode::DUMP) {
+        std::vector<String> classNames;
+        if (config.sharedArchiveFile.empty()
+            || !ClassDataArchive::readClassList(config.sharedClassListFile, &classNames)) {
+            fprintf(stderr, "-Xshare:dump needs -XX:SharedArchiveFile and -XX:SharedClassListFile\n");
+            return 1;
+        }
+        if (!ClassDataArchive::dump(config.sharedArchiveFile, ClassPath::get(), classNames)) {
+            fprintf(stderr, "Cannot write %s\n", config.sharedArchiveFile.c_str());
+            return 1;
+        }
+        return 0;
+    }
+
     auto *integer = (InstanceKlass *) BootstrapClassLoader::get()
             ->loadClass(L"java/lang/Integer");
 
@@ -7,16 +7,11 @@
 #include <kivm/oop/instanceKlass.h>
 #include <kivm/oop/arrayKlass.h>
 #include <kivm/oop/reflectionSupport.h>
-#include <kivm/classfile/classFileParser.h>
-#include <sstream>
+#include <kivm/classfile/classPath.h>
+#include <kivm/classfile/classPrefetcher.h>
 
 namespace kivm {
     Klass *BaseClassLoader::loadClass(const String &className) {
-        static const char *KLASSPATH_ENV = getenv("KLASSPATH");
-        static String RT_DIR = KLASSPATH_ENV == nullptr
-                               ? L""
-                               : strings::fromStdString(KLASSPATH_ENV);
-
         // Load array class
         if (className[0] == L'[') {
             // [I
@@ -56,11 +51,16 @@ namespace kivm {
         }
 
         // Load instance class
-        std::wstringstream path_builder;
-        path_builder << RT_DIR << L'/' << className << L".class";
-        const String &class_file_path = path_builder.str();
-        ClassFileParser classFileParser(strings::toStdString(class_file_path).c_str());
-        ClassFile *classFile = classFileParser.getParsedClassFile();
+        ClassPrefetcher *prefetcher = ClassPrefetcher::get();
+        bool parsed = false;
+        ClassFile *classFile = prefetcher != nullptr ? prefetcher->take(className, &parsed) : nullptr;
+        if (!parsed) {
+            classFile = ClassPath::get()->loadClassFile(className);
+        }
+        if (prefetcher != nullptr && classFile != nullptr) {
+            // parse what it links against while it is linked
+            prefetcher->prefetchReferences(classFile);
+        }
         return classFile != nullptr
                ? new InstanceKlass(classFile, this, nullptr, ClassType::INSTANCE_CLASS)
                : nullptr;
@@ -7,6 +7,7 @@
 #include <kivm/oop/primitiveOop.h>
 #include <kivm/oop/arrayOop.h>
 #include <kivm/method.h>
+#include <kivm/runtime/fieldProfile.h>
 
 namespace kivm {
     void Execution::invokeSpecial(JavaThread *thread, RuntimeConstantPool *rt, Stack &stack, int constantIndex) {
@@ -116,8 +117,11 @@ namespace kivm {
         return false;
     }
 
-    void Execution::loadIntArrayElement(Stack &stack) {
-        int index = stack.popInt();
+    /**
+     * Pop the index and the array reference of a primitive array access.
+     */
+    static typeArrayOop popTypeArray(Stack &stack, int *index) {
+        *index = stack.popInt();
         jobject ref = stack.popReference();
         if (ref == nullptr) {
             // TODO: throw NullPointerException
@@ -127,57 +131,49 @@ namespace kivm {
         if (array == nullptr) {
             PANIC("not a type array");
         }
+        return array;
+    }
 
-        auto element = (intOop) array->getElementAt(index);
-        stack.pushInt(element->getValue());
+    void Execution::loadIntArrayElement(Stack &stack) {
+        int index = 0;
+        typeArrayOop array = popTypeArray(stack, &index);
+        stack.pushInt(array->getValueAt<jint>(index));
     }
 
-    void Execution::loadFloatArrayElement(Stack &stack) {
-        int index = stack.popInt();
-        jobject ref = stack.popReference();
-        if (ref == nullptr) {
-            // TODO: throw NullPointerException
-            PANIC("java.lang.NullPointerException");
-        }
-        auto array = Resolver::tryResolveTypeArray(ref);
-        if (array == nullptr) {
-            PANIC("not a type array");
-        }
+    void Execution::loadShortArrayElement(Stack &stack) {
+        int index = 0;
+        typeArrayOop array = popTypeArray(stack, &index);
+        stack.pushInt(array->getValueAt<jshort>(index));
+    }
 
-        auto element = (floatOop) array->getElementAt(index);
-        stack.pushFloat(element->getValue());
+    void Execution::loadCharArrayElement(Stack &stack) {
+        int index = 0;
+        typeArrayOop array = popTypeArray(stack, &index);
+        stack.pushInt(array->getValueAt<jchar>(index));
     }
 
-    void Execution::loadDoubleArrayElement(Stack &stack) {
-        int index = stack.popInt();
-        jobject ref = stack.popReference();
-        if (ref == nullptr) {
-            // TODO: throw NullPointerException
-            PANIC("java.lang.NullPointerException");
-        }
-        auto array = Resolver::tryResolveTypeArray(ref);
-        if (array == nullptr) {
-            PANIC("not a type array");
-        }
+    void Execution::loadByteArrayElement(Stack &stack) {
+        int index = 0;
+        typeArrayOop array = popTypeArray(stack, &index);
+        stack.pushInt(array->getValueAt<jbyte>(index));
+    }
 
-        auto element = (doubleOop) array->getElementAt(index);
-        stack.pushDouble(element->getValue());
+    void Execution::loadFloatArrayElement(Stack &stack) {
+        int index = 0;
+        typeArrayOop array = popTypeArray(stack, &index);
+        stack.pushFloat(array->getValueAt<jfloat>(index));
     }
 
-    void Execution::loadLongArrayElement(Stack &stack) {
-        int index = stack.popInt();
-        jobject ref = stack.popReference();
-        if (ref == nullptr) {
-            // TODO: throw NullPointerException
-            PANIC("java.lang.NullPointerException");
-        }
-        auto array = Resolver::tryResolveTypeArray(ref);
-        if (array == nullptr) {
-            PANIC("not a type array");
-        }
+    void Execution::loadDoubleArrayElement(Stack &stack) {
+        int index = 0;
+        typeArrayOop array = popTypeArray(stack, &index);
+        stack.pushDouble(array->getValueAt<jdouble>(index));
+    }
 
-        auto element = (longOop) array->getElementAt(index);
-        stack.pushLong(element->getValue());
+    void Execution::loadLongArrayElement(Stack &stack) {
+        int index = 0;
+        typeArrayOop array = popTypeArray(stack, &index);
+        stack.pushLong(array->getValueAt<jlong>(index));
     }
 
     void Execution::loadObjectArrayElement(Stack &stack) {
@@ -198,66 +194,51 @@ namespace kivm {
 
     void Execution::storeIntArrayElement(Stack &stack) {
         jint value = stack.popInt();
-        int index = stack.popInt();
-        jobject ref = stack.popReference();
-        if (ref == nullptr) {
-            // TODO: throw NullPointerException
-            PANIC("java.lang.NullPointerException");
-        }
-        auto array = Resolver::tryResolveTypeArray(ref);
-        if (array == nullptr) {
-            PANIC("not a type array");
-        }
+        int index = 0;
+        typeArrayOop array = popTypeArray(stack, &index);
+        array->setValueAt<jint>(index, value);
+    }
 
-        array->setElementAt(index, new intOopDesc(value));
+    void Execution::storeShortArrayElement(Stack &stack) {
+        jint value = stack.popInt();
+        int index = 0;
+        typeArrayOop array = popTypeArray(stack, &index);
+        array->setValueAt<jshort>(index, (jshort) value);
+    }
+
+    void Execution::storeCharArrayElement(Stack &stack) {
+        jint value = stack.popInt();
+        int index = 0;
+        typeArrayOop array = popTypeArray(stack, &index);
+        array->setValueAt<jchar>(index, (jchar) value);
+    }
+
+    void Execution::storeByteArrayElement(Stack &stack) {
+        jint value = stack.popInt();
+        int index = 0;
+        typeArrayOop array = popTypeArray(stack, &index);
+        array->setValueAt<jbyte>(index, (jbyte) value);
     }
 
     void Execution::storeFloatArrayElement(Stack &stack) {
         jfloat value = stack.popFloat();
-        int index = stack.popInt();
-        jobject ref = stack.popReference();
-        if (ref == nullptr) {
-            // TODO: throw NullPointerException
-            PANIC("java.lang.NullPointerException");
-        }
-        auto array = Resolver::tryResolveTypeArray(ref);
-        if (array == nullptr) {
-            PANIC("not a type array");
-        }
-
-        array->setElementAt(index, new floatOopDesc(value));
+        int index = 0;
+        typeArrayOop array = popTypeArray(stack, &index);
+        array->setValueAt<jfloat>(index, value);
     }
 
     void Execution::storeDoubleArrayElement(Stack &stack) {
         jdouble value = stack.popDouble();
-        int index = stack.popInt();
-        jobject ref = stack.popReference();
-        if (ref == nullptr) {
-            // TODO: throw NullPointerException
-            PANIC("java.lang.NullPointerException");
-        }
-        auto array = Resolver::tryResolveTypeArray(ref);
-        if (array == nullptr) {
-            PANIC("not a type array");
-        }
-
-        array->setElementAt(index, new doubleOopDesc(value));
+        int index = 0;
+        typeArrayOop array = popTypeArray(stack, &index);
+        array->setValueAt<jdouble>(index, value);
     }
 
     void Execution::storeLongArrayElement(Stack &stack) {
         jlong value = stack.popLong();
-        int index = stack.popInt();
-        jobject ref = stack.popReference();
-        if (ref == nullptr) {
-            // TODO: throw NullPointerException
-            PANIC("java.lang.NullPointerException");
-        }
-        auto array = Resolver::tryResolveTypeArray(ref);
-        if (array == nullptr) {
-            PANIC("not a type array");
-        }
-
-        array->setElementAt(index, new longOopDesc(value));
+        int index = 0;
+        typeArrayOop array = popTypeArray(stack, &index);
+        array->setValueAt<jlong>(index, value);
     }
 
     void Execution::storeObjectArrayElement(Stack &stack) {
@@ -286,55 +267,44 @@ namespace kivm {
         auto instanceKlass = field->_field->getClass();
         Execution::initializeClass(thread, instanceKlass);
 
-        oop fieldValue = nullptr;
-
-        // We are getting a static field.
-        if (receiver == nullptr) {
-            if (!instanceKlass->getStaticFieldValue(field, &fieldValue)) {
-                PANIC("Cannot get static field value, constantIndex: %d", constantIndex);
-            }
-        } else {
-            // We are getting an instance field.
-            if (!instanceKlass->getInstanceFieldValue(receiver, field, &fieldValue)) {
-                PANIC("Cannot get instance field value, constantIndex: %d", constantIndex);
-            }
+        if (receiver != nullptr && FieldProfile::get()->isRecording()) {
+            field->_field->countAccess();
         }
 
+        // Fields are stored unboxed, in the receiver or in the static field block.
+        const u1 *address = receiver != nullptr
+                            ? (const u1 *) receiver + field->_offset
+                            : instanceKlass->getStaticFieldBlock() + field->_offset;
+
         switch (field->_field->getValueType()) {
             case ValueType::OBJECT:
-            case ValueType::ARRAY: {
-                stack.pushReference(fieldValue);
+            case ValueType::ARRAY:
+                stack.pushReference(CompressedOops::loadReference(address));
                 break;
-            }
-
             case ValueType::INT:
+                stack.pushInt(*(const jint *) address);
+                break;
             case ValueType::SHORT:
+                stack.pushInt(*(const jshort *) address);
+                break;
             case ValueType::CHAR:
+                stack.pushInt(*(const jchar *) address);
+                break;
             case ValueType::BOOLEAN:
-            case ValueType::BYTE: {
-                auto intObject = (intOop) fieldValue;
-                stack.pushInt(intObject->getValue());
+                stack.pushInt(*(const jboolean *) address);
                 break;
-            }
-
-            case ValueType::FLOAT: {
-                auto floatObject = (floatOop) fieldValue;
-                stack.pushFloat(floatObject->getValue());
+            case ValueType::BYTE:
+                stack.pushInt(*(const jbyte *) address);
                 break;
-            }
-
-            case ValueType::DOUBLE: {
-                auto doubleObject = (doubleOop) fieldValue;
-                stack.pushDouble(doubleObject->getValue());
+            case ValueType::FLOAT:
+                stack.pushFloat(*(const jfloat *) address);
                 break;
-            }
-
-            case ValueType::LONG: {
-                auto longObject = (longOop) fieldValue;
-                stack.pushLong(longObject->getValue());
+            case ValueType::DOUBLE:
+                stack.pushDouble(*(const jdouble *) address);
+                break;
+            case ValueType::LONG:
+                stack.pushLong(*(const jlong *) address);
                 break;
-            }
-
             case ValueType::VOID:
                 PANIC("Field cannot be typed void");
                 break;
@@ -354,10 +324,13 @@ namespace kivm {
         Execution::initializeClass(thread, instanceKlass);
 
         bool isStatic = field->_field->isStatic();
+        if (!isStatic && FieldProfile::get()->isRecording()) {
+            field->_field->countAccess();
+        }
 
-#define PUTFIELD(value) \
+#define PUTFIELD(type, value) \
         if (isStatic) { \
-            instanceKlass->setStaticFieldValue(field, value); \
+            instanceKlass->setStaticFieldAt<type>(field->_offset, value); \
         } else { \
             jobject receiverRef = stack.popReference(); \
             if (receiverRef == nullptr) { \
@@ -367,43 +340,64 @@ namespace kivm {
             if (receiver == nullptr) { \
                 PANIC("Not an instance oop"); \
             } \
-            instanceKlass->setInstanceFieldValue(receiver, field, value); \
+            receiver->setFieldAt<type>(field->_offset, value); \
         }
 
+        // Fields are stored unboxed, in the receiver or in the static field block.
         switch (field->_field->getValueType()) {
             case ValueType::OBJECT:
             case ValueType::ARRAY: {
                 jobject ref = stack.popReference();
                 oop value = Resolver::resolveJObject(ref);
-                PUTFIELD(value);
+                PUTFIELD(oop, value);
+                break;
+            }
+
+            case ValueType::INT: {
+                jint value = stack.popInt();
+                PUTFIELD(jint, value);
+                break;
+            }
+
+            case ValueType::SHORT: {
+                auto value = (jshort) stack.popInt();
+                PUTFIELD(jshort, value);
+                break;
+            }
+
+            case ValueType::CHAR: {
+                auto value = (jchar) stack.popInt();
+                PUTFIELD(jchar, value);
+                break;
+            }
+
+            case ValueType::BOOLEAN: {
+                auto value = (jboolean) (stack.popInt() & 1);
+                PUTFIELD(jboolean, value);
                 break;
             }
 
-            case ValueType::INT:
-            case ValueType::SHORT:
-            case ValueType::CHAR:
-            case ValueType::BOOLEAN:
             case ValueType::BYTE: {
-                auto intObject = new intOopDesc(stack.popInt());
-                PUTFIELD(intObject);
+                auto value = (jbyte) stack.popInt();
+                PUTFIELD(jbyte, value);
                 break;
             }
 
             case ValueType::FLOAT: {
-                auto floatObject = new floatOopDesc(stack.popFloat());
-                PUTFIELD(floatObject);
+                jfloat value = stack.popFloat();
+                PUTFIELD(jfloat, value);
                 break;
             }
 
             case ValueType::DOUBLE: {
-                auto doubleObject = new doubleOopDesc(stack.popDouble());
-                PUTFIELD(doubleObject);
+                jdouble value = stack.popDouble();
+                PUTFIELD(jdouble, value);
                 break;
             }
 
             case ValueType::LONG: {
-                auto longObject = new longOopDesc(stack.popLong());
-                PUTFIELD(longObject);
+                jlong value = stack.popLong();
+                PUTFIELD(jlong, value);
                 break;
             }
 
@@ -414,9 +408,11 @@ namespace kivm {
                 PANIC("Unrecognized field value type");
                 break;
         }
+#undef PUTFIELD
     }
 
-    instanceOop Execution::newInstance(JavaThread *thread, RuntimeConstantPool *rt, int constantIndex) {
+    instanceOop Execution::newInstance(JavaThread *thread, RuntimeConstantPool *rt, int constantIndex,
+                                       AllocationSite *site) {
         auto klass = rt->getClass(constantIndex);
         if (klass == nullptr) {
             PANIC("Cannot get class info from constant pool");
@@ -428,10 +424,11 @@ namespace kivm {
 
         auto instanceKlass = (InstanceKlass *) klass;
         Execution::initializeClass(thread, instanceKlass);
-        return instanceKlass->newInstance();
+        return instanceKlass->newInstance(site);
     }
 
-    typeArrayOop Execution::newPrimitiveArray(JavaThread *thread, int arrayType, int length) {
+    typeArrayOop Execution::newPrimitiveArray(JavaThread *thread, int arrayType, int length,
+                                              AllocationSite *site) {
         if (length < 0) {
             // TODO: NegativeArraySizeException
             PANIC("java.lang.NegativeArraySizeException");
@@ -474,11 +471,12 @@ namespace kivm {
         }
 
         auto typeArrayClass = (TypeArrayKlass *) arrayClass;
-        return typeArrayClass->newInstance(length);
+        return typeArrayClass->newInstance(length, site);
     }
 
     objectArrayOop Execution::newObjectArray(JavaThread *thread, RuntimeConstantPool *rt,
-                                             int constantIndex, int length) {
+                                             int constantIndex, int length,
+                                             AllocationSite *site) {
         if (length < 0) {
             // TODO: NegativeArraySizeException
             PANIC("java.lang.NegativeArraySizeException");
@@ -534,7 +532,7 @@ namespace kivm {
             PANIC("Cannot get component type of an object array");
         }
 
-        return objectArrayKlass->newInstance(length);
+        return objectArrayKlass->newInstance(length, site);
     }
 
     static arrayOop newMultiObjectArrayHelper(ArrayKlass *arrayKlass,
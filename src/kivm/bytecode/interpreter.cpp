@@ -5,11 +5,15 @@
 #include <kivm/bytecode/interpreter.h>
 #include <kivm/bytecode/bytecodes.h>
 #include <kivm/bytecode/execution.h>
+#include <kivm/bytecode/oopMap.h>
 #include <kivm/oop/instanceOop.h>
 #include <kivm/oop/arrayOop.h>
 #include <kivm/oop/primitiveOop.h>
 #include <kivm/oop/mirrorOop.h>
 #include <kivm/method.h>
+#include <kivm/memory/heap.h>
+#include <kivm/memory/allocationSite.h>
+#include <kivm/runtime/safepoint.h>
 #include <climits>
 #include <unordered_map>
 #include <deque>
@@ -39,7 +43,10 @@
 #define GOTO_UNCONDITIONALLY(occupied) \
                     short branch = code_blob[pc] << 8 | code_blob[pc + 1]; \
                     GOTO_PC(branch); \
-                    GOTO_PC(-((occupied) - 1))
+                    GOTO_PC(-((occupied) - 1)); \
+                    if (branch <= 0) { \
+                        pollAtInstructionStart(thread); \
+                    }
 
 #define __IF_GOTO_FACTORY(func, target, occupied, op) \
                     if (stack.func() op target) { \
@@ -64,7 +71,26 @@
 #define IF_ACMP_GOTO(occupied, op) __IF_CMP_GOTO_FACTORY(popReference, occupied, op)
 
 namespace kivm {
+    void ByteCodeInterpreter::pollAtInstructionStart(JavaThread *thread) {
+        thread->_pcAtInstructionStart = true;
+        Heap::get()->collectIfRequested();
+        Safepoint::poll(thread);
+        thread->_pcAtInstructionStart = false;
+    }
+
     oop ByteCodeInterpreter::interp(JavaThread *thread) {
+        Method *enteredMethod = thread->getCurrentFrame()->getMethod();
+        if (!enteredMethod->isNative() && OopMapCache::get()->lookup(enteredMethod) == nullptr) {
+            // Reading or computing the maps may take a while, let collections
+            // go on meanwhile. They scan the new frame conservatively.
+            ThreadStateTransition inNative(thread, ExecutionState::IN_NATIVE);
+            OopMapCache::get()->prepare(enteredMethod);
+        }
+
+        ThreadStateTransition inJava(thread, ExecutionState::IN_JAVA);
+
+        pollAtInstructionStart(thread);
+
         Frame *currentFrame = thread->getCurrentFrame();
         auto currentMethod = currentFrame->getMethod();
         auto currentClass = currentMethod->getClass();
@@ -352,17 +378,17 @@ namespace kivm {
                 }
                 OPCODE(BALOAD)
                 {
-                    Execution::loadIntArrayElement(stack);
+                    Execution::loadByteArrayElement(stack);
                     NEXT();
                 }
                 OPCODE(CALOAD)
                 {
-                    Execution::loadIntArrayElement(stack);
+                    Execution::loadCharArrayElement(stack);
                     NEXT();
                 }
                 OPCODE(SALOAD)
                 {
-                    Execution::loadIntArrayElement(stack);
+                    Execution::loadShortArrayElement(stack);
                     NEXT();
                 }
                 OPCODE(ISTORE)
@@ -522,17 +548,17 @@ namespace kivm {
                 }
                 OPCODE(BASTORE)
                 {
-                    Execution::storeIntArrayElement(stack);
+                    Execution::storeByteArrayElement(stack);
                     NEXT();
                 }
                 OPCODE(CASTORE)
                 {
-                    Execution::storeIntArrayElement(stack);
+                    Execution::storeCharArrayElement(stack);
                     NEXT();
                 }
                 OPCODE(SASTORE)
                 {
-                    Execution::storeIntArrayElement(stack);
+                    Execution::storeShortArrayElement(stack);
                     NEXT();
                 }
                 OPCODE(POP)
@@ -1390,26 +1416,29 @@ namespace kivm {
                 }
                 OPCODE(NEW)
                 {
+                    AllocationSite *site = AllocationSiteTable::get()->lookup(currentMethod, pc - 1);
                     int constantIndex = code_blob[pc] << 8 | code_blob[pc + 1];
                     pc += 2;
                     stack.pushReference(Execution::newInstance(thread, currentClass->getRuntimeConstantPool(),
-                                                               constantIndex));
+                                                               constantIndex, site));
                     NEXT();
                 }
                 OPCODE(NEWARRAY)
                 {
+                    AllocationSite *site = AllocationSiteTable::get()->lookup(currentMethod, pc - 1);
                     int arrayType = code_blob[pc++];
                     int length = stack.popInt();
-                    stack.pushReference(Execution::newPrimitiveArray(thread, arrayType, length));
+                    stack.pushReference(Execution::newPrimitiveArray(thread, arrayType, length, site));
                     NEXT();
                 }
                 OPCODE(ANEWARRAY)
                 {
+                    AllocationSite *site = AllocationSiteTable::get()->lookup(currentMethod, pc - 1);
                     int constantIndex = code_blob[pc] << 8 | code_blob[pc + 1];
                     pc += 2;
                     int length = stack.popInt();
                     stack.pushReference(Execution::newObjectArray(thread, currentClass->getRuntimeConstantPool(),
-                                                                  constantIndex, length));
+                                                                  constantIndex, length, site));
                     NEXT();
                 }
                 OPCODE(ARRAYLENGTH)
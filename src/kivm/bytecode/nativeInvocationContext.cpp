@@ -4,6 +4,7 @@
 #include <kivm/bytecode/invocationContext.h>
 #include <kivm/bytecode/execution.h>
 #include <kivm/runtime/thread.h>
+#include <kivm/runtime/safepoint.h>
 #include <kivm/oop/primitiveOop.h>
 #include <kivm/oop/mirrorOop.h>
 #include <ffi.h>
@@ -149,6 +150,10 @@ namespace kivm {
             PANIC("invokeNative: ffi_prep_cif() failed: %d", result);
         }
 
+        // Natives of the VM work on oops directly, so they run in VM state
+        // and cannot be stopped. Blocking natives should switch to IN_NATIVE.
+        ThreadStateTransition inVm(_thread, ExecutionState::IN_VM);
+
         // invoke and push the result onto the stack(if has)
         switch (returnValueType) {
             case ValueType::VOID: {
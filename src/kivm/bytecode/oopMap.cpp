@@ -0,0 +1,1199 @@
+//
+// Created by kiva on 2018/4/21.
+//
+
+#include <kivm/bytecode/oopMap.h>
+#include <kivm/bytecode/oopMapStore.h>
+#include <kivm/bytecode/bytecodes.h>
+#include <kivm/oop/instanceKlass.h>
+#include <kivm/method.h>
+#include <algorithm>
+#include <deque>
+#include <functional>
+
+namespace kivm {
+    enum SlotType : u1 {
+        // unknown, uninitialized or conflicting, never used as a reference
+        SLOT_TOP = 0,
+        SLOT_VALUE,
+        SLOT_REFERENCE,
+    };
+
+    struct TypeState {
+        bool _reached = false;
+        std::vector<u1> _locals;
+        std::vector<u1> _stack;
+    };
+
+    static inline u2 readU2(const u1 *code, u4 pc) {
+        return (u2) (code[pc] << 8 | code[pc + 1]);
+    }
+
+    static inline int readS4(const u1 *code, u4 pc) {
+        return (int) ((u4) code[pc] << 24 | (u4) code[pc + 1] << 16 | (u4) code[pc + 2] << 8 | code[pc + 3]);
+    }
+
+    /**
+     * Convert one field descriptor at {@code desc[*i]} to slot types.
+     * @return {@code false} if the descriptor is malformed
+     */
+    template<typename Char>
+    static bool parseFieldType(const Char *desc, int length, int *i, std::vector<u1> *slots) {
+        if (*i >= length) {
+            return false;
+        }
+
+        switch (desc[*i]) {
+            case 'B':
+            case 'C':
+            case 'F':
+            case 'I':
+            case 'S':
+            case 'Z':
+                slots->push_back(SLOT_VALUE);
+                ++*i;
+                return true;
+            case 'J':
+            case 'D':
+                slots->push_back(SLOT_VALUE);
+                slots->push_back(SLOT_VALUE);
+                ++*i;
+                return true;
+            case 'L':
+                while (*i < length && desc[*i] != ';') {
+                    ++*i;
+                }
+                ++*i;
+                slots->push_back(SLOT_REFERENCE);
+                return *i <= length;
+            case '[':
+                while (*i < length && desc[*i] == '[') {
+                    ++*i;
+                }
+                if (*i < length && desc[*i] == 'L') {
+                    while (*i < length && desc[*i] != ';') {
+                        ++*i;
+                    }
+                }
+                ++*i;
+                slots->push_back(SLOT_REFERENCE);
+                return *i <= length;
+            default:
+                return false;
+        }
+    }
+
+    /**
+     * Split a method descriptor to argument slots and return slots.
+     */
+    template<typename Char>
+    static bool parseMethodType(const Char *desc, int length,
+                                std::vector<u1> *args, std::vector<u1> *result) {
+        if (length == 0 || desc[0] != '(') {
+            return false;
+        }
+
+        int i = 1;
+        while (i < length && desc[i] != ')') {
+            if (!parseFieldType(desc, length, &i, args)) {
+                return false;
+            }
+        }
+        ++i;
+        if (i < length && desc[i] == 'V') {
+            return true;
+        }
+        return parseFieldType(desc, length, &i, result);
+    }
+
+    class OopMapBuilder {
+    private:
+        Method *_method;
+        Code_attribute *_code;
+        cp_info **_pool;
+        int _maxLocals;
+        int _maxStack;
+
+        // instruction start pc -> index in _starts, or -1
+        std::vector<int> _instructionIndex;
+        std::vector<u4> _starts;
+        std::vector<bool> _backwardTargets;
+
+        std::vector<TypeState> _states;
+        std::vector<bool> _declared;
+        std::deque<int> _worklist;
+
+        bool _failed = false;
+
+        CONSTANT_Utf8_info *utf8At(int index) {
+            return (CONSTANT_Utf8_info *) _pool[index];
+        }
+
+        CONSTANT_NameAndType_info *nameAndTypeOfMember(int index) {
+            cp_info *info = _pool[index];
+            u2 nameAndTypeIndex = 0;
+            switch (info->tag) {
+                case CONSTANT_Fieldref:
+                    nameAndTypeIndex = ((CONSTANT_Fieldref_info *) info)->name_and_type_index;
+                    break;
+                case CONSTANT_Methodref:
+                    nameAndTypeIndex = ((CONSTANT_Methodref_info *) info)->name_and_type_index;
+                    break;
+                case CONSTANT_InterfaceMethodref:
+                    nameAndTypeIndex = ((CONSTANT_InterfaceMethodref_info *) info)->name_and_type_index;
+                    break;
+                case CONSTANT_InvokeDynamic:
+                    nameAndTypeIndex = ((CONSTANT_InvokeDynamic_info *) info)->name_and_type_index;
+                    break;
+                default:
+                    return nullptr;
+            }
+            return (CONSTANT_NameAndType_info *) _pool[nameAndTypeIndex];
+        }
+
+        int instructionLength(u4 pc) {
+            const u1 *code = _code->code;
+            switch (code[pc]) {
+                case OPC_BIPUSH:
+                case OPC_LDC:
+                case OPC_ILOAD:
+                case OPC_LLOAD:
+                case OPC_FLOAD:
+                case OPC_DLOAD:
+                case OPC_ALOAD:
+                case OPC_ISTORE:
+                case OPC_LSTORE:
+                case OPC_FSTORE:
+                case OPC_DSTORE:
+                case OPC_ASTORE:
+                case OPC_RET:
+                case OPC_NEWARRAY:
+                    return 2;
+
+                case OPC_SIPUSH:
+                case OPC_LDC_W:
+                case OPC_LDC2_W:
+                case OPC_IINC:
+                case OPC_GOTO:
+                case OPC_JSR:
+                case OPC_GETSTATIC:
+                case OPC_PUTSTATIC:
+                case OPC_GETFIELD:
+                case OPC_PUTFIELD:
+                case OPC_INVOKEVIRTUAL:
+                case OPC_INVOKESPECIAL:
+                case OPC_INVOKESTATIC:
+                case OPC_NEW:
+                case OPC_ANEWARRAY:
+                case OPC_CHECKCAST:
+                case OPC_INSTANCEOF:
+                case OPC_IFNULL:
+                case OPC_IFNONNULL:
+                    return 3;
+
+                case OPC_MULTIANEWARRAY:
+                    return 4;
+
+                case OPC_INVOKEINTERFACE:
+                case OPC_INVOKEDYNAMIC:
+                case OPC_GOTO_W:
+                case OPC_JSR_W:
+                    return 5;
+
+                case OPC_WIDE:
+                    return code[pc + 1] == OPC_IINC ? 6 : 4;
+
+                case OPC_TABLESWITCH: {
+                    u4 base = (pc + 4) & ~3u;
+                    int low = readS4(code, base + 4);
+                    int high = readS4(code, base + 8);
+                    return (int) (base - pc) + 12 + (high - low + 1) * 4;
+                }
+
+                case OPC_LOOKUPSWITCH: {
+                    u4 base = (pc + 4) & ~3u;
+                    int pairs = readS4(code, base + 4);
+                    return (int) (base - pc) + 8 + pairs * 8;
+                }
+
+                default:
+                    if (code[pc] >= OPC_IFEQ && code[pc] <= OPC_IF_ACMPNE) {
+                        return 3;
+                    }
+                    return 1;
+            }
+        }
+
+        bool decodeInstructions() {
+            u4 pc = 0;
+            while (pc < _code->code_length) {
+                _instructionIndex[pc] = (int) _starts.size();
+                _starts.push_back(pc);
+                int length = instructionLength(pc);
+                if (length <= 0 || pc + length > _code->code_length) {
+                    return false;
+                }
+                pc += length;
+            }
+            return true;
+        }
+
+        static bool isSafepointInstruction(u1 opcode) {
+            switch (opcode) {
+                case OPC_LDC:
+                case OPC_LDC_W:
+                case OPC_GETSTATIC:
+                case OPC_PUTSTATIC:
+                case OPC_INVOKEVIRTUAL:
+                case OPC_INVOKESPECIAL:
+                case OPC_INVOKESTATIC:
+                case OPC_INVOKEINTERFACE:
+                case OPC_INVOKEDYNAMIC:
+                case OPC_NEW:
+                case OPC_NEWARRAY:
+                case OPC_ANEWARRAY:
+                case OPC_MULTIANEWARRAY:
+                    return true;
+                default:
+                    return false;
+            }
+        }
+
+        static void expandVerificationTag(u1 tag, std::vector<u1> *slots) {
+            switch (tag) {
+                case ITEM_Top:
+                    slots->push_back(SLOT_TOP);
+                    break;
+                case ITEM_Integer:
+                case ITEM_Float:
+                    slots->push_back(SLOT_VALUE);
+                    break;
+                case ITEM_Long:
+                case ITEM_Double:
+                    slots->push_back(SLOT_VALUE);
+                    slots->push_back(SLOT_VALUE);
+                    break;
+                default:
+                    // Null, UninitializedThis, Object and Uninitialized
+                    slots->push_back(SLOT_REFERENCE);
+                    break;
+            }
+        }
+
+        /**
+         * Use frames in StackMapTable as the authoritative type state at their pcs.
+         * Frames are deltas over verification types, where long and double
+         * take one entry but two slots, so we keep tags and expand them per frame.
+         */
+        void seedFromStackMapTable() {
+            using SMT = StackMapTable_attribute;
+            SMT *table = _method->getStackMapTable();
+            if (table == nullptr) {
+                return;
+            }
+
+            // the implicit initial frame
+            std::vector<u1> locals;
+            if (!_method->isStatic()) {
+                locals.push_back(ITEM_Object);
+            }
+            const String &descriptor = _method->getDescriptor();
+            for (int i = 1; i < (int) descriptor.size() && descriptor[i] != L')'; ++i) {
+                wchar_t ch = descriptor[i];
+                if (ch == L'L' || ch == L'[') {
+                    while (descriptor[i] == L'[') {
+                        ++i;
+                    }
+                    if (descriptor[i] == L'L') {
+                        i = (int) descriptor.find(L';', (size_t) i);
+                    }
+                    locals.push_back(ITEM_Object);
+                } else if (ch == L'J' || ch == L'D') {
+                    locals.push_back(ITEM_Long);
+                } else {
+                    locals.push_back(ITEM_Integer);
+                }
+            }
+
+            int pc = -1;
+            for (int i = 0; i < table->number_of_entries; ++i) {
+                SMT::stack_map_frame *frame = table->entries[i];
+                u1 type = frame->frame_type;
+                int delta = 0;
+                std::vector<u1> stack;
+
+                if (type <= 63) {
+                    delta = type;
+                } else if (type <= 127) {
+                    delta = type - 64;
+                    expandVerificationTag(((SMT::same_locals_1_stack_item_frame *) frame)->stack[0]->tag, &stack);
+                } else if (type == 247) {
+                    auto *f = (SMT::same_locals_1_stack_item_frame_extended *) frame;
+                    delta = f->offset_delta;
+                    expandVerificationTag(f->stack[0]->tag, &stack);
+                } else if (type >= 248 && type <= 250) {
+                    delta = ((SMT::chop_frame *) frame)->offset_delta;
+                    size_t chopped = 251u - type;
+                    if (chopped > locals.size()) {
+                        _failed = true;
+                        return;
+                    }
+                    locals.resize(locals.size() - chopped);
+                } else if (type == 251) {
+                    delta = ((SMT::same_frame_extended *) frame)->offset_delta;
+                } else if (type >= 252 && type <= 254) {
+                    auto *f = (SMT::append_frame *) frame;
+                    delta = f->offset_delta;
+                    for (int j = 0; j < type - 251; ++j) {
+                        locals.push_back(f->locals[j]->tag);
+                    }
+                } else if (type == 255) {
+                    auto *f = (SMT::full_frame *) frame;
+                    delta = f->offset_delta;
+                    locals.clear();
+                    for (int j = 0; j < f->number_of_locals; ++j) {
+                        locals.push_back(f->locals[j]->tag);
+                    }
+                    for (int j = 0; j < f->number_of_stack_items; ++j) {
+                        expandVerificationTag(f->stack[j]->tag, &stack);
+                    }
+                } else {
+                    _failed = true;
+                    return;
+                }
+
+                pc = pc + delta + 1;
+                if (pc >= (int) _code->code_length || _instructionIndex[pc] < 0) {
+                    _failed = true;
+                    return;
+                }
+
+                int index = _instructionIndex[pc];
+                TypeState &state = _states[index];
+                state._locals.clear();
+                for (u1 tag : locals) {
+                    expandVerificationTag(tag, &state._locals);
+                }
+                if (state._locals.size() > (size_t) _maxLocals || stack.size() > (size_t) _maxStack) {
+                    _failed = true;
+                    return;
+                }
+                state._locals.resize((size_t) _maxLocals, SLOT_TOP);
+                state._stack = stack;
+                _declared[index] = true;
+            }
+        }
+
+        void mergeInto(int index, const std::vector<u1> &locals, const std::vector<u1> &stack) {
+            TypeState &target = _states[index];
+            if (_declared[index]) {
+                if (!target._reached) {
+                    target._reached = true;
+                    _worklist.push_back(index);
+                }
+                return;
+            }
+
+            if (!target._reached) {
+                target._reached = true;
+                target._locals = locals;
+                target._stack = stack;
+                _worklist.push_back(index);
+                return;
+            }
+
+            if (target._stack.size() != stack.size()) {
+                // inconsistent stack height, unverifiable code
+                _failed = true;
+                return;
+            }
+
+            bool changed = false;
+            for (size_t i = 0; i < locals.size(); ++i) {
+                if (target._locals[i] != locals[i] && target._locals[i] != SLOT_TOP) {
+                    target._locals[i] = SLOT_TOP;
+                    changed = true;
+                }
+            }
+            for (size_t i = 0; i < stack.size(); ++i) {
+                if (target._stack[i] != stack[i] && target._stack[i] != SLOT_TOP) {
+                    target._stack[i] = SLOT_TOP;
+                    changed = true;
+                }
+            }
+            if (changed) {
+                _worklist.push_back(index);
+            }
+        }
+
+        void branchTo(u4 from, int offset, const std::vector<u1> &locals, const std::vector<u1> &stack) {
+            int target = (int) from + offset;
+            if (target < 0 || target >= (int) _code->code_length || _instructionIndex[target] < 0) {
+                _failed = true;
+                return;
+            }
+            if (offset <= 0) {
+                _backwardTargets[_instructionIndex[target]] = true;
+            }
+            mergeInto(_instructionIndex[target], locals, stack);
+        }
+
+        void propagateToHandlers(u4 pc, const std::vector<u1> &locals) {
+            static const std::vector<u1> EXCEPTION_STACK = {SLOT_REFERENCE};
+            for (int i = 0; i < _code->exception_table_length; ++i) {
+                const exception_table_t &entry = _code->exception_table[i];
+                if (pc >= entry.start_pc && pc < entry.end_pc) {
+                    if (_instructionIndex[entry.handler_pc] < 0) {
+                        _failed = true;
+                        return;
+                    }
+                    mergeInto(_instructionIndex[entry.handler_pc], locals, EXCEPTION_STACK);
+                }
+            }
+        }
+
+        /**
+         * Simulate one instruction on locals and stack.
+         * @return {@code false} if control never falls through
+         */
+        bool interpret(u4 pc, std::vector<u1> &locals, std::vector<u1> &stack);
+
+    public:
+        explicit OopMapBuilder(Method *method)
+            : _method(method),
+              _code(method->getCodeAttribute()),
+              _pool(method->getClass()->getRuntimeConstantPool()->getRawPool()),
+              _maxLocals(method->getMaxLocals()),
+              _maxStack(method->getMaxStack()) {
+        }
+
+        MethodOopMaps *build();
+    };
+
+#define POP(n) \
+    do { \
+        if (stack.size() < (size_t) (n)) { _failed = true; return false; } \
+        stack.resize(stack.size() - (n)); \
+    } while (false)
+
+#define PUSH(type) stack.push_back(type)
+
+#define PUSH_VALUES(n) \
+    do { for (int __i = 0; __i < (n); ++__i) stack.push_back(SLOT_VALUE); } while (false)
+
+#define STORE(index, type, n) \
+    do { \
+        if ((index) + (n) > _maxLocals) { _failed = true; return false; } \
+        for (int __i = 0; __i < (n); ++__i) locals[(index) + __i] = (type); \
+    } while (false)
+
+    bool OopMapBuilder::interpret(u4 pc, std::vector<u1> &locals, std::vector<u1> &stack) {
+        const u1 *code = _code->code;
+        u1 opcode = code[pc];
+
+        switch (opcode) {
+            case OPC_NOP:
+            case OPC_IINC:
+                return true;
+
+            case OPC_ACONST_NULL:
+                PUSH(SLOT_REFERENCE);
+                return true;
+
+            case OPC_ICONST_M1:
+            case OPC_ICONST_0:
+            case OPC_ICONST_1:
+            case OPC_ICONST_2:
+            case OPC_ICONST_3:
+            case OPC_ICONST_4:
+            case OPC_ICONST_5:
+            case OPC_FCONST_0:
+            case OPC_FCONST_1:
+            case OPC_FCONST_2:
+            case OPC_BIPUSH:
+            case OPC_SIPUSH:
+            case OPC_ILOAD:
+            case OPC_FLOAD:
+            case OPC_ILOAD_0:
+            case OPC_ILOAD_1:
+            case OPC_ILOAD_2:
+            case OPC_ILOAD_3:
+            case OPC_FLOAD_0:
+            case OPC_FLOAD_1:
+            case OPC_FLOAD_2:
+            case OPC_FLOAD_3:
+                PUSH(SLOT_VALUE);
+                return true;
+
+            case OPC_LCONST_0:
+            case OPC_LCONST_1:
+            case OPC_DCONST_0:
+            case OPC_DCONST_1:
+            case OPC_LDC2_W:
+            case OPC_LLOAD:
+            case OPC_DLOAD:
+            case OPC_LLOAD_0:
+            case OPC_LLOAD_1:
+            case OPC_LLOAD_2:
+            case OPC_LLOAD_3:
+            case OPC_DLOAD_0:
+            case OPC_DLOAD_1:
+            case OPC_DLOAD_2:
+            case OPC_DLOAD_3:
+                PUSH_VALUES(2);
+                return true;
+
+            case OPC_LDC:
+            case OPC_LDC_W: {
+                int index = opcode == OPC_LDC ? code[pc + 1] : readU2(code, pc + 1);
+                u1 tag = _pool[index]->tag;
+                PUSH(tag == CONSTANT_Integer || tag == CONSTANT_Float ? SLOT_VALUE : SLOT_REFERENCE);
+                return true;
+            }
+
+            case OPC_ALOAD:
+                if (code[pc + 1] >= _maxLocals) {
+                    _failed = true;
+                    return false;
+                }
+                PUSH(locals[code[pc + 1]]);
+                return true;
+
+            case OPC_ALOAD_0:
+            case OPC_ALOAD_1:
+            case OPC_ALOAD_2:
+            case OPC_ALOAD_3: {
+                int index = opcode - OPC_ALOAD_0;
+                if (index >= _maxLocals) {
+                    _failed = true;
+                    return false;
+                }
+                PUSH(locals[index]);
+                return true;
+            }
+
+            case OPC_IALOAD:
+            case OPC_FALOAD:
+            case OPC_BALOAD:
+            case OPC_CALOAD:
+            case OPC_SALOAD:
+                POP(2);
+                PUSH(SLOT_VALUE);
+                return true;
+
+            case OPC_LALOAD:
+            case OPC_DALOAD:
+                POP(2);
+                PUSH_VALUES(2);
+                return true;
+
+            case OPC_AALOAD:
+                POP(2);
+                PUSH(SLOT_REFERENCE);
+                return true;
+
+            case OPC_ISTORE:
+            case OPC_FSTORE:
+                POP(1);
+                STORE(code[pc + 1], SLOT_VALUE, 1);
+                return true;
+
+            case OPC_LSTORE:
+            case OPC_DSTORE:
+                POP(2);
+                STORE(code[pc + 1], SLOT_VALUE, 2);
+                return true;
+
+            case OPC_ASTORE: {
+                if (stack.empty()) {
+                    _failed = true;
+                    return false;
+                }
+                u1 type = stack.back();
+                POP(1);
+                STORE(code[pc + 1], type, 1);
+                return true;
+            }
+
+            case OPC_ISTORE_0:
+            case OPC_ISTORE_1:
+            case OPC_ISTORE_2:
+            case OPC_ISTORE_3:
+                POP(1);
+                STORE(opcode - OPC_ISTORE_0, SLOT_VALUE, 1);
+                return true;
+
+            case OPC_FSTORE_0:
+            case OPC_FSTORE_1:
+            case OPC_FSTORE_2:
+            case OPC_FSTORE_3:
+                POP(1);
+                STORE(opcode - OPC_FSTORE_0, SLOT_VALUE, 1);
+                return true;
+
+            case OPC_LSTORE_0:
+            case OPC_LSTORE_1:
+            case OPC_LSTORE_2:
+            case OPC_LSTORE_3:
+                POP(2);
+                STORE(opcode - OPC_LSTORE_0, SLOT_VALUE, 2);
+                return true;
+
+            case OPC_DSTORE_0:
+            case OPC_DSTORE_1:
+            case OPC_DSTORE_2:
+            case OPC_DSTORE_3:
+                POP(2);
+                STORE(opcode - OPC_DSTORE_0, SLOT_VALUE, 2);
+                return true;
+
+            case OPC_ASTORE_0:
+            case OPC_ASTORE_1:
+            case OPC_ASTORE_2:
+            case OPC_ASTORE_3: {
+                if (stack.empty()) {
+                    _failed = true;
+                    return false;
+                }
+                u1 type = stack.back();
+                POP(1);
+                STORE(opcode - OPC_ASTORE_0, type, 1);
+                return true;
+            }
+
+            case OPC_IASTORE:
+            case OPC_FASTORE:
+            case OPC_AASTORE:
+            case OPC_BASTORE:
+            case OPC_CASTORE:
+            case OPC_SASTORE:
+                POP(3);
+                return true;
+
+            case OPC_LASTORE:
+            case OPC_DASTORE:
+                POP(4);
+                return true;
+
+            case OPC_POP:
+                POP(1);
+                return true;
+
+            case OPC_POP2:
+                POP(2);
+                return true;
+
+            case OPC_DUP: {
+                if (stack.empty()) {
+                    _failed = true;
+                    return false;
+                }
+                u1 v1 = stack.back();
+                PUSH(v1);
+                return true;
+            }
+
+            case OPC_DUP_X1:
+            case OPC_DUP_X2:
+            case OPC_DUP2:
+            case OPC_DUP2_X1:
+            case OPC_DUP2_X2:
+            case OPC_SWAP: {
+                // word-level semantics, category 2 values take two words
+                static const int DEPTH[] = {2, 3, 2, 3, 4, 2};
+                int depth = DEPTH[opcode - OPC_DUP_X1];
+                if (stack.size() < (size_t) depth) {
+                    _failed = true;
+                    return false;
+                }
+                std::vector<u1> top(stack.end() - depth, stack.end());
+                stack.resize(stack.size() - depth);
+                switch (opcode) {
+                    case OPC_DUP_X1:    // v2 v1 -> v1 v2 v1
+                        stack.insert(stack.end(), {top[1], top[0], top[1]});
+                        break;
+                    case OPC_DUP_X2:    // v3 v2 v1 -> v1 v3 v2 v1
+                        stack.insert(stack.end(), {top[2], top[0], top[1], top[2]});
+                        break;
+                    case OPC_DUP2:      // v2 v1 -> v2 v1 v2 v1
+                        stack.insert(stack.end(), {top[0], top[1], top[0], top[1]});
+                        break;
+                    case OPC_DUP2_X1:   // v3 v2 v1 -> v2 v1 v3 v2 v1
+                        stack.insert(stack.end(), {top[1], top[2], top[0], top[1], top[2]});
+                        break;
+                    case OPC_DUP2_X2:   // v4 v3 v2 v1 -> v2 v1 v4 v3 v2 v1
+                        stack.insert(stack.end(), {top[2], top[3], top[0], top[1], top[2], top[3]});
+                        break;
+                    default:            // v2 v1 -> v1 v2
+                        stack.insert(stack.end(), {top[1], top[0]});
+                        break;
+                }
+                if (stack.size() > (size_t) _maxStack) {
+                    _failed = true;
+                    return false;
+                }
+                return true;
+            }
+
+            case OPC_IADD:
+            case OPC_FADD:
+            case OPC_ISUB:
+            case OPC_FSUB:
+            case OPC_IMUL:
+            case OPC_FMUL:
+            case OPC_IDIV:
+            case OPC_FDIV:
+            case OPC_IREM:
+            case OPC_FREM:
+            case OPC_ISHL:
+            case OPC_ISHR:
+            case OPC_IUSHR:
+            case OPC_IAND:
+            case OPC_IOR:
+            case OPC_IXOR:
+            case OPC_FCMPL:
+            case OPC_FCMPG:
+                POP(2);
+                PUSH(SLOT_VALUE);
+                return true;
+
+            case OPC_LADD:
+            case OPC_DADD:
+            case OPC_LSUB:
+            case OPC_DSUB:
+            case OPC_LMUL:
+            case OPC_DMUL:
+            case OPC_LDIV:
+            case OPC_DDIV:
+            case OPC_LREM:
+            case OPC_DREM:
+            case OPC_LAND:
+            case OPC_LOR:
+            case OPC_LXOR:
+                POP(4);
+                PUSH_VALUES(2);
+                return true;
+
+            case OPC_LSHL:
+            case OPC_LSHR:
+            case OPC_LUSHR:
+                POP(3);
+                PUSH_VALUES(2);
+                return true;
+
+            case OPC_INEG:
+            case OPC_FNEG:
+            case OPC_I2F:
+            case OPC_F2I:
+            case OPC_I2B:
+            case OPC_I2C:
+            case OPC_I2S:
+                POP(1);
+                PUSH(SLOT_VALUE);
+                return true;
+
+            case OPC_LNEG:
+            case OPC_DNEG:
+            case OPC_L2D:
+            case OPC_D2L:
+                POP(2);
+                PUSH_VALUES(2);
+                return true;
+
+            case OPC_I2L:
+            case OPC_I2D:
+            case OPC_F2L:
+            case OPC_F2D:
+                POP(1);
+                PUSH_VALUES(2);
+                return true;
+
+            case OPC_L2I:
+            case OPC_L2F:
+            case OPC_D2I:
+            case OPC_D2F:
+                POP(2);
+                PUSH(SLOT_VALUE);
+                return true;
+
+            case OPC_LCMP:
+            case OPC_DCMPL:
+            case OPC_DCMPG:
+                POP(4);
+                PUSH(SLOT_VALUE);
+                return true;
+
+            case OPC_IFEQ:
+            case OPC_IFNE:
+            case OPC_IFLT:
+            case OPC_IFGE:
+            case OPC_IFGT:
+            case OPC_IFLE:
+            case OPC_IFNULL:
+            case OPC_IFNONNULL:
+                POP(1);
+                branchTo(pc, (short) readU2(code, pc + 1), locals, stack);
+                return true;
+
+            case OPC_IF_ICMPEQ:
+            case OPC_IF_ICMPNE:
+            case OPC_IF_ICMPLT:
+            case OPC_IF_ICMPGE:
+            case OPC_IF_ICMPGT:
+            case OPC_IF_ICMPLE:
+            case OPC_IF_ACMPEQ:
+            case OPC_IF_ACMPNE:
+                POP(2);
+                branchTo(pc, (short) readU2(code, pc + 1), locals, stack);
+                return true;
+
+            case OPC_GOTO:
+                branchTo(pc, (short) readU2(code, pc + 1), locals, stack);
+                return false;
+
+            case OPC_GOTO_W:
+                branchTo(pc, readS4(code, pc + 1), locals, stack);
+                return false;
+
+            case OPC_TABLESWITCH: {
+                POP(1);
+                u4 base = (pc + 4) & ~3u;
+                branchTo(pc, readS4(code, base), locals, stack);
+                int low = readS4(code, base + 4);
+                int high = readS4(code, base + 8);
+                for (int i = 0; i <= high - low; ++i) {
+                    branchTo(pc, readS4(code, base + 12 + i * 4), locals, stack);
+                }
+                return false;
+            }
+
+            case OPC_LOOKUPSWITCH: {
+                POP(1);
+                u4 base = (pc + 4) & ~3u;
+                branchTo(pc, readS4(code, base), locals, stack);
+                int pairs = readS4(code, base + 4);
+                for (int i = 0; i < pairs; ++i) {
+                    branchTo(pc, readS4(code, base + 12 + i * 8), locals, stack);
+                }
+                return false;
+            }
+
+            case OPC_IRETURN:
+            case OPC_LRETURN:
+            case OPC_FRETURN:
+            case OPC_DRETURN:
+            case OPC_ARETURN:
+            case OPC_RETURN:
+            case OPC_ATHROW:
+                return false;
+
+            case OPC_GETSTATIC:
+            case OPC_PUTSTATIC:
+            case OPC_GETFIELD:
+            case OPC_PUTFIELD: {
+                auto *nameAndType = nameAndTypeOfMember(readU2(code, pc + 1));
+                if (nameAndType == nullptr) {
+                    _failed = true;
+                    return false;
+                }
+                auto *utf8 = utf8At(nameAndType->descriptor_index);
+                std::vector<u1> field;
+                int i = 0;
+                if (!parseFieldType(utf8->bytes, utf8->length, &i, &field)) {
+                    _failed = true;
+                    return false;
+                }
+
+                if (opcode == OPC_GETFIELD) {
+                    POP(1);
+                }
+                if (opcode == OPC_PUTSTATIC || opcode == OPC_PUTFIELD) {
+                    POP((int) field.size() + (opcode == OPC_PUTFIELD ? 1 : 0));
+                } else {
+                    stack.insert(stack.end(), field.begin(), field.end());
+                }
+                return true;
+            }
+
+            case OPC_INVOKEVIRTUAL:
+            case OPC_INVOKESPECIAL:
+            case OPC_INVOKESTATIC:
+            case OPC_INVOKEINTERFACE:
+            case OPC_INVOKEDYNAMIC: {
+                auto *nameAndType = nameAndTypeOfMember(readU2(code, pc + 1));
+                if (nameAndType == nullptr) {
+                    _failed = true;
+                    return false;
+                }
+                std::vector<u1> args;
+                std::vector<u1> result;
+                auto *utf8 = utf8At(nameAndType->descriptor_index);
+                if (!parseMethodType(utf8->bytes, utf8->length, &args, &result)) {
+                    _failed = true;
+                    return false;
+                }
+
+                bool hasReceiver = opcode != OPC_INVOKESTATIC && opcode != OPC_INVOKEDYNAMIC;
+                POP((int) args.size() + (hasReceiver ? 1 : 0));
+                stack.insert(stack.end(), result.begin(), result.end());
+                return true;
+            }
+
+            case OPC_NEW:
+                PUSH(SLOT_REFERENCE);
+                return true;
+
+            case OPC_NEWARRAY:
+            case OPC_ANEWARRAY:
+            case OPC_CHECKCAST:
+                POP(1);
+                PUSH(SLOT_REFERENCE);
+                return true;
+
+            case OPC_ARRAYLENGTH:
+            case OPC_INSTANCEOF:
+                POP(1);
+                PUSH(SLOT_VALUE);
+                return true;
+
+            case OPC_MONITORENTER:
+            case OPC_MONITOREXIT:
+                POP(1);
+                return true;
+
+            case OPC_MULTIANEWARRAY:
+                POP(code[pc + 3]);
+                PUSH(SLOT_REFERENCE);
+                return true;
+
+            case OPC_WIDE: {
+                u1 widened = code[pc + 1];
+                int index = readU2(code, pc + 2);
+                switch (widened) {
+                    case OPC_IINC:
+                        return true;
+                    case OPC_ILOAD:
+                    case OPC_FLOAD:
+                        PUSH(SLOT_VALUE);
+                        return true;
+                    case OPC_LLOAD:
+                    case OPC_DLOAD:
+                        PUSH_VALUES(2);
+                        return true;
+                    case OPC_ALOAD:
+                        if (index >= _maxLocals) {
+                            _failed = true;
+                            return false;
+                        }
+                        PUSH(locals[index]);
+                        return true;
+                    case OPC_ISTORE:
+                    case OPC_FSTORE:
+                        POP(1);
+                        STORE(index, SLOT_VALUE, 1);
+                        return true;
+                    case OPC_LSTORE:
+                    case OPC_DSTORE:
+                        POP(2);
+                        STORE(index, SLOT_VALUE, 2);
+                        return true;
+                    case OPC_ASTORE: {
+                        if (stack.empty()) {
+                            _failed = true;
+                            return false;
+                        }
+                        u1 type = stack.back();
+                        POP(1);
+                        STORE(index, type, 1);
+                        return true;
+                    }
+                    default:
+                        // wide ret
+                        _failed = true;
+                        return false;
+                }
+            }
+
+            default:
+                // jsr, ret and reserved opcodes are not supported
+                _failed = true;
+                return false;
+        }
+    }
+
+#undef POP
+#undef PUSH
+#undef PUSH_VALUES
+#undef STORE
+
+    MethodOopMaps *OopMapBuilder::build() {
+        auto *maps = new MethodOopMaps;
+        maps->_precise = false;
+        if (_code == nullptr || _code->code_length == 0 || _pool == nullptr) {
+            return maps;
+        }
+
+        _instructionIndex.assign(_code->code_length, -1);
+        if (!decodeInstructions()) {
+            D("OopMap: cannot decode %s", strings::toStdString(_method->getName()).c_str());
+            return maps;
+        }
+        _states.resize(_starts.size());
+        _declared.assign(_starts.size(), false);
+        _backwardTargets.assign(_starts.size(), false);
+
+        seedFromStackMapTable();
+
+        // entry state: receiver and arguments
+        std::vector<u1> entryLocals;
+        if (!_method->isStatic()) {
+            entryLocals.push_back(SLOT_REFERENCE);
+        }
+        std::vector<u1> result;
+        const String &descriptor = _method->getDescriptor();
+        if (!parseMethodType(descriptor.c_str(), (int) descriptor.size(), &entryLocals, &result)
+            || entryLocals.size() > (size_t) _maxLocals) {
+            return maps;
+        }
+        entryLocals.resize((size_t) _maxLocals, SLOT_TOP);
+        mergeInto(0, entryLocals, {});
+
+        while (!_worklist.empty() && !_failed) {
+            int index = _worklist.front();
+            _worklist.pop_front();
+
+            u4 pc = _starts[index];
+            std::vector<u1> locals = _states[index]._locals;
+            std::vector<u1> stack = _states[index]._stack;
+
+            propagateToHandlers(pc, locals);
+            bool fallThrough = interpret(pc, locals, stack);
+            if (_failed) {
+                break;
+            }
+            if (stack.size() > (size_t) _maxStack) {
+                _failed = true;
+                break;
+            }
+
+            // a store inside a try block is visible to the handler
+            propagateToHandlers(pc, locals);
+
+            if (fallThrough) {
+                if (index + 1 >= (int) _starts.size()) {
+                    _failed = true;
+                    break;
+                }
+                mergeInto(index + 1, locals, stack);
+            }
+        }
+
+        if (_failed) {
+            D("OopMap: analysis failed in %s.%s, fallback to conservative scanning",
+              strings::toStdString(_method->getClass()->getName()).c_str(),
+              strings::toStdString(_method->getName()).c_str());
+            return maps;
+        }
+
+        for (int index = 0; index < (int) _starts.size(); ++index) {
+            const TypeState &state = _states[index];
+            u4 pc = _starts[index];
+            if (!state._reached) {
+                continue;
+            }
+            if (pc != 0 && !_backwardTargets[index] && !isSafepointInstruction(_code->code[pc])) {
+                continue;
+            }
+
+            OopMap map;
+            map._startPc = pc;
+            map._endPc = index + 1 < (int) _starts.size() ? _starts[index + 1] : _code->code_length;
+            map._maxLocals = _maxLocals;
+            map._stackDepth = (int) state._stack.size();
+            map._references.resize((size_t) (_maxLocals + map._stackDepth), false);
+            for (int i = 0; i < _maxLocals; ++i) {
+                map._references[i] = state._locals[i] == SLOT_REFERENCE;
+            }
+            for (int i = 0; i < map._stackDepth; ++i) {
+                map._references[_maxLocals + i] = state._stack[i] == SLOT_REFERENCE;
+            }
+            maps->_maps.push_back(std::move(map));
+        }
+        maps->_precise = true;
+        return maps;
+    }
+
+    const OopMap *MethodOopMaps::find(u4 pc) const {
+        auto iter = std::upper_bound(_maps.begin(), _maps.end(), pc,
+                                     [](u4 pc, const OopMap &map) {
+                                         return pc < map.getStartPc();
+                                     });
+        if (iter == _maps.begin()) {
+            return nullptr;
+        }
+        --iter;
+        return iter->covers(pc) ? &*iter : nullptr;
+    }
+
+    const OopMap *MethodOopMaps::findEndingAt(u4 pc) const {
+        if (pc == 0) {
+            return nullptr;
+        }
+        const OopMap *map = find(pc - 1);
+        return map != nullptr && map->getEndPc() == pc ? map : nullptr;
+    }
+
+    static inline size_t hashMethod(Method *method) {
+        return std::hash<Method *>()(method);
+    }
+
+    OopMapCache *OopMapCache::get() {
+        static OopMapCache cache(OopMapStore::get());
+        return &cache;
+    }
+
+    OopMapCache::OopMapCache(OopMapStore *store)
+        : _entries(INITIAL_CAPACITY), _store(store) {
+    }
+
+    OopMapCache::~OopMapCache() {
+        _entries.forEach([](Entry *entry) {
+            delete entry->maps;
+            delete entry;
+        });
+    }
+
+    const MethodOopMaps *OopMapCache::lookup(Method *method) const {
+        Entry *entry = _entries.find(hashMethod(method), [method](const Entry *each) {
+            return each->method == method;
+        });
+        return entry != nullptr ? entry->maps : nullptr;
+    }
+
+    const MethodOopMaps *OopMapCache::prepare(Method *method) {
+        const MethodOopMaps *prepared = lookup(method);
+        if (prepared != nullptr) {
+            return prepared;
+        }
+
+        MethodOopMaps *maps = _store != nullptr ? _store->load(method) : nullptr;
+        if (maps == nullptr) {
+            maps = OopMapBuilder(method).build();
+            if (_store != nullptr) {
+                _store->store(method, maps);
+            }
+        }
+
+        // Another thread may have prepared the same method meanwhile.
+        size_t hash = hashMethod(method);
+        Entry *entry = _entries.findOrInsert(hash, [method](const Entry *each) {
+            return each->method == method;
+        }, [hash, method, maps] {
+            return new Entry{hash, method, maps};
+        });
+        if (entry->maps != maps) {
+            delete maps;
+        }
+        return entry->maps;
+    }
+}
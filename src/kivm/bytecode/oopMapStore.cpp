@@ -0,0 +1,204 @@
+//
+// Created by kiva on 2018/4/25.
+//
+
+#include <kivm/bytecode/oopMapStore.h>
+#include <kivm/bytecode/oopMap.h>
+#include <kivm/oop/instanceKlass.h>
+#include <kivm/runtime/runtimeConfig.h>
+#include <kivm/method.h>
+#include <shared/files.h>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+namespace kivm {
+    const char OopMapStore::MAGIC[8] = {'K', 'I', 'V', 'M', 'O', 'M', 'C', '\0'};
+
+    static u8 hashBytes(const void *data, size_t length, u8 hash = 14695981039346656037ull) {
+        // 64-bit FNV-1a
+        const auto *bytes = (const u1 *) data;
+        for (size_t i = 0; i < length; ++i) {
+            hash = (hash ^ bytes[i]) * 1099511628211ull;
+        }
+        return hash;
+    }
+
+    static bool readFile(const std::string &path, std::vector<u1> *bytes) {
+        std::ifstream in(path, std::ios::binary);
+        if (!in) {
+            return false;
+        }
+        bytes->assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        return !in.bad();
+    }
+
+    OopMapStore *OopMapStore::get() {
+        static OopMapStore *store = RuntimeConfig::get().oopMapCacheDirectory.empty()
+                                    ? nullptr
+                                    : new OopMapStore(RuntimeConfig::get().oopMapCacheDirectory);
+        return store;
+    }
+
+    OopMapStore::OopMapStore(const std::string &directory, u4 analysisVersion)
+        : _directory(directory), _analysisVersion(analysisVersion),
+          _directoryCreated(false), _loadCount(0), _storeCount(0), _rejectCount(0) {
+    }
+
+    std::string OopMapStore::getPath(Method *method, u8 *contentHash, u4 *methodIndex) {
+        InstanceKlass *klass = method->getClass();
+        ClassFile *classFile = klass->getClassFile();
+        if (classFile == nullptr || classFile->content == nullptr
+            || method->getCodeAttribute() == nullptr) {
+            return "";
+        }
+
+        LockGuard lockGuard(_lock);
+        auto iter = _contentHashes.find(klass);
+        if (iter == _contentHashes.end()) {
+            iter = _contentHashes.insert(std::make_pair(
+                klass, hashBytes(classFile->content, classFile->content_length))).first;
+        }
+        *contentHash = iter->second;
+        *methodIndex = (u4) (method->getMethodInfo() - classFile->methods);
+
+        u8 key = hashBytes(&_analysisVersion, sizeof(_analysisVersion), *contentHash);
+        char name[48];
+        snprintf(name, sizeof(name), "/%016llx-%u.oopmap", key, *methodIndex);
+        return _directory + name;
+    }
+
+    bool OopMapStore::readMaps(const std::vector<u1> &bytes, Method *method,
+                               u8 contentHash, u4 methodIndex, MethodOopMaps *maps) {
+        if (bytes.size() < sizeof(Header)) {
+            return false;
+        }
+
+        Header header{};
+        memcpy(&header, bytes.data(), sizeof(header));
+        Code_attribute *code = method->getCodeAttribute();
+        if (memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0
+            || header.version != VERSION
+            || header.methodIndex != methodIndex
+            || header.contentHash != contentHash
+            || header.contentLength != method->getClass()->getClassFile()->content_length
+            || header.codeLength != code->code_length
+            || header.analysisVersion != _analysisVersion) {
+            return false;
+        }
+
+        // Every map takes a record, do not trust the count any further.
+        if (header.mapCount > (bytes.size() - sizeof(Header)) / sizeof(MapRecord)) {
+            return false;
+        }
+
+        size_t offset = sizeof(Header);
+        maps->_precise = header.precise != 0;
+        maps->_maps.reserve(header.mapCount);
+        for (u4 i = 0; i < header.mapCount; ++i) {
+            if (offset + sizeof(MapRecord) > bytes.size()) {
+                return false;
+            }
+            MapRecord record{};
+            memcpy(&record, bytes.data() + offset, sizeof(record));
+            offset += sizeof(record);
+
+            u4 previousEnd = maps->_maps.empty() ? 0 : maps->_maps.back()._endPc;
+            if (record.startPc < previousEnd || record.startPc >= record.endPc
+                || record.endPc > code->code_length
+                || record.maxLocals != code->max_locals || record.stackDepth > code->max_stack) {
+                return false;
+            }
+
+            size_t slots = record.maxLocals + record.stackDepth;
+            if (offset + (slots + 7) / 8 > bytes.size()) {
+                return false;
+            }
+            OopMap map;
+            map._startPc = record.startPc;
+            map._endPc = record.endPc;
+            map._maxLocals = (int) record.maxLocals;
+            map._stackDepth = (int) record.stackDepth;
+            map._references.resize(slots);
+            for (size_t slot = 0; slot < slots; ++slot) {
+                map._references[slot] = (bytes[offset + slot / 8] & (1 << (slot % 8))) != 0;
+            }
+            offset += (slots + 7) / 8;
+            maps->_maps.push_back(std::move(map));
+        }
+        return offset == bytes.size();
+    }
+
+    MethodOopMaps *OopMapStore::load(Method *method) {
+        u8 contentHash = 0;
+        u4 methodIndex = 0;
+        const std::string &path = getPath(method, &contentHash, &methodIndex);
+        std::vector<u1> bytes;
+        if (path.empty() || !readFile(path, &bytes)) {
+            return nullptr;
+        }
+
+        auto *maps = new MethodOopMaps;
+        if (!readMaps(bytes, method, contentHash, methodIndex, maps)) {
+            D("Ignored stale oop map file %s", path.c_str());
+            delete maps;
+            LockGuard lockGuard(_lock);
+            ++_rejectCount;
+            return nullptr;
+        }
+
+        LockGuard lockGuard(_lock);
+        ++_loadCount;
+        return maps;
+    }
+
+    bool OopMapStore::store(Method *method, const MethodOopMaps *maps) {
+        u8 contentHash = 0;
+        u4 methodIndex = 0;
+        const std::string &path = getPath(method, &contentHash, &methodIndex);
+        if (path.empty()) {
+            return false;
+        }
+
+        Header header{};
+        memcpy(header.magic, MAGIC, sizeof(MAGIC));
+        header.version = VERSION;
+        header.methodIndex = methodIndex;
+        header.contentHash = contentHash;
+        header.contentLength = (u4) method->getClass()->getClassFile()->content_length;
+        header.codeLength = method->getCodeAttribute()->code_length;
+        header.analysisVersion = _analysisVersion;
+        header.precise = maps->_precise ? 1 : 0;
+        header.mapCount = (u4) maps->_maps.size();
+
+        std::vector<u1> bytes((const u1 *) &header, (const u1 *) &header + sizeof(header));
+        for (const OopMap &map : maps->_maps) {
+            MapRecord record{map._startPc, map._endPc, (u4) map._maxLocals, (u4) map._stackDepth};
+            bytes.insert(bytes.end(), (const u1 *) &record, (const u1 *) &record + sizeof(record));
+            size_t offset = bytes.size();
+            bytes.resize(offset + (map._references.size() + 7) / 8, 0);
+            for (size_t slot = 0; slot < map._references.size(); ++slot) {
+                if (map._references[slot]) {
+                    bytes[offset + slot / 8] |= (u1) (1 << (slot % 8));
+                }
+            }
+        }
+
+        {
+            LockGuard lockGuard(_lock);
+            if (!_directoryCreated) {
+                _directoryCreated = files::makeDirectory(_directory);
+            }
+        }
+
+        // Other VMs may be writing the same file.
+        if (!files::replaceFile(path, bytes.data(), bytes.size())) {
+            return false;
+        }
+
+        LockGuard lockGuard(_lock);
+        ++_storeCount;
+        return true;
+    }
+}
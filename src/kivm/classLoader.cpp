@@ -2,18 +2,11 @@
 // Created by kiva on 2018/2/27.
 //
 
-#include <unordered_map>
 #include <kivm/classLoader.h>
 #include <kivm/system.h>
 #include <kivm/oop/klass.h>
-#include <shared/lock.h>
 
 namespace kivm {
-    static RecursiveLock &get_bootstrap_lock() {
-        static RecursiveLock lock;
-        return lock;
-    }
-
     Klass *ClassLoader::requireClass(ClassLoader *classLoader, const String &className) {
         if (classLoader == nullptr) {
             // This is a bootstrap class
@@ -35,22 +28,102 @@ namespace kivm {
         return &classLoader;
     }
 
-    Klass *BootstrapClassLoader::loadClass(const String &className) {
-        RecursiveLockGuard guard(get_bootstrap_lock());
+    bool BootstrapClassLoader::isWaitingFor(std::thread::id owner, std::thread::id current) {
+        // at most one step per waiting thread
+        for (size_t step = 0; step <= _waiting.size(); ++step) {
+            auto waiting = _waiting.find(owner);
+            if (waiting == _waiting.end()) {
+                return false;
+            }
+            auto placeholder = _placeholders.find(waiting->second);
+            if (placeholder == _placeholders.end()) {
+                return false;
+            }
+            owner = placeholder->second.owner;
+            if (owner == current) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    Klass *BootstrapClassLoader::loadArrayClass(const String &className) {
+        auto *klass = BaseClassLoader::loadClass(className);
+        if (klass == nullptr) {
+            return nullptr;
+        }
+
+        klass->setClassState(ClassState::LOADED);
+        klass->linkAndInit();
+        Klass *loaded = SystemDictionary::get()->put(className, klass);
+        if (loaded != klass) {
+            delete klass;
+        }
+        return loaded;
+    }
 
+    Klass *BootstrapClassLoader::loadClass(const String &className) {
         // check whether class is already loaded
         auto iter = SystemDictionary::get()->find(className);
         if (iter != nullptr) {
             return iter;
         }
 
+        if (className[0] == L'[') {
+            return loadArrayClass(className);
+        }
+
+        std::thread::id current = std::this_thread::get_id();
+        {
+            std::unique_lock<Lock> lock(_placeholderLock);
+            while (true) {
+                iter = SystemDictionary::get()->find(className);
+                if (iter != nullptr) {
+                    return iter;
+                }
+
+                auto placeholder = _placeholders.find(className);
+                if (placeholder == _placeholders.end()) {
+                    _placeholders.insert(std::make_pair(className, Placeholder{current, nullptr}));
+                    break;
+                }
+
+                const Placeholder &loading = placeholder->second;
+                if (loading.owner == current || isWaitingFor(loading.owner, current)) {
+                    if (loading.klass == nullptr) {
+                        // TODO: throw ClassCircularityError
+                        PANIC("ClassCircularityError");
+                    }
+                    // referred to while linking
+                    return loading.klass;
+                }
+
+                // If the other loader fails, try again here.
+                _waiting[current] = className;
+                _placeholderRemoved.wait(lock);
+                _waiting.erase(current);
+            }
+        }
+
         // OK, let's find it!
         auto *klass = BaseClassLoader::loadClass(className);
         if (klass != nullptr) {
-            SystemDictionary::get()->put(className, klass);
             klass->setClassState(ClassState::LOADED);
+            {
+                LockGuard lockGuard(_placeholderLock);
+                _placeholders[className].klass = klass;
+            }
+
+            // Other threads see the class once it is linked.
             klass->linkAndInit();
+            SystemDictionary::get()->put(className, klass);
+        }
+
+        {
+            LockGuard lockGuard(_placeholderLock);
+            _placeholders.erase(className);
         }
+        _placeholderRemoved.notify_all();
         return klass;
     }
 }
@@ -127,7 +127,9 @@ namespace kivm {
         info.frame_type = stream.get1();
         info.offset_delta = stream.get2();
         if (info.frame_type - 251 >= 0) {
-            info.locals = new StackMapTable_attribute::verification_type_info *[info.frame_type - 251];
+            info.locals =
+                    stream.getArena()->newArray<StackMapTable_attribute::verification_type_info *>(
+                            info.frame_type - 251);
         }
         for (int i = 0; i < info.frame_type - 251; i++) {
             info.locals[i] = parse_verification_type(stream);
@@ -139,12 +141,15 @@ namespace kivm {
         info.frame_type = stream.get1();
         info.offset_delta = stream.get2();
         info.number_of_locals = stream.get2();
-        info.locals = new StackMapTable_attribute::verification_type_info *[info.number_of_locals];
+        info.locals =
+                stream.getArena()->newArray<StackMapTable_attribute::verification_type_info *>(info.number_of_locals);
         for (int i = 0; i < info.number_of_locals; i++) {
             info.locals[i] = parse_verification_type(stream);
         }
         info.number_of_stack_items = stream.get2();
-        info.stack = new StackMapTable_attribute::verification_type_info *[info.number_of_stack_items];
+        info.stack =
+                stream.getArena()->newArray<StackMapTable_attribute::verification_type_info *>(
+                        info.number_of_stack_items);
         for (int j = 0; j < info.number_of_stack_items; j++) {
             info.stack[j] = parse_verification_type(stream);
         }
@@ -154,7 +159,7 @@ namespace kivm {
     ClassFileStream &operator>>(ClassFileStream &stream, StackMapTable_attribute &attr) {
         stream >> *((attribute_info *) &attr);
         attr.number_of_entries = stream.get2();
-        attr.entries = new StackMapTable_attribute::stack_map_frame *[attr.number_of_entries];
+        attr.entries = stream.getArena()->newArray<StackMapTable_attribute::stack_map_frame *>(attr.number_of_entries);
         for (int i = 0; i < attr.number_of_entries; i++) {
             attr.entries[i] = parse_stack_map_frame(stream);
         }
@@ -170,7 +175,7 @@ namespace kivm {
     ClassFileStream &operator>>(ClassFileStream &stream, Exceptions_attribute &attr) {
         stream >> *((attribute_info *) &attr);
         attr.number_of_exceptions = stream.get2();
-        attr.exception_index_table = new u2[attr.number_of_exceptions];
+        attr.exception_index_table = stream.getArena()->newArray<u2>(attr.number_of_exceptions);
         for (int i = 0; i < attr.number_of_exceptions; i++) {
             attr.exception_index_table[i] = stream.get2();
         }
@@ -188,7 +193,7 @@ namespace kivm {
     ClassFileStream &operator>>(ClassFileStream &stream, InnerClasses_attribute &attr) {
         stream >> *((attribute_info *) &attr);
         attr.number_of_classes = stream.get2();
-        attr.classes = new classes_t[attr.number_of_classes];
+        attr.classes = stream.getArena()->newArray<classes_t>(attr.number_of_classes);
         for (int i = 0; i < attr.number_of_classes; i++) {
             stream >> attr.classes[i];
         }
@@ -221,8 +226,7 @@ namespace kivm {
 
     ClassFileStream &operator>>(ClassFileStream &stream, SourceDebugExtension_attribute &attr) {
         stream >> *((attribute_info *) &attr);
-        attr.debug_extension = new u1[attr.attribute_length];
-        stream.getBytes(attr.debug_extension, attr.attribute_length);
+        attr.debug_extension = stream.getBytesInPlace(attr.attribute_length);
         return stream;
     }
 
@@ -235,7 +239,7 @@ namespace kivm {
     ClassFileStream &operator>>(ClassFileStream &stream, LineNumberTable_attribute &attr) {
         stream >> *((attribute_info *) &attr);
         attr.line_number_table_length = stream.get2();
-        attr.line_number_table = new line_number_table_t[attr.line_number_table_length];
+        attr.line_number_table = stream.getArena()->newArray<line_number_table_t>(attr.line_number_table_length);
         for (int i = 0; i < attr.line_number_table_length; i++) {
             stream >> attr.line_number_table[i];
         }
@@ -254,7 +258,8 @@ namespace kivm {
     ClassFileStream &operator>>(ClassFileStream &stream, LocalVariableTable_attribute &attr) {
         stream >> *((attribute_info *) &attr);
         attr.local_variable_table_length = stream.get2();
-        attr.local_variable_table = new local_variable_table_t[attr.local_variable_table_length];
+        attr.local_variable_table =
+                stream.getArena()->newArray<local_variable_table_t>(attr.local_variable_table_length);
         for (int i = 0; i < attr.local_variable_table_length; i++) {
             stream >> attr.local_variable_table[i];
         }
@@ -275,7 +280,7 @@ namespace kivm {
         stream >> *((attribute_info *) &attr);
         attr.local_variable_type_table_length = stream.get2();
         attr.local_variable_type_table =
-                new local_variable_type_table_t[attr.local_variable_type_table_length];
+                stream.getArena()->newArray<local_variable_type_table_t>(attr.local_variable_type_table_length);
         for (int i = 0; i < attr.local_variable_type_table_length; i++) {
             stream >> attr.local_variable_type_table[i];
         }
@@ -290,7 +295,7 @@ namespace kivm {
     ClassFileStream &operator>>(ClassFileStream &stream, bootstrap_methods_t &attr) {
         attr.bootstrap_method_ref = stream.get2();
         attr.num_bootstrap_arguments = stream.get2();
-        attr.bootstrap_arguments = new u2[attr.num_bootstrap_arguments];
+        attr.bootstrap_arguments = stream.getArena()->newArray<u2>(attr.num_bootstrap_arguments);
         for (int i = 0; i < attr.num_bootstrap_arguments; i++) {
             attr.bootstrap_arguments[i] = stream.get2();
         }
@@ -300,7 +305,7 @@ namespace kivm {
     ClassFileStream &operator>>(ClassFileStream &stream, BootstrapMethods_attribute &attr) {
         stream >> *((attribute_info *) &attr);
         attr.num_bootstrap_methods = stream.get2();
-        attr.bootstrap_methods = new bootstrap_methods_t[attr.num_bootstrap_methods];
+        attr.bootstrap_methods = stream.getArena()->newArray<bootstrap_methods_t>(attr.num_bootstrap_methods);
         for (int i = 0; i < attr.num_bootstrap_methods; i++) {
             stream >> attr.bootstrap_methods[i];
         }
@@ -316,7 +321,7 @@ namespace kivm {
     ClassFileStream &operator>>(ClassFileStream &stream, MethodParameters_attribute &attr) {
         stream >> *((attribute_info *) &attr);
         attr.parameters_count = stream.get1();
-        attr.parameters = new parameters_t[attr.parameters_count];
+        attr.parameters = stream.getArena()->newArray<parameters_t>(attr.parameters_count);
         for (int i = 0; i < attr.parameters_count; i++) {
             stream >> attr.parameters[i];
         }
@@ -346,7 +351,7 @@ namespace kivm {
     ClassFileStream &operator>>(ClassFileStream &stream, annotation &info) {
         info.type_index = stream.get2();
         info.num_element_value_pairs = stream.get2();
-        info.element_value_pairs = new element_value_pairs_t[info.num_element_value_pairs];
+        info.element_value_pairs = stream.getArena()->newArray<element_value_pairs_t>(info.num_element_value_pairs);
         for (int i = 0; i < info.num_element_value_pairs; i++) {
             stream >> info.element_value_pairs[i];
         }
@@ -365,27 +370,27 @@ namespace kivm {
             case 'S':
             case 'Z':
             case 's': {
-                info.value = new const_value_t;
+                info.value = stream.getArena()->newObject<const_value_t>();
                 stream >> *(const_value_t *) info.value;
                 break;
             }
             case 'e': {
-                info.value = new enum_const_value_t;
+                info.value = stream.getArena()->newObject<enum_const_value_t>();
                 stream >> *(enum_const_value_t *) info.value;
                 break;
             }
             case 'c': {
-                info.value = new class_info_t;
+                info.value = stream.getArena()->newObject<class_info_t>();
                 stream >> *(class_info_t *) info.value;
                 break;
             }
             case '@': {
-                info.value = new annotation;
+                info.value = stream.getArena()->newObject<annotation>();
                 stream >> *(annotation *) info.value;
                 break;
             }
             case '[': {
-                info.value = new array_value_t;
+                info.value = stream.getArena()->newObject<array_value_t>();
                 stream >> *(array_value_t *) info.value;
                 break;
             }
@@ -404,7 +409,7 @@ namespace kivm {
 
     ClassFileStream &operator>>(ClassFileStream &stream, array_value_t &info) {
         info.num_values = stream.get2();
-        info.values = new element_value[info.num_values];
+        info.values = stream.getArena()->newArray<element_value>(info.num_values);
         for (int i = 0; i < info.num_values; i++) {
             stream >> info.values[i];
         }
@@ -450,7 +455,7 @@ namespace kivm {
 
     ClassFileStream &operator>>(ClassFileStream &stream, type_annotation::localvar_target &info) {
         info.table_length = stream.get2();
-        info.table = new type_annotation::table_t[info.table_length];
+        info.table = stream.getArena()->newArray<type_annotation::table_t>(info.table_length);
         for (int i = 0; i < info.table_length; i++) {
             stream >> info.table[i];
         }
@@ -482,7 +487,7 @@ namespace kivm {
 
     ClassFileStream &operator>>(ClassFileStream &stream, type_annotation::type_path &info) {
         info.path_length = stream.get1();
-        info.path = new type_annotation::path_t[info.path_length];
+        info.path = stream.getArena()->newArray<type_annotation::path_t>(info.path_length);
         for (int i = 0; i < info.path_length; i++) {
             stream >> info.path[i];
         }
@@ -492,59 +497,59 @@ namespace kivm {
     ClassFileStream &operator>>(ClassFileStream &stream, type_annotation &info) {
         info.target_type = stream.get1();
         if (info.target_type == 0x00 || info.target_type == 0x01) {
-            auto *result = new type_annotation::type_parameter_target;
+            auto *result = stream.getArena()->newObject<type_annotation::type_parameter_target>();
             stream >> *result;
             info.target_info = result;
         } else if (info.target_type == 0x10) {
-            auto *result = new type_annotation::supertype_target;
+            auto *result = stream.getArena()->newObject<type_annotation::supertype_target>();
             stream >> *result;
             info.target_info = result;
         } else if (info.target_type == 0x11 || info.target_type == 0x12) {
-            auto *result = new type_annotation::type_parameter_bound_target;
+            auto *result = stream.getArena()->newObject<type_annotation::type_parameter_bound_target>();
             stream >> *result;
             info.target_info = result;
         } else if (info.target_type == 0x13 || info.target_type == 0x14 || info.target_type == 0x15) {
-            auto *result = new type_annotation::empty_target;
+            auto *result = stream.getArena()->newObject<type_annotation::empty_target>();
             stream >> *result;
             info.target_info = result;
         } else if (info.target_type == 0x16) {
-            auto *result = new type_annotation::formal_parameter_target;
+            auto *result = stream.getArena()->newObject<type_annotation::formal_parameter_target>();
             stream >> *result;
             info.target_info = result;
         } else if (info.target_type == 0x17) {
-            auto *result = new type_annotation::throws_target;
+            auto *result = stream.getArena()->newObject<type_annotation::throws_target>();
             stream >> *result;
             info.target_info = result;
         } else if (info.target_type == 0x40 || info.target_type == 0x41) {
-            auto *result = new type_annotation::localvar_target;
+            auto *result = stream.getArena()->newObject<type_annotation::localvar_target>();
             stream >> *result;
             info.target_info = result;
         } else if (info.target_type == 0x42) {
-            auto *result = new type_annotation::catch_target;
+            auto *result = stream.getArena()->newObject<type_annotation::catch_target>();
             stream >> *result;
             info.target_info = result;
         } else if (info.target_type == 0x43 || info.target_type == 0x44 || info.target_type == 0x45 ||
                    info.target_type == 0x46) {
-            auto *result = new type_annotation::offset_target;
+            auto *result = stream.getArena()->newObject<type_annotation::offset_target>();
             stream >> *result;
             info.target_info = result;
         } else if (info.target_type == 0x47 || info.target_type == 0x48 || info.target_type == 0x49 ||
                    info.target_type == 0x4A || info.target_type == 0x4B) {
-            auto *result = new type_annotation::type_argument_target;
+            auto *result = stream.getArena()->newObject<type_annotation::type_argument_target>();
             stream >> *result;
             info.target_info = result;
         } else {
             assert(false);
         }
         stream >> info.target_path;
-        info.annotations = new annotation;
+        info.annotations = stream.getArena()->newObject<annotation>();
         stream >> *info.annotations;
         return stream;
     }
 
     ClassFileStream &operator>>(ClassFileStream &stream, parameter_annotations_t &info) {
         info.num_annotations = stream.get2();
-        info.annotations = new annotation[info.num_annotations];
+        info.annotations = stream.getArena()->newArray<annotation>(info.num_annotations);
         for (int i = 0; i < info.num_annotations; i++) {
             stream >> info.annotations[i];
         }
@@ -566,7 +571,7 @@ namespace kivm {
     ClassFileStream &operator>>(ClassFileStream &stream, RuntimeVisibleParameterAnnotations_attribute &info) {
         stream >> *((attribute_info *) &info);
         info.num_parameters = stream.get1();
-        info.parameter_annotations = new parameter_annotations_t[info.num_parameters];
+        info.parameter_annotations = stream.getArena()->newArray<parameter_annotations_t>(info.num_parameters);
         for (int i = 0; i < info.num_parameters; i++) {
             stream >> info.parameter_annotations[i];
         }
@@ -576,7 +581,7 @@ namespace kivm {
     ClassFileStream &operator>>(ClassFileStream &stream, RuntimeInvisibleParameterAnnotations_attribute &info) {
         stream >> *((attribute_info *) &info);
         info.num_parameters = stream.get1();
-        info.parameter_annotations = new parameter_annotations_t[info.num_parameters];
+        info.parameter_annotations = stream.getArena()->newArray<parameter_annotations_t>(info.num_parameters);
         for (int i = 0; i < info.num_parameters; i++) {
             stream >> info.parameter_annotations[i];
         }
@@ -586,7 +591,7 @@ namespace kivm {
     ClassFileStream &operator>>(ClassFileStream &stream, RuntimeVisibleTypeAnnotations_attribute &info) {
         stream >> *((attribute_info *) &info);
         info.num_annotations = stream.get2();
-        info.annotations = new type_annotation[info.num_annotations];
+        info.annotations = stream.getArena()->newArray<type_annotation>(info.num_annotations);
         for (int i = 0; i < info.num_annotations; i++) {
             stream >> info.annotations[i];
         }
@@ -596,7 +601,7 @@ namespace kivm {
     ClassFileStream &operator>>(ClassFileStream &stream, RuntimeInvisibleTypeAnnotations_attribute &info) {
         stream >> *((attribute_info *) &info);
         info.num_annotations = stream.get2();
-        info.annotations = new type_annotation[info.num_annotations];
+        info.annotations = stream.getArena()->newArray<type_annotation>(info.num_annotations);
         for (int i = 0; i < info.num_annotations; i++) {
             stream >> info.annotations[i];
         }
@@ -622,47 +627,47 @@ namespace kivm {
     static StackMapTable_attribute::verification_type_info *parse_verification_type(ClassFileStream &stream) {
         switch (stream.peek1()) {
             case ITEM_Top: {
-                auto *tvi = new StackMapTable_attribute::Top_variable_info;
+                auto *tvi = stream.getArena()->newObject<StackMapTable_attribute::Top_variable_info>();
                 stream >> (*tvi);
                 return tvi;
             }
             case ITEM_Integer: {
-                auto *ivi = new StackMapTable_attribute::Integer_variable_info;
+                auto *ivi = stream.getArena()->newObject<StackMapTable_attribute::Integer_variable_info>();
                 stream >> (*ivi);
                 return ivi;
             }
             case ITEM_Float: {
-                auto *fvi = new StackMapTable_attribute::Float_variable_info;
+                auto *fvi = stream.getArena()->newObject<StackMapTable_attribute::Float_variable_info>();
                 stream >> (*fvi);
                 return fvi;
             }
             case ITEM_Double: {
-                auto *dvi = new StackMapTable_attribute::Double_variable_info;
+                auto *dvi = stream.getArena()->newObject<StackMapTable_attribute::Double_variable_info>();
                 stream >> (*dvi);
                 return dvi;
             }
             case ITEM_Long: {
-                auto *lvi = new StackMapTable_attribute::Long_variable_info;
+                auto *lvi = stream.getArena()->newObject<StackMapTable_attribute::Long_variable_info>();
                 stream >> (*lvi);
                 return lvi;
             }
             case ITEM_Null: {
-                auto *nvi = new StackMapTable_attribute::Null_variable_info;
+                auto *nvi = stream.getArena()->newObject<StackMapTable_attribute::Null_variable_info>();
                 stream >> (*nvi);
                 return nvi;
             }
             case ITEM_UninitializedThis: {
-                auto *utvi = new StackMapTable_attribute::UninitializedThis_variable_info;
+                auto *utvi = stream.getArena()->newObject<StackMapTable_attribute::UninitializedThis_variable_info>();
                 stream >> (*utvi);
                 return utvi;
             }
             case ITEM_Object: {
-                auto *ovi = new StackMapTable_attribute::Object_variable_info;
+                auto *ovi = stream.getArena()->newObject<StackMapTable_attribute::Object_variable_info>();
                 stream >> (*ovi);
                 return ovi;
             }
             case ITEM_Uninitialized: {
-                auto *uvi = new StackMapTable_attribute::Uninitialized_variable_info;
+                auto *uvi = stream.getArena()->newObject<StackMapTable_attribute::Uninitialized_variable_info>();
                 stream >> (*uvi);
                 return uvi;
             }
@@ -680,31 +685,32 @@ namespace kivm {
     static StackMapTable_attribute::stack_map_frame *parse_stack_map_frame(ClassFileStream &stream) {
         u1 frame_type = stream.peek1();
         if (frame_type >= 0 && frame_type <= 63) {
-            auto *frame = new StackMapTable_attribute::same_frame;
+            auto *frame = stream.getArena()->newObject<StackMapTable_attribute::same_frame>();
             stream >> *frame;
             return frame;
         } else if (frame_type >= 64 && frame_type <= 127) {
-            auto *frame = new StackMapTable_attribute::same_locals_1_stack_item_frame;
+            auto *frame = stream.getArena()->newObject<StackMapTable_attribute::same_locals_1_stack_item_frame>();
             stream >> *frame;
             return frame;
         } else if (frame_type == 247) {
-            auto *frame = new StackMapTable_attribute::same_locals_1_stack_item_frame_extended;
+            auto *frame =
+                    stream.getArena()->newObject<StackMapTable_attribute::same_locals_1_stack_item_frame_extended>();
             stream >> *frame;
             return frame;
         } else if (frame_type >= 248 && frame_type <= 250) {
-            auto *frame = new StackMapTable_attribute::chop_frame;
+            auto *frame = stream.getArena()->newObject<StackMapTable_attribute::chop_frame>();
             stream >> *frame;
             return frame;
         } else if (frame_type == 251) {
-            auto *frame = new StackMapTable_attribute::same_frame_extended;
+            auto *frame = stream.getArena()->newObject<StackMapTable_attribute::same_frame_extended>();
             stream >> *frame;
             return frame;
         } else if (frame_type >= 252 && frame_type <= 254) {
-            auto *frame = new StackMapTable_attribute::append_frame;
+            auto *frame = stream.getArena()->newObject<StackMapTable_attribute::append_frame>();
             stream >> *frame;
             return frame;
         } else if (frame_type == 255) {
-            auto *frame = new StackMapTable_attribute::full_frame;
+            auto *frame = stream.getArena()->newObject<StackMapTable_attribute::full_frame>();
             stream >> *frame;
             return frame;
         } else {
@@ -723,21 +729,14 @@ namespace kivm {
         exception_table = nullptr;
     }
 
-    Code_attribute::~Code_attribute() {
-        delete[] code;
-        delete[] exception_table;
-        AttributeParser::deallocAttributes(&attributes, attributes_count);
-    }
-
     void Code_attribute::init(ClassFileStream &stream, cp_info **constant_pool) {
         stream >> *((attribute_info *) this);
         max_stack = stream.get2();
         max_locals = stream.get2();
         code_length = stream.get4();
-        code = new u1[code_length];
-        stream.getBytes(code, code_length);
+        code = stream.getBytesInPlace(code_length);
         exception_table_length = stream.get2();
-        exception_table = new exception_table_t[exception_table_length];
+        exception_table = stream.getArena()->newArray<exception_table_t>(exception_table_length);
         for (int i = 0; i < exception_table_length; ++i) {
             exception_table[i].start_pc = stream.get2();
             exception_table[i].end_pc = stream.get2();
@@ -798,128 +797,6 @@ namespace kivm {
         this->parameters = nullptr;
     }
 
-    StackMapTable_attribute::same_locals_1_stack_item_frame::~same_locals_1_stack_item_frame() {
-        delete stack[0];
-    }
-
-    StackMapTable_attribute::same_locals_1_stack_item_frame_extended::~same_locals_1_stack_item_frame_extended() {
-        delete stack[0];
-    }
-
-    StackMapTable_attribute::full_frame::~full_frame() {
-        if (locals != nullptr) {
-            for (int i = 0; i < number_of_locals; i++) {
-                delete locals[i];
-            }
-            delete[] locals;
-        }
-        if (stack != nullptr) {
-            for (int i = 0; i < number_of_stack_items; i++) {
-                delete stack[i];
-            }
-            delete[] stack;
-        }
-    }
-
-    StackMapTable_attribute::~StackMapTable_attribute() {
-        if (entries != nullptr) {
-            for (int attr = 0; attr < number_of_entries; attr++) {
-                delete entries[attr];
-            }
-            delete[] entries;
-        }
-    }
-
-    Exceptions_attribute::~Exceptions_attribute() {
-        delete[] exception_index_table;
-    }
-
-    InnerClasses_attribute::~InnerClasses_attribute() {
-        delete[] classes;
-    }
-
-    SourceDebugExtension_attribute::~SourceDebugExtension_attribute() {
-        delete[] debug_extension;
-    }
-
-    LineNumberTable_attribute::~LineNumberTable_attribute() {
-        delete[] line_number_table;
-    }
-
-    LocalVariableTable_attribute::~LocalVariableTable_attribute() {
-        delete[] local_variable_table;
-    }
-
-    LocalVariableTypeTable_attribute::~LocalVariableTypeTable_attribute() {
-        delete[] local_variable_type_table;
-    }
-
-    bootstrap_methods_t::~bootstrap_methods_t() {
-        delete[] bootstrap_arguments;
-    }
-
-    BootstrapMethods_attribute::~BootstrapMethods_attribute() {
-        delete[] bootstrap_methods;
-    }
-
-    MethodParameters_attribute::~MethodParameters_attribute() {
-        delete[] parameters;
-    }
-
-    array_value_t::~array_value_t() {
-        delete[] values;
-    }
-
-    element_value::~element_value() {
-        delete value;
-    }
-
-    annotation::~annotation() {
-        delete[] element_value_pairs;
-    }
-
-    type_annotation::localvar_target::~localvar_target() {
-        delete[] table;
-    }
-
-    type_annotation::type_path::~type_path() {
-        delete[] path;
-    }
-
-    type_annotation::~type_annotation() {
-        delete target_info;
-        delete annotations;
-    }
-
-    parameter_annotations_t::~parameter_annotations_t() {
-        delete[] annotations;
-    }
-
-    RuntimeVisibleParameterAnnotations_attribute::~RuntimeVisibleParameterAnnotations_attribute() {
-        delete[] parameter_annotations;
-    }
-
-    RuntimeInvisibleParameterAnnotations_attribute::~RuntimeInvisibleParameterAnnotations_attribute() {
-        delete[] parameter_annotations;
-    }
-
-    RuntimeVisibleTypeAnnotations_attribute::~RuntimeVisibleTypeAnnotations_attribute() {
-        delete[] annotations;
-    }
-
-    RuntimeInvisibleTypeAnnotations_attribute::~RuntimeInvisibleTypeAnnotations_attribute() {
-        delete[] annotations;
-    }
-
-    StackMapTable_attribute::append_frame::~append_frame() {
-        if (locals != nullptr) {
-            for (int i = 0; i < frame_type - 251; i++) {
-                delete locals[i];
-            }
-            delete[] locals;
-        }
-    }
-
     /*******************************************************************
      * Attribute parser
      *******************************************************************/
@@ -966,7 +843,7 @@ namespace kivm {
 
     template<typename T>
     static T *read_attribute_entry(ClassFileStream &stream) {
-        auto *result = new T;
+        auto *result = stream.getArena()->newObject<T>();
         stream >> *result;
         return result;
     }
@@ -977,7 +854,7 @@ namespace kivm {
         u2 attribute_tag = toAttributeTag(attribute_name_index, constant_pool);
         switch (attribute_tag) {
             case ATTRIBUTE_Code: {
-                auto *result = new Code_attribute;
+                auto *result = stream.getArena()->newObject<Code_attribute>();
                 result->init(stream, constant_pool);
                 return result;
             }
@@ -1063,26 +940,12 @@ namespace kivm {
 
     void AttributeParser::readAttributes(attribute_info ***p, u2 count,
                                          ClassFileStream &stream, cp_info **constant_pool) {
-        auto **attributes = new attribute_info *[count];
+        auto **attributes = stream.getArena()->newArray<attribute_info *>(count);
         for (int j = 0; j < count; ++j) {
             attributes[j] = AttributeParser::parseAttribute(stream, constant_pool);
         }
         if (p != nullptr) {
             *p = attributes;
-        } else {
-            deallocAttributes(&attributes, count);
-        }
-    }
-
-    void AttributeParser::deallocAttributes(attribute_info ***p, u2 count) {
-        if (p == nullptr) {
-            return;
-        }
-        auto **attributes = *p;
-        for (int i = 0; i < count; i++) {
-            delete attributes[i];
         }
-        delete[] attributes;
-        *p = nullptr;
     }
 }
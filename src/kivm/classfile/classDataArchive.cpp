@@ -0,0 +1,197 @@
+//
+// Created by kiva on 2018/4/25.
+//
+
+#include <kivm/classfile/classDataArchive.h>
+#include <kivm/classfile/classFileParser.h>
+#include <kivm/classfile/classPath.h>
+#include <shared/files.h>
+#include <shared/memory.h>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+namespace kivm {
+    const char ClassDataArchive::MAGIC[8] = {'K', 'I', 'V', 'M', 'C', 'D', 'S', '\0'};
+
+    static const size_t ALIGNMENT = 8;
+
+    static bool writePadded(FILE *file, const void *data, size_t length) {
+        static const char PADDING[ALIGNMENT] = {0};
+        size_t padding = memory::alignUp(length, ALIGNMENT) - length;
+        return fwrite(data, 1, length, file) == length
+               && fwrite(PADDING, 1, padding, file) == padding;
+    }
+
+    bool ClassDataArchive::readClassList(const std::string &path, std::vector<String> *classNames) {
+        std::ifstream in(path);
+        if (!in) {
+            return false;
+        }
+
+        std::string line;
+        while (std::getline(in, line)) {
+            size_t end = line.find_last_not_of(" \t\r");
+            if (end == std::string::npos || line[0] == '#') {
+                continue;
+            }
+            classNames->push_back(strings::fromStdString(line.substr(0, end + 1)));
+        }
+        return true;
+    }
+
+    bool ClassDataArchive::dump(const std::string &path, ClassPath *classPath,
+                                const std::vector<String> &classNames) {
+        FILE *file = fopen(path.c_str(), "wb");
+        if (file == nullptr) {
+            return false;
+        }
+
+        const std::string &paths = classPath->getPaths();
+        Header header{};
+        memcpy(header.magic, MAGIC, sizeof(MAGIC));
+        header.version = VERSION;
+        header.classPathLength = (u4) paths.size();
+        bool written = writePadded(file, &header, sizeof(header))
+                       && writePadded(file, paths.data(), paths.size());
+
+        for (const auto &className : classNames) {
+            if (!written) {
+                break;
+            }
+
+            // Parsing validates the class file before it is shared.
+            std::string source;
+            ClassFile *classFile = classPath->loadClassFile(className, &source);
+            files::FileStatus status{};
+            if (classFile != nullptr && !files::getStatus(source, &status)) {
+                ClassFileParser::dealloc(classFile);
+                classFile = nullptr;
+            }
+            if (classFile == nullptr) {
+                D("Class %s not found, not archived", strings::toStdString(className).c_str());
+                continue;
+            }
+
+            const std::string &name = strings::toStdString(className);
+            ClassRecord record{(u4) name.size(), (u4) classFile->content_length, (u4) source.size(), 0,
+                               status.size, (u8) status.modificationTime};
+            written = writePadded(file, &record, sizeof(record))
+                      && writePadded(file, name.data(), name.size())
+                      && writePadded(file, source.data(), source.size())
+                      && writePadded(file, classFile->content, classFile->content_length);
+            ClassFileParser::dealloc(classFile);
+            ++header.classCount;
+        }
+
+        // the count is known only now
+        written = written
+                  && fseek(file, 0L, SEEK_SET) == 0
+                  && fwrite(&header, sizeof(header), 1, file) == 1;
+        written = fclose(file) == 0 && written;
+        if (!written) {
+            remove(path.c_str());
+            return false;
+        }
+        D("Archived %d classes into %s", header.classCount, path.c_str());
+        return true;
+    }
+
+    ClassDataArchive *ClassDataArchive::open(const std::string &path, const std::string &classPath) {
+        size_t length = 0;
+        auto *content = (u1 *) memory::mapFile(path.c_str(), &length);
+        if (content == nullptr) {
+            return nullptr;
+        }
+
+        auto *archive = new ClassDataArchive(path, content, length);
+        if (!archive->readClasses(classPath)) {
+            D("Ignored class data archive %s", path.c_str());
+            delete archive;
+            return nullptr;
+        }
+        return archive;
+    }
+
+    ClassDataArchive::ClassDataArchive(const std::string &path, u1 *content, size_t contentLength)
+        : _path(path), _content(content), _contentLength(contentLength), _staleClassCount(0) {
+    }
+
+    ClassDataArchive::~ClassDataArchive() {
+        memory::unmapFile(_content, _contentLength);
+    }
+
+    bool ClassDataArchive::readClasses(const std::string &classPath) {
+        if (_contentLength < sizeof(Header)) {
+            return false;
+        }
+
+        Header header{};
+        memcpy(&header, _content, sizeof(header));
+        if (memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.version != VERSION) {
+            return false;
+        }
+
+        size_t offset = sizeof(Header);
+        if (offset + header.classPathLength > _contentLength
+            || classPath.compare(0, std::string::npos,
+                                 (const char *) _content + offset, header.classPathLength) != 0) {
+            return false;
+        }
+        offset += memory::alignUp(header.classPathLength, ALIGNMENT);
+
+        // one check per source file, classes of a JAR share theirs
+        std::unordered_map<std::string, files::FileStatus> sources;
+        _classes.reserve(header.classCount);
+        for (u4 i = 0; i < header.classCount; ++i) {
+            if (offset + sizeof(ClassRecord) > _contentLength) {
+                return false;
+            }
+            ClassRecord record{};
+            memcpy(&record, _content + offset, sizeof(record));
+            offset += sizeof(ClassRecord);
+
+            size_t nameOffset = offset;
+            size_t sourceOffset = nameOffset + memory::alignUp(record.nameLength, ALIGNMENT);
+            size_t contentOffset = sourceOffset + memory::alignUp(record.sourceLength, ALIGNMENT);
+            offset = contentOffset + memory::alignUp(record.contentLength, ALIGNMENT);
+            if (offset > _contentLength) {
+                return false;
+            }
+
+            std::string source((const char *) _content + sourceOffset, record.sourceLength);
+            auto iter = sources.find(source);
+            if (iter == sources.end()) {
+                files::FileStatus status{};
+                if (!files::getStatus(source, &status)) {
+                    status.modificationTime = -1;
+                }
+                iter = sources.emplace(source, status).first;
+            }
+            if (iter->second.size != record.sourceSize
+                || (u8) iter->second.modificationTime != record.sourceModificationTime) {
+                ++_staleClassCount;
+                continue;
+            }
+
+            _classes.emplace(std::string((const char *) _content + nameOffset, record.nameLength),
+                             std::make_pair(_content + contentOffset, (size_t) record.contentLength));
+        }
+        if (_staleClassCount > 0) {
+            D("%zd classes of class data archive %s changed since the dump",
+              _staleClassCount, _path.c_str());
+        }
+        return true;
+    }
+
+    ClassFile *ClassDataArchive::loadClassFile(const std::string &className) {
+        auto iter = _classes.find(className);
+        if (iter == _classes.end()) {
+            return nullptr;
+        }
+
+        // the archive stays mapped as long as the VM runs
+        ClassFileParser parser(_path.c_str(), iter->second.first, iter->second.second, nullptr);
+        return parser.getParsedClassFile();
+    }
+}
@@ -12,10 +12,6 @@ namespace kivm {
         this->attributes_count = 0;
     }
 
-    field_info::~field_info() {
-        AttributeParser::deallocAttributes(&attributes, attributes_count);
-    }
-
     void field_info::init(ClassFileStream &stream, cp_info **constant_pool) {
         access_flags = stream.get2();
         name_index = stream.get2();
@@ -30,10 +26,6 @@ namespace kivm {
         this->attributes_count = 0;
     }
 
-    method_info::~method_info() {
-        AttributeParser::deallocAttributes(&attributes, attributes_count);
-    }
-
     void method_info::init(ClassFileStream &stream, cp_info **constant_pool) {
         access_flags = stream.get2();
         name_index = stream.get2();
@@ -0,0 +1,47 @@
+//
+// Created by kiva on 2018/4/25.
+//
+
+#include <kivm/classfile/classFileArena.h>
+#include <shared/memory.h>
+#include <cstdlib>
+
+namespace kivm {
+    ClassFileArena::ClassFileArena(size_t sizeHint)
+        : _chunks(nullptr), _top(nullptr), _end(nullptr), _used(0), _reserved(0) {
+        addChunk(sizeHint);
+    }
+
+    ClassFileArena::~ClassFileArena() {
+        while (_chunks != nullptr) {
+            Chunk *next = _chunks->next;
+            free(_chunks);
+            _chunks = next;
+        }
+    }
+
+    void ClassFileArena::addChunk(size_t size) {
+        // Chunks grow, so a bad size hint costs a few chunks at most.
+        size_t chunkSize = memory::alignUp(sizeof(Chunk) + size, MIN_CHUNK_SIZE);
+        if (_chunks != nullptr && chunkSize < _chunks->size * 2) {
+            chunkSize = _chunks->size * 2;
+        }
+
+        auto *chunk = (Chunk *) malloc(chunkSize);
+        if (chunk == nullptr) {
+            PANIC("ClassFileArena: out of memory");
+        }
+        chunk->next = _chunks;
+        chunk->size = chunkSize;
+        _chunks = chunk;
+        _reserved += chunkSize;
+
+        _top = (u1 *) (chunk + 1);
+        _end = (u1 *) chunk + chunkSize;
+    }
+
+    void *ClassFileArena::allocateInNewChunk(size_t size, size_t alignment) {
+        addChunk(size + alignment);
+        return allocate(size, alignment);
+    }
+}
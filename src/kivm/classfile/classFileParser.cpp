@@ -2,67 +2,73 @@
 // Created by kiva on 2018/2/25.
 //
 
-#include <cstdio>
 #include <kivm/classfile/classFileParser.h>
+#include <shared/memory.h>
 #include <cassert>
 
 namespace kivm {
-    static u1 *read_all_rewind(FILE *file, size_t *psize) {
-        fseek(file, 0L, SEEK_END);
-        long size = ftell(file);
-        auto *content = new u1[size + 1];
-        if (content != nullptr) {
-            fseek(file, 0L, SEEK_SET);
-            fread(content, static_cast<size_t>(size), 1, file);
-            *psize = static_cast<size_t>(size);
-        }
-        return content;
+    static void unmapContent(u1 *content, size_t contentLength) {
+        memory::unmapFile(content, contentLength);
     }
 
-    ClassFile *ClassFileParser::alloc() {
-        auto *classFile = new ClassFile();
+    ClassFile *ClassFileParser::alloc(ClassFileArena *arena) {
+        auto *classFile = arena->newObject<ClassFile>();
+        classFile->constant_pool_count = 0;
         classFile->constant_pool = nullptr;
         classFile->interfaces = nullptr;
         classFile->fields = nullptr;
         classFile->methods = nullptr;
         classFile->attributes = nullptr;
+        classFile->content = nullptr;
+        classFile->content_length = 0;
+        classFile->release_content = nullptr;
+        classFile->arena = arena;
         return classFile;
     }
 
     void ClassFileParser::dealloc(ClassFile *class_file) {
-        AttributeParser::deallocAttributes(&class_file->attributes, class_file->attributes_count);
+        // Everything else is plain data which goes with the arena.
         for (int i = 1; i < class_file->constant_pool_count; ++i) {
-            u1 tag = class_file->constant_pool[i]->tag;
-            delete class_file->constant_pool[i];
-            if (tag == CONSTANT_Long || tag == CONSTANT_Double) {
+            cp_info *entry = class_file->constant_pool[i];
+            if (entry->tag == CONSTANT_Utf8) {
+                ((CONSTANT_Utf8_info *) entry)->~CONSTANT_Utf8_info();
+            } else if (entry->tag == CONSTANT_Long || entry->tag == CONSTANT_Double) {
                 ++i;
             }
         }
-        delete[] class_file->methods;
-        delete[] class_file->fields;
-        delete[] class_file->interfaces;
-        delete[] class_file->attributes;
-        delete[] class_file->constant_pool;
-        delete class_file;
+        if (class_file->release_content != nullptr) {
+            class_file->release_content(class_file->content, class_file->content_length);
+        }
+        delete class_file->arena;
     }
 
     ClassFileParser::ClassFileParser(const char *filePath) {
         _classFile = nullptr;
-        _content = nullptr;
-        _file = fopen(filePath, "rb");
+        _contentLength = 0;
+        // class files are read from start to end
+        _content = (u1 *) memory::mapFile(filePath, &_contentLength, true);
+        _releaseContent = unmapContent;
         _classFileStream.setSource(filePath);
     }
 
+    ClassFileParser::ClassFileParser(const char *source, u1 *content, size_t contentLength,
+                                     void (*releaseContent)(u1 *, size_t)) {
+        _classFile = nullptr;
+        _content = content;
+        _contentLength = contentLength;
+        _releaseContent = releaseContent;
+        _classFileStream.setSource(source);
+    }
+
     ClassFileParser::~ClassFileParser() {
-        if (_file != nullptr) {
-            fclose(_file);
+        if (_content != nullptr && _releaseContent != nullptr) {
+            _releaseContent(_content, _contentLength);
         }
-        delete[] _content;
     }
 
     ClassFile *ClassFileParser::getParsedClassFile() {
         if (_classFile == nullptr) {
-            if (_file != nullptr) {
+            if (_content != nullptr) {
                 _classFile = parse();
             }
         }
@@ -71,18 +77,17 @@ namespace kivm {
     }
 
     ClassFile *ClassFileParser::parse() {
-        size_t size = 0;
-        _content = read_all_rewind(_file, &size);
-        if (_content == nullptr) {
-            return nullptr;
-        }
-
-        ClassFile *classFile = ClassFileParser::alloc();
-        if (classFile == nullptr) {
-            return nullptr;
-        }
-
-        _classFileStream.init(_content, size);
+        // Parsed structures take about three to four times the size of the class file.
+        auto *arena = new ClassFileArena(_contentLength * 4);
+        ClassFile *classFile = ClassFileParser::alloc(arena);
+        _classFileStream.setArena(arena);
+
+        // Byte payloads are not copied, the class file keeps the mapping.
+        classFile->content = _content;
+        classFile->content_length = _contentLength;
+        classFile->release_content = _releaseContent;
+        _content = nullptr;
+        _classFileStream.init(classFile->content, classFile->content_length);
 
         classFile->magic = _classFileStream.get4();
         if (classFile->magic != 0xCAFEBABE) {
@@ -107,14 +112,14 @@ namespace kivm {
 
     template<typename T>
     static void read_pool_entry(cp_info **pool, int index, ClassFileStream &stream) {
-        pool[index] = new T;
+        pool[index] = stream.getArena()->newObject<T>();
         stream >> *(T *) pool[index];
     }
 
     void ClassFileParser::parseConstantPool(ClassFile *classFile) {
         u2 count = classFile->constant_pool_count = _classFileStream.get2();
 
-        classFile->constant_pool = new cp_info *[count];
+        classFile->constant_pool = _classFileStream.getArena()->newArray<cp_info *>(count);
         cp_info **pool = classFile->constant_pool;
 
         // The constant_pool table is indexed
@@ -175,7 +180,7 @@ namespace kivm {
 
     void ClassFileParser::parseInterfaces(ClassFile *classFile) {
         u2 count = classFile->interfaces_count = _classFileStream.get2();
-        classFile->interfaces = new u2[count];
+        classFile->interfaces = _classFileStream.getArena()->newArray<u2>(count);
         for (int i = 0; i < count; i++) {
             classFile->interfaces[i] = _classFileStream.get2();
         }
@@ -183,7 +188,7 @@ namespace kivm {
 
     void ClassFileParser::parseFields(ClassFile *classFile) {
         u2 count = classFile->fields_count = _classFileStream.get2();
-        classFile->fields = new field_info[count];
+        classFile->fields = _classFileStream.getArena()->newArray<field_info>(count);
         for (int i = 0; i < count; ++i) {
             classFile->fields[i].init(_classFileStream, classFile->constant_pool);
         }
@@ -191,7 +196,7 @@ namespace kivm {
 
     void ClassFileParser::parseMethods(ClassFile *classFile) {
         u2 count = classFile->methods_count = _classFileStream.get2();
-        classFile->methods = new method_info[count];
+        classFile->methods = _classFileStream.getArena()->newArray<method_info>(count);
         for (int i = 0; i < count; ++i) {
             classFile->methods[i].init(_classFileStream, classFile->constant_pool);
         }
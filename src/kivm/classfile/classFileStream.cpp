@@ -4,6 +4,7 @@
 
 #include <kivm/classfile/classFileStream.h>
 #include <cassert>
+#include <cstring>
 
 #pragma clang diagnostic push
 #pragma ide diagnostic ignored "missing_default_case"
@@ -14,6 +15,7 @@ namespace kivm {
         this->_buffer_start = nullptr;
         this->_buffer_end = nullptr;
         this->_source = nullptr;
+        this->_arena = nullptr;
     }
 
     void ClassFileStream::init(u1 *buffer, size_t length) {
@@ -81,37 +83,19 @@ namespace kivm {
     }
 
     void ClassFileStream::getBytes(u1 *to, int count) {
+        memcpy(to, getBytesInPlace(count), (size_t) count);
+    }
+
+    u1 *ClassFileStream::getBytesInPlace(int count) {
         u1 *from = asU1Buffer();
         skip1(count);
-
-        int n = (count + 7) / 8;
-        switch (count % 8) {
-            case 0:
-                do {
-                    *to++ = *from++;
-                    case 7:
-                        *to++ = *from++;
-                    case 6:
-                        *to++ = *from++;
-                    case 5:
-                        *to++ = *from++;
-                    case 4:
-                        *to++ = *from++;
-                    case 3:
-                        *to++ = *from++;
-                    case 2:
-                        *to++ = *from++;
-                    case 1:
-                        *to++ = *from++;
-                } while (--n > 0);
-        }
+        return from;
     }
 
     ClassFileStream &ClassFileStream::operator>>(CONSTANT_Utf8_info &info) {
         info.tag = get1();
         info.length = get2();
-        info.bytes = new u1[info.length];
-        getBytes(info.bytes, info.length);
+        info.bytes = getBytesInPlace(info.length);
         return *this;
     }
 
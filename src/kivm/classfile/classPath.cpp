@@ -0,0 +1,265 @@
+//
+// Created by kiva on 2018/4/25.
+//
+
+#include <kivm/classfile/classPath.h>
+#include <kivm/classfile/classDataArchive.h>
+#include <kivm/classfile/classFileParser.h>
+#include <kivm/runtime/runtimeConfig.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+namespace kivm {
+#ifdef KIVM_PLATFORM_WINDOWS
+    static const char PATH_SEPARATOR = ';';
+#else
+    static const char PATH_SEPARATOR = ':';
+#endif
+
+    static const std::string CLASS_SUFFIX = ".class";
+
+    static void deleteContent(u1 *content, size_t) {
+        delete[] content;
+    }
+
+    static inline u8 nanosSince(std::chrono::steady_clock::time_point start) {
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        return (u8) std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+    }
+
+    static inline bool isClassFileName(const char *name, size_t length) {
+        return length > CLASS_SUFFIX.size()
+               && CLASS_SUFFIX.compare(0, CLASS_SUFFIX.size(),
+                                       name + length - CLASS_SUFFIX.size(), CLASS_SUFFIX.size()) == 0;
+    }
+
+    static ClassPath *newDefaultClassPath() {
+        const char *klassPath = getenv("KLASSPATH");
+        const RuntimeConfig &config = RuntimeConfig::get();
+        auto *classPath = new ClassPath(klassPath != nullptr ? klassPath : ".", config.watchClassPath);
+
+        // a dump reads the class files themselves
+        if (config.sharingMode == SharingMode::AUTO && !config.sharedArchiveFile.empty()) {
+            classPath->setArchive(ClassDataArchive::open(config.sharedArchiveFile, classPath->getPaths()));
+        }
+        return classPath;
+    }
+
+    ClassPath *ClassPath::get() {
+        // Never destroyed, classes parsed in place point into its archives.
+        static ClassPath *classPath = newDefaultClassPath();
+        return classPath;
+    }
+
+    ClassPath::ClassPath(const std::string &paths, bool watch)
+        : _paths(paths), _watcher(nullptr), _archive(nullptr),
+          _lookups(0), _misses(0), _sharedHits(0), _probes(0), _lookupNanos(0), _indexNanos(0) {
+        if (watch) {
+            _watcher = new files::DirectoryWatcher();
+            if (!_watcher->isSupported()) {
+                D("Watching class path directories is not supported");
+                delete _watcher;
+                _watcher = nullptr;
+            }
+        }
+
+        size_t start = 0;
+        while (start <= paths.size()) {
+            size_t end = paths.find(PATH_SEPARATOR, start);
+            if (end == std::string::npos) {
+                end = paths.size();
+            }
+
+            std::string path = paths.substr(start, end - start);
+            start = end + 1;
+            if (path.empty()) {
+                continue;
+            }
+
+            if (files::isDirectory(path)) {
+                _entries.push_back(Entry{path, nullptr});
+                continue;
+            }
+
+            // Only the central directory is read here, entries when classes are loaded.
+            ZipArchive *archive = ZipArchive::open(path);
+            if (archive == nullptr) {
+                D("Skipped class path entry %s", path.c_str());
+                continue;
+            }
+            _entries.push_back(Entry{"", archive});
+        }
+
+        buildIndex();
+    }
+
+    ClassPath::~ClassPath() {
+        // Archives, the class data archive too, stay mapped:
+        // classes parsed in place point into them.
+        delete _watcher;
+    }
+
+    void ClassPath::setArchive(ClassDataArchive *archive) {
+        LockGuard lockGuard(_lock);
+        _archive = archive;
+    }
+
+    void ClassPath::addPackage(const std::string &package, size_t index) {
+        auto &entries = _packages[package];
+        if (entries.empty() || entries.back() != index) {
+            entries.push_back(index);
+        }
+    }
+
+    void ClassPath::indexDirectory(size_t index, const std::string &path,
+                                   const std::string &package, int depth) {
+        std::vector<files::DirectoryEntry> children;
+        if (!files::listDirectory(path, &children)) {
+            return;
+        }
+
+        if (_watcher != nullptr && _watchedDirectories.insert(path).second) {
+            _watcher->watch(path);
+        }
+
+        for (const auto &child : children) {
+            if (child.directory) {
+                if (depth < MAX_PACKAGE_DEPTH) {
+                    indexDirectory(index, path + "/" + child.name,
+                                   package.empty() ? child.name : package + "/" + child.name,
+                                   depth + 1);
+                }
+            } else if (isClassFileName(child.name.c_str(), child.name.size())) {
+                addPackage(package, index);
+            }
+        }
+    }
+
+    void ClassPath::buildIndex() {
+        auto start = std::chrono::steady_clock::now();
+        _packages.clear();
+        for (size_t index = 0; index < _entries.size(); ++index) {
+            const Entry &entry = _entries[index];
+            if (entry.archive == nullptr) {
+                indexDirectory(index, entry.directory, "", 0);
+                continue;
+            }
+
+            entry.archive->iterateEntries([&](const char *name, size_t length) {
+                if (!isClassFileName(name, length)) {
+                    return;
+                }
+                size_t slash = length;
+                while (slash > 0 && name[slash - 1] != '/') {
+                    --slash;
+                }
+                addPackage(std::string(name, slash > 0 ? slash - 1 : 0), index);
+            });
+        }
+        _indexNanos += nanosSince(start);
+        D("Indexed %zd packages in %zd class path entries",
+          _packages.size(), _entries.size());
+    }
+
+    void ClassPath::refresh() {
+        LockGuard lockGuard(_lock);
+        buildIndex();
+    }
+
+    std::vector<size_t> ClassPath::findEntries(const std::string &package) {
+        LockGuard lockGuard(_lock);
+        auto iter = _packages.find(package);
+        return iter != _packages.end() ? iter->second : std::vector<size_t>();
+    }
+
+    ClassFile *ClassPath::findClassFile(const std::vector<size_t> &entries, const std::string &fileName,
+                                        std::string *source) {
+        // Entries are never removed, only the package index is rebuilt.
+        for (size_t index : entries) {
+            const Entry &entry = _entries[index];
+            ++_probes;
+            if (entry.archive == nullptr) {
+                const std::string &path = entry.directory + "/" + fileName;
+                ClassFileParser parser(path.c_str());
+                ClassFile *classFile = parser.getParsedClassFile();
+                if (classFile != nullptr) {
+                    if (source != nullptr) {
+                        *source = path;
+                    }
+                    return classFile;
+                }
+                continue;
+            }
+
+            size_t length = 0;
+            bool allocated = false;
+            u1 *content = entry.archive->read(fileName, &length, &allocated);
+            if (content == nullptr) {
+                continue;
+            }
+
+            // Stored entries point into the archive, which is never unmapped.
+            ClassFileParser parser(entry.archive->getPath().c_str(), content, length,
+                                   allocated ? deleteContent : nullptr);
+            ClassFile *classFile = parser.getParsedClassFile();
+            if (classFile != nullptr) {
+                if (source != nullptr) {
+                    *source = entry.archive->getPath();
+                }
+                return classFile;
+            }
+        }
+        return nullptr;
+    }
+
+    ClassFile *ClassPath::loadClassFile(const String &className, std::string *source) {
+        auto start = std::chrono::steady_clock::now();
+        const std::string &fileName = strings::toStdString(className) + CLASS_SUFFIX;
+        size_t slash = fileName.rfind('/');
+        const std::string &package = slash == std::string::npos ? "" : fileName.substr(0, slash);
+
+        ClassFile *classFile = nullptr;
+        if (_archive != nullptr) {
+            classFile = _archive->loadClassFile(fileName.substr(0, fileName.size() - CLASS_SUFFIX.size()));
+            if (classFile != nullptr) {
+                ++_sharedHits;
+                if (source != nullptr) {
+                    *source = _archive->getPath();
+                }
+            }
+        }
+        if (classFile == nullptr) {
+            classFile = findClassFile(findEntries(package), fileName, source);
+        }
+        if (classFile == nullptr && _watcher != nullptr) {
+            bool changed = false;
+            {
+                LockGuard lockGuard(_lock);
+                if (_watcher->pollChanges()) {
+                    buildIndex();
+                    changed = true;
+                }
+            }
+            if (changed) {
+                classFile = findClassFile(findEntries(package), fileName, source);
+            }
+        }
+
+        ++_lookups;
+        if (classFile == nullptr) {
+            ++_misses;
+        }
+        _lookupNanos += nanosSince(start);
+        return classFile;
+    }
+
+    void ClassPath::printStatistics() const {
+        fprintf(stderr, "Class path: %zd packages indexed in %.3f ms, "
+                        "%llu lookups (%llu missed, %llu shared, %llu class files probed) in %.3f ms\n",
+                _packages.size(), (double) _indexNanos.load() / 1e6,
+                (unsigned long long) _lookups, (unsigned long long) _misses,
+                (unsigned long long) _sharedHits,
+                (unsigned long long) _probes, (double) _lookupNanos.load() / 1e6);
+    }
+}
@@ -0,0 +1,206 @@
+//
+// Created by kiva on 2018/4/25.
+//
+
+#include <kivm/classfile/classPrefetcher.h>
+#include <kivm/classfile/classDataArchive.h>
+#include <kivm/classfile/classFileParser.h>
+#include <kivm/classfile/classPath.h>
+#include <kivm/runtime/runtimeConfig.h>
+
+namespace kivm {
+    static ClassPrefetcher *newDefaultPrefetcher() {
+        const RuntimeConfig &config = RuntimeConfig::get();
+        if (!config.prefetchClasses) {
+            return nullptr;
+        }
+
+        auto *prefetcher = new ClassPrefetcher(ClassPath::get(), config.prefetchThreads);
+        std::vector<String> classNames;
+        if (!config.sharedClassListFile.empty()
+            && ClassDataArchive::readClassList(config.sharedClassListFile, &classNames)) {
+            prefetcher->prefetch(classNames);
+        }
+        return prefetcher;
+    }
+
+    ClassPrefetcher *ClassPrefetcher::get() {
+        // Never destroyed, workers may still be parsing at exit.
+        static ClassPrefetcher *prefetcher = newDefaultPrefetcher();
+        return prefetcher;
+    }
+
+    ClassPrefetcher::ClassPrefetcher(ClassPath *classPath, int threads)
+        : _classPath(classPath), _parsing(0), _stopping(false),
+          _hits(0), _waits(0), _misses(0) {
+        for (int i = 0; i < threads; ++i) {
+            _workers.emplace_back([this] { run(); });
+        }
+    }
+
+    ClassPrefetcher::~ClassPrefetcher() {
+        {
+            LockGuard lockGuard(_lock);
+            _stopping = true;
+        }
+        _changed.notify_all();
+        for (auto &worker : _workers) {
+            worker.join();
+        }
+
+        for (auto &e : _slots) {
+            if (e.second.state == STAGED && e.second.classFile != nullptr) {
+                ClassFileParser::dealloc(e.second.classFile);
+            }
+        }
+    }
+
+    void ClassPrefetcher::enqueue(const String &className, bool certain) {
+        // only instance classes have class files
+        size_t dimension = 0;
+        while (dimension < className.size() && className[dimension] == L'[') {
+            ++dimension;
+        }
+        if (dimension > 0) {
+            if (className.size() < dimension + 3 || className[dimension] != L'L') {
+                return;
+            }
+            enqueue(className.substr(dimension + 1, className.size() - dimension - 2), certain);
+            return;
+        }
+
+        auto iter = _slots.find(className);
+        if (iter != _slots.end()) {
+            // a certain class whose references were not queued yet
+            if (certain && !iter->second.certain && iter->second.state == QUEUED) {
+                iter->second.certain = true;
+            }
+            return;
+        }
+        _slots.insert(std::make_pair(className, Slot{QUEUED, certain, nullptr}));
+        _queue.push_back(className);
+        _changed.notify_all();
+    }
+
+    void ClassPrefetcher::enqueueReferences(ClassFile *classFile, bool certain) {
+        cp_info **pool = classFile->constant_pool;
+        if (classFile->super_class != 0) {
+            auto *superClass = (CONSTANT_Class_info *) pool[classFile->super_class];
+            enqueue(requireConstant<CONSTANT_Utf8_info>(pool, superClass->name_index)->get_constant(),
+                    certain);
+        }
+        for (int i = 0; i < classFile->interfaces_count; ++i) {
+            auto *interface = (CONSTANT_Class_info *) pool[classFile->interfaces[i]];
+            enqueue(requireConstant<CONSTANT_Utf8_info>(pool, interface->name_index)->get_constant(),
+                    certain);
+        }
+        if (!certain) {
+            return;
+        }
+
+        for (int i = 1; i < classFile->constant_pool_count; ++i) {
+            // the second slot of long and double constants is empty
+            if (pool[i] == nullptr || pool[i]->tag != CONSTANT_Class || i == classFile->this_class) {
+                continue;
+            }
+            auto *classInfo = (CONSTANT_Class_info *) pool[i];
+            enqueue(requireConstant<CONSTANT_Utf8_info>(pool, classInfo->name_index)->get_constant(),
+                    false);
+        }
+    }
+
+    void ClassPrefetcher::run() {
+        std::unique_lock<Lock> lock(_lock);
+        while (true) {
+            while (!_stopping && _queue.empty()) {
+                _changed.wait(lock);
+            }
+            if (_stopping) {
+                return;
+            }
+
+            String className = _queue.front();
+            _queue.pop_front();
+            Slot &slot = _slots[className];
+            if (slot.state != QUEUED) {
+                // taken meanwhile
+                if (_queue.empty()) {
+                    _changed.notify_all();
+                }
+                continue;
+            }
+            slot.state = PARSING;
+            ++_parsing;
+
+            lock.unlock();
+            ClassFile *classFile = _classPath->loadClassFile(className);
+            lock.lock();
+
+            // references to map elements survive rehashing
+            if (classFile != nullptr) {
+                enqueueReferences(classFile, slot.certain);
+            }
+            slot.state = STAGED;
+            slot.classFile = classFile;
+            --_parsing;
+            _changed.notify_all();
+        }
+    }
+
+    void ClassPrefetcher::prefetch(const std::vector<String> &classNames) {
+        LockGuard lockGuard(_lock);
+        for (const auto &className : classNames) {
+            enqueue(className, true);
+        }
+    }
+
+    void ClassPrefetcher::prefetchReferences(ClassFile *classFile) {
+        LockGuard lockGuard(_lock);
+        enqueueReferences(classFile, true);
+    }
+
+    ClassFile *ClassPrefetcher::take(const String &className, bool *parsed) {
+        std::unique_lock<Lock> lock(_lock);
+        auto iter = _slots.find(className);
+        if (iter == _slots.end()) {
+            _slots.insert(std::make_pair(className, Slot{TAKEN, true, nullptr}));
+            ++_misses;
+            *parsed = false;
+            return nullptr;
+        }
+
+        Slot &slot = iter->second;
+        if (slot.state == PARSING) {
+            ++_waits;
+            while (slot.state == PARSING) {
+                _changed.wait(lock);
+            }
+        } else if (slot.state == STAGED) {
+            ++_hits;
+        } else {
+            // queued, cheaper to parse here than to wait for a worker
+            slot.state = TAKEN;
+            ++_misses;
+            *parsed = false;
+            return nullptr;
+        }
+
+        slot.state = TAKEN;
+        *parsed = true;
+        ClassFile *classFile = slot.classFile;
+        slot.classFile = nullptr;
+        return classFile;
+    }
+
+    void ClassPrefetcher::drain() {
+        std::unique_lock<Lock> lock(_lock);
+        while (!_queue.empty() || _parsing > 0) {
+            _changed.wait(lock);
+        }
+    }
+
+    void ClassPrefetcher::printStatistics() const {
+        D("Class prefetch: %llu classes parsed ahead, %llu waited for, %llu parsed on demand",
+          (unsigned long long) _hits, (unsigned long long) _waits, (unsigned long long) _misses);
+    }
+}
@@ -56,7 +56,7 @@ namespace kivm {
         }
     }
 
-    String CONSTANT_Utf8_info::get_constant() {
+    const String &CONSTANT_Utf8_info::get_constant() {
         // UTF-8 Strings in Java needs to be Unicode in C++
         if (!_cached) {
             _cached_string = kivm::strings::fromBytes(bytes, length);
@@ -72,6 +72,6 @@ namespace kivm {
     }
 
     CONSTANT_Utf8_info::~CONSTANT_Utf8_info() {
-        delete[] bytes;
+        // bytes are owned by ClassFile::content
     }
 }
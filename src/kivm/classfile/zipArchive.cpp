@@ -0,0 +1,208 @@
+//
+// Created by kiva on 2018/4/25.
+//
+
+#include <kivm/classfile/zipArchive.h>
+#include <shared/memory.h>
+#include <cstring>
+#include <zlib.h>
+
+namespace kivm {
+    static const u4 LOCAL_HEADER_SIGNATURE = 0x04034b50;
+    static const u4 CENTRAL_HEADER_SIGNATURE = 0x02014b50;
+    static const u4 END_SIGNATURE = 0x06054b50;
+
+    static const size_t LOCAL_HEADER_SIZE = 30;
+    static const size_t CENTRAL_HEADER_SIZE = 46;
+    static const size_t END_SIZE = 22;
+    static const size_t MAX_COMMENT_LENGTH = 0xffff;
+
+    static const u2 METHOD_STORED = 0;
+    static const u2 METHOD_DEFLATED = 8;
+
+    // ZIP fields are little-endian
+    static inline u2 readLE2(const u1 *p) {
+        return (u2) (p[0] | (p[1] << 8));
+    }
+
+    static inline u4 readLE4(const u1 *p) {
+        return (u4) p[0] | ((u4) p[1] << 8) | ((u4) p[2] << 16) | ((u4) p[3] << 24);
+    }
+
+    /**
+     * A raw deflate stream, reset between entries
+     * so its window is allocated once per thread.
+     */
+    class Inflater {
+    private:
+        z_stream _stream;
+        bool _initialized;
+
+    public:
+        Inflater() : _stream() {
+            _initialized = inflateInit2(&_stream, -MAX_WBITS) == Z_OK;
+        }
+
+        ~Inflater() {
+            if (_initialized) {
+                inflateEnd(&_stream);
+            }
+        }
+
+        bool inflate(const u1 *input, size_t inputLength, u1 *output, size_t outputLength) {
+            if (!_initialized || inflateReset(&_stream) != Z_OK) {
+                return false;
+            }
+            _stream.next_in = (Bytef *) input;
+            _stream.avail_in = (uInt) inputLength;
+            _stream.next_out = output;
+            _stream.avail_out = (uInt) outputLength;
+            return ::inflate(&_stream, Z_FINISH) == Z_STREAM_END
+                   && _stream.total_out == outputLength;
+        }
+    };
+
+    bool ZipArchive::Name::operator==(const Name &other) const {
+        return length == other.length && memcmp(data, other.data, length) == 0;
+    }
+
+    size_t ZipArchive::NameHash::operator()(const Name &name) const {
+        // FNV-1a
+        size_t hash = 2166136261u;
+        for (size_t i = 0; i < name.length; ++i) {
+            hash = (hash ^ (u1) name.data[i]) * 16777619u;
+        }
+        return hash;
+    }
+
+    ZipArchive *ZipArchive::open(const std::string &path) {
+        size_t length = 0;
+        auto *content = (u1 *) memory::mapFile(path.c_str(), &length);
+        if (content == nullptr) {
+            return nullptr;
+        }
+
+        auto *archive = new ZipArchive(path, content, length);
+        if (!archive->readCentralDirectory()) {
+            D("Not a supported ZIP archive: %s", path.c_str());
+            delete archive;
+            return nullptr;
+        }
+        return archive;
+    }
+
+    ZipArchive::ZipArchive(const std::string &path, u1 *content, size_t contentLength)
+        : _path(path), _content(content), _contentLength(contentLength) {
+    }
+
+    ZipArchive::~ZipArchive() {
+        memory::unmapFile(_content, _contentLength);
+    }
+
+    bool ZipArchive::readCentralDirectory() {
+        if (_contentLength < END_SIZE) {
+            return false;
+        }
+
+        // The end record is followed by a comment of up to 64 KB, search backwards.
+        const u1 *end = nullptr;
+        const u1 *lowest = _contentLength > END_SIZE + MAX_COMMENT_LENGTH
+                           ? _content + _contentLength - END_SIZE - MAX_COMMENT_LENGTH
+                           : _content;
+        for (const u1 *p = _content + _contentLength - END_SIZE; p >= lowest; --p) {
+            if (readLE4(p) == END_SIGNATURE) {
+                end = p;
+                break;
+            }
+        }
+        if (end == nullptr) {
+            return false;
+        }
+
+        u2 count = readLE2(end + 10);
+        u4 directorySize = readLE4(end + 12);
+        u4 directoryOffset = readLE4(end + 16);
+        if ((size_t) directoryOffset + directorySize > (size_t) (end - _content)) {
+            // ZIP64 or corrupt
+            return false;
+        }
+
+        _entries.reserve(count);
+        const u1 *p = _content + directoryOffset;
+        const u1 *directoryEnd = p + directorySize;
+        for (u2 i = 0; i < count; ++i) {
+            if (p + CENTRAL_HEADER_SIZE > directoryEnd || readLE4(p) != CENTRAL_HEADER_SIGNATURE) {
+                return false;
+            }
+
+            u2 nameLength = readLE2(p + 28);
+            u2 extraLength = readLE2(p + 30);
+            u2 commentLength = readLE2(p + 32);
+            const u1 *next = p + CENTRAL_HEADER_SIZE + nameLength + extraLength + commentLength;
+            if (next > directoryEnd) {
+                return false;
+            }
+
+            Entry entry{};
+            entry.method = readLE2(p + 10);
+            entry.compressedSize = readLE4(p + 20);
+            entry.uncompressedSize = readLE4(p + 24);
+            entry.localHeaderOffset = readLE4(p + 42);
+            Name name{(const char *) p + CENTRAL_HEADER_SIZE, nameLength};
+            _entries.emplace(name, entry);
+            p = next;
+        }
+        return true;
+    }
+
+    const ZipArchive::Entry *ZipArchive::find(const std::string &name) const {
+        auto iter = _entries.find(Name{name.data(), name.size()});
+        return iter != _entries.end() ? &iter->second : nullptr;
+    }
+
+    u1 *ZipArchive::read(const std::string &name, size_t *length, bool *allocated) const {
+        const Entry *entry = find(name);
+        if (entry == nullptr) {
+            return nullptr;
+        }
+
+        // The local header may carry a different extra field, read its lengths.
+        size_t offset = entry->localHeaderOffset;
+        if (offset + LOCAL_HEADER_SIZE > _contentLength
+            || readLE4(_content + offset) != LOCAL_HEADER_SIGNATURE) {
+            return nullptr;
+        }
+        offset += LOCAL_HEADER_SIZE
+                  + readLE2(_content + offset + 26)
+                  + readLE2(_content + offset + 28);
+        if (offset + entry->compressedSize > _contentLength) {
+            return nullptr;
+        }
+        u1 *data = _content + offset;
+
+        switch (entry->method) {
+            case METHOD_STORED:
+                *length = entry->compressedSize;
+                *allocated = false;
+                return data;
+
+            case METHOD_DEFLATED: {
+                static thread_local Inflater inflater;
+                auto *output = new u1[entry->uncompressedSize == 0 ? 1 : entry->uncompressedSize];
+                if (!inflater.inflate(data, entry->compressedSize, output, entry->uncompressedSize)) {
+                    D("Corrupt entry %s in %s", name.c_str(), _path.c_str());
+                    delete[] output;
+                    return nullptr;
+                }
+                *length = entry->uncompressedSize;
+                *allocated = true;
+                return output;
+            }
+
+            default:
+                D("Unsupported compression method %d of %s in %s",
+                  entry->method, name.c_str(), _path.c_str());
+                return nullptr;
+        }
+    }
+}
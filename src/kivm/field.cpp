@@ -6,7 +6,6 @@
 #include <kivm/oop/instanceKlass.h>
 #include <shared/lock.h>
 
-#include <sstream>
 
 namespace kivm {
     static Lock &get_method_pool_lock() {
@@ -30,22 +29,28 @@ namespace kivm {
 
     bool Field::isSame(const Field *lhs, const Field *rhs) {
         return lhs != nullptr && rhs != nullptr
-               && lhs->getName() == rhs->getName()
-               && lhs->getDescriptor() == rhs->getDescriptor();
+               && lhs->_name == rhs->_name
+               && lhs->_descriptor == rhs->_descriptor;
     }
 
     String Field::makeIdentity(InstanceKlass *belongTo, const Field *f) {
-        std::wstringstream ss;
-        ss << belongTo->getName() << L" " << f->getName() << L" " << f->getDescriptor();
-        return ss.str();
+        return belongTo->getName() + L" " + f->getName() + L" " + f->getDescriptor();
+    }
+
+    FieldKey Field::getKey() const {
+        return FieldKey{_klass->getNameSymbol(), _name, _descriptor};
     }
 
     Field::Field(InstanceKlass *clazz, field_info *fieldInfo) {
         this->_linked = false;
         this->_klass = clazz;
+        this->_name = nullptr;
+        this->_descriptor = nullptr;
+        this->_signature = nullptr;
         this->_fieldInfo = fieldInfo;
         this->_constantAttr = nullptr;
         this->_valueClassType = nullptr;
+        this->_accessCount = 0;
     }
 
     void Field::linkField(cp_info **pool) {
@@ -55,8 +60,8 @@ namespace kivm {
         this->_accessFlag = _fieldInfo->access_flags;
         auto *name_info = requireConstant<CONSTANT_Utf8_info>(pool, _fieldInfo->name_index);
         auto *desc_info = requireConstant<CONSTANT_Utf8_info>(pool, _fieldInfo->descriptor_index);
-        this->_name = name_info->get_constant();
-        this->_descriptor = desc_info->get_constant();
+        this->_name = SymbolTable::get()->lookup(name_info->bytes, name_info->length);
+        this->_descriptor = SymbolTable::get()->lookup(desc_info->bytes, desc_info->length);
         linkAttributes(pool);
         linkValueType();
         this->_linked = true;
@@ -74,7 +79,7 @@ namespace kivm {
                 case ATTRIBUTE_Signature: {
                     auto *sig_attr = (Signature_attribute *) attr;
                     auto *utf8 = requireConstant<CONSTANT_Utf8_info>(pool, sig_attr->signature_index);
-                    _signature = utf8->get_constant();
+                    _signature = SymbolTable::get()->lookup(utf8->bytes, utf8->length);
                     break;
                 }
 
@@ -88,7 +93,8 @@ namespace kivm {
     }
 
     void Field::linkValueType() {
-        switch (_descriptor[0]) {
+        const String &descriptor = getDescriptor();
+        switch (descriptor[0]) {
             case L'Z':
                 _valueType = ValueType::BOOLEAN;
                 break;
@@ -115,7 +121,7 @@ namespace kivm {
                 break;
             case L'L': {
                 _valueType = ValueType::OBJECT;
-                const String &class_name = _descriptor.substr(1, _descriptor.size() - 2);
+                const String &class_name = descriptor.substr(1, descriptor.size() - 2);
                 _valueClassType = ClassLoader::requireClass(getClass()->getClassLoader(),
                                                               class_name);
                 break;
@@ -123,7 +129,7 @@ namespace kivm {
             case L'[': {
                 _valueType = ValueType::ARRAY;
                 _valueClassType = ClassLoader::requireClass(getClass()->getClassLoader(),
-                                                              _descriptor);
+                                                              descriptor);
                 break;
             }
             default:
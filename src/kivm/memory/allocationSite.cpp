@@ -0,0 +1,128 @@
+//
+// Created by kiva on 2018/4/25.
+//
+
+#include <kivm/memory/allocationSite.h>
+#include <kivm/runtime/runtimeConfig.h>
+#include <kivm/oop/instanceKlass.h>
+#include <kivm/method.h>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+namespace kivm {
+    AllocationSite::AllocationSite(Method *method, int bci, u4 id, bool tenured)
+        : _method(method), _bci(bci), _id(id),
+          _allocated(0), _survived(0),
+          _totalAllocated(0), _totalSurvived(0),
+          _tenured(tenured) {
+    }
+
+    AllocationSiteTable *AllocationSiteTable::get() {
+        static AllocationSiteTable table;
+        return &table;
+    }
+
+    AllocationSiteTable::AllocationSiteTable() {
+        const RuntimeConfig &config = RuntimeConfig::get();
+        _enabled = config.usePretenuring;
+        // id 0 means no site
+        _sitesById.push_back(nullptr);
+        if (!config.pretenureProfileInput.empty() && !load(config.pretenureProfileInput)) {
+            D("Cannot read pretenuring profile %s", config.pretenureProfileInput.c_str());
+        }
+    }
+
+    String AllocationSiteTable::makeIdentity(Method *method, int bci) {
+        std::wstringstream ss;
+        ss << method->getClass()->getName() << L" "
+           << method->getName() << L" " << method->getDescriptor() << L" " << bci;
+        return ss.str();
+    }
+
+    AllocationSite *AllocationSiteTable::lookup(Method *method, int bci) {
+        if (!_enabled) {
+            return nullptr;
+        }
+
+        LockGuard lockGuard(_lock);
+        auto &sites = _sites[method];
+        auto iter = sites.find(bci);
+        if (iter != sites.end()) {
+            return iter->second;
+        }
+
+        bool tenured = !_profiledSites.empty()
+                       && _profiledSites.count(makeIdentity(method, bci)) != 0;
+        auto *site = new AllocationSite(method, bci, (u4) _sitesById.size(), tenured);
+        sites.emplace(bci, site);
+        _sitesById.push_back(site);
+        return site;
+    }
+
+    void AllocationSiteTable::endCollection() {
+        for (size_t id = 1; id < _sitesById.size(); ++id) {
+            AllocationSite *site = _sitesById[id];
+            if (site->_allocated == 0) {
+                continue;
+            }
+
+            site->_totalAllocated += site->_allocated;
+            site->_totalSurvived += site->_survived;
+            site->_allocated = 0;
+            site->_survived = 0;
+
+            if (!site->_tenured
+                && site->_totalAllocated >= MIN_SAMPLES
+                && site->_totalSurvived * 100 >= site->_totalAllocated * SURVIVAL_PERCENT) {
+                site->_tenured = true;
+                if (RuntimeConfig::get().printPretenuring) {
+                    fprintf(stderr, "Pretenuring %s: %llu of %llu objects survived\n",
+                            strings::toStdString(makeIdentity(site->_method, site->_bci)).c_str(),
+                            (unsigned long long) site->_totalSurvived,
+                            (unsigned long long) site->_totalAllocated);
+                }
+            }
+        }
+    }
+
+    bool AllocationSiteTable::load(const std::string &path) {
+        std::ifstream in(path);
+        if (!in) {
+            return false;
+        }
+
+        std::string line;
+        while (std::getline(in, line)) {
+            std::istringstream fields(line);
+            std::string className;
+            std::string name;
+            std::string descriptor;
+            int bci = 0;
+            if (!(fields >> className >> name >> descriptor >> bci)) {
+                continue;
+            }
+
+            std::stringstream identity;
+            identity << className << " " << name << " " << descriptor << " " << bci;
+            _profiledSites.insert(strings::fromStdString(identity.str()));
+        }
+        return true;
+    }
+
+    bool AllocationSiteTable::save(const std::string &path) {
+        std::ofstream out(path);
+        if (!out) {
+            return false;
+        }
+
+        LockGuard lockGuard(_lock);
+        for (size_t id = 1; id < _sitesById.size(); ++id) {
+            AllocationSite *site = _sitesById[id];
+            if (site->_tenured) {
+                out << strings::toStdString(makeIdentity(site->_method, site->_bci)) << '\n';
+            }
+        }
+        return (bool) out;
+    }
+}
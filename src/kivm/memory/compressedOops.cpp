@@ -0,0 +1,104 @@
+//
+// Created by kiva on 2018/4/25.
+//
+
+#include <kivm/memory/compressedOops.h>
+#include <kivm/runtime/runtimeConfig.h>
+#include <shared/memory.h>
+#include <shared/lock.h>
+#include <algorithm>
+#include <cstddef>
+#include <new>
+
+namespace kivm {
+    bool CompressedOops::_useCompressedOops = false;
+    bool CompressedOops::_useCompressedClassPointers = false;
+    char *CompressedOops::_oopBase = nullptr;
+    char *CompressedOops::_klassBase = nullptr;
+
+    static char *klassSpaceTop = nullptr;
+    static char *klassSpaceCommitted = nullptr;
+    static char *klassSpaceEnd = nullptr;
+
+    // the class space is committed in steps of this size
+    static const size_t KLASS_SPACE_COMMIT_CHUNK = 64 * 1024;
+
+    static Lock &getKlassSpaceLock() {
+        static Lock lock;
+        return lock;
+    }
+
+    bool CompressedOops::doInitialize() {
+        const RuntimeConfig &config = RuntimeConfig::get();
+        if (sizeof(void *) <= sizeof(narrowOop)) {
+            // pointers are already 32-bit
+            return true;
+        }
+
+        if (config.useCompressedOops) {
+            if ((u8) config.maxHeapSize > MAX_ENCODABLE_SIZE) {
+                D("Max heap size too large for compressed oops, using full pointers");
+            } else {
+                _useCompressedOops = true;
+            }
+        }
+
+        if (config.useCompressedClassPointers) {
+            size_t size = memory::alignUp(config.compressedClassSpaceSize, memory::getPageSize());
+            if ((u8) size > MAX_ENCODABLE_SIZE) {
+                size = (size_t) MAX_ENCODABLE_SIZE;
+            }
+            auto *base = (char *) memory::reserve(size);
+            if (base == nullptr) {
+                D("Could not reserve %zd bytes for the class space, using full pointers", size);
+            } else {
+                _klassBase = base;
+                _useCompressedClassPointers = true;
+                klassSpaceTop = base;
+                klassSpaceCommitted = base;
+                klassSpaceEnd = base + size;
+            }
+        }
+        return true;
+    }
+
+    void CompressedOops::initialize() {
+        static bool initialized = doInitialize();
+        (void) initialized;
+    }
+
+    void *CompressedOops::allocateKlass(size_t size) {
+        initialize();
+        if (!_useCompressedClassPointers) {
+            return ::operator new(size);
+        }
+
+        size = memory::alignUp(size, alignof(std::max_align_t));
+        LockGuard lockGuard(getKlassSpaceLock());
+        if ((size_t) (klassSpaceEnd - klassSpaceTop) < size) {
+            // TODO: throw java.lang.OutOfMemoryError
+            PANIC("java.lang.OutOfMemoryError: Compressed class space");
+        }
+        if (klassSpaceTop + size > klassSpaceCommitted) {
+            size_t commitSize = memory::alignUp((size_t) (klassSpaceTop + size - klassSpaceCommitted),
+                                                KLASS_SPACE_COMMIT_CHUNK);
+            commitSize = std::min(commitSize, (size_t) (klassSpaceEnd - klassSpaceCommitted));
+            if (!memory::commit(klassSpaceCommitted, commitSize)) {
+                PANIC("java.lang.OutOfMemoryError: Compressed class space");
+            }
+            klassSpaceCommitted += commitSize;
+        }
+
+        char *klass = klassSpaceTop;
+        klassSpaceTop += size;
+        return klass;
+    }
+
+    void CompressedOops::deallocateKlass(void *ptr) {
+        if (_useCompressedClassPointers) {
+            // classes are never unloaded, the class space is not reused
+            return;
+        }
+        ::operator delete(ptr);
+    }
+}
@@ -0,0 +1,280 @@
+//
+// Created by kiva on 2018/4/20.
+//
+
+#include <kivm/memory/heap.h>
+#include <kivm/memory/markCompact.h>
+#include <kivm/memory/compressedOops.h>
+#include <kivm/memory/allocationSite.h>
+#include <kivm/oop/instanceOop.h>
+#include <kivm/oop/arrayOop.h>
+#include <kivm/runtime/thread.h>
+#include <kivm/runtime/runtimeConfig.h>
+#include <kivm/runtime/safepoint.h>
+#include <kivm/native/java_lang_Class.h>
+#include <kivm/native/java_lang_String.h>
+#include <shared/memory.h>
+#include <algorithm>
+#include <csetjmp>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+
+namespace kivm {
+    // transparent huge pages are only used for 2 MB aligned ranges
+    static const size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+    Heap *Heap::get() {
+        static Heap heap(RuntimeConfig::get().initialHeapSize,
+                         RuntimeConfig::get().maxHeapSize);
+        return &heap;
+    }
+
+    Heap::Heap(size_t initialCapacity, size_t reservedSize)
+        : _collectionRequested(false), _collections(0) {
+        const RuntimeConfig &config = RuntimeConfig::get();
+        size_t pageSize = memory::getPageSize();
+        if ((u8) reservedSize > MAX_RESERVED_SIZE) {
+            D("Heap of %zd bytes cut down to %llu bytes", reservedSize, MAX_RESERVED_SIZE);
+            reservedSize = (size_t) MAX_RESERVED_SIZE;
+        }
+        _reservedSize = memory::alignUp(reservedSize, pageSize);
+        _initialCapacity = std::min(memory::alignUp(initialCapacity, pageSize), _reservedSize);
+
+        // One contiguous range for the whole heap, committed as it grows.
+        _base = (char *) memory::reserve(_reservedSize,
+                                         config.useTransparentHugePages ? HUGE_PAGE_SIZE : 0);
+        if (_base == nullptr) {
+            PANIC("Could not reserve %zd bytes for the Java heap", _reservedSize);
+        }
+        if (config.useTransparentHugePages) {
+            memory::adviseHugePages(_base, _reservedSize);
+        }
+
+        // The tenured space takes the top of the range, a quarter at most.
+        size_t tenuredSize = 0;
+        if (config.usePretenuring) {
+            tenuredSize = memory::alignDown(_reservedSize / 4,
+                                            config.useTransparentHugePages ? HUGE_PAGE_SIZE : pageSize);
+        }
+        _oldSpace = new MarkCompactSpace(_base, _reservedSize - tenuredSize,
+                                         std::min(_initialCapacity, _reservedSize - tenuredSize));
+        _tenuredSpace = nullptr;
+        _initialTenuredCapacity = 0;
+        if (tenuredSize != 0) {
+            _initialTenuredCapacity = std::min(memory::alignUp(_initialCapacity / 4, pageSize), tenuredSize);
+            _tenuredSpace = new MarkCompactSpace(_base + _reservedSize - tenuredSize, tenuredSize,
+                                                 _initialTenuredCapacity);
+        }
+        _largeObjectSpace = new LargeObjectSpace();
+        _largeObjectLimit = _initialCapacity;
+
+        // Take the page faults now rather than during the first requests.
+        if (config.alwaysPreTouch) {
+            memory::pretouch(_base, _initialCapacity);
+        }
+
+        // Narrow oops are offsets from the start of the reserved range,
+        // which is at most 32 GB when they are enabled.
+        CompressedOops::initialize();
+        CompressedOops::setOopBase(_base);
+
+        // Large objects are mapped elsewhere, out of reach of narrow oops.
+        _largeObjectThreshold = config.largeObjectThreshold;
+        if (_largeObjectThreshold == 0 || CompressedOops::useCompressedOops()) {
+            _largeObjectThreshold = SIZE_MAX;
+        }
+    }
+
+    void *Heap::allocate(size_t size, AllocationSite *site) {
+        if ((u8) size > HeapBlock::SIZE_LIMIT - sizeof(HeapBlock) - HEAP_WORD_SIZE) {
+            // TODO: throw java.lang.OutOfMemoryError
+            PANIC("java.lang.OutOfMemoryError: Requested array size exceeds VM limit");
+        }
+
+        size_t blockSize = HeapBlock::blockSizeFor(size);
+        HeapBlock *block = tryAllocate(blockSize, site);
+        if (block == nullptr) {
+            // Out of space: collect now rather than at the next poll, and retry.
+            collectAtSafepoint(false);
+            block = tryAllocate(blockSize, site);
+        }
+
+        if (block == nullptr) {
+            // TODO: throw java.lang.OutOfMemoryError
+            PANIC("java.lang.OutOfMemoryError: Java heap space");
+        }
+
+        // Pre-zeroed, see MarkCompactSpace::allocate(),
+        // or a fresh mapping of the large-object space.
+        return block->getObject();
+    }
+
+    HeapBlock *Heap::tryAllocate(size_t blockSize, AllocationSite *site) {
+        if (blockSize >= _largeObjectThreshold) {
+            return allocateLarge(blockSize);
+        }
+
+        LockGuard lockGuard(_lock);
+        return allocateBlock(blockSize, site);
+    }
+
+    HeapBlock *Heap::allocateBlock(size_t blockSize, AllocationSite *site) {
+        if (_tenuredSpace == nullptr) {
+            HeapBlock *block = _oldSpace->allocate(blockSize);
+            if (_oldSpace->isOverCapacity()) {
+                _collectionRequested = true;
+            }
+            return block;
+        }
+
+        // Either space takes the overflow of the other one.
+        bool tenured = site != nullptr && site->isTenured();
+        MarkCompactSpace *space = tenured ? _tenuredSpace : _oldSpace;
+        HeapBlock *block = space->allocate(blockSize);
+        if (block == nullptr) {
+            space = tenured ? _oldSpace : _tenuredSpace;
+            block = space->allocate(blockSize);
+        }
+        if (space->isOverCapacity()) {
+            _collectionRequested = true;
+        }
+
+        // Until its first collection the block header remembers
+        // where the object came from, see MarkCompactCollector::markObject().
+        if (block != nullptr && site != nullptr && !tenured) {
+            block->setForwardee(site->getId());
+            site->countAllocation();
+        }
+        return block;
+    }
+
+    HeapBlock *Heap::allocateLarge(size_t blockSize) {
+        LockGuard lockGuard(_lock);
+        HeapBlock *block = nullptr;
+        if (getUsed() + blockSize <= _reservedSize) {
+            block = _largeObjectSpace->allocate(blockSize);
+        }
+        if (_largeObjectSpace->getUsed() > _largeObjectLimit) {
+            _collectionRequested = true;
+        }
+        return block;
+    }
+
+    void Heap::collect() {
+        collectAtSafepoint(false);
+    }
+
+    void Heap::collectAtSafepoint(bool onlyIfRequested) {
+        SafepointScope safepoint;
+        LockGuard lockGuard(_lock);
+
+        // Another thread may have collected while we were waiting.
+        if (!onlyIfRequested || _collectionRequested) {
+            doCollect();
+        }
+    }
+
+    void Heap::doCollect() {
+        MarkCompactCollector(this).collect();
+        ++_collections;
+        _collectionRequested = false;
+
+        // Keep at least half of the capacity free after a collection.
+        size_t capacity = std::max(_initialCapacity,
+                                   memory::alignUp(_oldSpace->getUsed() * 2, memory::getPageSize()));
+        _oldSpace->setCapacity(capacity);
+        if (_tenuredSpace != nullptr) {
+            _tenuredSpace->setCapacity(std::max(_initialTenuredCapacity,
+                                                memory::alignUp(_tenuredSpace->getUsed() * 2,
+                                                                memory::getPageSize())));
+            AllocationSiteTable::get()->endCollection();
+        }
+        _largeObjectLimit = std::max(_initialCapacity, _largeObjectSpace->getUsed() * 2);
+    }
+
+    void Heap::destroyAll() {
+        LockGuard lockGuard(_lock);
+        for (MarkCompactSpace *space : {_oldSpace, _tenuredSpace}) {
+            if (space == nullptr) {
+                continue;
+            }
+            space->iterateBlocks([](HeapBlock *block) {
+                if (!block->isFiller()) {
+                    destroyObject((oop) block->getObject());
+                }
+            });
+            space->setTop(space->getBottom());
+            memory::discard(space->getBottom(), space->getCommittedSize());
+        }
+        _largeObjectSpace->sweep([](void *object) {
+            destroyObject((oop) object);
+        });
+    }
+
+    void Heap::iterateObject(oop object, OopClosure *closure) {
+        switch (object->getMarkOop()->getOopType()) {
+            case oopType::INSTANCE_OOP:
+                ((instanceOop) object)->iterateOops(closure);
+                break;
+            case oopType::OBJECT_ARRAY_OOP:
+            case oopType::TYPE_ARRAY_OOP:
+                ((arrayOop) object)->iterateOops(closure);
+                break;
+            case oopType::PRIMITIVE_OOP:
+                break;
+        }
+    }
+
+    void Heap::destroyObject(oop object) {
+        object->getMarkOop()->deflate();
+        switch (object->getMarkOop()->getOopType()) {
+            case oopType::INSTANCE_OOP:
+                ((instanceOop) object)->~instanceOopDesc();
+                break;
+            case oopType::OBJECT_ARRAY_OOP:
+            case oopType::TYPE_ARRAY_OOP:
+                ((arrayOop) object)->~arrayOopDesc();
+                break;
+            case oopType::PRIMITIVE_OOP:
+                // trivially destructible
+                break;
+        }
+    }
+
+    static KIVM_NOINLINE void scanNativeStack(RootClosure *closure) {
+        void *base = memory::getCurrentStackBase();
+        if (base == nullptr) {
+            D("Unknown stack base, skipped scanning native stack");
+            return;
+        }
+
+        // Everything above this frame belongs to callers,
+        // including the registers spilled by iterateNativeStack().
+        void *marker = nullptr;
+        auto **p = (void **) memory::alignDown((size_t) &marker, sizeof(void *));
+        auto **end = (void **) base;
+        for (; p < end; ++p) {
+            closure->doConservativeRoot(*p);
+        }
+    }
+
+    static KIVM_NOINLINE void iterateNativeStack(RootClosure *closure) {
+        // Spill callee-saved registers into this frame,
+        // references held in registers are visible to the stack scan then.
+        jmp_buf registers;
+        setjmp(registers);
+#if defined(__GNUC__)
+        __builtin_unwind_init();
+#endif
+        scanNativeStack(closure);
+    }
+
+    void Heap::iterateRoots(RootClosure *closure) {
+        SystemDictionary::get()->iterateOops(closure);
+        java::lang::Class::iterateOops(closure);
+        java::lang::InternStringPool::getGlobal()->iterateOops(closure);
+        Threads::iterateRoots(closure);
+        iterateNativeStack(closure);
+    }
+}
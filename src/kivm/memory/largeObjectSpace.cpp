@@ -0,0 +1,44 @@
+//
+// Created by kiva on 2018/4/25.
+//
+
+#include <kivm/memory/largeObjectSpace.h>
+#include <shared/memory.h>
+
+namespace kivm {
+    LargeObjectSpace::LargeObjectSpace()
+        : _used(0) {
+    }
+
+    HeapBlock *LargeObjectSpace::allocate(size_t blockSize) {
+        size_t mappedSize = memory::alignUp(blockSize, memory::getPageSize());
+        auto *address = (char *) memory::reserve(mappedSize);
+        if (address == nullptr) {
+            return nullptr;
+        }
+        if (!memory::commit(address, mappedSize)) {
+            memory::release(address, mappedSize);
+            return nullptr;
+        }
+
+        auto *block = (HeapBlock *) address;
+        block->initialize(blockSize, false);
+        _blocks.emplace(address, mappedSize);
+        _used += mappedSize;
+        return block;
+    }
+
+    HeapBlock *LargeObjectSpace::findBlock(const void *p) const {
+        auto iter = _blocks.upper_bound((char *) p);
+        if (iter == _blocks.begin()) {
+            return nullptr;
+        }
+        --iter;
+        return (const char *) p < iter->first + iter->second ? (HeapBlock *) iter->first : nullptr;
+    }
+
+    void LargeObjectSpace::release(char *block, size_t mappedSize) {
+        memory::release(block, mappedSize);
+        _used -= mappedSize;
+    }
+}
@@ -0,0 +1,288 @@
+//
+// Created by kiva on 2018/4/20.
+//
+
+#include <kivm/memory/markCompact.h>
+#include <kivm/memory/allocationSite.h>
+#include <shared/memory.h>
+#include <algorithm>
+#include <cstring>
+
+namespace kivm {
+    class MarkClosure : public RootClosure {
+    private:
+        MarkCompactCollector *_collector;
+        std::vector<void *> &_conservativeRoots;
+
+    public:
+        MarkClosure(MarkCompactCollector *collector,
+                    std::vector<void *> &conservativeRoots)
+            : _collector(collector), _conservativeRoots(conservativeRoots) {
+        }
+
+        void doOop(oop *p) override;
+
+        void doConservativeRoot(void *word) override;
+    };
+
+    class AdjustPointerClosure : public RootClosure {
+    private:
+        const MarkCompactCollector *_collector;
+
+    public:
+        explicit AdjustPointerClosure(const MarkCompactCollector *collector)
+            : _collector(collector) {
+        }
+
+        void doOop(oop *p) override {
+            *p = _collector->forward(*p);
+        }
+
+        void doConservativeRoot(void *) override {
+            // Objects reached by conservative roots are pinned.
+        }
+    };
+
+    MarkCompactCollector::MarkCompactCollector(Heap *heap)
+        : _heap(heap),
+          _largeObjects(heap->getLargeObjectSpace()),
+          _liveBytes(0), _pinnedBlocks(0), _destroyedObjects(0), _releasedLargeObjects(0) {
+        _spaces.emplace_back(heap->getOldSpace());
+        if (heap->getTenuredSpace() != nullptr) {
+            _spaces.emplace_back(heap->getTenuredSpace());
+        }
+    }
+
+    MarkCompactSpace *MarkCompactCollector::findSpace(const void *p) const {
+        for (const auto &compacted : _spaces) {
+            if (compacted.space->contains(p)) {
+                return compacted.space;
+            }
+        }
+        return nullptr;
+    }
+
+    void MarkClosure::doOop(oop *p) {
+        _collector->markObject(*p);
+    }
+
+    void MarkClosure::doConservativeRoot(void *word) {
+        if (_collector->findSpace(word) != nullptr) {
+            _conservativeRoots.push_back(word);
+            return;
+        }
+
+        // Large objects never move, so they need no pinning.
+        HeapBlock *block = _collector->_largeObjects->findBlock(word);
+        if (block != nullptr) {
+            _collector->markObject((oop) block->getObject());
+        }
+    }
+
+    void MarkCompactCollector::markObject(oop object) {
+        if (object == nullptr) {
+            return;
+        }
+
+        bool compacted = findSpace(object) != nullptr;
+        if (!compacted && !_largeObjects->contains(object)) {
+            return;
+        }
+
+        HeapBlock *block = HeapBlock::fromObject(object);
+        if (!block->isMarked()) {
+            block->setMarked();
+            _markStack.push_back(object);
+
+            // first survival of an object from a tracked site, see Heap::allocateBlock()
+            if (compacted && block->getForwardee() != 0) {
+                AllocationSiteTable::get()->recordSurvivor(block->getForwardee());
+            }
+        }
+    }
+
+    void MarkCompactCollector::drainMarkStack() {
+        MarkClosure closure(this, _conservativeRoots);
+        while (!_markStack.empty()) {
+            oop object = _markStack.back();
+            _markStack.pop_back();
+            Heap::iterateObject(object, &closure);
+        }
+    }
+
+    void MarkCompactCollector::pinConservativeRoots() {
+        auto &roots = _conservativeRoots;
+        std::sort(roots.begin(), roots.end());
+        roots.erase(std::unique(roots.begin(), roots.end()), roots.end());
+
+        for (auto &compacted : _spaces) {
+            size_t index = 0;
+            compacted.space->iterateBlocks([&](HeapBlock *block) {
+                char *start = (char *) block;
+                char *end = start + block->getSize();
+                while (index < roots.size() && (char *) roots[index] < start) {
+                    ++index;
+                }
+
+                if (index < roots.size() && (char *) roots[index] < end && !block->isFiller()) {
+                    // Interior pointers keep the object alive as well.
+                    block->setPinned();
+                    markObject((oop) block->getObject());
+                }
+            });
+        }
+    }
+
+    void MarkCompactCollector::mark() {
+        MarkClosure closure(this, _conservativeRoots);
+        Heap::iterateRoots(&closure);
+        pinConservativeRoots();
+        drainMarkStack();
+    }
+
+    void MarkCompactCollector::computeForwardingAddresses(CompactedSpace &compacted) {
+        MarkCompactSpace *space = compacted.space;
+        auto &holes = compacted.holes;
+        std::vector<char *> pinned;
+        space->iterateBlocks([&](HeapBlock *block) {
+            if (block->isMarked() && block->isPinned()) {
+                pinned.push_back((char *) block);
+            }
+        });
+        _pinnedBlocks += pinned.size();
+
+        size_t nextPinned = 0;
+        char *compactTop = space->getBottom();
+        space->iterateBlocks([&](HeapBlock *block) {
+            if (block->isFiller()) {
+                return;
+            }
+
+            if (!block->isMarked()) {
+                Heap::destroyObject((oop) block->getObject());
+                ++_destroyedObjects;
+                return;
+            }
+
+            char *start = (char *) block;
+            size_t size = block->getSize();
+            _liveBytes += size;
+
+            if (block->isPinned()) {
+                if (compactTop < start) {
+                    holes.emplace_back(compactTop, (size_t) (start - compactTop));
+                }
+                compactTop = start;
+                ++nextPinned;
+
+            } else if (nextPinned < pinned.size() && compactTop + size > pinned[nextPinned]) {
+                // Not enough room in front of the next pinned object, stay where it is.
+                if (compactTop < start) {
+                    holes.emplace_back(compactTop, (size_t) (start - compactTop));
+                }
+                compactTop = start;
+            }
+
+            block->setForwardee(_heap->toWordOffset(compactTop));
+            compactTop += size;
+        });
+        compacted.compactTop = compactTop;
+    }
+
+    oop MarkCompactCollector::forward(oop object) const {
+        if (object == nullptr || findSpace(object) == nullptr) {
+            return object;
+        }
+
+        HeapBlock *block = HeapBlock::fromObject(object);
+        if (!block->isMarked()) {
+            return object;
+        }
+        auto *forwardee = (HeapBlock *) _heap->fromWordOffset(block->getForwardee());
+        return (oop) forwardee->getObject();
+    }
+
+    void MarkCompactCollector::adjustPointers() {
+        AdjustPointerClosure closure(this);
+        Heap::iterateRoots(&closure);
+
+        for (auto &compacted : _spaces) {
+            compacted.space->iterateBlocks([&](HeapBlock *block) {
+                if (block->isMarked() && !block->isFiller()) {
+                    Heap::iterateObject((oop) block->getObject(), &closure);
+                }
+            });
+        }
+
+        // only live large objects are left after sweeping
+        _largeObjects->iterateBlocks([&](HeapBlock *block) {
+            Heap::iterateObject((oop) block->getObject(), &closure);
+        });
+    }
+
+    void MarkCompactCollector::sweepLargeObjects() {
+        _releasedLargeObjects = _largeObjects->sweep([](void *object) {
+            Heap::destroyObject((oop) object);
+        });
+    }
+
+    void MarkCompactCollector::compact(CompactedSpace &compacted) {
+        MarkCompactSpace *space = compacted.space;
+        char *compactTop = compacted.compactTop;
+        space->iterateBlocks([&](HeapBlock *block) {
+            if (!block->isMarked() || block->isFiller()) {
+                return;
+            }
+
+            auto *destination = (HeapBlock *) _heap->fromWordOffset(block->getForwardee());
+            if (destination != block) {
+                memmove(destination, block, block->getSize());
+            }
+            destination->clearCollectorStates();
+            // survivors no longer count for their allocation site
+            destination->setForwardee(0);
+        });
+
+        // Holes are filled after all objects moved,
+        // because a hole may overlap objects that were not moved yet.
+        for (const auto &hole : compacted.holes) {
+            HeapBlock::fill(hole.first, hole.second);
+        }
+
+        // Return the pages no longer used to the operating system.
+        size_t pageSize = memory::getPageSize();
+        char *oldTop = space->getTop();
+        auto *releaseStart = (char *) memory::alignUp((size_t) compactTop, pageSize);
+        auto *releaseEnd = (char *) memory::alignUp((size_t) oldTop, pageSize);
+        space->setTop(compactTop);
+        if (releaseStart < releaseEnd) {
+            memory::discard(releaseStart, (size_t) (releaseEnd - releaseStart));
+        }
+
+        // Clear the rest by hand, new objects are carved out of it without zeroing.
+        char *clearEnd = std::min(releaseStart, oldTop);
+        if (compactTop < clearEnd) {
+            memset(compactTop, '\0', (size_t) (clearEnd - compactTop));
+        }
+    }
+
+    void MarkCompactCollector::collect() {
+#ifdef KIVM_DEBUG
+        size_t usedBefore = _heap->getUsed();
+#endif
+
+        mark();
+        sweepLargeObjects();
+        for (auto &compacted : _spaces) {
+            computeForwardingAddresses(compacted);
+        }
+        adjustPointers();
+        for (auto &compacted : _spaces) {
+            compact(compacted);
+        }
+
+        D("GC: %zd -> %zd bytes, live: %zd bytes, pinned: %zd, destroyed: %zd, large objects released: %zd",
+          usedBefore, _heap->getUsed(), _liveBytes, _pinnedBlocks, _destroyedObjects,
+          _releasedLargeObjects);
+    }
+}
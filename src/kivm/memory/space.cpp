@@ -0,0 +1,51 @@
+//
+// Created by kiva on 2018/4/20.
+//
+
+#include <kivm/memory/space.h>
+#include <shared/memory.h>
+#include <algorithm>
+
+namespace kivm {
+    MarkCompactSpace::MarkCompactSpace(void *bottom, size_t reservedSize, size_t capacity)
+        : _bottom((char *) bottom),
+          _top((char *) bottom),
+          _end((char *) bottom + capacity),
+          _committedEnd((char *) bottom),
+          _reservedEnd((char *) bottom + reservedSize) {
+        if (!expandCommitted(_end)) {
+            PANIC("Could not commit %zd bytes for the Java heap", capacity);
+        }
+    }
+
+    bool MarkCompactSpace::expandCommitted(char *top) {
+        size_t size = memory::alignUp((size_t) (top - _committedEnd), COMMIT_CHUNK);
+        size = std::min(size, (size_t) (_reservedEnd - _committedEnd));
+        if (!memory::commit(_committedEnd, size)) {
+            return false;
+        }
+        _committedEnd += size;
+        return true;
+    }
+
+    HeapBlock *MarkCompactSpace::allocate(size_t blockSize) {
+        if (blockSize > (size_t) (_reservedEnd - _top)) {
+            return nullptr;
+        }
+        if (_top + blockSize > _committedEnd && !expandCommitted(_top + blockSize)) {
+            return nullptr;
+        }
+
+        auto *block = (HeapBlock *) _top;
+        block->initialize(blockSize, false);
+        _top += blockSize;
+        return block;
+    }
+
+    void MarkCompactSpace::setCapacity(size_t capacity) {
+        if (capacity > getReservedSize()) {
+            capacity = getReservedSize();
+        }
+        this->_end = _bottom + capacity;
+    }
+}
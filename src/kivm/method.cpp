@@ -6,7 +6,6 @@
 #include <kivm/oop/instanceKlass.h>
 #include <kivm/bytecode/execution.h>
 #include <shared/lock.h>
-#include <sstream>
 
 namespace kivm {
     static Lock &get_method_pool_lock() {
@@ -30,21 +29,19 @@ namespace kivm {
 
     bool Method::isSame(const Method *lhs, const Method *rhs) {
         return lhs != nullptr && rhs != nullptr
-               && lhs->getName() == rhs->getName()
-               && lhs->getDescriptor() == rhs->getDescriptor();
-    }
-
-    String Method::makeIdentity(const Method *m) {
-        std::wstringstream ss;
-        ss << m->getName() << L" " << m->getDescriptor();
-        return ss.str();
+               && lhs->_name == rhs->_name
+               && lhs->_descriptor == rhs->_descriptor;
     }
 
     Method::Method(InstanceKlass *clazz, method_info *methodInfo) {
         this->_linked = false;
         this->_klass = clazz;
+        this->_name = nullptr;
+        this->_descriptor = nullptr;
+        this->_signature = nullptr;
         this->_methodInfo = methodInfo;
         this->_codeAttr = nullptr;
+        this->_stackMapTableAttr = nullptr;
         this->_exceptionAttr = nullptr;
         this->_argumentValueTypesResolved = false;
         this->_returnTypeResolved = false;
@@ -64,8 +61,8 @@ namespace kivm {
         this->_accessFlag = _methodInfo->access_flags;
         auto *name_info = requireConstant<CONSTANT_Utf8_info>(pool, _methodInfo->name_index);
         auto *desc_info = requireConstant<CONSTANT_Utf8_info>(pool, _methodInfo->descriptor_index);
-        this->_name = name_info->get_constant();
-        this->_descriptor = desc_info->get_constant();
+        this->_name = SymbolTable::get()->lookup(name_info->bytes, name_info->length);
+        this->_descriptor = SymbolTable::get()->lookup(desc_info->bytes, desc_info->length);
         linkAttributes(pool);
         _linked = true;
     }
@@ -86,7 +83,7 @@ namespace kivm {
                 case ATTRIBUTE_Signature: {
                     auto *sig_attr = (Signature_attribute *) attr;
                     auto *utf8 = requireConstant<CONSTANT_Utf8_info>(pool, sig_attr->signature_index);
-                    _signature = utf8->get_constant();
+                    _signature = SymbolTable::get()->lookup(utf8->bytes, utf8->length);
                     break;
                 }
                 case ATTRIBUTE_RuntimeVisibleAnnotations:
@@ -143,8 +140,11 @@ namespace kivm {
                     }
                     break;
                 }
+                case ATTRIBUTE_StackMapTable: {
+                    _stackMapTableAttr = (StackMapTable_attribute *) sub_attr;
+                    break;
+                }
                 case ATTRIBUTE_RuntimeVisibleTypeAnnotations:
-                case ATTRIBUTE_StackMapTable:
                 case ATTRIBUTE_LocalVariableTable:
                 case ATTRIBUTE_LocalVariableTypeTable:
                 case ATTRIBUTE_RuntimeInvisibleTypeAnnotations:
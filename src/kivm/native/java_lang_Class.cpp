@@ -6,6 +6,7 @@
 #include <kivm/oop/klass.h>
 #include <kivm/oop/mirrorKlass.h>
 #include <kivm/oop/mirrorOop.h>
+#include <kivm/memory/oopClosure.h>
 
 namespace kivm {
     namespace java {
@@ -25,6 +26,12 @@ namespace kivm {
                 return mirrors;
             }
 
+            void Class::iterateOops(OopClosure *closure) {
+                for (auto &e : getPrimitiveTypeMirrors()) {
+                    closure->doOop((oop *) &e.second);
+                }
+            }
+
             void Class::initialize() {
                 BootstrapClassLoader::get()->loadClass(L"java/lang/Class");
                 auto &m = getDelayedMirrors();
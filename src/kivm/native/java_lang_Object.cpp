@@ -0,0 +1,14 @@
+//
+// Created by kiva on 2018/4/24.
+//
+
+#include <kivm/kivm.h>
+#include <kivm/oop/oop.h>
+#include <kivm/bytecode/execution.h>
+
+using namespace kivm;
+
+extern "C" jint Java_java_lang_Object_hashCode(jobject thisObj) {
+    oop object = Resolver::resolveJObject(thisObj);
+    return (jint) object->getMarkOop()->getIdentityHash();
+}
@@ -7,6 +7,7 @@
 #include <kivm/oop/instanceOop.h>
 #include <kivm/oop/primitiveOop.h>
 #include <kivm/oop/arrayOop.h>
+#include <kivm/memory/oopClosure.h>
 #include <unordered_map>
 
 namespace kivm {
@@ -31,17 +32,19 @@ namespace kivm {
                 return java_string;
             }
 
+            void InternStringPool::iterateOops(OopClosure *closure) {
+                for (auto &e : _pool) {
+                    closure->doOop((oop *) &e.second);
+                }
+            }
+
             int String::Hash::operator()(instanceOop string) const noexcept {
                 // if has a hash_val cache, need no calculate.
-                oop int_oop_hash = nullptr;
-
                 auto klass = (InstanceKlass *) string->getClass();
                 FieldID *hash_field = klass->getInstanceFieldInfo(J_STRING, L"hash", L"I");
-                if (string->getFieldValue(hash_field, &int_oop_hash)) {
-                    int cached_hash = ((intOop) int_oop_hash)->getValue();
-                    if (cached_hash != 0) {
-                        return cached_hash;
-                    }
+                int cached_hash = string->getFieldAt<jint>(hash_field->_offset);
+                if (cached_hash != 0) {
+                    return cached_hash;
                 }
 
                 // get string's content which is typed `TypeArrayOop` and calculate hash value.
@@ -50,10 +53,9 @@ namespace kivm {
                     int length = value_field->getLength();
                     int hash = 0;
                     for (int i = 0; i < length; i++) {
-                        auto single_char = (intOop) value_field->getElementAt(i);
-                        hash = 31 * hash + single_char->getValue();
+                        hash = 31 * hash + value_field->getValueAt<jchar>(i);
                     }
-                    string->setFieldValue(hash_field, new intOopDesc(hash));
+                    string->setFieldAt<jint>(hash_field->_offset, hash);
                     return hash;
                 }
 
@@ -92,9 +94,7 @@ namespace kivm {
                 }
 
                 for (int i = 0; i < lhs_length; ++i) {
-                    auto lhs_char = (intOop) lhs_value->getElementAt(i);
-                    auto rhs_char = (intOop) rhs_value->getElementAt(i);
-                    if (lhs_char->getValue() != rhs_char->getValue()) {
+                    if (lhs_value->getValueAt<jchar>(i) != rhs_value->getValueAt<jchar>(i)) {
                         return false;
                     }
                 }
@@ -107,7 +107,7 @@ namespace kivm {
 
                 typeArrayOop chars = char_array_klass->newInstance((int) string.size());
                 for (int i = 0; i < string.size(); ++i) {
-                    chars->setElementAt(i, new intOopDesc((unsigned short) string[i]));
+                    chars->setValueAt<jchar>(i, (jchar) string[i]);
                 }
 
                 instanceOop java_string = string_klass->newInstance();
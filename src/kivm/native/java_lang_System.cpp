@@ -0,0 +1,17 @@
+//
+// Created by kiva on 2018/4/24.
+//
+
+#include <kivm/kivm.h>
+#include <kivm/oop/oop.h>
+#include <kivm/bytecode/execution.h>
+
+using namespace kivm;
+
+extern "C" jint Java_java_lang_System_identityHashCode(jobject obj) {
+    oop object = Resolver::resolveJObject(obj);
+    if (object == nullptr) {
+        return 0;
+    }
+    return (jint) object->getMarkOop()->getIdentityHash();
+}
@@ -4,6 +4,8 @@
 
 #include <kivm/oop/arrayKlass.h>
 #include <kivm/oop/arrayOop.h>
+#include <kivm/oop/helper.h>
+#include <kivm/memory/oopClosure.h>
 #include <sstream>
 
 namespace kivm {
@@ -12,7 +14,8 @@ namespace kivm {
                            int dimension, ClassType classType)
         : _classLoader(classLoader),
           _javaLoader(javaLoader),
-          _dimension(dimension) {
+          _dimension(dimension),
+          _elementSize(CompressedOops::getReferenceSize()) {
         this->setClassType(classType);
     }
 
@@ -20,6 +23,11 @@ namespace kivm {
         this->setClassState(ClassState::LINKED);
     }
 
+    void ArrayKlass::iterateOops(OopClosure *closure) {
+        Klass::iterateOops(closure);
+        closure->doOop((oop *) &_javaLoader);
+    }
+
     TypeArrayKlass::TypeArrayKlass(ClassLoader *classLoader, mirrorOop javaLoader,
                                    int dimension, ValueType componentType)
         : ArrayKlass(classLoader, javaLoader, dimension, ClassType::TYPE_ARRAY_CLASS),
@@ -31,6 +39,11 @@ namespace kivm {
         }
         ss << valueTypeToPrimitiveType(componentType);
         this->setName(ss.str());
+
+        // sub-arrays are referenced, only the last dimension is unboxed
+        if (dimension == 1) {
+            _elementSize = helperValueSize(componentType);
+        }
     }
 
     TypeArrayKlass::TypeArrayKlass(ClassLoader *classLoader, TypeArrayKlass *downType)
@@ -41,8 +54,8 @@ namespace kivm {
         this->_downDimensionType = downType;
     }
 
-    typeArrayOop TypeArrayKlass::newInstance(int length) {
-        return new typeArrayOopDesc(this, length);
+    typeArrayOop TypeArrayKlass::newInstance(int length, AllocationSite *site) {
+        return new(this, length, site) typeArrayOopDesc(this, length);
     }
 
     ObjectArrayKlass::ObjectArrayKlass(ClassLoader *classLoader, mirrorOop javaLoader,
@@ -66,7 +79,7 @@ namespace kivm {
         this->_downDimensionType = downType;
     }
 
-    objectArrayOop ObjectArrayKlass::newInstance(int length) {
-        return new objectArrayOopDesc(this, length);
+    objectArrayOop ObjectArrayKlass::newInstance(int length, AllocationSite *site) {
+        return new(this, length, site) objectArrayOopDesc(this, length);
     }
 }
@@ -3,36 +3,63 @@
 //
 
 #include <kivm/oop/arrayOop.h>
+#include <kivm/oop/helper.h>
+#include <kivm/memory/oopClosure.h>
 
 namespace kivm {
+    void *arrayOopDesc::operator new(size_t size, ArrayKlass *arrayClass, int length,
+                                     AllocationSite *site) noexcept {
+        if (length < 0) {
+            // TODO: throw NegativeArraySizeException
+            PANIC("java.lang.NegativeArraySizeException");
+        }
+        return allocate((size_t) getBaseOffset() + (size_t) length * arrayClass->getElementSize(), site);
+    }
+
     arrayOopDesc::arrayOopDesc(ArrayKlass *arrayClass, oopType type, int length)
         : oopDesc(arrayClass, type) {
-        _elements.resize(static_cast<unsigned>(length));
-        _elements.shrink_to_fit();
+        *(jint *) ((u1 *) this + getLengthOffset()) = length;
     }
 
     int arrayOopDesc::getDimension() const {
         return ((ArrayKlass *) getClass())->getDimension();
     }
 
-    int arrayOopDesc::getLength() const {
-        return static_cast<int>(_elements.size());
+    bool arrayOopDesc::hasReferenceElements() const {
+        return getClass()->getClassType() == ClassType::OBJECT_ARRAY_CLASS
+               || getDimension() > 1;
     }
 
     oop arrayOopDesc::getElementAt(int position) const {
-        if (position < 0 || position >= getLength()) {
-            // TODO: throw ArrayIndexOutOfBoundsException
-            PANIC("java.lang.ArrayIndexOutOfBoundsException");
+        checkIndex(position);
+        u1 *element = getElementBase() + (size_t) position * ((ArrayKlass *) getClass())->getElementSize();
+        if (hasReferenceElements()) {
+            return CompressedOops::loadReference(element);
         }
-        return _elements[position];
+        return helperLoadValue(((TypeArrayKlass *) getClass())->getComponentType(), element);
     }
 
     void arrayOopDesc::setElementAt(int position, oop element) {
-        if (position < 0 || position >= getLength()) {
-            // TODO: throw ArrayIndexOutOfBoundsException
-            PANIC("java.lang.ArrayIndexOutOfBoundsException");
+        checkIndex(position);
+        u1 *address = getElementBase() + (size_t) position * ((ArrayKlass *) getClass())->getElementSize();
+        if (hasReferenceElements()) {
+            CompressedOops::storeReference(address, element);
+            return;
+        }
+        helperStoreValue(((TypeArrayKlass *) getClass())->getComponentType(), address, element);
+    }
+
+    void arrayOopDesc::iterateOops(OopClosure *closure) {
+        if (!hasReferenceElements()) {
+            return;
+        }
+
+        u1 *elements = getElementBase();
+        int referenceSize = CompressedOops::getReferenceSize();
+        int length = getLength();
+        for (int i = 0; i < length; ++i) {
+            closure->doHeapOop(elements + (size_t) i * referenceSize);
         }
-        _elements[position] = element;
     }
 
     typeArrayOopDesc::typeArrayOopDesc(TypeArrayKlass *arrayClass, int length)
@@ -5,23 +5,29 @@
 #include <kivm/oop/instanceKlass.h>
 #include <kivm/oop/primitiveOop.h>
 #include <kivm/oop/instanceOop.h>
+#include <kivm/oop/mirrorOop.h>
 #include <kivm/oop/helper.h>
 #include <kivm/method.h>
 #include <kivm/field.h>
-#include <sstream>
+#include <kivm/memory/oopClosure.h>
+#include <kivm/runtime/fieldProfile.h>
+#include <algorithm>
 
 namespace kivm {
     InstanceKlass::InstanceKlass(ClassFile *classFile, ClassLoader *classLoader,
                                  mirrorOop javaLoader, ClassType classType)
-        : _runtimePool(this),
+        : _classLoader(classLoader),
           _javaLoader(javaLoader),
           _classFile(classFile),
-          _classLoader(classLoader),
-          _nInstanceFields(0),
-          _nStaticFields(0),
+          _innerClassAttr(nullptr),
           _enclosingMethodAttr(nullptr),
           _bootstrapMethodAttr(nullptr),
-          _innerClassAttr(nullptr) {
+          _runtimePool(this),
+          _nStaticFields(0),
+          _nInstanceFields(0),
+          _instanceSize(sizeof(instanceOopDesc)),
+          _staticFieldBlock(nullptr),
+          _staticFieldBlockSize(0) {
         this->setClassType(classType);
     }
 
@@ -58,6 +64,15 @@ namespace kivm {
         this->setClassState(ClassState::LINKED);
     }
 
+    void InstanceKlass::iterateOops(OopClosure *closure) {
+        Klass::iterateOops(closure);
+        closure->doOop((oop *) &_javaLoader);
+        for (int offset : _staticReferenceOffsets) {
+            closure->doHeapOop(_staticFieldBlock + offset);
+        }
+        _runtimePool.iterateOops(closure);
+    }
+
     void InstanceKlass::linkSuperClass(cp_info **pool) {
         if (_classFile->super_class == 0) {
             // java.lang.Object
@@ -101,7 +116,7 @@ namespace kivm {
             method->linkMethod(pool);
             MethodPool::add(method);
 
-            const auto &id = Method::makeIdentity(method);
+            SymbolPair id = method->getIdentity();
             const auto &pair = make_pair(id, method);
             _allMethods.insert(pair);
 
@@ -119,78 +134,176 @@ namespace kivm {
         }
     }
 
+    static bool isReferenceField(Field *field) {
+        return field->getValueType() == ValueType::OBJECT
+               || field->getValueType() == ValueType::ARRAY;
+    }
+
+    /**
+     * Pack fields from {@code offset}: larger fields first, references grouped together.
+     * Alignment gaps, including one left before {@code offset},
+     * are filled with the largest field that still fits.
+     * @param place called with every field and its byte offset
+     * @return end of the last field
+     */
+    template <typename Place>
+    static int packFields(std::vector<Field *> &fields, int offset, Place place) {
+        std::stable_sort(fields.begin(), fields.end(),
+                         [](Field *lhs, Field *rhs) {
+                             int lhsSize = helperValueSize(lhs->getValueType());
+                             int rhsSize = helperValueSize(rhs->getValueType());
+                             if (lhsSize != rhsSize) {
+                                 return lhsSize > rhsSize;
+                             }
+                             return isReferenceField(lhs) && !isReferenceField(rhs);
+                         });
+
+        while (!fields.empty()) {
+            auto iter = std::find_if(fields.begin(), fields.end(),
+                                     [offset](Field *field) {
+                                         return offset % helperValueSize(field->getValueType()) == 0;
+                                     });
+            if (iter == fields.end()) {
+                // nothing fits, pad to the smallest remaining field
+                int alignment = helperValueSize(fields.back()->getValueType());
+                offset = (offset + alignment - 1) / alignment * alignment;
+                continue;
+            }
+
+            Field *field = *iter;
+            fields.erase(iter);
+            place(field, offset);
+            offset += helperValueSize(field->getValueType());
+        }
+        return offset;
+    }
+
+    std::vector<Field *> InstanceKlass::selectHotFields(std::vector<Field *> &fields, int offset) {
+        std::vector<Field *> hot;
+        FieldProfile *profile = FieldProfile::get();
+        if (!profile->hasProfile()) {
+            return hot;
+        }
+
+        std::vector<std::pair<u8, Field *>> accessed;
+        for (Field *field : fields) {
+            u8 count = profile->getCount(this, field);
+            if (count != 0) {
+                accessed.emplace_back(count, field);
+            }
+        }
+        std::stable_sort(accessed.begin(), accessed.end(),
+                         [](const std::pair<u8, Field *> &lhs, const std::pair<u8, Field *> &rhs) {
+                             return lhs.first > rhs.first;
+                         });
+
+        int lineSize = FieldProfile::CACHE_LINE_SIZE;
+        int budget = offset < lineSize ? lineSize - offset : lineSize;
+        for (const auto &e : accessed) {
+            int size = helperValueSize(e.second->getValueType());
+            // a colder field may still fill what a hotter one could not
+            if (size <= budget) {
+                budget -= size;
+                hot.push_back(e.second);
+            }
+        }
+
+        for (Field *field : hot) {
+            fields.erase(std::find(fields.begin(), fields.end(), field));
+        }
+        return hot;
+    }
+
     void InstanceKlass::linkFields(cp_info **pool) {
         using std::make_pair;
 
-        // for a easy implementation, I just copy superclass's instance fields layout.
-        int instance_field_index = 0;
+        // Instance fields are stored inline after the object header.
+        // Superclass fields keep their offsets, so a subclass object
+        // can be used wherever its superclass is expected.
+        // Interfaces declare only static fields and contribute nothing here.
+        int instance_size = oopDesc::getHeaderSize();
+        if (getName() == L"java/lang/Class") {
+            // leave room for the native part of mirrors
+            instance_size = sizeof(mirrorOopDesc);
+        }
 
         // instance fields in superclass
         if (this->_superClass != nullptr) {
             auto *super = (InstanceKlass *) this->_superClass;
             for (auto e : super->_instanceFields) {
-                D("%s: Extended instance field: #%-d %s",
+                D("%s: Extended instance field: +%-d %s",
                   strings::toStdString(getName()).c_str(),
-                  instance_field_index,
-                  strings::toStdString(e.first).c_str());
+                  e.second->_offset,
+                  strings::toStdString(Field::makeIdentity(e.second->_field->getClass(),
+                                                           e.second->_field)).c_str());
                 this->_instanceFields.insert(
                     make_pair(e.first,
-                              new FieldID(instance_field_index++, e.second->_field)));
-            }
-        }
-
-        // instance fields in interfaces
-        for (auto interface : this->_interfaces) {
-            for (auto field : interface.second->_instanceFields) {
-                D("%s: Extended interface instance field: #%-d %s",
-                  strings::toStdString(getName()).c_str(),
-                  instance_field_index,
-                  strings::toStdString(field.first).c_str());
-
-                this->_instanceFields.insert(
-                    make_pair(field.first,
-                              new FieldID(instance_field_index++, field.second->_field)));
+                              new FieldID(e.second->_offset, e.second->_field)));
             }
+            this->_referenceFieldOffsets = super->_referenceFieldOffsets;
+            instance_size = std::max(instance_size, super->_instanceSize);
         }
 
         // link our fields
-        int static_field_index = 0;
+        std::vector<Field *> static_fields;
+        std::vector<Field *> instance_fields;
         for (int i = 0; i < _classFile->fields_count; ++i) {
             auto *field = new Field(this, _classFile->fields + i);
             field->linkField(pool);
             FieldPool::add(field);
 
             if (field->isStatic()) {
-                // static final fields should be initialized with constant values in constant pool.
-                // static non-final fields should be initialized with specified values.
-                if (!field->isFinal()) {
-                    helperInitField(_staticFieldValues, static_field_index, field);
-
-                } else if (!helperInitConstantField(_staticFieldValues, pool, field)) {
-                    // TODO: throw VerifyError: static final fields must be initialized.
-                    assert(false);
-                }
-
-                D("%s: New static field: #%-d %s",
-                  strings::toStdString(getName()).c_str(),
-                  static_field_index,
-                  strings::toStdString(Field::makeIdentity(this, field)).c_str());
-
-                _staticFields.insert(make_pair(Field::makeIdentity(this, field),
-                                                new FieldID(static_field_index++, field)));
+                static_fields.push_back(field);
             } else {
-                D("%s: New instance field: #%-d %s",
-                  strings::toStdString(getName()).c_str(),
-                  instance_field_index,
-                  strings::toStdString(Field::makeIdentity(this, field)).c_str());
+                instance_fields.push_back(field);
+            }
+        }
 
-                _instanceFields.insert(make_pair(Field::makeIdentity(this, field),
-                                                  new FieldID(instance_field_index++, field)));
+        // Static fields are stored unboxed in a block owned by this class.
+        std::vector<Field *> constant_fields = static_fields;
+        this->_staticFieldBlockSize = packFields(static_fields, 0, [this](Field *field, int offset) {
+            D("%s: New static field: +%-d %s",
+              strings::toStdString(getName()).c_str(),
+              offset,
+              strings::toStdString(Field::makeIdentity(this, field)).c_str());
+
+            _staticFields.insert(make_pair(field->getKey(), new FieldID(offset, field)));
+            if (isReferenceField(field)) {
+                _staticReferenceOffsets.push_back(offset);
             }
+        });
+        this->_staticFieldBlock = new u1[_staticFieldBlockSize]();
+
+        // static fields start zeroed, except those with a ConstantValue attribute
+        for (Field *field : constant_fields) {
+            FieldID *id = _staticFields[field->getKey()];
+            helperInitConstantField(_staticFieldBlock + id->_offset, pool, field);
         }
-        this->_staticFieldValues.shrink_to_fit();
-        this->_nStaticFields = static_field_index;
-        this->_nInstanceFields = instance_field_index;
+
+        auto placeInstanceField = [this](Field *field, int offset) {
+            D("%s: New instance field: +%-d %s",
+              strings::toStdString(getName()).c_str(),
+              offset,
+              strings::toStdString(Field::makeIdentity(this, field)).c_str());
+
+            _instanceFields.insert(make_pair(field->getKey(), new FieldID(offset, field)));
+            if (isReferenceField(field)) {
+                _referenceFieldOffsets.push_back(offset);
+            }
+        };
+
+        // With a field profile, the most accessed fields go first,
+        // into what is left of the header's cache line
+        // (or a line of their own once superclass fields fill it).
+        // Only offsets change: the declared order seen by reflection stays.
+        std::vector<Field *> hot_fields = selectHotFields(instance_fields, instance_size);
+        instance_size = packFields(hot_fields, instance_size, placeInstanceField);
+        this->_instanceSize = packFields(instance_fields, instance_size, placeInstanceField);
+
+        this->_staticReferenceOffsets.shrink_to_fit();
+        this->_referenceFieldOffsets.shrink_to_fit();
+        this->_nStaticFields = (int) _staticFields.size();
+        this->_nInstanceFields = (int) _instanceFields.size();
     }
 
     void InstanceKlass::linkConstantPool(cp_info **pool) {
@@ -233,16 +346,30 @@ namespace kivm {
         }
     }
 
-#define KEY_MAKER(CLASS, NAME, DESC) \
-        ((CLASS) + L" " + (NAME) + L" " + (DESC))
-
-#define ND_KEY_MAKER(NAME, DESC) \
-        ((NAME) + L" " + (DESC))
-
 #define RETURN_IF(ITER, COLLECTION, KEY, SUCCESS, FAIL) \
     const auto &ITER = (COLLECTION).find(KEY); \
     return (ITER) != (COLLECTION).end() ? (SUCCESS) : (FAIL);
 
+    /**
+     * Strings which were never interned name nothing,
+     * so looking them up does not add symbols.
+     */
+    static bool probeKey(const String &className, const String &name, const String &descriptor,
+                         FieldKey *key) {
+        SymbolTable *symbolTable = SymbolTable::get();
+        key->className = symbolTable->probe(className);
+        key->name = symbolTable->probe(name);
+        key->descriptor = symbolTable->probe(descriptor);
+        return key->className != nullptr && key->name != nullptr && key->descriptor != nullptr;
+    }
+
+    static bool probeKey(const String &name, const String &descriptor, SymbolPair *key) {
+        SymbolTable *symbolTable = SymbolTable::get();
+        key->first = symbolTable->probe(name);
+        key->second = symbolTable->probe(descriptor);
+        return key->first != nullptr && key->second != nullptr;
+    }
+
     int InstanceKlass::getStaticFieldOffset(const String &className,
                                             const String &name,
                                             const String &descriptor) const {
@@ -255,53 +382,74 @@ namespace kivm {
         return this->getInstanceFieldInfo(className, name, descriptor)->_offset;
     }
 
-    FieldID* InstanceKlass::getThisClassField(const String &name, const String &descriptor) const {
-        auto id = getInstanceFieldInfo(getName(), name, descriptor);
-        return id->_field != nullptr
-               ? id
-               : getStaticFieldInfo(getName(), name, descriptor);
+    FieldID *InstanceKlass::getThisClassField(const String &name, const String &descriptor) const {
+        SymbolPair key;
+        return probeKey(name, descriptor, &key)
+               ? getThisClassField(key.first, key.second)
+               : nullptr;
     }
 
-    FieldID* InstanceKlass::getStaticFieldInfo(const String &className,
-                                              const String &name,
-                                              const String &descriptor) const {
-        RETURN_IF(iter, this->_staticFields,
-                  KEY_MAKER(className, name, descriptor),
-                  iter->second,
-                  nullptr);
+    FieldID *InstanceKlass::getThisClassField(Symbol *name, Symbol *descriptor) const {
+        FieldKey key{getNameSymbol(), name, descriptor};
+        FieldID *id = getInstanceFieldInfo(key);
+        return id != nullptr ? id : getStaticFieldInfo(key);
     }
 
-    FieldID* InstanceKlass::getInstanceFieldInfo(const String &className,
-                                                const String &name,
-                                                const String &descriptor) const {
-        RETURN_IF(iter, this->_instanceFields,
-                  KEY_MAKER(className, name, descriptor),
-                  iter->second,
-                  nullptr);
+    FieldID *InstanceKlass::getStaticFieldInfo(const String &className,
+                                               const String &name,
+                                               const String &descriptor) const {
+        FieldKey key{};
+        return probeKey(className, name, descriptor, &key) ? getStaticFieldInfo(key) : nullptr;
+    }
+
+    FieldID *InstanceKlass::getStaticFieldInfo(const FieldKey &key) const {
+        RETURN_IF(iter, this->_staticFields, key, iter->second, nullptr);
+    }
+
+    FieldID *InstanceKlass::getInstanceFieldInfo(const String &className,
+                                                 const String &name,
+                                                 const String &descriptor) const {
+        FieldKey key{};
+        return probeKey(className, name, descriptor, &key) ? getInstanceFieldInfo(key) : nullptr;
+    }
+
+    FieldID *InstanceKlass::getInstanceFieldInfo(const FieldKey &key) const {
+        RETURN_IF(iter, this->_instanceFields, key, iter->second, nullptr);
     }
 
     Method *InstanceKlass::getThisClassMethod(const String &name, const String &descriptor) const {
+        SymbolPair key;
+        return probeKey(name, descriptor, &key) ? getThisClassMethod(key.first, key.second) : nullptr;
+    }
+
+    Method *InstanceKlass::getThisClassMethod(Symbol *name, Symbol *descriptor) const {
         RETURN_IF(iter, this->_allMethods,
-                  ND_KEY_MAKER(name, descriptor),
+                  std::make_pair(name, descriptor),
                   iter->second, nullptr);
     }
 
     Method *InstanceKlass::getVirtualMethod(const String &name, const String &descriptor) const {
-        RETURN_IF(iter, this->_vtable,
-                  ND_KEY_MAKER(name, descriptor),
-                  iter->second, nullptr);
+        SymbolPair key;
+        if (!probeKey(name, descriptor, &key)) {
+            return nullptr;
+        }
+        RETURN_IF(iter, this->_vtable, key, iter->second, nullptr);
     }
 
     Method *InstanceKlass::getNonVirtualMethod(const String &name, const String &descriptor) const {
-        RETURN_IF(iter, this->_pftable,
-                  ND_KEY_MAKER(name, descriptor),
-                  iter->second, nullptr);
+        SymbolPair key;
+        if (!probeKey(name, descriptor, &key)) {
+            return nullptr;
+        }
+        RETURN_IF(iter, this->_pftable, key, iter->second, nullptr);
     }
 
     Method *InstanceKlass::getStaticMethod(const String &name, const String &descriptor) const {
-        RETURN_IF(iter, this->_stable,
-                  ND_KEY_MAKER(name, descriptor),
-                  iter->second, nullptr);
+        SymbolPair key;
+        if (!probeKey(name, descriptor, &key)) {
+            return nullptr;
+        }
+        RETURN_IF(iter, this->_stable, key, iter->second, nullptr);
     }
 
     InstanceKlass *InstanceKlass::getInterface(const String &interfaceClassName) const {
@@ -329,7 +477,8 @@ namespace kivm {
           strings::toStdString(fieldID->_field->getName()).c_str(),
           strings::toStdString(fieldID->_field->getDescriptor()).c_str(),
           value);
-        this->_staticFieldValues[fieldID->_offset] = value;
+        helperStoreValue(fieldID->_field->getValueType(),
+                         _staticFieldBlock + fieldID->_offset, value);
     }
 
     bool InstanceKlass::getStaticFieldValue(const String &className,
@@ -345,7 +494,8 @@ namespace kivm {
             return false;
         }
 
-        *result = this->_staticFieldValues[fieldID->_offset];
+        *result = helperLoadValue(fieldID->_field->getValueType(),
+                                  _staticFieldBlock + fieldID->_offset);
         return true;
     }
 
@@ -369,7 +519,8 @@ namespace kivm {
           strings::toStdString(fieldID->_field->getName()).c_str(),
           strings::toStdString(fieldID->_field->getDescriptor()).c_str(),
           value);
-        receiver->_instanceFieldValues[fieldID->_offset] = value;
+        helperStoreValue(fieldID->_field->getValueType(),
+                         (u1 *) receiver + fieldID->_offset, value);
     }
 
     bool InstanceKlass::getInstanceFieldValue(instanceOop receiver, const String &className,
@@ -386,11 +537,13 @@ namespace kivm {
             return false;
         }
 
-        *result = receiver->_instanceFieldValues[fieldID->_offset];
+        // primitive fields are stored unboxed, box them for callers
+        *result = helperLoadValue(fieldID->_field->getValueType(),
+                                  (const u1 *) receiver + fieldID->_offset);
         return true;
     }
 
-    instanceOop InstanceKlass::newInstance() {
-        return new instanceOopDesc(this);
+    instanceOop InstanceKlass::newInstance(AllocationSite *site) {
+        return new(this, site) instanceOopDesc(this);
     }
 }
@@ -2,17 +2,22 @@
 // Created by kiva on 2018/2/28.
 //
 
-#include <kivm/oop/reflectionSupport.h>
 #include <kivm/oop/instanceOop.h>
-#include <kivm/oop/helper.h>
+#include <kivm/memory/oopClosure.h>
+#include <algorithm>
 
 namespace kivm {
+    void *instanceOopDesc::operator new(size_t size, InstanceKlass *klass, AllocationSite *site) noexcept {
+        return allocate(std::max(size, (size_t) klass->getInstanceSize()), site);
+    }
 
     instanceOopDesc::instanceOopDesc(InstanceKlass *klass)
         : oopDesc(klass, oopType::INSTANCE_OOP) {
-        this->_instanceFieldValues.resize(klass->_instanceFields.size());
-        for (auto &e : klass->_instanceFields) {
-            helperInitField(this->_instanceFieldValues, e.second->_offset, e.second->_field);
+    }
+
+    void instanceOopDesc::iterateOops(OopClosure *closure) {
+        for (int offset : getInstanceClass()->getReferenceFieldOffsets()) {
+            closure->doHeapOop((u1 *) this + offset);
         }
     }
 }
@@ -3,9 +3,25 @@
 //
 
 #include <kivm/oop/klass.h>
+#include <kivm/memory/oopClosure.h>
+#include <kivm/memory/compressedOops.h>
 
 namespace kivm {
-    Klass::Klass() {
+    void *Klass::operator new(size_t size) {
+        return CompressedOops::allocateKlass(size);
+    }
+
+    void Klass::operator delete(void *ptr) {
+        CompressedOops::deallocateKlass(ptr);
+    }
+
+    Klass::Klass()
+        : _accessFlag(0), _nameSymbol(nullptr), _type(ClassType::INSTANCE_CLASS),
+          _javaMirror(nullptr), _superClass(nullptr) {
         setClassState(ClassState::ALLOCATED);
     }
+
+    void Klass::iterateOops(OopClosure *closure) {
+        closure->doOop((oop *) &_javaMirror);
+    }
 }
@@ -7,10 +7,8 @@
 
 namespace kivm {
     mirrorOop mirrorKlass::newMirror(Klass *target, mirrorOop loader) {
-        if (target != nullptr && target->getName() == L"java/lang/Exception") {
-            BootstrapClassLoader::get()->loadClass(L"java/lang/Class");
-        }
-        auto mirror = new mirrorOopDesc(target);
+        auto classKlass = (InstanceKlass *) BootstrapClassLoader::get()->loadClass(L"java/lang/Class");
+        auto mirror = new(classKlass, nullptr) mirrorOopDesc(target);
         if (loader != nullptr) {
             mirror->setFieldValue(L"java/lang/Class",
                                   L"classLoader",
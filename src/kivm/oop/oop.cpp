@@ -3,18 +3,210 @@
 //
 
 #include <kivm/oop/oop.h>
+#include <kivm/runtime/monitorTable.h>
 
 namespace kivm {
-    markOopDesc::markOopDesc(oopType type) {
-        this->_type = type;
+    ObjectMonitor *markOopDesc::inflate() {
+        MonitorTable *table = MonitorTable::get();
+        u8 value = _value.load();
+        for (;;) {
+            u4 owner = 0;
+            u4 recursions = 0;
+            switch (value & LOCK_MASK) {
+                case INFLATED:
+                    return table->getMonitor((u4) ((value >> MONITOR_SHIFT) & MONITOR_MASK));
+                case THIN_LOCKED:
+                    owner = getOwner(value);
+                    recursions = getRecursions(value);
+                    break;
+                default:
+                    break;
+            }
+
+            // The monitor takes over the thin lock, including its owner.
+            u4 index = table->allocate();
+            ObjectMonitor *monitor = table->getMonitor(index);
+            monitor->reset(owner, recursions);
+            u8 inflated = (value & ~LOCK_FIELDS) | ((u8) index << MONITOR_SHIFT) | INFLATED;
+            if (_value.compare_exchange_weak(value, inflated)) {
+                return monitor;
+            }
+
+            // The lock or the header changed, try again.
+            table->release(index);
+        }
+    }
+
+    void markOopDesc::monitorEnterSlow() {
+        u8 self = currentLockOwner();
+        u8 value = _value.load();
+        for (;;) {
+            u8 lock = value & LOCK_MASK;
+            if (lock == UNLOCKED && self <= OWNER_MASK) {
+                if (_value.compare_exchange_weak(value, value | THIN_LOCKED | (self << OWNER_SHIFT))) {
+                    return;
+                }
+                continue;
+            }
+
+            if (lock == THIN_LOCKED && getOwner(value) == self
+                && getRecursions(value) < RECURSION_MASK) {
+                if (_value.compare_exchange_weak(value, value + ((u8) 1 << RECURSION_SHIFT))) {
+                    return;
+                }
+                continue;
+            }
+
+            // contended, nested too deep, or already inflated
+            inflate()->enter();
+            return;
+        }
+    }
+
+    void markOopDesc::monitorExitSlow() {
+        u4 self = currentLockOwner();
+        u8 value = _value.load();
+        for (;;) {
+            u8 lock = value & LOCK_MASK;
+            if (lock == INFLATED) {
+                inflate()->leave();
+                return;
+            }
+
+            if (lock != THIN_LOCKED || getOwner(value) != self) {
+                // TODO: throw java.lang.IllegalMonitorStateException
+                PANIC("java.lang.IllegalMonitorStateException");
+            }
+
+            u8 updated = getRecursions(value) > 0
+                         ? value - ((u8) 1 << RECURSION_SHIFT)
+                         : value & ~LOCK_FIELDS;
+            if (_value.compare_exchange_weak(value, updated)) {
+                return;
+            }
+        }
+    }
+
+    bool markOopDesc::isLockedByCurrentThread() {
+        u8 value = _value.load();
+        switch (value & LOCK_MASK) {
+            case THIN_LOCKED:
+                return getOwner(value) == currentLockOwner();
+            case INFLATED:
+                return inflate()->isOwnedBy(currentLockOwner());
+            default:
+                return false;
+        }
+    }
+
+    void markOopDesc::wait(long macro_sec) {
+        if (!isLockedByCurrentThread()) {
+            // TODO: throw java.lang.IllegalMonitorStateException
+            PANIC("java.lang.IllegalMonitorStateException");
+        }
+        inflate()->wait(macro_sec);
+    }
+
+    void markOopDesc::notify() {
+        if (!isLockedByCurrentThread()) {
+            // TODO: throw java.lang.IllegalMonitorStateException
+            PANIC("java.lang.IllegalMonitorStateException");
+        }
+        // A thin lock has no waiters.
+        if (isInflated()) {
+            inflate()->notify();
+        }
+    }
+
+    void markOopDesc::notifyAll() {
+        if (!isLockedByCurrentThread()) {
+            // TODO: throw java.lang.IllegalMonitorStateException
+            PANIC("java.lang.IllegalMonitorStateException");
+        }
+        if (isInflated()) {
+            inflate()->notifyAll();
+        }
+    }
+
+    void markOopDesc::forceUnlockWhenExceptionOccurred() {
+        u4 self = currentLockOwner();
+        u8 value = _value.load();
+        for (;;) {
+            u8 lock = value & LOCK_MASK;
+            if (lock == INFLATED) {
+                inflate()->forceLeave();
+                return;
+            }
+            if (lock != THIN_LOCKED || getOwner(value) != self) {
+                return;
+            }
+            if (_value.compare_exchange_weak(value, value & ~LOCK_FIELDS)) {
+                return;
+            }
+        }
+    }
+
+    void markOopDesc::deflate() {
+        u8 value = _value.load();
+        if ((value & LOCK_MASK) == INFLATED) {
+            MonitorTable::get()->release((u4) ((value >> MONITOR_SHIFT) & MONITOR_MASK));
+        }
+        _value.store(value & ~LOCK_FIELDS);
+    }
+
+    /**
+     * Marsaglia's xor-shift generator, one per thread,
+     * so hashing needs no shared state after the seed.
+     */
+    static u4 nextIdentityHash() {
+        static std::atomic<u4> seeds(0x9e3779b9);
+        thread_local u4 x = seeds.fetch_add(0x9e3779b9) ^ (u4) (uintptr_t) &x;
+        thread_local u4 y = 842502087;
+        thread_local u4 z = 0x8767;
+        thread_local u4 w = 273326509;
+
+        u4 t = x ^ (x << 11);
+        x = y;
+        y = z;
+        z = w;
+        w = (w ^ (w >> 19)) ^ (t ^ (t >> 8));
+        return w;
+    }
+
+    u4 markOopDesc::installIdentityHash() {
+        u4 hash = 0;
+        while (hash == 0) {
+            hash = (u4) (nextIdentityHash() & HASH_MASK);
+        }
+
+        u8 value = _value.load();
+        for (;;) {
+            u4 installed = (u4) ((value >> HASH_SHIFT) & HASH_MASK);
+            if (installed != 0) {
+                // another thread won
+                return installed;
+            }
+            if (_value.compare_exchange_weak(value, value | ((u8) hash << HASH_SHIFT))) {
+                return hash;
+            }
+        }
     }
 
-    oopDesc::oopDesc(Klass *klass, oopType type) {
-        this->_klass = klass;
-        this->_mark = new markOopDesc(type);
+    void markOopDesc::setAge(int age) {
+        u8 value = _value.load();
+        u8 updated;
+        do {
+            updated = (value & ~(AGE_MASK << AGE_SHIFT)) | (((u8) age & AGE_MASK) << AGE_SHIFT);
+        } while (!_value.compare_exchange_weak(value, updated));
     }
 
-    oopDesc::~oopDesc() {
-        delete this->_mark;
+    oopDesc::oopDesc(Klass *klass, oopType type)
+        : _mark(type) {
+        // a narrow class pointer must not clobber the field behind it
+        if (CompressedOops::useCompressedClassPointers()) {
+            _metadata._narrowKlass = CompressedOops::encodeKlass(klass);
+        } else {
+            _metadata._klass = klass;
+        }
     }
 }
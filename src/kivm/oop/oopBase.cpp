@@ -3,39 +3,27 @@
 //
 
 #include <kivm/oop/oop.h>
-#include <cstring>
-#include <cstdlib>
+#include <kivm/memory/heap.h>
 
 namespace kivm {
-    void *oopBase::allocate(size_t size, bool addToPool) {
+    void *oopBase::allocate(size_t size, AllocationSite *site) {
         if (size == 0) {
             return nullptr;
         }
 
-        void *ptr = malloc(size);
-        memset(ptr, '\0', size);
-
-        // add it to the oopPoll
-        if (addToPool) {
-            LockGuard lg(getOopMemoryLock());
-            oopPool::getOopHandlerPool().push_back((oop) ptr);
-        }
-
-        return ptr;
+        return Heap::get()->allocate(size, site);
     }
 
     void oopBase::deallocate(void *ptr) {
-        if (ptr != nullptr) {
-            free(ptr);
-        }
+        // Memory is owned by the heap.
     }
 
-    void *oopBase::operator new(size_t size, bool addToPool) throw() {
-        return allocate(size, addToPool);
+    void *oopBase::operator new(size_t size) throw() {
+        return allocate(size);
     }
 
-    void *oopBase::operator new[](size_t size, bool addToPool) throw() {
-        return allocate(size, addToPool);
+    void *oopBase::operator new[](size_t size) throw() {
+        return allocate(size);
     }
 
     void oopBase::operator delete(void *ptr) {
@@ -47,9 +35,6 @@ namespace kivm {
     }
 
     void oopBase::cleanup() {
-        LockGuard lg(getOopMemoryLock());
-        for (auto iter : oopPool::getOopHandlerPool()) {
-            delete iter;
-        }
+        Heap::get()->destroyAll();
     }
 }
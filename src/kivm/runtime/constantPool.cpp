@@ -5,12 +5,19 @@
 #include <kivm/runtime/constantPool.h>
 #include <kivm/oop/instanceKlass.h>
 #include <kivm/oop/arrayOop.h>
+#include <kivm/memory/oopClosure.h>
 
 namespace kivm {
     RuntimeConstantPool::RuntimeConstantPool(InstanceKlass *instanceKlass)
         : _classLoader(instanceKlass->getClassLoader()) {
     }
 
+    void RuntimeConstantPool::iterateOops(OopClosure *closure) {
+        _stringPool.forEach([closure](pools::StringPoolEntry &entry) {
+            closure->doOop((oop *) &entry);
+        });
+    }
+
     /********************** pools ***********************/
     pools::ClassPoolEntey pools::ClassCreator::operator()(RuntimeConstantPool *rt, cp_info **pool, int index) {
         auto classInfo = (CONSTANT_Class_info *) pool[index];
@@ -61,11 +68,16 @@ namespace kivm {
         return nullptr;
     }
 
+    pools::SymbolPoolEntry pools::SymbolCreator::operator()(RuntimeConstantPool *rt, cp_info **pool, int index) {
+        auto utf8Info = (CONSTANT_Utf8_info *) pool[index];
+        return SymbolTable::get()->lookup(utf8Info->bytes, utf8Info->length);
+    }
+
     pools::NameAndTypePoolEntry
     pools::NameAndTypeCreator::operator()(RuntimeConstantPool *rt, cp_info **pool, int index) {
         auto nameAndType = (CONSTANT_NameAndType_info *) pool[index];
-        return std::make_pair(rt->getUtf8(nameAndType->name_index),
-                              rt->getUtf8(nameAndType->descriptor_index));
+        return std::make_pair(rt->getSymbol(nameAndType->name_index),
+                              rt->getSymbol(nameAndType->descriptor_index));
     }
 
     /********************** pools ***********************/
@@ -0,0 +1,79 @@
+//
+// Created by kiva on 2018/4/25.
+//
+
+#include <kivm/runtime/fieldProfile.h>
+#include <kivm/runtime/runtimeConfig.h>
+#include <kivm/oop/instanceKlass.h>
+#include <kivm/field.h>
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <vector>
+
+namespace kivm {
+    FieldProfile *FieldProfile::get() {
+        static FieldProfile profile;
+        return &profile;
+    }
+
+    FieldProfile::FieldProfile() {
+        const RuntimeConfig &config = RuntimeConfig::get();
+        _recording = !config.fieldProfileOutput.empty();
+        if (!config.fieldProfileInput.empty() && !load(config.fieldProfileInput)) {
+            D("Cannot read field profile %s, using default layout",
+              config.fieldProfileInput.c_str());
+        }
+    }
+
+    u8 FieldProfile::getCount(InstanceKlass *klass, const Field *field) const {
+        auto iter = _counts.find(Field::makeIdentity(klass, field));
+        return iter != _counts.end() ? iter->second : 0;
+    }
+
+    bool FieldProfile::load(const std::string &path) {
+        std::ifstream in(path);
+        if (!in) {
+            return false;
+        }
+
+        std::string line;
+        while (std::getline(in, line)) {
+            std::istringstream fields(line);
+            u8 count = 0;
+            std::string className;
+            std::string name;
+            std::string descriptor;
+            if (!(fields >> count >> className >> name >> descriptor)) {
+                continue;
+            }
+
+            std::string identity = className + " " + name + " " + descriptor;
+            _counts[strings::fromStdString(identity)] += count;
+        }
+        return true;
+    }
+
+    bool FieldProfile::save(const std::string &path) const {
+        std::vector<Field *> accessed;
+        for (Field *field : FieldPool::getEntries()) {
+            if (field->getAccessCount() != 0) {
+                accessed.push_back(field);
+            }
+        }
+        std::stable_sort(accessed.begin(), accessed.end(),
+                         [](Field *lhs, Field *rhs) {
+                             return lhs->getAccessCount() > rhs->getAccessCount();
+                         });
+
+        std::ofstream out(path);
+        if (!out) {
+            return false;
+        }
+        for (Field *field : accessed) {
+            out << field->getAccessCount() << ' '
+                << strings::toStdString(Field::makeIdentity(field->getClass(), field)) << '\n';
+        }
+        return (bool) out;
+    }
+}
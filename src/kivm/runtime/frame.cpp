@@ -2,12 +2,58 @@
 // Created by kiva on 2018/3/23.
 //
 #include <kivm/runtime/frame.h>
+#include <kivm/memory/oopClosure.h>
+#include <kivm/bytecode/oopMap.h>
+#include <kivm/method.h>
+#include <algorithm>
 
 namespace kivm {
     Frame::Frame(int maxLocals, int maxStacks)
             : _locals(maxLocals), _stack(maxStacks) {
     }
 
+    void Frame::iterateRoots(RootClosure *closure, u4 pc, bool atInstructionStart) {
+        const OopMap *map = nullptr;
+        if (_method != nullptr && !_nativeFrame) {
+            const MethodOopMaps *maps = OopMapCache::get()->lookup(_method);
+            // Maps of a method being entered may not be prepared yet.
+            if (maps != nullptr && maps->isPrecise()) {
+                map = atInstructionStart ? maps->find(pc) : maps->findEndingAt(pc);
+            }
+        }
+
+        if (map != nullptr) {
+            for (int i = 0; i < _locals.getSize(); ++i) {
+                if (map->isLocalReference(i)) {
+                    closure->doOop((oop *) _locals.getReferenceAddress(i));
+                }
+            }
+
+            // The map describes the stack before the instruction at pc.
+            // When called from the middle of an instruction, the operands
+            // may have been popped, and results pushed by the VM are untyped.
+            int sp = _stack.getSp();
+            int depth = std::min(sp, map->getStackDepth());
+            for (int i = 0; i < depth; ++i) {
+                if (map->isStackReference(i)) {
+                    closure->doOop((oop *) _stack.getReferenceAddress(i));
+                }
+            }
+            for (int i = depth; i < sp; ++i) {
+                closure->doConservativeRoot(_stack.getReference(i));
+            }
+            return;
+        }
+
+        for (int i = 0; i < _locals.getSize(); ++i) {
+            closure->doConservativeRoot(_locals.getReference(i));
+        }
+
+        for (int i = 0; i < _stack.getSp(); ++i) {
+            closure->doConservativeRoot(_stack.getReference(i));
+        }
+    }
+
     FrameList::FrameList(int maxFrames)
             : _max_frames(maxFrames), _size(0), _current(nullptr) {
     }
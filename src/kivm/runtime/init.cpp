@@ -2,6 +2,12 @@
 // Created by kiva on 2018/3/28.
 //
 #include <kivm/runtime/thread.h>
+#include <kivm/runtime/fieldProfile.h>
+#include <kivm/memory/allocationSite.h>
+#include <kivm/classfile/classPath.h>
+#include <kivm/classfile/classPrefetcher.h>
+#include <kivm/runtime/runtimeConfig.h>
+#include <kivm/runtime/safepoint.h>
 #include <kivm/bytecode/execution.h>
 #include <kivm/oop/primitiveOop.h>
 #include <kivm/native/class_names.h>
@@ -52,6 +58,27 @@ namespace kivm {
 
             sched_yield();
         }
+
+        FieldProfile *profile = FieldProfile::get();
+        const std::string &profileOutput = RuntimeConfig::get().fieldProfileOutput;
+        if (profile->isRecording() && !profile->save(profileOutput)) {
+            D("Cannot write field profile %s", profileOutput.c_str());
+        }
+
+        const std::string &pretenureOutput = RuntimeConfig::get().pretenureProfileOutput;
+        if (!pretenureOutput.empty() && !AllocationSiteTable::get()->save(pretenureOutput)) {
+            D("Cannot write pretenuring profile %s", pretenureOutput.c_str());
+        }
+
+        if (RuntimeConfig::get().printClassPathStatistics) {
+            ClassPath::get()->printStatistics();
+        }
+        if (ClassPrefetcher::get() != nullptr) {
+            ClassPrefetcher::get()->printStatistics();
+        }
+        if (RuntimeConfig::get().printSafepointStatistics) {
+            Safepoint::printStatistics();
+        }
     }
 
     bool JavaMainThread::shouldRecordInThreadTable() {
@@ -81,7 +108,6 @@ namespace kivm {
         // JavaMainThread is created with java_thread_object == nullptr
         // Now we have created a thread for it.
         thread->setJavaThreadObject(init_thread);
-        Threads::add(thread);
 
         // Create and construct the system thread group.
         instanceOop init_tg = tg_class->newInstance();
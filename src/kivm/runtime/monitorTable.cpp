@@ -0,0 +1,52 @@
+//
+// Created by kiva on 2018/4/23.
+//
+
+#include <kivm/runtime/monitorTable.h>
+
+namespace kivm {
+    MonitorTable *MonitorTable::get() {
+        static MonitorTable table(MAX_MONITORS);
+        return &table;
+    }
+
+    MonitorTable::MonitorTable(u4 maxMonitors)
+        : _maxChunks(maxMonitors / CHUNK_SIZE),
+          // index 0 means no monitor
+          _nextIndex(1) {
+        _chunks = new std::atomic<ObjectMonitor *>[_maxChunks];
+        for (u4 i = 0; i < _maxChunks; ++i) {
+            _chunks[i].store(nullptr, std::memory_order_relaxed);
+        }
+    }
+
+    u4 MonitorTable::allocate() {
+        LockGuard lockGuard(_lock);
+        if (!_freeList.empty()) {
+            u4 index = _freeList.back();
+            _freeList.pop_back();
+            return index;
+        }
+
+        u4 index = _nextIndex;
+        u4 chunk = index >> CHUNK_SHIFT;
+        if (chunk >= _maxChunks) {
+            PANIC("Too many inflated monitors");
+        }
+        if (_chunks[chunk].load(std::memory_order_relaxed) == nullptr) {
+            _chunks[chunk].store(new ObjectMonitor[CHUNK_SIZE], std::memory_order_release);
+        }
+        ++_nextIndex;
+        return index;
+    }
+
+    void MonitorTable::release(u4 index) {
+        LockGuard lockGuard(_lock);
+        _freeList.push_back(index);
+    }
+
+    u4 MonitorTable::getInUseCount() {
+        LockGuard lockGuard(_lock);
+        return _nextIndex - 1 - (u4) _freeList.size();
+    }
+}
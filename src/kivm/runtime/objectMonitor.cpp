@@ -0,0 +1,214 @@
+//
+// Created by kiva on 2018/4/23.
+//
+
+#include <kivm/runtime/objectMonitor.h>
+#include <kivm/runtime/safepoint.h>
+#include <shared/lock.h>
+#include <chrono>
+#include <vector>
+
+namespace kivm {
+    class LockOwnerIds {
+    private:
+        Lock _lock;
+        u4 _next = 1;
+        std::vector<u4> _free;
+
+    public:
+        static LockOwnerIds *get() {
+            static LockOwnerIds ids;
+            return &ids;
+        }
+
+        u4 acquire() {
+            LockGuard lockGuard(_lock);
+            if (!_free.empty()) {
+                u4 id = _free.back();
+                _free.pop_back();
+                return id;
+            }
+            return _next++;
+        }
+
+        void release(u4 id) {
+            LockGuard lockGuard(_lock);
+            _free.push_back(id);
+        }
+    };
+
+    struct LockOwner {
+        u4 _id = 0;
+
+        ~LockOwner() {
+            if (_id != 0) {
+                LockOwnerIds::get()->release(_id);
+            }
+        }
+    };
+
+    static thread_local LockOwner currentOwner;
+
+    u4 currentLockOwner() {
+        if (currentOwner._id == 0) {
+            currentOwner._id = LockOwnerIds::get()->acquire();
+        }
+        return currentOwner._id;
+    }
+
+    /**
+     * Keep current VM thread in a safe state while it blocks.
+     * The owner may be stopped at a safepoint, so waiting for it
+     * in a running state would keep the world from stopping.
+     */
+    class BlockingScope {
+    private:
+        Thread *_thread;
+        ExecutionState _previous;
+
+    public:
+        BlockingScope()
+            : _thread(Thread::current()),
+              _previous(ExecutionState::NEW) {
+            if (_thread != nullptr) {
+                _previous = _thread->getExecutionState();
+                if (!Thread::isSafeState(_previous)) {
+                    Safepoint::transition(_thread, ExecutionState::BLOCKED);
+                }
+            }
+        }
+
+        ~BlockingScope() {
+            if (_thread != nullptr && _thread->getExecutionState() != _previous) {
+                Safepoint::transition(_thread, _previous);
+            }
+        }
+
+        BlockingScope(const BlockingScope &) = delete;
+    };
+
+    ObjectMonitor::ObjectMonitor()
+        : _owner(0), _recursions(0), _contenders(0), _waiters(0) {
+    }
+
+    void ObjectMonitor::reset(u4 owner, u4 recursions) {
+        std::lock_guard<std::mutex> guard(_mutex);
+        _owner = owner;
+        _recursions = recursions;
+        _contenders = 0;
+        _waiters = 0;
+    }
+
+    void ObjectMonitor::acquire(std::unique_lock<std::mutex> &guard, u4 self) {
+        ++_contenders;
+        _entryQueue.wait(guard, [this] { return _owner == 0; });
+        --_contenders;
+        _owner = self;
+        _recursions = 0;
+    }
+
+    void ObjectMonitor::enter() {
+        u4 self = currentLockOwner();
+        {
+            std::lock_guard<std::mutex> guard(_mutex);
+            if (_owner == self) {
+                ++_recursions;
+                return;
+            }
+            if (_owner == 0) {
+                _owner = self;
+                _recursions = 0;
+                return;
+            }
+        }
+
+        // State changes happen outside of _mutex: leaving a safe state
+        // may wait for a safepoint, and must not keep others from entering.
+        BlockingScope blocking;
+        std::unique_lock<std::mutex> guard(_mutex);
+        acquire(guard, self);
+    }
+
+    void ObjectMonitor::leave() {
+        std::lock_guard<std::mutex> guard(_mutex);
+        if (_owner != currentLockOwner()) {
+            // TODO: throw java.lang.IllegalMonitorStateException
+            PANIC("java.lang.IllegalMonitorStateException");
+        }
+
+        if (_recursions > 0) {
+            --_recursions;
+            return;
+        }
+        _owner = 0;
+        if (_contenders > 0) {
+            _entryQueue.notify_one();
+        }
+    }
+
+    void ObjectMonitor::forceLeave() {
+        std::lock_guard<std::mutex> guard(_mutex);
+        if (_owner == currentLockOwner()) {
+            _owner = 0;
+            _recursions = 0;
+            if (_contenders > 0) {
+                _entryQueue.notify_one();
+            }
+        }
+    }
+
+    void ObjectMonitor::wait(long millis) {
+        u4 self = currentLockOwner();
+        BlockingScope blocking;
+        {
+            std::unique_lock<std::mutex> guard(_mutex);
+            if (_owner != self) {
+                // TODO: throw java.lang.IllegalMonitorStateException
+                PANIC("java.lang.IllegalMonitorStateException");
+            }
+
+            u4 recursions = _recursions;
+            _owner = 0;
+            _recursions = 0;
+            if (_contenders > 0) {
+                _entryQueue.notify_one();
+            }
+
+            // Spurious wakeups are allowed by Object.wait()
+            ++_waiters;
+            if (millis > 0) {
+                _waitSet.wait_for(guard, std::chrono::milliseconds(millis));
+            } else {
+                _waitSet.wait(guard);
+            }
+            --_waiters;
+
+            if (_owner == 0) {
+                _owner = self;
+                _recursions = 0;
+            } else {
+                acquire(guard, self);
+            }
+            _recursions = recursions;
+        }
+    }
+
+    void ObjectMonitor::notify() {
+        std::lock_guard<std::mutex> guard(_mutex);
+        if (_waiters > 0) {
+            _waitSet.notify_one();
+        }
+    }
+
+    void ObjectMonitor::notifyAll() {
+        std::lock_guard<std::mutex> guard(_mutex);
+        if (_waiters > 0) {
+            _waitSet.notify_all();
+        }
+    }
+
+    bool ObjectMonitor::isOwnedBy(u4 owner) {
+        std::lock_guard<std::mutex> guard(_mutex);
+        return _owner == owner;
+    }
+}
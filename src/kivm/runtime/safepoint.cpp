@@ -0,0 +1,175 @@
+//
+// Created by kiva on 2018/4/22.
+//
+
+#include <kivm/runtime/safepoint.h>
+#include <chrono>
+#include <cstdio>
+#include <condition_variable>
+#include <mutex>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace kivm {
+    using Clock = std::chrono::steady_clock;
+
+    std::atomic<bool> Safepoint::_pollRequested(false);
+
+    // protects thread state changes observed by the requester
+    static std::mutex &stateLock() {
+        static std::mutex lock;
+        return lock;
+    }
+
+    static std::condition_variable &stateChanged() {
+        static std::condition_variable cond;
+        return cond;
+    }
+
+    // held by the requester from begin() to end()
+    static std::mutex &safepointLock() {
+        static std::mutex lock;
+        return lock;
+    }
+
+    static SafepointStatistics statistics;
+    static Clock::time_point requestTime;
+
+    static inline u8 nanosSince(Clock::time_point start) {
+        return (u8) std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+    }
+
+    bool Safepoint::allThreadsStopped(Thread *requester) {
+        LockGuard lockGuard(Threads::appThreadLock());
+        for (Thread *thread : Threads::getAppThreadList()) {
+            if (thread != requester && !Thread::isSafeState(thread->getExecutionState())) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    static void waitForSafepointEnd() {
+        std::unique_lock<std::mutex> guard(stateLock());
+        stateChanged().wait(guard, [] {
+            return !Safepoint::isPollRequested();
+        });
+    }
+
+    void Safepoint::publishState(Thread *thread, ExecutionState state) {
+        std::lock_guard<std::mutex> guard(stateLock());
+        thread->_executionState.store(state);
+        stateChanged().notify_all();
+    }
+
+    KIVM_NOINLINE void Safepoint::park(Thread *thread, ExecutionState previous) {
+        // Frames above this one stay alive until the thread resumes.
+        void *marker = nullptr;
+        thread->_stackAnchor = &marker;
+        publishState(thread, ExecutionState::BLOCKED);
+        transition(thread, previous);
+    }
+
+    KIVM_NOINLINE void Safepoint::stop(Thread *thread) {
+        ExecutionState previous = thread->getExecutionState();
+        setjmp(thread->_savedRegisters);
+#if defined(__GNUC__)
+        __builtin_unwind_init();
+#endif
+        // Polls are at instruction starts, see poll().
+        bool atInstructionStart = thread->_pcAtInstructionStart;
+        thread->_pcAtInstructionStart = true;
+        park(thread, previous);
+        thread->_pcAtInstructionStart = atInstructionStart;
+    }
+
+    KIVM_NOINLINE void Safepoint::transition(Thread *thread, ExecutionState state) {
+        if (Thread::isSafeState(state)) {
+            // The thread goes on in the frames of its callers, which start
+            // where this one ends. Callee-saved registers may hold their references.
+            setjmp(thread->_savedRegisters);
+#if defined(__GNUC__)
+            thread->_stackAnchor = __builtin_frame_address(0);
+#else
+            thread->_stackAnchor = _AddressOfReturnAddress();
+#endif
+            publishState(thread, state);
+            return;
+        }
+
+        ExecutionState safeState = thread->getExecutionState();
+        if (!Thread::isSafeState(safeState)) {
+            // IN_VM <-> IN_JAVA, the thread keeps running
+            thread->_executionState.store(state);
+            return;
+        }
+
+        for (;;) {
+            // Pairs with begin(): either we see the request,
+            // or the requester sees us running and waits for our poll.
+            thread->_executionState.store(state);
+            if (!_pollRequested.load()) {
+                break;
+            }
+            publishState(thread, safeState);
+            waitForSafepointEnd();
+        }
+        thread->_stackAnchor = nullptr;
+    }
+
+    void Safepoint::begin() {
+        Thread *current = Thread::current();
+        if (current != nullptr) {
+            // Another thread may be stopping the world, let it go first.
+            ThreadStateTransition blocked(current, ExecutionState::BLOCKED);
+            safepointLock().lock();
+        } else {
+            safepointLock().lock();
+        }
+
+        requestTime = Clock::now();
+        _pollRequested.store(true);
+
+        std::unique_lock<std::mutex> guard(stateLock());
+        stateChanged().wait(guard, [current] {
+            return allThreadsStopped(current);
+        });
+
+        u8 timeToSafepoint = nanosSince(requestTime);
+        statistics.totalTimeToSafepoint += timeToSafepoint;
+        statistics.maxTimeToSafepoint = std::max(statistics.maxTimeToSafepoint, timeToSafepoint);
+        D("Safepoint: all threads stopped in %llu ns", timeToSafepoint);
+    }
+
+    void Safepoint::end() {
+        {
+            std::lock_guard<std::mutex> guard(stateLock());
+            _pollRequested.store(false);
+            stateChanged().notify_all();
+        }
+
+        u8 pauseTime = nanosSince(requestTime);
+        ++statistics.safepoints;
+        statistics.totalPauseTime += pauseTime;
+        statistics.maxPauseTime = std::max(statistics.maxPauseTime, pauseTime);
+        D("Safepoint: threads resumed after %llu ns", pauseTime);
+
+        safepointLock().unlock();
+    }
+
+    SafepointStatistics Safepoint::getStatistics() {
+        std::lock_guard<std::mutex> guard(safepointLock());
+        return statistics;
+    }
+
+    void Safepoint::printStatistics() {
+        SafepointStatistics current = getStatistics();
+        fprintf(stderr, "Safepoint: %llu safepoints, time to safepoint %.3f ms (max %.3f ms), "
+                        "paused %.3f ms (max %.3f ms)\n",
+                (unsigned long long) current.safepoints,
+                (double) current.totalTimeToSafepoint / 1e6, (double) current.maxTimeToSafepoint / 1e6,
+                (double) current.totalPauseTime / 1e6, (double) current.maxPauseTime / 1e6);
+    }
+}
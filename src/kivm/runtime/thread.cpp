@@ -5,26 +5,42 @@
 #include <kivm/method.h>
 #include <kivm/runtime/thread.h>
 #include <kivm/runtime/runtimeConfig.h>
+#include <kivm/runtime/safepoint.h>
 #include <kivm/bytecode/interpreter.h>
 #include <kivm/oop/primitiveOop.h>
+#include <kivm/memory/oopClosure.h>
+#include <shared/memory.h>
 #include <algorithm>
 
 namespace kivm {
+    static thread_local Thread *currentThread = nullptr;
+
+    Thread *Thread::current() {
+        return currentThread;
+    }
+
     Thread::Thread(Method *method, const std::list<oop> &args)
-        : _frames(RuntimeConfig::get().threadMaxStackSize),
-          _method(method), _args(args),
-          _javaThreadObject(nullptr), _nativeThread(nullptr),
-          _pc(0), _state(ThreadState::RUNNING) {
+        : _javaThreadObject(nullptr), _nativeThread(nullptr),
+          _state(ThreadState::RUNNING), _method(method),
+          _frames(RuntimeConfig::get().threadMaxStackSize), _args(args),
+          _pc(0), _pcAtInstructionStart(false),
+          _executionState(ExecutionState::NEW),
+          _stackAnchor(nullptr), _stackBase(nullptr) {
     }
 
     void Thread::create(instanceOop javaThread) {
         this->_javaThreadObject = javaThread;
         this->_nativeThread = new std::thread([this] {
-            if (this->shouldRecordInThreadTable()) {
-                D("should_record_in_thread_table == true, recording.");
-                Threads::add(this);
-            }
+            currentThread = this;
+            this->_stackBase = memory::getCurrentStackBase();
+            // Safepoints must stop every thread running Java code,
+            // the main thread included, but only app threads are counted.
+            Threads::add(this, this->shouldRecordInThreadTable());
+
+            // A new thread must not run while the world is stopped.
+            Safepoint::transition(this, ExecutionState::IN_VM);
             this->start();
+            Safepoint::transition(this, ExecutionState::TERMINATED);
         });
         this->onThreadLaunched();
     }
@@ -43,6 +59,54 @@ namespace kivm {
 
     Thread::~Thread() = default;
 
+    void Thread::iterateRoots(RootClosure *closure) {
+        closure->doOop((oop *) &_javaThreadObject);
+        for (auto &arg : _args) {
+            closure->doOop(&arg);
+        }
+
+        // The top frame stops at _pc, and each caller inside
+        // the instruction ending at the return pc recorded by its callee.
+        u4 pc = _pc;
+        bool atInstructionStart = _pcAtInstructionStart;
+        for (Frame *frame = _frames.getCurrentFrameOrNull();
+             frame != nullptr; frame = frame->getPrevious()) {
+            frame->iterateRoots(closure, pc, atInstructionStart);
+            pc = frame->getReturnPc();
+            atInstructionStart = false;
+        }
+
+        // The native stack of current thread is scanned by the heap.
+        if (this != Thread::current() && _stackAnchor != nullptr && _stackBase != nullptr) {
+            auto **p = (void **) &_savedRegisters;
+            auto **end = (void **) ((char *) &_savedRegisters + sizeof(_savedRegisters));
+            for (; p < end; ++p) {
+                closure->doConservativeRoot(*p);
+            }
+
+            p = (void **) memory::alignDown((size_t) _stackAnchor, sizeof(void *));
+            end = (void **) _stackBase;
+            for (; p < end; ++p) {
+                closure->doConservativeRoot(*p);
+            }
+        }
+    }
+
+    void Threads::iterateRoots(RootClosure *closure) {
+        LockGuard lockGuard(appThreadLock());
+        const auto &threads = getAppThreadList();
+        for (Thread *thread : threads) {
+            thread->iterateRoots(closure);
+        }
+
+        // The current thread may not be recorded in thread table yet.
+        Thread *current = Thread::current();
+        if (current != nullptr
+            && std::find(threads.begin(), threads.end(), current) == threads.end()) {
+            current->iterateRoots(closure);
+        }
+    }
+
     JavaThread::JavaThread(Method *method, const std::list<oop> &args)
         : Thread(method, args) {
     }
@@ -77,6 +141,7 @@ namespace kivm {
 
         // copy args to local variable table
         int localVariableIndex = 0;
+        int argumentIndex = 0;
         bool isStatic = method->isStatic();
         const std::vector<ValueType> descriptorMap = method->getArgumentValueTypes();
 
@@ -85,6 +150,7 @@ namespace kivm {
             if (arg == nullptr) {
                 D("Copying reference: #%d - null", localVariableIndex);
                 locals.setReference(localVariableIndex++, nullptr);
+                ++argumentIndex;
                 return;
             }
 
@@ -94,11 +160,13 @@ namespace kivm {
                 case oopType::TYPE_ARRAY_OOP: {
                     D("Copying reference: #%d - %p", localVariableIndex, arg);
                     locals.setReference(localVariableIndex++, arg);
+                    ++argumentIndex;
                     break;
                 }
 
                 case oopType::PRIMITIVE_OOP: {
-                    ValueType valueType = descriptorMap[isStatic ? localVariableIndex : localVariableIndex - 1];
+                    ValueType valueType = descriptorMap[isStatic ? argumentIndex : argumentIndex - 1];
+                    ++argumentIndex;
                     switch (valueType) {
                         case ValueType::INT: {
                             int value = ((intOop) arg)->getValue();
@@ -115,13 +183,15 @@ namespace kivm {
                         case ValueType::DOUBLE: {
                             double value = ((doubleOop) arg)->getValue();
                             D("Copying double: #%d - %lf", localVariableIndex, value);
-                            locals.setDouble(localVariableIndex++, value);
+                            locals.setDouble(localVariableIndex, value);
+                            localVariableIndex += 2;
                             break;
                         }
                         case ValueType::LONG: {
                             long value = ((longOop) arg)->getValue();
                             D("Copying long: #%d - %ld", localVariableIndex, value);
-                            locals.setLong(localVariableIndex++, value);
+                            locals.setLong(localVariableIndex, value);
+                            localVariableIndex += 2;
                             break;
                         }
                         default:
@@ -2,6 +2,7 @@
 // Created by kiva on 2018/3/25.
 //
 #include <kivm/runtime/runtimeConfig.h>
+#include <cstdlib>
 
 namespace kivm {
     RuntimeConfig &RuntimeConfig::get() {
@@ -12,5 +13,172 @@ namespace kivm {
     RuntimeConfig::RuntimeConfig() {
         threadInitialStackSize = 256;
         threadMaxStackSize = 512;
+        initialHeapSize = 16 * 1024 * 1024;
+        maxHeapSize = 512 * 1024 * 1024;
+        largeObjectThreshold = 1024 * 1024;
+        useTransparentHugePages = true;
+        alwaysPreTouch = false;
+
+        const char *compressedOops = getenv("KIVM_COMPRESSED_OOPS");
+        useCompressedOops = compressedOops != nullptr && *compressedOops == '1';
+        useCompressedClassPointers = useCompressedOops;
+        compressedClassSpaceSize = 64 * 1024 * 1024;
+
+        const char *profileOutput = getenv("KIVM_FIELD_PROFILE_OUT");
+        const char *profileInput = getenv("KIVM_FIELD_PROFILE");
+        fieldProfileOutput = profileOutput != nullptr ? profileOutput : "";
+        fieldProfileInput = profileInput != nullptr ? profileInput : "";
+
+        usePretenuring = true;
+        const char *pretenureOutput = getenv("KIVM_PRETENURE_PROFILE_OUT");
+        const char *pretenureInput = getenv("KIVM_PRETENURE_PROFILE");
+        pretenureProfileOutput = pretenureOutput != nullptr ? pretenureOutput : "";
+        pretenureProfileInput = pretenureInput != nullptr ? pretenureInput : "";
+        printPretenuring = false;
+
+        watchClassPath = false;
+
+        sharingMode = SharingMode::AUTO;
+        const char *sharedArchive = getenv("KIVM_SHARED_ARCHIVE");
+        sharedArchiveFile = sharedArchive != nullptr ? sharedArchive : "";
+
+        prefetchClasses = false;
+        prefetchThreads = 2;
+
+        const char *oopMapCache = getenv("KIVM_OOP_MAP_CACHE");
+        oopMapCacheDirectory = oopMapCache != nullptr ? oopMapCache : "";
+
+        printClassPathStatistics = false;
+        printSafepointStatistics = false;
+    }
+
+    size_t RuntimeConfig::parseSize(const std::string &value) {
+        if (value.empty() || value[0] < '0' || value[0] > '9') {
+            return 0;
+        }
+
+        char *suffix = nullptr;
+        unsigned long long size = strtoull(value.c_str(), &suffix, 10);
+        switch (*suffix) {
+            case 'g':
+            case 'G':
+                size *= 1024;
+                // fall through
+            case 'm':
+            case 'M':
+                size *= 1024;
+                // fall through
+            case 'k':
+            case 'K':
+                size *= 1024;
+                ++suffix;
+                break;
+            default:
+                break;
+        }
+        return *suffix == '\0' ? (size_t) size : 0;
+    }
+
+    bool RuntimeConfig::parseOption(const std::string &option) {
+        if (option.compare(0, 4, "-Xms") == 0 || option.compare(0, 4, "-Xmx") == 0) {
+            size_t size = parseSize(option.substr(4));
+            if (size == 0) {
+                return false;
+            }
+            (option[3] == 's' ? initialHeapSize : maxHeapSize) = size;
+            return true;
+        }
+
+        static const std::string CLASS_SPACE_SIZE = "-XX:CompressedClassSpaceSize=";
+        if (option.compare(0, CLASS_SPACE_SIZE.size(), CLASS_SPACE_SIZE) == 0) {
+            size_t size = parseSize(option.substr(CLASS_SPACE_SIZE.size()));
+            if (size == 0) {
+                return false;
+            }
+            compressedClassSpaceSize = size;
+            return true;
+        }
+
+        static const std::string LARGE_OBJECT_THRESHOLD = "-XX:LargeObjectThreshold=";
+        if (option.compare(0, LARGE_OBJECT_THRESHOLD.size(), LARGE_OBJECT_THRESHOLD) == 0) {
+            std::string value = option.substr(LARGE_OBJECT_THRESHOLD.size());
+            size_t size = parseSize(value);
+            if (size == 0 && value != "0") {
+                return false;
+            }
+            largeObjectThreshold = size;
+            return true;
+        }
+
+        if (option == "-Xshare:off") {
+            sharingMode = SharingMode::OFF;
+            return true;
+        } else if (option == "-Xshare:auto") {
+            sharingMode = SharingMode::AUTO;
+            return true;
+        } else if (option == "-Xshare:dump") {
+            sharingMode = SharingMode::DUMP;
+            return true;
+        }
+
+        static const std::string SHARED_ARCHIVE_FILE = "-XX:SharedArchiveFile=";
+        static const std::string SHARED_CLASS_LIST_FILE = "-XX:SharedClassListFile=";
+        if (option.compare(0, SHARED_ARCHIVE_FILE.size(), SHARED_ARCHIVE_FILE) == 0) {
+            sharedArchiveFile = option.substr(SHARED_ARCHIVE_FILE.size());
+            return !sharedArchiveFile.empty();
+        } else if (option.compare(0, SHARED_CLASS_LIST_FILE.size(), SHARED_CLASS_LIST_FILE) == 0) {
+            sharedClassListFile = option.substr(SHARED_CLASS_LIST_FILE.size());
+            return !sharedClassListFile.empty();
+        }
+
+        static const std::string PREFETCH_THREADS = "-XX:PrefetchThreads=";
+        if (option.compare(0, PREFETCH_THREADS.size(), PREFETCH_THREADS) == 0) {
+            std::string value = option.substr(PREFETCH_THREADS.size());
+            char *end = nullptr;
+            long threads = strtol(value.c_str(), &end, 10);
+            if (value.empty() || *end != '\0' || threads < 1 || threads > 64) {
+                return false;
+            }
+            prefetchThreads = (int) threads;
+            return true;
+        }
+
+        static const std::string OOP_MAP_CACHE_DIRECTORY = "-XX:OopMapCacheDirectory=";
+        if (option.compare(0, OOP_MAP_CACHE_DIRECTORY.size(), OOP_MAP_CACHE_DIRECTORY) == 0) {
+            oopMapCacheDirectory = option.substr(OOP_MAP_CACHE_DIRECTORY.size());
+            return !oopMapCacheDirectory.empty();
+        }
+
+        if (option.size() < 6 || option.compare(0, 4, "-XX:") != 0
+            || (option[4] != '+' && option[4] != '-')) {
+            return false;
+        }
+
+        bool enabled = option[4] == '+';
+        std::string flag = option.substr(5);
+        if (flag == "UseCompressedOops") {
+            useCompressedOops = enabled;
+        } else if (flag == "UseCompressedClassPointers") {
+            useCompressedClassPointers = enabled;
+        } else if (flag == "UseTransparentHugePages") {
+            useTransparentHugePages = enabled;
+        } else if (flag == "AlwaysPreTouch") {
+            alwaysPreTouch = enabled;
+        } else if (flag == "UsePretenuring") {
+            usePretenuring = enabled;
+        } else if (flag == "PrintPretenuring") {
+            printPretenuring = enabled;
+        } else if (flag == "WatchClassPath") {
+            watchClassPath = enabled;
+        } else if (flag == "PrefetchClasses") {
+            prefetchClasses = enabled;
+        } else if (flag == "PrintClassPathStatistics") {
+            printClassPathStatistics = enabled;
+        } else if (flag == "PrintSafepointStatistics") {
+            printSafepointStatistics = enabled;
+        } else {
+            return false;
+        }
+        return true;
     }
 }
@@ -0,0 +1,137 @@
+//
+// Created by kiva on 2018/4/25.
+//
+#include <kivm/symbol.h>
+#include <cstddef>
+#include <cstdlib>
+
+namespace kivm {
+    static const size_t MAX_SYMBOL_LENGTH = 0xffff;
+
+    /**
+     * Encode {@code string} the way class files do:
+     * {@code '\0'} takes two bytes and characters outside the BMP
+     * are written as two surrogates of three bytes each.
+     * @return encoded length, which may exceed {@code capacity}
+     */
+    static size_t encodeModifiedUtf8(const String &string, u1 *out, size_t capacity) {
+        size_t length = 0;
+        auto put = [&](u4 c) {
+            if (c != 0 && c < 0x80) {
+                if (length < capacity) {
+                    out[length] = (u1) c;
+                }
+                length += 1;
+            } else if (c < 0x800) {
+                if (length + 2 <= capacity) {
+                    out[length] = (u1) (0xc0 | (c >> 6));
+                    out[length + 1] = (u1) (0x80 | (c & 0x3f));
+                }
+                length += 2;
+            } else {
+                if (length + 3 <= capacity) {
+                    out[length] = (u1) (0xe0 | (c >> 12));
+                    out[length + 1] = (u1) (0x80 | ((c >> 6) & 0x3f));
+                    out[length + 2] = (u1) (0x80 | (c & 0x3f));
+                }
+                length += 3;
+            }
+        };
+
+        for (wchar_t ch : string) {
+            auto c = (u4) ch;
+            if (c > 0xffff) {
+                c -= 0x10000;
+                put(0xd800 | (c >> 10));
+                put(0xdc00 | (c & 0x3ff));
+            } else {
+                put(c);
+            }
+        }
+        return length;
+    }
+
+    /**
+     * Encode {@code string} into {@code buffer} if it fits, or into {@code heap}.
+     */
+    template<size_t N>
+    static const u1 *encode(const String &string, u1 (&buffer)[N], std::vector<u1> &heap, size_t *length) {
+        *length = encodeModifiedUtf8(string, buffer, N);
+        if (*length <= N) {
+            return buffer;
+        }
+        heap.resize(*length);
+        encodeModifiedUtf8(string, heap.data(), heap.size());
+        return heap.data();
+    }
+
+    size_t Symbol::hashBytes(const u1 *bytes, size_t length) {
+        // FNV-1a
+        size_t hash = 2166136261u;
+        for (size_t i = 0; i < length; ++i) {
+            hash = (hash ^ bytes[i]) * 16777619u;
+        }
+        return hash;
+    }
+
+    String Symbol::toString() const {
+        return strings::fromBytes(_bytes, _length);
+    }
+
+    SymbolTable *SymbolTable::get() {
+        // Never destroyed, symbols are used until the very end.
+        static SymbolTable *symbolTable = new SymbolTable;
+        return symbolTable;
+    }
+
+    SymbolTable::SymbolTable()
+        : _symbols(INITIAL_CAPACITY), _bytes(0) {
+    }
+
+    SymbolTable::~SymbolTable() {
+        _symbols.forEach([](Symbol *symbol) {
+            free(symbol);
+        });
+    }
+
+    Symbol *SymbolTable::lookup(const u1 *bytes, size_t length) {
+        if (length > MAX_SYMBOL_LENGTH) {
+            PANIC("Symbol too long");
+        }
+
+        size_t hash = Symbol::hashBytes(bytes, length);
+        auto matches = [bytes, length](const Symbol *symbol) {
+            return symbol->equals(bytes, length);
+        };
+        return _symbols.findOrInsert(hash, matches, [this, bytes, length, hash] {
+            size_t size = offsetof(Symbol, _bytes) + (length > 0 ? length : 1);
+            auto *symbol = (Symbol *) malloc(size);
+            if (symbol == nullptr) {
+                PANIC("SymbolTable: out of memory");
+            }
+            symbol->_hash = hash;
+            symbol->_length = (u2) length;
+            memcpy(symbol->_bytes, bytes, length);
+            _bytes += size;
+            return symbol;
+        });
+    }
+
+    Symbol *SymbolTable::lookup(const String &string) {
+        u1 buffer[256];
+        std::vector<u1> heap;
+        size_t length = 0;
+        const u1 *bytes = encode(string, buffer, heap, &length);
+        return lookup(bytes, length);
+    }
+
+    Symbol *SymbolTable::probe(const String &string) {
+        u1 buffer[256];
+        std::vector<u1> heap;
+        size_t length = 0;
+        const u1 *bytes = encode(string, buffer, heap, &length);
+        return _symbols.find(Symbol::hashBytes(bytes, length), [bytes, length](const Symbol *symbol) {
+            return symbol->equals(bytes, length);
+        });
+    }
+}
@@ -2,21 +2,49 @@
 // Created by kiva on 2018/3/28.
 //
 #include <kivm/system.h>
+#include <kivm/oop/klass.h>
+#include <functional>
 
 namespace kivm {
+    static inline size_t hashName(const String &name) {
+        return std::hash<String>()(name);
+    }
+
     SystemDictionary *SystemDictionary::get() {
         static SystemDictionary dictionary;
         return &dictionary;
     }
 
+    SystemDictionary::SystemDictionary()
+        : _entries(INITIAL_CAPACITY) {
+    }
+
+    SystemDictionary::~SystemDictionary() {
+        _entries.forEach([](Entry *entry) {
+            delete entry;
+        });
+    }
+
     Klass *SystemDictionary::find(const String &name) {
-        LockGuard lockGuard(this->_lock);
-        const auto &iter = this->_classes.find(name);
-        return iter != this->_classes.end() ? iter->second : nullptr;
+        Entry *entry = _entries.find(hashName(name), [&name](const Entry *each) {
+            return each->name == name;
+        });
+        return entry != nullptr ? entry->klass : nullptr;
+    }
+
+    Klass *SystemDictionary::put(const String &name, Klass *klass) {
+        size_t hash = hashName(name);
+        Entry *entry = _entries.findOrInsert(hash, [&name](const Entry *each) {
+            return each->name == name;
+        }, [&name, klass, hash] {
+            return new Entry{hash, name, klass};
+        });
+        return entry->klass;
     }
 
-    void SystemDictionary::put(const String &name, Klass *klass) {
-        LockGuard lockGuard(this->_lock);
-        this->_classes.insert(std::make_pair(name, klass));
+    void SystemDictionary::iterateOops(OopClosure *closure) {
+        _entries.forEach([closure](Entry *entry) {
+            entry->klass->iterateOops(closure);
+        });
     }
 }
@@ -0,0 +1,144 @@
+//
+// Created by kiva on 2018/4/25.
+//
+
+#ifdef KIVM_PLATFORM_UNIX
+
+#include <shared/files.h>
+#include <sys/stat.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(__linux__)
+#include <sys/inotify.h>
+#endif
+
+namespace kivm {
+    namespace files {
+        bool isDirectory(const std::string &path) {
+            struct stat st{};
+            return stat(path.c_str(), &st) == 0 && S_ISDIR(st.st_mode);
+        }
+
+        bool getStatus(const std::string &path, FileStatus *status) {
+            struct stat st{};
+            if (stat(path.c_str(), &st) != 0) {
+                return false;
+            }
+#if defined(__APPLE__)
+            const struct timespec &modified = st.st_mtimespec;
+#else
+            const struct timespec &modified = st.st_mtim;
+#endif
+            status->size = (uint64_t) st.st_size;
+            status->modificationTime = (int64_t) modified.tv_sec * 1000000000 + modified.tv_nsec;
+            return true;
+        }
+
+        bool listDirectory(const std::string &path, std::vector<DirectoryEntry> *entries) {
+            DIR *dir = opendir(path.c_str());
+            if (dir == nullptr) {
+                return false;
+            }
+
+            struct dirent *entry = nullptr;
+            while ((entry = readdir(dir)) != nullptr) {
+                if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) {
+                    continue;
+                }
+
+                bool directory = false;
+#if defined(_DIRENT_HAVE_D_TYPE) || defined(__APPLE__)
+                if (entry->d_type == DT_DIR) {
+                    directory = true;
+                } else if (entry->d_type == DT_UNKNOWN || entry->d_type == DT_LNK) {
+                    directory = isDirectory(path + "/" + entry->d_name);
+                }
+#else
+                directory = isDirectory(path + "/" + entry->d_name);
+#endif
+                entries->push_back(DirectoryEntry{entry->d_name, directory});
+            }
+            closedir(dir);
+            return true;
+        }
+
+        bool makeDirectory(const std::string &path) {
+            return mkdir(path.c_str(), 0755) == 0 || isDirectory(path);
+        }
+
+        bool replaceFile(const std::string &path, const void *data, size_t length) {
+            std::string temporary = path + ".XXXXXX";
+            int fd = mkstemp(&temporary[0]);
+            if (fd < 0) {
+                return false;
+            }
+
+            bool written = fchmod(fd, 0644) == 0;
+            const auto *bytes = (const char *) data;
+            while (written && length > 0) {
+                ssize_t count = write(fd, bytes, length);
+                if (count < 0 && errno == EINTR) {
+                    continue;
+                }
+                written = count > 0;
+                bytes += written ? count : 0;
+                length -= written ? (size_t) count : 0;
+            }
+            written = close(fd) == 0 && written;
+            if (!written || rename(temporary.c_str(), path.c_str()) != 0) {
+                unlink(temporary.c_str());
+                return false;
+            }
+            return true;
+        }
+
+        DirectoryWatcher::DirectoryWatcher() {
+#if defined(__linux__)
+            int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+            if (fd >= 0) {
+                _handles.push_back(fd);
+            }
+#endif
+        }
+
+        DirectoryWatcher::~DirectoryWatcher() {
+            for (intptr_t handle : _handles) {
+                close((int) handle);
+            }
+        }
+
+        bool DirectoryWatcher::isSupported() const {
+            return !_handles.empty();
+        }
+
+        void DirectoryWatcher::watch(const std::string &path) {
+#if defined(__linux__)
+            if (isSupported()) {
+                inotify_add_watch((int) _handles[0], path.c_str(),
+                                  IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO);
+            }
+#endif
+        }
+
+        bool DirectoryWatcher::pollChanges() {
+            if (!isSupported()) {
+                return false;
+            }
+
+            // Drain all pending events, one change is as good as many.
+            bool changed = false;
+            char buffer[4096];
+            while (read((int) _handles[0], buffer, sizeof(buffer)) > 0) {
+                changed = true;
+            }
+            return changed;
+        }
+    }
+}
+
+#endif
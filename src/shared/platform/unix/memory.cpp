@@ -0,0 +1,138 @@
+//
+// Created by kiva on 2018/4/20.
+//
+
+#ifdef KIVM_PLATFORM_UNIX
+
+// for pthread_getattr_np
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include <shared/memory.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#ifndef MAP_NORESERVE
+#define MAP_NORESERVE 0
+#endif
+
+namespace kivm {
+    namespace memory {
+        size_t getPageSize() {
+            static size_t pageSize = (size_t) sysconf(_SC_PAGESIZE);
+            return pageSize;
+        }
+
+        void *reserve(size_t size, size_t alignment) {
+            size_t pageSize = getPageSize();
+            if (alignment < pageSize) {
+                alignment = pageSize;
+            }
+
+            // over-reserve and trim the misaligned head and the rest of the tail
+            size_t mapped = size + alignment - pageSize;
+            void *address = mmap(nullptr, mapped, PROT_NONE,
+                                 MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+            if (address == MAP_FAILED) {
+                return nullptr;
+            }
+
+            auto *start = (char *) address;
+            auto *aligned = (char *) alignUp((size_t) start, alignment);
+            if (aligned > start) {
+                munmap(start, (size_t) (aligned - start));
+            }
+            char *end = start + mapped;
+            if (aligned + size < end) {
+                munmap(aligned + size, (size_t) (end - aligned - size));
+            }
+            return aligned;
+        }
+
+        bool commit(void *address, size_t size) {
+            return size == 0 || mprotect(address, size, PROT_READ | PROT_WRITE) == 0;
+        }
+
+        void adviseHugePages(void *address, size_t size) {
+#if defined(MADV_HUGEPAGE)
+            madvise(address, size, MADV_HUGEPAGE);
+#endif
+        }
+
+        void pretouch(void *address, size_t size) {
+            size_t pageSize = getPageSize();
+            auto *end = (char *) address + size;
+            for (auto *p = (volatile char *) address; p < end; p += pageSize) {
+                *p = 0;
+            }
+        }
+
+        void release(void *address, size_t size) {
+            if (address != nullptr) {
+                munmap(address, size);
+            }
+        }
+
+        void discard(void *address, size_t size) {
+            if (size > 0) {
+                madvise(address, size, MADV_DONTNEED);
+            }
+        }
+
+        void *mapFile(const char *path, size_t *size, bool readAhead) {
+            int fd = open(path, O_RDONLY);
+            if (fd < 0) {
+                return nullptr;
+            }
+
+#ifdef POSIX_FADV_WILLNEED
+            if (readAhead) {
+                posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED);
+            }
+#endif
+
+            struct stat st{};
+            void *address = MAP_FAILED;
+            if (fstat(fd, &st) == 0 && st.st_size > 0) {
+                address = mmap(nullptr, (size_t) st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            }
+            // the mapping keeps the file open
+            close(fd);
+
+            if (address == MAP_FAILED) {
+                return nullptr;
+            }
+            *size = (size_t) st.st_size;
+            return address;
+        }
+
+        void unmapFile(void *address, size_t size) {
+            if (address != nullptr) {
+                munmap(address, size);
+            }
+        }
+
+        void *getCurrentStackBase() {
+#if defined(__APPLE__)
+            return pthread_get_stackaddr_np(pthread_self());
+#else
+            pthread_attr_t attr;
+            if (pthread_getattr_np(pthread_self(), &attr) != 0) {
+                return nullptr;
+            }
+
+            void *low = nullptr;
+            size_t size = 0;
+            pthread_attr_getstack(&attr, &low, &size);
+            pthread_attr_destroy(&attr);
+            return (char *) low + size;
+#endif
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,116 @@
+//
+// Created by kiva on 2018/4/25.
+//
+
+#ifdef KIVM_PLATFORM_WINDOWS
+
+#include <shared/files.h>
+#include <windows.h>
+#include <cstring>
+
+namespace kivm {
+    namespace files {
+        bool isDirectory(const std::string &path) {
+            DWORD attributes = GetFileAttributesA(path.c_str());
+            return attributes != INVALID_FILE_ATTRIBUTES
+                   && (attributes & FILE_ATTRIBUTE_DIRECTORY) != 0;
+        }
+
+        bool getStatus(const std::string &path, FileStatus *status) {
+            WIN32_FILE_ATTRIBUTE_DATA data;
+            if (!GetFileAttributesExA(path.c_str(), GetFileExInfoStandard, &data)) {
+                return false;
+            }
+            status->size = ((uint64_t) data.nFileSizeHigh << 32) | data.nFileSizeLow;
+            // 100-nanosecond intervals
+            status->modificationTime = (int64_t) ((((uint64_t) data.ftLastWriteTime.dwHighDateTime << 32)
+                                                   | data.ftLastWriteTime.dwLowDateTime) * 100);
+            return true;
+        }
+
+        bool listDirectory(const std::string &path, std::vector<DirectoryEntry> *entries) {
+            WIN32_FIND_DATAA data;
+            HANDLE find = FindFirstFileA((path + "\\*").c_str(), &data);
+            if (find == INVALID_HANDLE_VALUE) {
+                return false;
+            }
+
+            do {
+                if (strcmp(data.cFileName, ".") == 0 || strcmp(data.cFileName, "..") == 0) {
+                    continue;
+                }
+                entries->push_back(DirectoryEntry{data.cFileName,
+                                                  (data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0});
+            } while (FindNextFileA(find, &data));
+            FindClose(find);
+            return true;
+        }
+
+        bool makeDirectory(const std::string &path) {
+            return CreateDirectoryA(path.c_str(), nullptr) || isDirectory(path);
+        }
+
+        bool replaceFile(const std::string &path, const void *data, size_t length) {
+            // unique among processes and their threads
+            const std::string &temporary = path + "." + std::to_string(GetCurrentProcessId())
+                                           + "-" + std::to_string(GetCurrentThreadId()) + ".tmp";
+            HANDLE file = CreateFileA(temporary.c_str(), GENERIC_WRITE, 0, nullptr,
+                                      CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+            if (file == INVALID_HANDLE_VALUE) {
+                return false;
+            }
+
+            bool written = true;
+            const auto *bytes = (const char *) data;
+            while (written && length > 0) {
+                DWORD chunk = length > 0x40000000 ? 0x40000000 : (DWORD) length;
+                DWORD count = 0;
+                written = WriteFile(file, bytes, chunk, &count, nullptr) && count > 0;
+                bytes += count;
+                length -= count;
+            }
+            written = CloseHandle(file) && written;
+            if (!written || !MoveFileExA(temporary.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING)) {
+                DeleteFileA(temporary.c_str());
+                return false;
+            }
+            return true;
+        }
+
+        DirectoryWatcher::DirectoryWatcher() = default;
+
+        DirectoryWatcher::~DirectoryWatcher() {
+            for (intptr_t handle : _handles) {
+                FindCloseChangeNotification((HANDLE) handle);
+            }
+        }
+
+        bool DirectoryWatcher::isSupported() const {
+            return true;
+        }
+
+        void DirectoryWatcher::watch(const std::string &path) {
+            HANDLE handle = FindFirstChangeNotificationA(path.c_str(), FALSE,
+                                                         FILE_NOTIFY_CHANGE_FILE_NAME
+                                                         | FILE_NOTIFY_CHANGE_DIR_NAME);
+            if (handle != INVALID_HANDLE_VALUE) {
+                _handles.push_back((intptr_t) handle);
+            }
+        }
+
+        bool DirectoryWatcher::pollChanges() {
+            bool changed = false;
+            for (intptr_t handle : _handles) {
+                while (WaitForSingleObject((HANDLE) handle, 0) == WAIT_OBJECT_0) {
+                    changed = true;
+                    if (!FindNextChangeNotification((HANDLE) handle)) {
+                        break;
+                    }
+                }
+            }
+            return changed;
+        }
+    }
+}
+
+#endif
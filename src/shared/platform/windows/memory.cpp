@@ -0,0 +1,113 @@
+//
+// Created by kiva on 2018/4/20.
+//
+
+#ifdef KIVM_PLATFORM_WINDOWS
+
+#include <shared/memory.h>
+#include <windows.h>
+
+namespace kivm {
+    namespace memory {
+        size_t getPageSize() {
+            SYSTEM_INFO info;
+            GetSystemInfo(&info);
+            return info.dwPageSize;
+        }
+
+        void *reserve(size_t size, size_t alignment) {
+            SYSTEM_INFO info;
+            GetSystemInfo(&info);
+            if (alignment <= info.dwAllocationGranularity) {
+                return VirtualAlloc(nullptr, size, MEM_RESERVE, PAGE_READWRITE);
+            }
+
+            // Ranges cannot be trimmed here, find an aligned hole and reserve it.
+            // Another thread may take the hole in between, so retry a few times.
+            for (int attempt = 0; attempt < 8; ++attempt) {
+                void *probe = VirtualAlloc(nullptr, size + alignment, MEM_RESERVE, PAGE_READWRITE);
+                if (probe == nullptr) {
+                    return nullptr;
+                }
+                VirtualFree(probe, 0, MEM_RELEASE);
+                auto *aligned = (void *) alignUp((size_t) probe, alignment);
+                void *address = VirtualAlloc(aligned, size, MEM_RESERVE, PAGE_READWRITE);
+                if (address != nullptr) {
+                    return address;
+                }
+            }
+            return VirtualAlloc(nullptr, size, MEM_RESERVE, PAGE_READWRITE);
+        }
+
+        bool commit(void *address, size_t size) {
+            return size == 0 || VirtualAlloc(address, size, MEM_COMMIT, PAGE_READWRITE) != nullptr;
+        }
+
+        void adviseHugePages(void *address, size_t size) {
+            // Large pages need a privilege and must be committed at reservation.
+        }
+
+        void pretouch(void *address, size_t size) {
+            size_t pageSize = getPageSize();
+            auto *end = (char *) address + size;
+            for (auto *p = (volatile char *) address; p < end; p += pageSize) {
+                *p = 0;
+            }
+        }
+
+        void release(void *address, size_t size) {
+            if (address != nullptr) {
+                VirtualFree(address, 0, MEM_RELEASE);
+            }
+        }
+
+        void discard(void *address, size_t size) {
+            if (size > 0) {
+                // MEM_RESET keeps stale contents, decommit to get zero-filled pages back
+                VirtualFree(address, size, MEM_DECOMMIT);
+                VirtualAlloc(address, size, MEM_COMMIT, PAGE_READWRITE);
+            }
+        }
+
+        void *mapFile(const char *path, size_t *size, bool readAhead) {
+            HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                                      readAhead ? FILE_FLAG_SEQUENTIAL_SCAN : FILE_ATTRIBUTE_NORMAL,
+                                      nullptr);
+            if (file == INVALID_HANDLE_VALUE) {
+                return nullptr;
+            }
+
+            LARGE_INTEGER fileSize;
+            void *address = nullptr;
+            if (GetFileSizeEx(file, &fileSize) && fileSize.QuadPart > 0) {
+                HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+                if (mapping != nullptr) {
+                    address = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+                    // the view keeps the mapping and the file open
+                    CloseHandle(mapping);
+                }
+            }
+            CloseHandle(file);
+
+            if (address != nullptr) {
+                *size = (size_t) fileSize.QuadPart;
+            }
+            return address;
+        }
+
+        void unmapFile(void *address, size_t size) {
+            if (address != nullptr) {
+                UnmapViewOfFile(address);
+            }
+        }
+
+        void *getCurrentStackBase() {
+            ULONG_PTR low = 0;
+            ULONG_PTR high = 0;
+            GetCurrentThreadStackLimits(&low, &high);
+            return (void *) high;
+        }
+    }
+}
+
+#endif
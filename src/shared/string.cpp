@@ -4,100 +4,279 @@
 
 #include <shared/string.h>
 #include <cassert>
-#include <vector>
-#include <codecvt>
-#include <locale>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define KIVM_STRINGS_SSE2
+#include <emmintrin.h>
+#endif
+
+#if defined(KIVM_STRINGS_SSE2) && defined(__GNUC__) && defined(__x86_64__)
+#define KIVM_STRINGS_AVX2
+#include <immintrin.h>
+#endif
 
 namespace kivm {
     namespace strings {
-        // $ 4.4.7
-        static bool isFirstType(const u1 *bytes, size_t length, int position) {
-            assert(position + 1 <= length);
-            return (bytes[position] & 0x80) == 0;
-        }
-
-        static bool isSecondType(const u1 *bytes, size_t length, int position) {
-            assert(position + 2 <= length);
-            return (bytes[position] & 0xE0) == 0xC0
-                   && (bytes[position + 1] & 0xC0) == 0x80;
-        }
+        /*
+         * ASCII runs are copied 16 or 32 characters at a time,
+         * the rest is decoded one character at a time.
+         * Results are written in place: a string is sized for the worst case,
+         * filled through its buffer and cut to what was written.
+         */
+        using WidenFunction = size_t (*)(const u1 *in, size_t length, wchar_t *out);
 
-        static bool isThirdType(const u1 *bytes, size_t length, int position) {
-            assert(position + 3 <= length);
-            return (bytes[position] & 0xF0) == 0xE0
-                   && (bytes[position + 1] & 0xC0) == 0x80
-                   && (bytes[position + 2] & 0xC0) == 0x80;
+        static size_t widenAsciiScalar(const u1 *in, size_t length, wchar_t *out) {
+            size_t i = 0;
+            while (i < length && in[i] < 0x80) {
+                out[i] = in[i];
+                ++i;
+            }
+            return i;
         }
 
-        static bool isForthType(const u1 *bytes, size_t length, int position) {
-            assert(position + 6 <= length);
-            return (bytes[position] == 0xED)
-                   && (bytes[position + 1] & 0xF0) == 0xA0
-                   && (bytes[position + 2] & 0xC0) == 0x80
-                   && (bytes[position + 3] == 0xED)
-                   && (bytes[position + 4] & 0xF0) == 0xB0
-                   && (bytes[position + 5] & 0xC0) == 0x80;
+#ifdef KIVM_STRINGS_SSE2
+        static size_t widenAsciiSse2(const u1 *in, size_t length, wchar_t *out) {
+            const __m128i zero = _mm_setzero_si128();
+            size_t i = 0;
+            for (; i + 16 <= length; i += 16) {
+                __m128i bytes = _mm_loadu_si128((const __m128i *) (in + i));
+                if (_mm_movemask_epi8(bytes) != 0) {
+                    break;
+                }
+                __m128i low = _mm_unpacklo_epi8(bytes, zero);
+                __m128i high = _mm_unpackhi_epi8(bytes, zero);
+                if (sizeof(wchar_t) == 2) {
+                    _mm_storeu_si128((__m128i *) (out + i), low);
+                    _mm_storeu_si128((__m128i *) (out + i + 8), high);
+                } else {
+                    _mm_storeu_si128((__m128i *) (out + i), _mm_unpacklo_epi16(low, zero));
+                    _mm_storeu_si128((__m128i *) (out + i + 4), _mm_unpackhi_epi16(low, zero));
+                    _mm_storeu_si128((__m128i *) (out + i + 8), _mm_unpacklo_epi16(high, zero));
+                    _mm_storeu_si128((__m128i *) (out + i + 12), _mm_unpackhi_epi16(high, zero));
+                }
+            }
+            return i + widenAsciiScalar(in + i, length - i, out + i);
         }
+#endif
 
-        static u2 getFirstType(const u1 *bytes, size_t length, int position) {
-            return bytes[position];
+#ifdef KIVM_STRINGS_AVX2
+        __attribute__((target("avx2")))
+        static size_t widenAsciiAvx2(const u1 *in, size_t length, wchar_t *out) {
+            size_t i = 0;
+            for (; i + 32 <= length; i += 32) {
+                __m256i bytes = _mm256_loadu_si256((const __m256i *) (in + i));
+                if (_mm256_movemask_epi8(bytes) != 0) {
+                    break;
+                }
+                if (sizeof(wchar_t) == 2) {
+                    for (size_t k = 0; k < 32; k += 16) {
+                        __m128i part = _mm_loadu_si128((const __m128i *) (in + i + k));
+                        _mm256_storeu_si256((__m256i *) (out + i + k), _mm256_cvtepu8_epi16(part));
+                    }
+                } else {
+                    for (size_t k = 0; k < 32; k += 8) {
+                        __m128i part = _mm_loadl_epi64((const __m128i *) (in + i + k));
+                        _mm256_storeu_si256((__m256i *) (out + i + k), _mm256_cvtepu8_epi32(part));
+                    }
+                }
+            }
+            return i + widenAsciiSse2(in + i, length - i, out + i);
         }
+#endif
 
-        static u2 getSecondType(const u1 *bytes, size_t length, int position) {
-            return static_cast<u2>(((bytes[position] & 0x1f) << 6)
-                                   + (bytes[position + 1] & 0x3f));
+        static WidenFunction selectWidenAscii() {
+#if defined(KIVM_STRINGS_AVX2)
+            __builtin_cpu_init();
+            if (__builtin_cpu_supports("avx2")) {
+                return widenAsciiAvx2;
+            }
+            return widenAsciiSse2;
+#elif defined(KIVM_STRINGS_SSE2)
+            return widenAsciiSse2;
+#else
+            return widenAsciiScalar;
+#endif
         }
 
-        static u2 getThirdType(const u1 *bytes, size_t length, int position) {
-            return static_cast<u2>(((bytes[position] & 0xf) << 12)
-                                   + ((bytes[position + 1] & 0x3f) << 6)
-                                   + (bytes[position + 2] & 0x3f));
+        /**
+         * Copy the ASCII characters at the start of {@code in}.
+         * @return how many were copied
+         */
+        static inline size_t widenAscii(const u1 *in, size_t length, wchar_t *out) {
+            static const WidenFunction widen = selectWidenAscii();
+            return widen(in, length, out);
         }
 
-        static u2 getForthType(const u1 *bytes, size_t length, int position) {
-            return static_cast<u2>(0x10000
-                                   + ((bytes[position + 1] & 0x0f) << 16)
-                                   + ((bytes[position + 2] & 0x3f) << 10)
-                                   + ((bytes[position + 4] & 0x0f) << 6)
-                                   + (bytes[position + 5] & 0x3f));
+        /**
+         * Copy the ASCII characters at the start of {@code in}.
+         * @return how many were copied
+         */
+        static size_t narrowAscii(const wchar_t *in, size_t length, char *out) {
+            size_t i = 0;
+#ifdef KIVM_STRINGS_SSE2
+            const __m128i zero = _mm_setzero_si128();
+            if (sizeof(wchar_t) == 2) {
+                const __m128i nonAscii = _mm_set1_epi16((short) 0xff80);
+                for (; i + 16 <= length; i += 16) {
+                    __m128i a = _mm_loadu_si128((const __m128i *) (in + i));
+                    __m128i b = _mm_loadu_si128((const __m128i *) (in + i + 8));
+                    __m128i high = _mm_and_si128(_mm_or_si128(a, b), nonAscii);
+                    if (_mm_movemask_epi8(_mm_cmpeq_epi16(high, zero)) != 0xffff) {
+                        break;
+                    }
+                    _mm_storeu_si128((__m128i *) (out + i), _mm_packus_epi16(a, b));
+                }
+            } else {
+                const __m128i nonAscii = _mm_set1_epi32(~0x7f);
+                for (; i + 16 <= length; i += 16) {
+                    __m128i a = _mm_loadu_si128((const __m128i *) (in + i));
+                    __m128i b = _mm_loadu_si128((const __m128i *) (in + i + 4));
+                    __m128i c = _mm_loadu_si128((const __m128i *) (in + i + 8));
+                    __m128i d = _mm_loadu_si128((const __m128i *) (in + i + 12));
+                    __m128i all = _mm_or_si128(_mm_or_si128(a, b), _mm_or_si128(c, d));
+                    if (_mm_movemask_epi8(_mm_cmpeq_epi32(_mm_and_si128(all, nonAscii), zero)) != 0xffff) {
+                        break;
+                    }
+                    __m128i low = _mm_packs_epi32(a, b);
+                    __m128i high = _mm_packs_epi32(c, d);
+                    _mm_storeu_si128((__m128i *) (out + i), _mm_packus_epi16(low, high));
+                }
+            }
+#endif
+            while (i < length && (u4) in[i] < 0x80) {
+                out[i] = (char) in[i];
+                ++i;
+            }
+            return i;
         }
 
-        String fromBytes(u1 *bytes, size_t length) {
-            std::vector<u2> buffer;
+        // bytes of a sequence by its first byte's high nibble, 0 if it starts none
+        static const u1 SEQUENCE_LENGTH[16] = {1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 2, 2, 3, 4};
 
-            for (int pos = 0; pos < length;) {
-                if (isFirstType(bytes, length, pos)) {
-                    buffer.push_back(getFirstType(bytes, length, pos));
-                    pos += 1;
+        /**
+         * Decode one character of two or more bytes at {@code in[0]}.
+         * $ 4.4.7: class files have no four byte form, characters outside the BMP
+         * come as two surrogates which are decoded one by one.
+         * Malformed bytes stand for themselves.
+         * @return bytes consumed
+         */
+        static inline size_t decodeSequence(const u1 *in, size_t length, bool modified, u4 *c) {
+            u1 first = in[0];
+            size_t n = SEQUENCE_LENGTH[first >> 4];
+            if (modified && n == 4) {
+                n = 0;
+            }
+            u4 continuation = 0;
+            for (size_t i = 1; i < n && i < length; ++i) {
+                continuation |= (u4) (in[i] & 0xc0) ^ 0x80u;
+            }
+            if (n == 0 || n > length || continuation != 0) {
+                *c = modified ? first : 0xfffd;
+                return 1;
+            }
 
-                } else if (isSecondType(bytes, length, pos)) {
-                    buffer.push_back(getSecondType(bytes, length, pos));
-                    pos += 2;
+            switch (n) {
+                case 2:
+                    *c = ((first & 0x1fu) << 6) | (in[1] & 0x3fu);
+                    break;
+                case 3:
+                    *c = ((first & 0x0fu) << 12) | ((in[1] & 0x3fu) << 6) | (in[2] & 0x3fu);
+                    break;
+                default:
+                    *c = ((first & 0x07u) << 18) | ((in[1] & 0x3fu) << 12)
+                         | ((in[2] & 0x3fu) << 6) | (in[3] & 0x3fu);
+                    break;
+            }
+            return n;
+        }
 
-                } else if (isThirdType(bytes, length, pos)) {
-                    buffer.push_back(getThirdType(bytes, length, pos));
-                    pos += 3;
+        /**
+         * @param modified whether {@code bytes} is modified UTF-8, as in class files
+         */
+        static String decode(const u1 *bytes, size_t length, bool modified) {
+            String result;
+            // never more characters than bytes
+            result.resize(length);
+            wchar_t *out = &result[0];
+            size_t count = 0;
 
-                } else if (isForthType(bytes, length, pos)) {
-                    buffer.push_back(getForthType(bytes, length, pos));
-                    pos += 6;
+            for (size_t pos = 0; pos < length;) {
+                size_t ascii = widenAscii(bytes + pos, length - pos, out + count);
+                pos += ascii;
+                count += ascii;
 
-                } else {
-                    // should never reach here
-                    assert(false);
+                while (pos < length && bytes[pos] >= 0x80) {
+                    u4 c;
+                    size_t n = decodeSequence(bytes + pos, length - pos, modified, &c);
+                    assert(!modified || n > 1);
+                    pos += n;
+                    if (sizeof(wchar_t) == 2 && c > 0xffff) {
+                        c -= 0x10000;
+                        out[count++] = (wchar_t) (0xd800 | (c >> 10));
+                        out[count++] = (wchar_t) (0xdc00 | (c & 0x3ff));
+                    } else {
+                        out[count++] = (wchar_t) c;
+                    }
                 }
             }
-            return String(buffer.begin(), buffer.end());
+
+            result.resize(count);
+            return result;
+        }
+
+        String fromBytes(const u1 *bytes, size_t length) {
+            return decode(bytes, length, true);
         }
 
         String fromStdString(const std::string &str) {
-            std::wstring_convert<std::codecvt_utf8<wchar_t >> convert;
-            return convert.from_bytes(str);
+            return decode((const u1 *) str.data(), str.size(), false);
         }
 
         std::string toStdString(const String &str) {
-            std::wstring_convert<std::codecvt_utf8<wchar_t>> convert;
-            return convert.to_bytes(str);
+            const wchar_t *in = str.data();
+            size_t length = str.size();
+
+            std::string result;
+            result.resize(length);
+            size_t count = narrowAscii(in, length, &result[0]);
+            if (count == length) {
+                return result;
+            }
+
+            // four bytes at most for each character left
+            result.resize(count + (length - count) * 4);
+            char *out = &result[0];
+            for (size_t pos = count; pos < length;) {
+                size_t ascii = narrowAscii(in + pos, length - pos, out + count);
+                pos += ascii;
+                count += ascii;
+
+                while (pos < length && (u4) in[pos] >= 0x80) {
+                    auto c = (u4) in[pos++];
+                    if (c >= 0xd800 && c <= 0xdbff && pos < length
+                        && (u4) in[pos] >= 0xdc00 && (u4) in[pos] <= 0xdfff) {
+                        c = 0x10000 + ((c - 0xd800) << 10) + ((u4) in[pos++] - 0xdc00);
+                    } else if (c > 0x10ffff) {
+                        c = 0xfffd;
+                    }
+
+                    if (c < 0x800) {
+                        out[count++] = (char) (0xc0 | (c >> 6));
+                    } else {
+                        if (c < 0x10000) {
+                            out[count++] = (char) (0xe0 | (c >> 12));
+                        } else {
+                            out[count++] = (char) (0xf0 | (c >> 18));
+                            out[count++] = (char) (0x80 | ((c >> 12) & 0x3f));
+                        }
+                        out[count++] = (char) (0x80 | ((c >> 6) & 0x3f));
+                    }
+                    out[count++] = (char) (0x80 | (c & 0x3f));
+                }
+            }
+
+            result.resize(count);
+            return result;
         }
 
         String replaceAll(const String &string, const String &oldValue, const String &newValue) {
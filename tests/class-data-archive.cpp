@@ -0,0 +1,149 @@
+//
+// Created by kiva on 2018/4/25.
+//
+
+#include <cassert>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <sys/stat.h>
+#include <kivm/classLoader.h>
+#include <kivm/classfile/classDataArchive.h>
+#include <kivm/classfile/classFileParser.h>
+#include <kivm/classfile/classPath.h>
+#include <kivm/oop/instanceKlass.h>
+#include <kivm/oop/instanceOop.h>
+#include "classFileBuilder.h"
+
+using namespace kivm;
+
+static const int N_CLASSES = 500;
+
+// class <name> extends <super> { long f0; ... }
+static std::vector<u1> makeClassFile(const std::string &name, const char *super, int fields) {
+    ClassFileBuilder builder(name, super);
+    int descriptor = builder.utf8("J");
+    for (int i = 0; i < fields; ++i) {
+        builder.addField(ACC_PUBLIC, builder.utf8("f" + std::to_string(i)), descriptor);
+    }
+    return builder.build();
+}
+
+static std::string className(int i) {
+    return "pkg" + std::to_string(i % 10) + "/C" + std::to_string(i);
+}
+
+/**
+ * Load all listed classes.
+ * @return microseconds taken
+ */
+static double loadAll(ClassPath &classPath, const std::vector<String> &classNames) {
+    auto start = std::chrono::steady_clock::now();
+    for (const auto &name : classNames) {
+        ClassFile *classFile = classPath.loadClassFile(name);
+        assert(classFile != nullptr);
+        ClassFileParser::dealloc(classFile);
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    return (double) std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count() / 1e3;
+}
+
+int main() {
+    std::string root = makeTemporaryDirectory("class-data-archive");
+    std::string classes = root + "/classes";
+    std::string archivePath = root + "/classes.jsa";
+    std::string listPath = root + "/classlist";
+    assert(mkdir(classes.c_str(), 0755) == 0);
+
+    writeClassFile(classes, "java/lang/Object", makeClassFile("java/lang/Object", nullptr, 0));
+    std::ofstream list(listPath);
+    list << "# bootstrap classes\njava/lang/Object\n\n";
+    for (int i = 0; i < N_CLASSES; ++i) {
+        writeClassFile(classes, className(i), makeClassFile(className(i), "java/lang/Object", i % 8));
+        list << className(i) << "\n";
+    }
+    list << "Missing\n";
+    list.close();
+
+    // the class list skips comments and empty lines
+    std::vector<String> classNames;
+    assert(ClassDataArchive::readClassList(listPath, &classNames));
+    assert(classNames.size() == N_CLASSES + 2);
+    assert(classNames.front() == L"java/lang/Object");
+    assert(!ClassDataArchive::readClassList(root + "/missing", &classNames));
+
+    // classes which are not found are left out
+    ClassPath classPath(classes);
+    assert(ClassDataArchive::dump(archivePath, &classPath, classNames));
+    classNames.pop_back();
+
+    // archives of another class path are ignored
+    assert(ClassDataArchive::open(archivePath, root) == nullptr);
+    assert(ClassDataArchive::open(listPath, classes) == nullptr);
+    assert(ClassDataArchive::open(root + "/missing.jsa", classes) == nullptr);
+
+    auto start = std::chrono::steady_clock::now();
+    ClassDataArchive *archive = ClassDataArchive::open(archivePath, classes);
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    double opening = (double) std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count() / 1e3;
+    assert(archive != nullptr);
+    assert(archive->getClassCount() == N_CLASSES + 1);
+    assert(archive->getStaleClassCount() == 0);
+    assert(archive->loadClassFile("Missing") == nullptr);
+
+    // archived classes are parsed in place
+    ClassFile *classFile = archive->loadClassFile(className(7));
+    assert(classFile != nullptr);
+    assert(archive->contains(classFile->content));
+    assert(classFile->fields_count == 7);
+    ClassFileParser::dealloc(classFile);
+
+    // without touching the class path entries
+    ClassPath directories(classes);
+    double fromDirectories = loadAll(directories, classNames);
+    ClassPath shared(classes);
+    shared.setArchive(archive);
+    double fromArchive = loadAll(shared, classNames);
+    assert(directories.getProbeCount() == N_CLASSES + 1);
+    assert(shared.getProbeCount() == 0);
+    assert(shared.getSharedHitCount() == N_CLASSES + 1);
+    printf("Loading %zd classes: %.0f us from directories, "
+           "%.0f us from the archive after %.0f us opening and checking it\n",
+           classNames.size(), fromDirectories, fromArchive, opening);
+
+    // classes missing from the archive still come from the entries
+    writeClassFile(classes, "Late", makeClassFile("Late", "java/lang/Object", 1));
+    shared.refresh();
+    classFile = shared.loadClassFile(L"Late");
+    assert(classFile != nullptr && !archive->contains(classFile->content));
+    ClassFileParser::dealloc(classFile);
+    assert(shared.getProbeCount() == 1);
+
+    // classes changed since the dump come from the entries too
+    writeClassFile(classes, className(42), makeClassFile(className(42), "java/lang/Object", 9));
+    ClassDataArchive *reopened = ClassDataArchive::open(archivePath, classes);
+    assert(reopened != nullptr);
+    assert(reopened->getClassCount() == N_CLASSES);
+    assert(reopened->getStaleClassCount() == 1);
+    ClassPath changed(classes);
+    changed.setArchive(reopened);
+    classFile = changed.loadClassFile(strings::fromStdString(className(42)));
+    assert(classFile != nullptr && !reopened->contains(classFile->content));
+    assert(classFile->fields_count == 9);
+    ClassFileParser::dealloc(classFile);
+    assert(changed.getSharedHitCount() == 0);
+
+    // the bootstrap class loader picks up the configured archive
+    setenv("KLASSPATH", classes.c_str(), 1);
+    setenv("KIVM_SHARED_ARCHIVE", archivePath.c_str(), 1);
+    auto *klass = (InstanceKlass *) BootstrapClassLoader::get()->loadClass(L"pkg3/C123");
+    assert(klass != nullptr);
+    assert(klass->getInstanceSize() == sizeof(instanceOopDesc) + 3 * sizeof(jlong));
+    assert(ClassPath::get()->getArchive() != nullptr);
+    assert(ClassPath::get()->getSharedHitCount() == 2);
+    assert(ClassPath::get()->getProbeCount() == 0);
+    return 0;
+}
@@ -0,0 +1,192 @@
+//
+// Created by kiva on 2018/4/25.
+//
+
+#include <cassert>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <malloc.h>
+#include <new>
+#include <kivm/classfile/classFileParser.h>
+#include "classFileBuilder.h"
+
+using namespace kivm;
+
+static size_t allocations = 0;
+
+void *operator new(size_t size) {
+    ++allocations;
+    void *p = malloc(size);
+    if (p == nullptr) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void *p) noexcept {
+    free(p);
+}
+
+static const int N_FIELDS = 12;
+static const int N_METHODS = 40;
+static const int N_CALLS = 8;
+static const int N_CLASSES = 1000;
+
+/**
+ * A class shaped like library classes: constants, fields with initial values,
+ * and methods with code, line numbers, local variables, stack maps and exceptions.
+ */
+static std::vector<u1> makeClassFile() {
+    ClassFileBuilder builder("lib/Shaped", "java/lang/Object", 52);
+    int exceptionIndex = builder.classRef("java/io/IOException");
+    builder.codeName();
+    int constantValueName = builder.utf8("ConstantValue");
+    int lineNumbersName = builder.utf8("LineNumberTable");
+    int localsName = builder.utf8("LocalVariableTable");
+    int stackMapName = builder.utf8("StackMapTable");
+    int exceptionsName = builder.utf8("Exceptions");
+    int sourceFileName = builder.utf8("SourceFile");
+    int sourceFile = builder.utf8("Shaped.java");
+    int thisName = builder.utf8("this");
+    int thisDescriptor = builder.utf8("Llib/Shaped;");
+
+    std::vector<int> methodrefs;
+    for (int i = 0; i < N_CALLS; ++i) {
+        methodrefs.push_back(builder.methodref(builder.getThisClass(), "m" + std::to_string(i), "(I)I"));
+    }
+
+    for (int i = 0; i < N_FIELDS; ++i) {
+        std::vector<u1> value;
+        put2(value, builder.integer(i));
+        builder.addField(ACC_PUBLIC | ACC_STATIC | ACC_FINAL, "F" + std::to_string(i), "I",
+                         {ClassFileBuilder::attribute(constantValueName, value)});
+    }
+
+    for (int i = 0; i < N_METHODS; ++i) {
+        // aload_0; iload_1; invokevirtual m<k>; ... ireturn
+        std::vector<u1> code;
+        for (int call = 0; call < N_CALLS; ++call) {
+            code.push_back(0x2a);
+            code.push_back(0x1b);
+            code.push_back(0xb6);
+            put2(code, methodrefs[(i + call) % N_CALLS]);
+            code.push_back(0x3c);
+        }
+        code.push_back(0x1b);
+        code.push_back(0xac);
+
+        std::vector<u1> lineNumbers;
+        put2(lineNumbers, N_CALLS);
+        for (int call = 0; call < N_CALLS; ++call) {
+            put2(lineNumbers, call * 6);
+            put2(lineNumbers, 10 + i * N_CALLS + call);
+        }
+
+        std::vector<u1> locals;
+        put2(locals, 1);
+        put2(locals, 0);
+        put2(locals, (int) code.size());
+        put2(locals, thisName);
+        put2(locals, thisDescriptor);
+        put2(locals, 0);
+
+        // same_frame, then append_frame with one int
+        std::vector<u1> stackMap;
+        put2(stackMap, 2);
+        stackMap.push_back(6);
+        stackMap.push_back(252);
+        put2(stackMap, 5);
+        stackMap.push_back(ITEM_Integer);
+
+        std::vector<u1> handler;
+        put2(handler, 0);
+        put2(handler, (int) code.size() - 2);
+        put2(handler, (int) code.size() - 2);
+        put2(handler, exceptionIndex);
+
+        std::vector<u1> exceptions;
+        put2(exceptions, 1);
+        put2(exceptions, exceptionIndex);
+
+        builder.addMethod(ACC_PUBLIC, "m" + std::to_string(i), "(I)I", {
+            builder.code(3, 2, code, {
+                ClassFileBuilder::attribute(lineNumbersName, lineNumbers),
+                ClassFileBuilder::attribute(localsName, locals),
+                ClassFileBuilder::attribute(stackMapName, stackMap),
+            }, handler),
+            ClassFileBuilder::attribute(exceptionsName, exceptions),
+        });
+    }
+
+    std::vector<u1> source;
+    put2(source, sourceFile);
+    builder.addAttribute(ClassFileBuilder::attribute(sourceFileName, source));
+    return builder.build();
+}
+
+static size_t mallocInUse() {
+    return mallinfo2().uordblks;
+}
+
+static ClassFile *parse(std::vector<u1> &bytes) {
+    ClassFileParser parser("Shaped.class", bytes.data(), bytes.size(), nullptr);
+    return parser.getParsedClassFile();
+}
+
+int main() {
+    std::vector<u1> bytes = makeClassFile();
+
+    // the parsed representation is complete
+    ClassFile *classFile = parse(bytes);
+    assert(classFile != nullptr);
+    assert(classFile->fields_count == N_FIELDS && classFile->methods_count == N_METHODS);
+    method_info &method = classFile->methods[N_METHODS - 1];
+    assert(method.attributes_count == 2);
+    auto *code = (Code_attribute *) method.attributes[0];
+    assert(code->code_length == N_CALLS * 6 + 2);
+    assert(code->exception_table_length == 1);
+    assert(code->attributes_count == 3);
+    auto *lineNumbers = (LineNumberTable_attribute *) code->attributes[0];
+    assert(lineNumbers->line_number_table_length == N_CALLS);
+    assert(lineNumbers->line_number_table[N_CALLS - 1].line_number == 10 + N_METHODS * N_CALLS - 1);
+    auto *exceptions = (Exceptions_attribute *) method.attributes[1];
+    assert(exceptions->number_of_exceptions == 1);
+
+    // all of it lives in a chunk or two of its arena
+    ClassFileArena *arena = classFile->arena;
+    assert(arena->getUsed() > bytes.size() && arena->getUsed() <= arena->getReserved());
+    assert(arena->getReserved() <= 2 * (arena->getUsed() + bytes.size()));
+    printf("arena: %zd bytes used, %zd bytes reserved\n", arena->getUsed(), arena->getReserved());
+    ClassFileParser::dealloc(classFile);
+
+    // parsed class files kept alive at once, like loaded classes
+    std::vector<ClassFile *> classFiles;
+    classFiles.reserve(N_CLASSES);
+    size_t allocationsBefore = allocations;
+    size_t before = mallocInUse();
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < N_CLASSES; ++i) {
+        classFiles.push_back(parse(bytes));
+    }
+    auto parsed = std::chrono::steady_clock::now();
+    size_t used = mallocInUse() - before;
+    size_t allocated = allocations - allocationsBefore;
+    // what is left decodes the few distinct attribute names
+    assert(allocated < 100 * N_CLASSES);
+    for (ClassFile *each : classFiles) {
+        ClassFileParser::dealloc(each);
+    }
+    auto released = std::chrono::steady_clock::now();
+
+    using std::chrono::duration_cast;
+    using std::chrono::nanoseconds;
+    printf("%zd byte class file: parse %.1f us, release %.1f us, "
+           "%zd allocations and %zd bytes of memory per class\n",
+           bytes.size(),
+           (double) duration_cast<nanoseconds>(parsed - start).count() / 1e3 / N_CLASSES,
+           (double) duration_cast<nanoseconds>(released - parsed).count() / 1e3 / N_CLASSES,
+           allocated / N_CLASSES, used / N_CLASSES);
+    return 0;
+}
@@ -0,0 +1,70 @@
+//
+// Created by kiva on 2018/4/25.
+//
+
+#include <cassert>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <kivm/classfile/classFileParser.h>
+#include "classFileBuilder.h"
+
+using namespace kivm;
+
+static const u1 CODE[] = {0x03, 0xac}; // iconst_0; ireturn
+
+// class Mapped { static int zero() { return 0; } }
+static std::vector<u1> makeClassFile() {
+    ClassFileBuilder builder("Mapped");
+    builder.addMethod(ACC_STATIC, "zero", "()I",
+                      {builder.code(1, 0, std::vector<u1>(CODE, CODE + sizeof(CODE)))});
+    return builder.build();
+}
+
+static bool isInside(const ClassFile *classFile, const u1 *p, size_t length) {
+    return p >= classFile->content && p + length <= classFile->content + classFile->content_length;
+}
+
+int main() {
+    std::string root = makeTemporaryDirectory("class-file-mapping");
+
+    std::vector<u1> bytes = makeClassFile();
+    writeFile(root + "/Mapped.class", bytes);
+    writeFile(root + "/Empty.class", {});
+
+    ClassFile *classFile = nullptr;
+    {
+        ClassFileParser parser((root + "/Mapped.class").c_str());
+        classFile = parser.getParsedClassFile();
+        assert(classFile != nullptr);
+        assert(parser.getParsedClassFile() == classFile);
+    }
+
+    // the class file outlives its parser
+    assert(classFile->content != nullptr);
+    assert(classFile->content_length == bytes.size());
+    assert(memcmp(classFile->content, bytes.data(), bytes.size()) == 0);
+
+    // UTF-8 constants are not copied
+    auto *name = (CONSTANT_Utf8_info *) classFile->constant_pool[1];
+    assert(name->tag == CONSTANT_Utf8);
+    assert(isInside(classFile, name->bytes, name->length));
+    assert(name->get_constant() == L"Mapped");
+
+    // neither is bytecode
+    assert(classFile->methods_count == 1);
+    method_info &method = classFile->methods[0];
+    assert(method.attributes_count == 1);
+    auto *code = (Code_attribute *) method.attributes[0];
+    assert(code->code_length == sizeof(CODE));
+    assert(isInside(classFile, code->code, code->code_length));
+    assert(memcmp(code->code, CODE, sizeof(CODE)) == 0);
+    ClassFileParser::dealloc(classFile);
+
+    // missing and empty files are no class files
+    ClassFileParser missing((root + "/Missing.class").c_str());
+    assert(missing.getParsedClassFile() == nullptr);
+    ClassFileParser empty((root + "/Empty.class").c_str());
+    assert(empty.getParsedClassFile() == nullptr);
+    return 0;
+}
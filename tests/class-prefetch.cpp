@@ -0,0 +1,112 @@
+//
+// Created by kiva on 2018/4/25.
+//
+
+#include <cassert>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <kivm/classLoader.h>
+#include <kivm/classfile/classFileParser.h>
+#include <kivm/classfile/classPath.h>
+#include <kivm/classfile/classPrefetcher.h>
+#include <kivm/oop/instanceKlass.h>
+#include <kivm/runtime/runtimeConfig.h>
+#include "classFileBuilder.h"
+
+using namespace kivm;
+
+// class <name> extends <super> implements <interfaces>, referring to <references>
+static std::vector<u1> makeClassFile(const std::string &name, const char *super,
+                                     const std::vector<std::string> &interfaces,
+                                     const std::vector<std::string> &references) {
+    ClassFileBuilder builder(name, super);
+    for (const auto &reference : references) {
+        builder.classRef(reference);
+    }
+    for (const auto &interface : interfaces) {
+        builder.addInterface(interface);
+    }
+    return builder.build();
+}
+
+static std::string writeClassFiles() {
+    std::string root = makeTemporaryDirectory("class-prefetch");
+    writeClassFile(root, "java/lang/Object", makeClassFile("java/lang/Object", nullptr, {}, {}));
+    writeClassFile(root, "app/Main", makeClassFile("app/Main", "app/Base", {"app/Runnable"},
+                                                   {"app/Helper", "[[Lapp/Other;", "[I"}));
+    writeClassFile(root, "app/Base", makeClassFile("app/Base", "java/lang/Object", {}, {}));
+    writeClassFile(root, "app/Runnable", makeClassFile("app/Runnable", "java/lang/Object", {}, {}));
+    writeClassFile(root, "app/Helper", makeClassFile("app/Helper", "app/HelperBase", {}, {"app/Deep"}));
+    writeClassFile(root, "app/HelperBase", makeClassFile("app/HelperBase", "java/lang/Object", {}, {}));
+    writeClassFile(root, "app/Other", makeClassFile("app/Other", "java/lang/Object", {}, {}));
+    writeClassFile(root, "app/Deep", makeClassFile("app/Deep", "java/lang/Object", {}, {}));
+    return root;
+}
+
+static bool isStaged(ClassPrefetcher &prefetcher, const String &className) {
+    bool parsed = false;
+    ClassFile *classFile = prefetcher.take(className, &parsed);
+    if (classFile != nullptr) {
+        ClassFileParser::dealloc(classFile);
+    }
+    return parsed && classFile != nullptr;
+}
+
+int main() {
+    std::string root = writeClassFiles();
+
+    {
+        ClassPath classPath(root);
+        ClassPrefetcher prefetcher(&classPath, 2);
+
+        // a listed class brings its supers and the classes it refers to,
+        // those bring their supers only
+        prefetcher.prefetch({L"app/Main"});
+        prefetcher.drain();
+        assert(classPath.getLookupCount() == 7);
+        assert(isStaged(prefetcher, L"app/Main"));
+        assert(isStaged(prefetcher, L"app/Base"));
+        assert(isStaged(prefetcher, L"app/Runnable"));
+        assert(isStaged(prefetcher, L"app/Other"));
+        assert(isStaged(prefetcher, L"app/HelperBase"));
+        assert(prefetcher.getHitCount() == 5);
+
+        // references of a speculatively parsed class are followed once it is loaded
+        bool parsed = false;
+        ClassFile *helper = prefetcher.take(L"app/Helper", &parsed);
+        assert(parsed && helper != nullptr);
+        prefetcher.prefetchReferences(helper);
+        ClassFileParser::dealloc(helper);
+        prefetcher.drain();
+        assert(classPath.getLookupCount() == 8);
+        assert(isStaged(prefetcher, L"app/Deep"));
+
+        // classes parsed ahead are handed out once, missing ones are not looked up again
+        assert(!isStaged(prefetcher, L"app/Main"));
+        prefetcher.prefetch({L"app/Missing"});
+        prefetcher.drain();
+        assert(prefetcher.take(L"app/Missing", &parsed) == nullptr && parsed);
+        assert(classPath.getLookupCount() == 9);
+        assert(prefetcher.getMissCount() == 1);
+        prefetcher.printStatistics();
+
+        // whatever is left staged goes with the prefetcher
+        prefetcher.prefetch({L"java/lang/Object"});
+    }
+
+    // the class loader takes parsed class files from the prefetcher
+    setenv("KLASSPATH", root.c_str(), 1);
+    RuntimeConfig::get().prefetchClasses = true;
+    auto *main = (InstanceKlass *) BootstrapClassLoader::get()->loadClass(L"app/Main");
+    assert(main != nullptr);
+    assert(main->getSuperClass() == BootstrapClassLoader::get()->loadClass(L"app/Base"));
+    assert(main->getInterface(L"app/Runnable") != nullptr);
+
+    ClassPrefetcher *prefetcher = ClassPrefetcher::get();
+    assert(prefetcher != nullptr);
+    // Main, Base, Runnable and Object
+    assert(prefetcher->getHitCount() + prefetcher->getWaitCount() + prefetcher->getMissCount() == 4);
+    assert(ClassPath::get()->getMissCount() == 0);
+    return 0;
+}
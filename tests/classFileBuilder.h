@@ -0,0 +1,260 @@
+//
+// Created by kiva on 2018/4/25.
+//
+#pragma once
+
+#include <kivm/kivm.h>
+#include <kivm/classfile/constantPool.h>
+#include <cassert>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <sys/stat.h>
+
+// Class files and class paths made up by the tests.
+
+inline void put2(std::vector<u1> &out, int value) {
+    out.push_back((u1) (value >> 8));
+    out.push_back((u1) value);
+}
+
+inline void put4(std::vector<u1> &out, int value) {
+    put2(out, value >> 16);
+    put2(out, value);
+}
+
+/**
+ * Builds a class file: constants are appended in call order
+ * and their indexes returned, so that code may refer to them.
+ */
+class ClassFileBuilder {
+private:
+    std::vector<u1> _pool;
+    int _count;
+    int _major;
+    int _thisClass;
+    int _superClass;
+    int _codeName;
+    std::vector<int> _interfaces;
+    std::vector<u1> _fields;
+    int _fieldCount;
+    std::vector<u1> _methods;
+    int _methodCount;
+    std::vector<std::vector<u1>> _attributes;
+
+    static void putMember(std::vector<u1> &out, int access, int name, int descriptor,
+                          const std::vector<std::vector<u1>> &attributes) {
+        put2(out, access);
+        put2(out, name);
+        put2(out, descriptor);
+        put2(out, (int) attributes.size());
+        for (const auto &attribute : attributes) {
+            out.insert(out.end(), attribute.begin(), attribute.end());
+        }
+    }
+
+public:
+    /**
+     * Starts {@code class <name> extends <super>}, the two being the first constants.
+     * @param super {@code nullptr} for java/lang/Object itself
+     */
+    explicit ClassFileBuilder(const std::string &name, const char *super = nullptr, int major = 50)
+        : _count(1), _major(major), _superClass(0), _codeName(0), _fieldCount(0), _methodCount(0) {
+        _thisClass = classRef(name);
+        if (super != nullptr) {
+            _superClass = classRef(super);
+        }
+    }
+
+    inline int getThisClass() const {
+        return _thisClass;
+    }
+
+    int utf8(const std::string &value) {
+        _pool.push_back(CONSTANT_Utf8);
+        put2(_pool, (int) value.size());
+        _pool.insert(_pool.end(), value.begin(), value.end());
+        return _count++;
+    }
+
+    int classRef(const std::string &name) {
+        int nameIndex = utf8(name);
+        _pool.push_back(CONSTANT_Class);
+        put2(_pool, nameIndex);
+        return _count++;
+    }
+
+    int integer(int value) {
+        _pool.push_back(CONSTANT_Integer);
+        put4(_pool, value);
+        return _count++;
+    }
+
+    int longConstant(long long value) {
+        _pool.push_back(CONSTANT_Long);
+        put4(_pool, (int) (value >> 32));
+        put4(_pool, (int) value);
+        int index = _count;
+        _count += 2;
+        return index;
+    }
+
+    int nameAndType(int name, int descriptor) {
+        _pool.push_back(CONSTANT_NameAndType);
+        put2(_pool, name);
+        put2(_pool, descriptor);
+        return _count++;
+    }
+
+    int methodref(int classIndex, int nameAndTypeIndex) {
+        _pool.push_back(CONSTANT_Methodref);
+        put2(_pool, classIndex);
+        put2(_pool, nameAndTypeIndex);
+        return _count++;
+    }
+
+    int methodref(int classIndex, const std::string &name, const std::string &descriptor) {
+        int nameIndex = utf8(name);
+        return methodref(classIndex, nameAndType(nameIndex, utf8(descriptor)));
+    }
+
+    /**
+     * @return the {@code "Code"} constant, added on first use
+     */
+    int codeName() {
+        if (_codeName == 0) {
+            _codeName = utf8("Code");
+        }
+        return _codeName;
+    }
+
+    /**
+     * @return an attribute named by the constant {@code name}
+     */
+    static std::vector<u1> attribute(int name, const std::vector<u1> &body) {
+        std::vector<u1> out;
+        put2(out, name);
+        put4(out, (int) body.size());
+        out.insert(out.end(), body.begin(), body.end());
+        return out;
+    }
+
+    /**
+     * @param exceptionTable entries of 8 bytes each
+     * @return a Code attribute
+     */
+    std::vector<u1> code(int maxStack, int maxLocals, const std::vector<u1> &bytecode,
+                         const std::vector<std::vector<u1>> &attributes = {},
+                         const std::vector<u1> &exceptionTable = {}) {
+        std::vector<u1> body;
+        put2(body, maxStack);
+        put2(body, maxLocals);
+        put4(body, (int) bytecode.size());
+        body.insert(body.end(), bytecode.begin(), bytecode.end());
+        put2(body, (int) exceptionTable.size() / 8);
+        body.insert(body.end(), exceptionTable.begin(), exceptionTable.end());
+        put2(body, (int) attributes.size());
+        for (const auto &attribute : attributes) {
+            body.insert(body.end(), attribute.begin(), attribute.end());
+        }
+        return attribute(codeName(), body);
+    }
+
+    void addInterface(const std::string &name) {
+        _interfaces.push_back(classRef(name));
+    }
+
+    void addField(int access, int name, int descriptor,
+                  const std::vector<std::vector<u1>> &attributes = {}) {
+        putMember(_fields, access, name, descriptor, attributes);
+        ++_fieldCount;
+    }
+
+    void addField(int access, const std::string &name, const std::string &descriptor,
+                  const std::vector<std::vector<u1>> &attributes = {}) {
+        int nameIndex = utf8(name);
+        addField(access, nameIndex, utf8(descriptor), attributes);
+    }
+
+    void addMethod(int access, int name, int descriptor,
+                   const std::vector<std::vector<u1>> &attributes = {}) {
+        putMember(_methods, access, name, descriptor, attributes);
+        ++_methodCount;
+    }
+
+    void addMethod(int access, const std::string &name, const std::string &descriptor,
+                   const std::vector<std::vector<u1>> &attributes = {}) {
+        int nameIndex = utf8(name);
+        addMethod(access, nameIndex, utf8(descriptor), attributes);
+    }
+
+    void addAttribute(const std::vector<u1> &attribute) {
+        _attributes.push_back(attribute);
+    }
+
+    std::vector<u1> build(int access = ACC_PUBLIC | ACC_SUPER) const {
+        std::vector<u1> out;
+        put4(out, (int) 0xCAFEBABE);
+        put2(out, 0);
+        put2(out, _major);
+        put2(out, _count);
+        out.insert(out.end(), _pool.begin(), _pool.end());
+
+        put2(out, access);
+        put2(out, _thisClass);
+        put2(out, _superClass);
+        put2(out, (int) _interfaces.size());
+        for (int index : _interfaces) {
+            put2(out, index);
+        }
+        put2(out, _fieldCount);
+        out.insert(out.end(), _fields.begin(), _fields.end());
+        put2(out, _methodCount);
+        out.insert(out.end(), _methods.begin(), _methods.end());
+        put2(out, (int) _attributes.size());
+        for (const auto &attribute : _attributes) {
+            out.insert(out.end(), attribute.begin(), attribute.end());
+        }
+        return out;
+    }
+};
+
+inline void writeFile(const std::string &path, const std::vector<u1> &bytes) {
+    FILE *file = fopen(path.c_str(), "wb");
+    assert(file != nullptr);
+    fwrite(bytes.data(), 1, bytes.size(), file);
+    fclose(file);
+}
+
+/**
+ * Write {@code <root>/<name>.class}, creating the directories of its package.
+ */
+inline void writeClassFile(const std::string &root, const std::string &name,
+                           const std::vector<u1> &bytes) {
+    for (size_t slash = name.find('/'); slash != std::string::npos; slash = name.find('/', slash + 1)) {
+        mkdir((root + "/" + name.substr(0, slash)).c_str(), 0755);
+    }
+    writeFile(root + "/" + name + ".class", bytes);
+}
+
+/**
+ * @return a new directory {@code /tmp/kivm-<name>-XXXXXX}
+ */
+inline std::string makeTemporaryDirectory(const std::string &name) {
+    std::string pattern = "/tmp/kivm-" + name + "-XXXXXX";
+    std::vector<char> path(pattern.begin(), pattern.end());
+    path.push_back('\0');
+    char *created = mkdtemp(path.data());
+    assert(created != nullptr);
+    return created;
+}
+
+/**
+ * @return a new temporary directory, made the class path of the VM
+ */
+inline std::string makeClassPath(const std::string &name) {
+    std::string root = makeTemporaryDirectory(name);
+    setenv("KLASSPATH", root.c_str(), 1);
+    return root;
+}
@@ -0,0 +1,85 @@
+//
+// Created by kiva on 2018/4/25.
+//
+
+#include <cassert>
+#include <string>
+#include <vector>
+#include <sys/stat.h>
+#include <kivm/classfile/classFileParser.h>
+#include <kivm/classfile/classPath.h>
+#include <kivm/runtime/runtimeConfig.h>
+#include "classFileBuilder.h"
+
+using namespace kivm;
+
+static void writeClassFile(const std::string &root, const std::string &name) {
+    // class <name> {}
+    writeClassFile(root, name, ClassFileBuilder(name).build());
+}
+
+static std::string makeDirectory(const std::string &path) {
+    assert(mkdir(path.c_str(), 0755) == 0);
+    return path;
+}
+
+static bool load(ClassPath &classPath, const String &className) {
+    ClassFile *classFile = classPath.loadClassFile(className);
+    if (classFile == nullptr) {
+        return false;
+    }
+    ClassFileParser::dealloc(classFile);
+    return true;
+}
+
+int main() {
+    std::string root = makeTemporaryDirectory("classpath-index");
+    std::string first = makeDirectory(root + "/first");
+    std::string second = makeDirectory(root + "/second");
+    writeClassFile(first, "pkg/A");
+    writeClassFile(first, "B");
+    writeClassFile(second, "pkg/C");
+    writeClassFile(second, "deep/er/D");
+
+    // packages are found once, at startup
+    ClassPath classPath(first + ":" + second + ":" + root + "/missing");
+    assert(classPath.getEntryCount() == 2);
+    assert(classPath.getPackageCount() == 3);
+    assert(classPath.getProbeCount() == 0);
+
+    // only entries which have the package are tried
+    assert(load(classPath, L"deep/er/D"));
+    assert(classPath.getProbeCount() == 1);
+    assert(load(classPath, L"pkg/C"));
+    assert(classPath.getProbeCount() == 3);
+    assert(load(classPath, L"B"));
+    assert(classPath.getProbeCount() == 4);
+
+    // unknown packages cost no file access at all
+    assert(!load(classPath, L"none/X"));
+    assert(!load(classPath, L"deep/X"));
+    assert(classPath.getProbeCount() == 4);
+    assert(classPath.getLookupCount() == 5);
+    assert(classPath.getMissCount() == 2);
+    assert(RuntimeConfig::get().parseOption("-XX:+PrintClassPathStatistics"));
+    classPath.printStatistics();
+
+    // an unwatched class path sees new classes after a refresh only
+    writeClassFile(second, "late/E");
+    assert(!load(classPath, L"late/E"));
+    classPath.refresh();
+    assert(classPath.getPackageCount() == 4);
+    assert(load(classPath, L"late/E"));
+
+#if defined(__linux__)
+    // a watched one rebuilds its index when a lookup misses after a change
+    ClassPath watched(first, true);
+    assert(!load(watched, L"fresh/F"));
+    writeClassFile(first, "fresh/F");
+    assert(load(watched, L"fresh/F"));
+    writeClassFile(first, "fresh/G");
+    assert(load(watched, L"fresh/G"));
+    assert(watched.getMissCount() == 1);
+#endif
+    return 0;
+}
@@ -0,0 +1,137 @@
+//
+// Created by kiva on 2018/4/25.
+//
+
+#include <cassert>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <kivm/classLoader.h>
+#include <kivm/memory/heap.h>
+#include <kivm/oop/arrayKlass.h>
+#include <kivm/oop/arrayOop.h>
+#include <kivm/oop/instanceKlass.h>
+#include <kivm/oop/instanceOop.h>
+#include <kivm/oop/primitiveOop.h>
+#include <kivm/runtime/runtimeConfig.h>
+#include "classFileBuilder.h"
+
+using namespace kivm;
+
+static const int N_NODES = 64;
+static const int N_GARBAGE = 16;
+
+struct FieldDecl {
+    const char *name;
+    const char *descriptor;
+    int access;
+};
+
+// class Node { Object key; Object value; Node next; int hash; static Node HEAD; }
+static const std::vector<FieldDecl> NODE_FIELDS = {
+    {"hash", "I", 0}, {"key", "Ljava/lang/Object;", 0}, {"value", "Ljava/lang/Object;", 0},
+    {"next", "LNode;", 0}, {"HEAD", "LNode;", ACC_STATIC},
+};
+
+static std::vector<u1> makeClassFile(const char *name, const char *super,
+                                     const std::vector<FieldDecl> &fields) {
+    ClassFileBuilder builder(name, super);
+    for (const auto &field : fields) {
+        builder.addField(ACC_PUBLIC | field.access, field.name, field.descriptor);
+    }
+    return builder.build();
+}
+
+static void writeClassFiles() {
+    std::string root = makeClassPath("compressed-oops");
+    writeClassFile(root, "java/lang/Object", makeClassFile("java/lang/Object", nullptr, {}));
+    writeClassFile(root, "Node", makeClassFile("Node", "java/lang/Object", NODE_FIELDS));
+}
+
+static int offsetOf(InstanceKlass *klass, const String &name, const String &descriptor) {
+    FieldID *id = klass->getInstanceFieldInfo(L"Node", name, descriptor);
+    assert(id != nullptr);
+    return id->_offset;
+}
+
+int main() {
+    // must be chosen before the first class is allocated
+    RuntimeConfig::get().useCompressedOops = true;
+    RuntimeConfig::get().useCompressedClassPointers = true;
+
+    writeClassFiles();
+    auto *object = (InstanceKlass *) BootstrapClassLoader::get()->loadClass(L"java/lang/Object");
+    auto *node = (InstanceKlass *) BootstrapClassLoader::get()->loadClass(L"Node");
+    assert(object != nullptr && node != nullptr);
+    Heap *heap = Heap::get();
+
+    assert(CompressedOops::useCompressedOops());
+    assert(CompressedOops::useCompressedClassPointers());
+    assert(CompressedOops::getReferenceSize() == sizeof(narrowOop));
+    assert(oopDesc::getHeaderSize() == 12);
+
+    // references take 4 bytes, the first field shares the class pointer's word
+    int key = offsetOf(node, L"key", L"Ljava/lang/Object;");
+    int value = offsetOf(node, L"value", L"Ljava/lang/Object;");
+    int next = offsetOf(node, L"next", L"LNode;");
+    int hash = offsetOf(node, L"hash", L"I");
+    assert(key == 12 && value == 16 && next == 20 && hash == 24);
+    assert(node->getInstanceSize() == 28);
+    size_t used = heap->getUsed();
+    instanceOop probe = node->newInstance();
+    assert(heap->getUsed() - used == HeapBlock::blockSizeFor(28));
+    assert(probe->getClass() == node);
+    assert(CompressedOops::decode(CompressedOops::encode(probe)) == probe);
+    assert(CompressedOops::encode(nullptr) == 0);
+
+    // elements are 4 bytes, after a length packed into the header
+    auto *nodeArrayKlass = new ObjectArrayKlass(nullptr, nullptr, 1, node);
+    assert(nodeArrayKlass->getElementSize() == sizeof(narrowOop));
+    assert(arrayOopDesc::getBaseOffset() == 16);
+    used = heap->getUsed();
+    auto nodes = (objectArrayOop) nodeArrayKlass->newInstance(N_NODES);
+    assert(heap->getUsed() - used == HeapBlock::blockSizeFor(16 + N_NODES * sizeof(narrowOop)));
+    assert(nodes->getLength() == N_NODES);
+    assert(nodes->getClass() == nodeArrayKlass);
+
+    // a list interleaved with garbage, reachable from a static field and the array
+    instanceOop tail = nullptr;
+    std::vector<uintptr_t> addresses;
+    for (int i = N_NODES - 1; i >= 0; --i) {
+        for (int j = 0; j < N_GARBAGE; ++j) {
+            new intOopDesc(-1);
+        }
+        instanceOop current = node->newInstance();
+        current->setFieldAt<jint>(hash, i);
+        current->setFieldAt<oop>(key, object->newInstance());
+        current->setFieldAt<oop>(next, tail);
+        nodes->setElementAt(i, current);
+        addresses.push_back((uintptr_t) current);
+        tail = current;
+    }
+    node->setStaticFieldAt<oop>(node->getStaticFieldOffset(L"Node", L"HEAD", L"LNode;"), tail);
+    tail = nullptr;
+    heap->collect();
+
+    // narrow slots were rewritten when their referents moved
+    auto head = (instanceOop) node->getStaticFieldAt<oop>(
+        node->getStaticFieldOffset(L"Node", L"HEAD", L"LNode;"));
+    int moved = 0;
+    int i = 0;
+    for (instanceOop current = head; current != nullptr;
+         current = (instanceOop) current->getFieldAt<oop>(next), ++i) {
+        assert(heap->contains(current));
+        assert(current->getClass() == node);
+        assert(current->getFieldAt<jint>(hash) == i);
+        assert(nodes->getElementAt(i) == current);
+        auto referent = (instanceOop) current->getFieldAt<oop>(key);
+        assert(heap->contains(referent) && referent->getClass() == object);
+        assert(current->getFieldAt<oop>(value) == nullptr);
+        if ((uintptr_t) current != addresses[N_NODES - 1 - i]) {
+            ++moved;
+        }
+    }
+    assert(i == N_NODES);
+    assert(moved > 0);
+    return 0;
+}
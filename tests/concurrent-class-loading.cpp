@@ -0,0 +1,134 @@
+//
+// Created by kiva on 2018/4/25.
+//
+
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+#include <kivm/classLoader.h>
+#include <kivm/system.h>
+#include <kivm/classfile/classPath.h>
+#include <kivm/oop/instanceKlass.h>
+#include "classFileBuilder.h"
+
+using namespace kivm;
+
+static const int N_THREADS = 8;
+static const int N_CHAINS = 40;
+static const int CHAIN_LENGTH = 5;
+static const int N_PAIRS = 100;
+static const int N_FINDS = 200000;
+
+// class <name> extends <super> { <type> f0; ... }
+static std::vector<u1> makeClassFile(const std::string &name, const char *super,
+                                     const std::vector<std::string> &fieldTypes) {
+    ClassFileBuilder builder(name, super);
+    for (size_t i = 0; i < fieldTypes.size(); ++i) {
+        builder.addField(ACC_PUBLIC, "f" + std::to_string(i), fieldTypes[i]);
+    }
+    return builder.build();
+}
+
+static std::string chainClass(int chain, int depth) {
+    return "chain" + std::to_string(chain) + "/C" + std::to_string(depth);
+}
+
+static std::string pairClass(int pair, char side) {
+    return std::string("pair/P") + std::to_string(pair) + side;
+}
+
+/**
+ * Chains of subclasses, each class with a field of its own type and an array of it,
+ * and pairs of classes with fields of each other's type.
+ * @return names of all classes
+ */
+static std::vector<String> writeClassFiles() {
+    std::string root = makeClassPath("concurrent-class-loading");
+
+    std::vector<String> classNames;
+    writeClassFile(root, "java/lang/Object", makeClassFile("java/lang/Object", nullptr, {}));
+    for (int chain = 0; chain < N_CHAINS; ++chain) {
+        for (int depth = 0; depth < CHAIN_LENGTH; ++depth) {
+            const std::string &name = chainClass(chain, depth);
+            const std::string &super = depth == 0 ? "java/lang/Object" : chainClass(chain, depth - 1);
+            writeClassFile(root, name, makeClassFile(name, super.c_str(),
+                                                     {"L" + name + ";", "[L" + name + ";", "J"}));
+            classNames.push_back(strings::fromStdString(name));
+        }
+    }
+    for (int pair = 0; pair < N_PAIRS; ++pair) {
+        const std::string &a = pairClass(pair, 'A');
+        const std::string &b = pairClass(pair, 'B');
+        writeClassFile(root, a, makeClassFile(a, "java/lang/Object", {"L" + b + ";"}));
+        writeClassFile(root, b, makeClassFile(b, "java/lang/Object", {"L" + a + ";"}));
+        classNames.push_back(strings::fromStdString(a));
+        classNames.push_back(strings::fromStdString(b));
+    }
+    return classNames;
+}
+
+int main() {
+    std::vector<String> classNames = writeClassFiles();
+    size_t n = classNames.size();
+
+    // every thread loads every class, each starting somewhere else;
+    // pair classes are loaded from both ends at once
+    std::vector<std::vector<Klass *>> loaded(N_THREADS, std::vector<Klass *>(n));
+    std::atomic<int> ready(0);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < N_THREADS; ++t) {
+        threads.emplace_back([&, t] {
+            ++ready;
+            while (ready < N_THREADS) {
+                std::this_thread::yield();
+            }
+            for (size_t i = 0; i < n; ++i) {
+                size_t index = t % 2 == 0 ? (i + t * n / N_THREADS) % n : n - 1 - i;
+                loaded[t][index] = BootstrapClassLoader::get()->loadClass(classNames[index]);
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    // all threads got the same classes, each linked and parsed once
+    for (size_t i = 0; i < n; ++i) {
+        Klass *klass = SystemDictionary::get()->find(classNames[i]);
+        assert(klass != nullptr);
+        assert(klass->getClassState() == ClassState::LINKED);
+        for (int t = 0; t < N_THREADS; ++t) {
+            assert(loaded[t][i] == klass);
+        }
+    }
+    assert(ClassPath::get()->getLookupCount() == n + 1);
+    assert(ClassPath::get()->getMissCount() == 0);
+
+    auto *deepest = (InstanceKlass *) SystemDictionary::get()->find(L"chain7/C4");
+    assert(deepest->getSuperClass() == SystemDictionary::get()->find(L"chain7/C3"));
+    assert(SystemDictionary::get()->find(L"[Lchain7/C4;") != nullptr);
+    assert(SystemDictionary::get()->getSize() == n + 1 + N_CHAINS * CHAIN_LENGTH);
+
+    // lookups of loaded classes take no lock
+    auto start = std::chrono::steady_clock::now();
+    threads.clear();
+    for (int t = 0; t < N_THREADS; ++t) {
+        threads.emplace_back([&, t] {
+            for (int i = 0; i < N_FINDS; ++i) {
+                const String &name = classNames[(i + t) % n];
+                assert(BootstrapClassLoader::get()->loadClass(name) != nullptr);
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    printf("%d threads looking up loaded classes: %.1f ns per lookup\n", N_THREADS,
+           (double) std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count() / N_FINDS / N_THREADS);
+    return 0;
+}
@@ -0,0 +1,180 @@
+//
+// Created by kiva on 2018/4/24.
+//
+
+#include <cassert>
+#include <string>
+#include <vector>
+#include <kivm/classLoader.h>
+#include <kivm/memory/heap.h>
+#include <kivm/oop/instanceKlass.h>
+#include <kivm/oop/instanceOop.h>
+#include <kivm/oop/primitiveOop.h>
+#include "classFileBuilder.h"
+
+using namespace kivm;
+
+struct FieldDecl {
+    const char *name;
+    const char *descriptor;
+    int access;
+    // 'I' or 'J' for a ConstantValue attribute
+    char constantType;
+    long long constant;
+};
+
+// class Object { int i0; ... int i9; }
+static const std::vector<FieldDecl> OBJECT_FIELDS = {
+    {"i0", "I", 0, 0, 0}, {"i1", "I", 0, 0, 0}, {"i2", "I", 0, 0, 0},
+    {"i3", "I", 0, 0, 0}, {"i4", "I", 0, 0, 0}, {"i5", "I", 0, 0, 0},
+    {"i6", "I", 0, 0, 0}, {"i7", "I", 0, 0, 0}, {"i8", "I", 0, 0, 0},
+    {"i9", "I", 0, 0, 0},
+};
+
+// class Mixed extends Object, fields in declaration order
+static const std::vector<FieldDecl> MIXED_FIELDS = {
+    {"b", "B", 0, 0, 0}, {"l", "J", 0, 0, 0}, {"o", "Ljava/lang/Object;", 0, 0, 0},
+    {"s", "S", 0, 0, 0}, {"d", "D", 0, 0, 0}, {"c", "C", 0, 0, 0},
+    {"f", "F", 0, 0, 0}, {"z", "Z", 0, 0, 0},
+    {"COUNTER", "J", ACC_STATIC, 0, 0},
+    {"MASK", "B", ACC_STATIC | ACC_FINAL, 'I', -3},
+    {"SEED", "J", ACC_STATIC | ACC_FINAL, 'J', 0x123456789LL},
+    {"CACHE", "Ljava/lang/Object;", ACC_STATIC, 0, 0},
+    {"SIZE", "I", ACC_STATIC | ACC_FINAL, 'I', 42},
+};
+
+static std::vector<u1> makeClassFile(const char *name, const char *super,
+                                     const std::vector<FieldDecl> &fields) {
+    ClassFileBuilder builder(name, super);
+    int constantValue = builder.utf8("ConstantValue");
+    for (const auto &field : fields) {
+        int access = field.access != 0 ? field.access : ACC_PUBLIC;
+        int nameIndex = builder.utf8(field.name);
+        int descriptor = builder.utf8(field.descriptor);
+        if (field.constantType == 0) {
+            builder.addField(access, nameIndex, descriptor);
+            continue;
+        }
+
+        std::vector<u1> value;
+        put2(value, field.constantType == 'J'
+                    ? builder.longConstant(field.constant)
+                    : builder.integer((int) field.constant));
+        builder.addField(access, nameIndex, descriptor,
+                         {ClassFileBuilder::attribute(constantValue, value)});
+    }
+    return builder.build();
+}
+
+static void writeClassFiles() {
+    std::string root = makeClassPath("field-layout");
+    writeClassFile(root, "java/lang/Object",
+                   makeClassFile("java/lang/Object", nullptr, OBJECT_FIELDS));
+    writeClassFile(root, "Mixed",
+                   makeClassFile("Mixed", "java/lang/Object", MIXED_FIELDS));
+}
+
+static int offsetOf(InstanceKlass *klass, const String &className,
+                    const String &name, const String &descriptor) {
+    FieldID *id = klass->getInstanceFieldInfo(className, name, descriptor);
+    assert(id != nullptr);
+    return id->_offset;
+}
+
+int main() {
+    writeClassFiles();
+    Heap *heap = Heap::get();
+
+    auto *object = (InstanceKlass *) BootstrapClassLoader::get()->loadClass(L"java/lang/Object");
+    auto *mixed = (InstanceKlass *) BootstrapClassLoader::get()->loadClass(L"Mixed");
+    assert(object != nullptr && mixed != nullptr);
+
+    // ten ints packed after the header, in one allocation
+    assert(object->getInstanceSize() == sizeof(instanceOopDesc) + 10 * sizeof(jint));
+    assert(object->getInstanceSize() == 56);
+    assert(object->getReferenceFieldOffsets().empty());
+    size_t used = heap->getUsed();
+    instanceOop plain = object->newInstance();
+    assert(heap->getUsed() - used == sizeof(HeapBlock) + 56);
+
+    // superclass fields keep their offsets
+    for (const auto &field : OBJECT_FIELDS) {
+        String name = strings::fromStdString(field.name);
+        int offset = offsetOf(object, L"java/lang/Object", name, L"I");
+        assert(offset >= (int) sizeof(instanceOopDesc) && offset % sizeof(jint) == 0);
+        assert(offsetOf(mixed, L"java/lang/Object", name, L"I") == offset);
+    }
+
+    // larger fields first, references ahead of primitives of the same size
+    assert(offsetOf(mixed, L"Mixed", L"o", L"Ljava/lang/Object;") == 56);
+    assert(offsetOf(mixed, L"Mixed", L"l", L"J") == 64);
+    assert(offsetOf(mixed, L"Mixed", L"d", L"D") == 72);
+    assert(offsetOf(mixed, L"Mixed", L"f", L"F") == 80);
+    assert(offsetOf(mixed, L"Mixed", L"s", L"S") == 84);
+    assert(offsetOf(mixed, L"Mixed", L"c", L"C") == 86);
+    assert(offsetOf(mixed, L"Mixed", L"b", L"B") == 88);
+    assert(offsetOf(mixed, L"Mixed", L"z", L"Z") == 89);
+    assert(mixed->getInstanceSize() == 90);
+    assert(mixed->getReferenceFieldOffsets().size() == 1);
+    assert(mixed->getReferenceFieldOffsets()[0] == 56);
+
+    // fields start zeroed, primitive values are stored unboxed
+    instanceOop instance = mixed->newInstance();
+    assert(instance->getFieldAt<jlong>(64) == 0);
+    assert(instance->getFieldAt<oop>(56) == nullptr);
+    instance->setFieldAt<jbyte>(88, -2);
+    instance->setFieldAt<jlong>(64, 0x123456789LL);
+    instance->setFieldAt<jint>(offsetOf(mixed, L"java/lang/Object", L"i9", L"I"), 9);
+    assert(instance->getFieldAt<jbyte>(88) == -2);
+    assert(instance->getFieldAt<jboolean>(89) == 0);
+    assert(instance->getFieldAt<jlong>(64) == 0x123456789LL);
+
+    // the boxed accessors convert at the boundary
+    oop boxed = nullptr;
+    assert(instance->getFieldValue(L"Mixed", L"b", L"B", &boxed));
+    assert(((intOop) boxed)->getValue() == -2);
+    assert(instance->getFieldValue(L"java/lang/Object", L"i9", L"I", &boxed));
+    assert(((intOop) boxed)->getValue() == 9);
+    instance->setFieldValue(L"Mixed", L"d", L"D", new doubleOopDesc(2.5));
+    assert(instance->getFieldAt<jdouble>(72) == 2.5);
+
+    // reference fields are visited by the collector
+    instance->setFieldValue(L"Mixed", L"o", L"Ljava/lang/Object;", plain);
+    plain = nullptr;
+    heap->collect();
+    auto referent = (instanceOop) instance->getFieldAt<oop>(56);
+    assert(referent != nullptr);
+    assert(referent->getClass() == object);
+    assert(instance->getFieldAt<jlong>(64) == 0x123456789LL);
+
+    // static fields are packed into an unboxed block, constants applied
+    int counter = mixed->getStaticFieldOffset(L"Mixed", L"COUNTER", L"J");
+    int mask = mixed->getStaticFieldOffset(L"Mixed", L"MASK", L"B");
+    int seed = mixed->getStaticFieldOffset(L"Mixed", L"SEED", L"J");
+    int cache = mixed->getStaticFieldOffset(L"Mixed", L"CACHE", L"Ljava/lang/Object;");
+    int size = mixed->getStaticFieldOffset(L"Mixed", L"SIZE", L"I");
+    assert(cache == 0);
+    assert(counter == 8 && seed == 16);
+    assert(size == 24 && mask == 28);
+    assert(mixed->getStaticFieldAt<jlong>(counter) == 0);
+    assert(mixed->getStaticFieldAt<jbyte>(mask) == -3);
+    assert(mixed->getStaticFieldAt<jlong>(seed) == 0x123456789LL);
+    assert(mixed->getStaticFieldAt<jint>(size) == 42);
+
+    for (int i = 0; i < 1000; ++i) {
+        mixed->setStaticFieldAt<jlong>(counter, mixed->getStaticFieldAt<jlong>(counter) + 1);
+    }
+    assert(mixed->getStaticFieldAt<jlong>(counter) == 1000);
+    assert(mixed->getStaticFieldValue(L"Mixed", L"COUNTER", L"J", &boxed));
+    assert(((longOop) boxed)->getValue() == 1000);
+    assert(mixed->getStaticFieldValue(L"Mixed", L"MASK", L"B", &boxed));
+    assert(((intOop) boxed)->getValue() == -3);
+
+    // static references are roots
+    mixed->setStaticFieldValue(L"Mixed", L"CACHE", L"Ljava/lang/Object;", object->newInstance());
+    heap->collect();
+    auto cached = (instanceOop) mixed->getStaticFieldAt<oop>(cache);
+    assert(heap->contains(cached));
+    assert(cached->getClass() == object);
+    return 0;
+}
@@ -0,0 +1,129 @@
+//
+// Created by kiva on 2018/4/25.
+//
+
+#include <cassert>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <kivm/classLoader.h>
+#include <kivm/field.h>
+#include <kivm/oop/instanceKlass.h>
+#include <kivm/oop/instanceOop.h>
+#include <kivm/runtime/fieldProfile.h>
+#include <kivm/runtime/runtimeConfig.h>
+#include "classFileBuilder.h"
+
+using namespace kivm;
+
+static const int FIELDS = 16;
+
+// field index and how often it is accessed, hottest first
+static const int HOT[][2] = {
+    {15, 1000}, {12, 500}, {9, 200}, {3, 100}, {7, 50}, {1, 10}, {14, 5},
+};
+
+// the header line holds this many longs, the coldest hot field misses it
+static const int HOT_IN_LINE = 6;
+
+// class <name> extends <super> { long f0; ... }
+static std::vector<u1> makeClassFile(const char *name, const char *super, int fields) {
+    ClassFileBuilder builder(name, super);
+    int descriptor = builder.utf8("J");
+    for (int i = 0; i < fields; ++i) {
+        builder.addField(ACC_PUBLIC, builder.utf8("f" + std::to_string(i)), descriptor);
+    }
+    return builder.build();
+}
+
+static std::string writeClassFiles() {
+    std::string root = makeClassPath("field-profile");
+    writeClassFile(root, "java/lang/Object", makeClassFile("java/lang/Object", nullptr, 0));
+    writeClassFile(root, "Wide", makeClassFile("Wide", "java/lang/Object", FIELDS));
+    return root;
+}
+
+static FieldID *fieldOf(InstanceKlass *klass, int index) {
+    FieldID *id = klass->getInstanceFieldInfo(L"Wide", L"f" + std::to_wstring(index), L"J");
+    assert(id != nullptr);
+    return id;
+}
+
+/**
+ * The profiling run: default layout, count accesses, save at exit.
+ */
+static void recordProfile(const std::string &path) {
+    RuntimeConfig::get().fieldProfileOutput = path;
+    assert(FieldProfile::get()->isRecording());
+    assert(!FieldProfile::get()->hasProfile());
+
+    auto *wide = (InstanceKlass *) BootstrapClassLoader::get()->loadClass(L"Wide");
+    assert(wide != nullptr);
+    for (int i = 0; i < FIELDS; ++i) {
+        assert(fieldOf(wide, i)->_offset == (int) (sizeof(instanceOopDesc) + i * sizeof(jlong)));
+    }
+
+    // what GETFIELD/PUTFIELD do on every execution
+    for (const auto &hot : HOT) {
+        Field *field = fieldOf(wide, hot[0])->_field;
+        for (int i = 0; i < hot[1]; ++i) {
+            field->countAccess();
+        }
+    }
+    assert(FieldProfile::get()->save(path));
+}
+
+int main() {
+    std::string root = writeClassFiles();
+    std::string path = root + "/fields.profile";
+
+    pid_t child = fork();
+    assert(child >= 0);
+    if (child == 0) {
+        recordProfile(path);
+        _exit(0);
+    }
+    int status = 0;
+    assert(waitpid(child, &status, 0) == child);
+    assert(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+
+    // hottest first, one field per line
+    std::ifstream in(path);
+    std::string line;
+    assert(std::getline(in, line));
+    assert(line == "1000 Wide f15 J");
+
+    // the next run lays hot fields out in the header's cache line
+    RuntimeConfig::get().fieldProfileInput = path;
+    assert(FieldProfile::get()->hasProfile());
+    assert(!FieldProfile::get()->isRecording());
+    auto *wide = (InstanceKlass *) BootstrapClassLoader::get()->loadClass(L"Wide");
+    assert(wide != nullptr);
+    assert(wide->getInstanceSize() == sizeof(instanceOopDesc) + FIELDS * sizeof(jlong));
+
+    int lineEnd = FieldProfile::CACHE_LINE_SIZE;
+    for (int i = 0; i < HOT_IN_LINE; ++i) {
+        int offset = fieldOf(wide, HOT[i][0])->_offset;
+        assert(offset >= (int) sizeof(instanceOopDesc) && offset < lineEnd);
+    }
+    assert(fieldOf(wide, HOT[HOT_IN_LINE][0])->_offset >= lineEnd);
+
+    // every field still has its own slot
+    std::vector<bool> used(FIELDS, false);
+    for (int i = 0; i < FIELDS; ++i) {
+        int slot = (fieldOf(wide, i)->_offset - (int) sizeof(instanceOopDesc)) / (int) sizeof(jlong);
+        assert(!used[slot]);
+        used[slot] = true;
+    }
+
+    // and the fields work wherever they landed
+    instanceOop object = wide->newInstance();
+    object->setFieldAt<jlong>(fieldOf(wide, 15)->_offset, 15);
+    object->setFieldAt<jlong>(fieldOf(wide, 0)->_offset, -1);
+    assert(object->getFieldAt<jlong>(fieldOf(wide, 15)->_offset) == 15);
+    assert(object->getFieldAt<jlong>(fieldOf(wide, 0)->_offset) == -1);
+    return 0;
+}
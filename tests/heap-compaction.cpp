@@ -0,0 +1,113 @@
+//
+// Created by kiva on 2018/4/20.
+//
+
+#include <cassert>
+#include <cstdint>
+#include <vector>
+#include <kivm/memory/heap.h>
+#include <kivm/runtime/runtimeConfig.h>
+#include <shared/memory.h>
+#include <kivm/oop/arrayKlass.h>
+#include <kivm/oop/arrayOop.h>
+#include <kivm/oop/primitiveOop.h>
+
+using namespace kivm;
+
+static const int N_ARRAYS = 64;
+static const int N_ELEMENTS = 4;
+static const int N_GARBAGE = 16;
+static const int N_FULL_HEAP_ARRAYS = 100000;
+
+static size_t occupiedBytes(Heap *heap) {
+    size_t occupied = 0;
+    heap->getOldSpace()->iterateBlocks([&](HeapBlock *block) {
+        if (!block->isFiller()) {
+            occupied += block->getSize();
+        }
+    });
+    return occupied;
+}
+
+int main() {
+    assert(RuntimeConfig::get().parseOption("-Xmx32m"));
+    auto *intArrayKlass = new TypeArrayKlass(nullptr, nullptr, 1, ValueType::INT);
+    auto *intArray2Klass = new TypeArrayKlass(nullptr, intArrayKlass);
+    Heap *heap = Heap::get();
+
+    // Live arrays interleaved with garbage.
+    typeArrayOop outer = intArray2Klass->newInstance(N_ARRAYS);
+    std::vector<uintptr_t> addresses;
+    for (int i = 0; i < N_ARRAYS; ++i) {
+        for (int j = 0; j < N_GARBAGE; ++j) {
+            new intOopDesc(-1);
+        }
+
+        typeArrayOop inner = intArrayKlass->newInstance(N_ELEMENTS);
+        for (int j = 0; j < N_ELEMENTS; ++j) {
+            inner->setValueAt<jint>(j, i * N_ELEMENTS + j);
+        }
+        outer->setElementAt(i, inner);
+        addresses.push_back((uintptr_t) inner);
+    }
+
+    size_t usedBefore = heap->getUsed();
+    assert(occupiedBytes(heap) == usedBefore);
+    uintptr_t outerAddress = (uintptr_t) outer;
+    heap->collect();
+
+    // Stale words on native stack may pin a few dead objects
+    // and leave holes, but most of the garbage must be gone.
+    assert(heap->getCollections() == 1);
+    assert(heap->getUsed() <= usedBefore);
+    assert(occupiedBytes(heap) < usedBefore / 2);
+
+    // outer is referenced from native stack, so it is pinned.
+    assert((uintptr_t) outer == outerAddress);
+
+    int moved = 0;
+    for (int i = 0; i < N_ARRAYS; ++i) {
+        auto inner = (typeArrayOop) outer->getElementAt(i);
+        assert(heap->contains(inner));
+        assert(inner->getLength() == N_ELEMENTS);
+        for (int j = 0; j < N_ELEMENTS; ++j) {
+            assert(inner->getValueAt<jint>(j) == i * N_ELEMENTS + j);
+        }
+        if ((uintptr_t) inner != addresses[i]) {
+            ++moved;
+        }
+    }
+    assert(moved > 0);
+
+    // The heap is still usable after compaction.
+    typeArrayOop fresh = intArrayKlass->newInstance(N_ELEMENTS);
+    assert(heap->contains(fresh));
+    assert(fresh->getValueAt<jint>(0) == 0);
+
+    // Far more garbage than the heap holds, with no poll to collect it:
+    // a full heap is collected by the failing allocation itself.
+    int collections = heap->getCollections();
+    for (int i = 0; i < N_FULL_HEAP_ARRAYS; ++i) {
+        intArrayKlass->newInstance(1000);
+    }
+    assert(heap->getCollections() > collections + 1);
+    assert(heap->getUsed() < heap->getReservedSize());
+
+    // A free range too large for one block header takes several fillers.
+    // Only the pages holding their headers are committed.
+    size_t pageSize = memory::getPageSize();
+    size_t rangeSize = (size_t) HeapBlock::SIZE_LIMIT + pageSize;
+    auto *range = (char *) memory::reserve(rangeSize);
+    assert(range != nullptr);
+    char *secondPage = range + memory::alignDown((size_t) HeapBlock::SIZE_LIMIT - HEAP_WORD_SIZE, pageSize);
+    assert(memory::commit(range, pageSize));
+    assert(memory::commit(secondPage, range + rangeSize - secondPage));
+    HeapBlock::fill(range, rangeSize);
+    auto *first = (HeapBlock *) range;
+    assert(first->isFiller() && first->getSize() == HeapBlock::SIZE_LIMIT - HEAP_WORD_SIZE);
+    HeapBlock *second = first->next();
+    assert(second->isFiller() && second->getSize() == pageSize + HEAP_WORD_SIZE);
+    assert((char *) second->next() == range + rangeSize);
+    memory::release(range, rangeSize);
+    return 0;
+}
@@ -0,0 +1,84 @@
+//
+// Created by kiva on 2018/4/25.
+//
+
+#include <cassert>
+#include <cstdint>
+#include <vector>
+#include <sys/mman.h>
+#include <kivm/memory/heap.h>
+#include <kivm/oop/arrayKlass.h>
+#include <kivm/oop/arrayOop.h>
+#include <kivm/runtime/runtimeConfig.h>
+#include <shared/memory.h>
+
+using namespace kivm;
+
+static const size_t MB = 1024 * 1024;
+
+// below the large-object threshold
+static const int ARRAY_SIZE = (int) MB / 2;
+
+static bool isResident(void *address, size_t size) {
+    size_t pageSize = memory::getPageSize();
+    std::vector<unsigned char> pages(size / pageSize);
+    if (mincore(address, size, pages.data()) != 0) {
+        return false;
+    }
+    for (unsigned char page : pages) {
+        if ((page & 1) == 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+int main() {
+    assert(RuntimeConfig::parseSize("100") == 100);
+    assert(RuntimeConfig::parseSize("64k") == 64 * 1024);
+    assert(RuntimeConfig::parseSize("512m") == 512 * MB);
+    assert(RuntimeConfig::parseSize("2G") == 2048 * MB);
+    assert(RuntimeConfig::parseSize("") == 0);
+    assert(RuntimeConfig::parseSize("m") == 0);
+    assert(RuntimeConfig::parseSize("12x") == 0);
+
+    RuntimeConfig &config = RuntimeConfig::get();
+    assert(config.parseOption("-Xmx64m"));
+    assert(config.parseOption("-Xms4m"));
+    assert(config.parseOption("-XX:+AlwaysPreTouch"));
+    assert(config.parseOption("-XX:+UseTransparentHugePages"));
+    assert(!config.parseOption("-Xmxlots"));
+    assert(!config.parseOption("-XX:+NoSuchFlag"));
+    assert(!config.parseOption("-verbose"));
+    assert(config.maxHeapSize == 64 * MB && config.initialHeapSize == 4 * MB);
+    assert(config.alwaysPreTouch);
+
+    // one range for the whole heap, aligned for huge pages, committed in part
+    Heap *heap = Heap::get();
+    MarkCompactSpace *space = heap->getOldSpace();
+    assert(heap->getReservedSize() == 64 * MB);
+    assert(space->getReservedSize() <= 64 * MB);
+    assert((uintptr_t) space->getBottom() % (2 * MB) == 0);
+    assert(space->getCommittedSize() >= 4 * MB);
+    assert(space->getCommittedSize() < 64 * MB);
+
+    // the initial heap was touched at startup
+    assert(isResident(space->getBottom(), 4 * MB));
+
+    // commit follows allocation, new memory reads zero
+    auto *byteArrayKlass = new TypeArrayKlass(nullptr, nullptr, 1, ValueType::BYTE);
+    std::vector<typeArrayOop> arrays;
+    for (int i = 0; i < 48; ++i) {
+        typeArrayOop array = byteArrayKlass->newInstance(ARRAY_SIZE);
+        assert(array->getValueAt<jbyte>(0) == 0);
+        assert(array->getValueAt<jbyte>(ARRAY_SIZE - 1) == 0);
+        array->setValueAt<jbyte>(ARRAY_SIZE - 1, (jbyte) i);
+        arrays.push_back(array);
+    }
+    assert(space->getCommittedSize() >= heap->getUsed());
+    assert(space->getCommittedSize() <= space->getReservedSize());
+    for (int i = 0; i < 48; ++i) {
+        assert(arrays[i]->getValueAt<jbyte>(ARRAY_SIZE - 1) == i);
+    }
+    return 0;
+}
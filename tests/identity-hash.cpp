@@ -0,0 +1,98 @@
+//
+// Created by kiva on 2018/4/24.
+//
+
+#include <cassert>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+#include <kivm/memory/heap.h>
+#include <kivm/oop/arrayKlass.h>
+#include <kivm/oop/arrayOop.h>
+#include <kivm/oop/primitiveOop.h>
+
+using namespace kivm;
+
+extern "C" jint Java_java_lang_Object_hashCode(jobject thisObj);
+
+extern "C" jint Java_java_lang_System_identityHashCode(jobject obj);
+
+static const int N_OBJECTS = 1000;
+static const int N_THREADS = 4;
+
+int main() {
+    auto *intArrayKlass = new TypeArrayKlass(nullptr, nullptr, 1, ValueType::INT);
+    auto *intArray2Klass = new TypeArrayKlass(nullptr, intArrayKlass);
+    Heap *heap = Heap::get();
+
+    // generated lazily, then stable
+    intOop object = new intOopDesc(1);
+    markOop mark = object->getMarkOop();
+    u4 hash = mark->getIdentityHash();
+    assert(hash != 0 && hash <= 0x7fffffff);
+    assert(mark->getIdentityHash() == hash);
+    assert(Java_java_lang_Object_hashCode((jobject) object) == (jint) hash);
+    assert(Java_java_lang_System_identityHashCode((jobject) object) == (jint) hash);
+    assert(Java_java_lang_System_identityHashCode(nullptr) == 0);
+
+    // locking keeps the hash and hashing does not inflate
+    intOop locked = new intOopDesc(2);
+    locked->getMarkOop()->monitorEnter();
+    u4 lockedHash = locked->getMarkOop()->getIdentityHash();
+    assert(locked->getMarkOop()->getLockState() == markOopDesc::THIN_LOCKED);
+    locked->getMarkOop()->wait(1);
+    assert(locked->getMarkOop()->isInflated());
+    assert(locked->getMarkOop()->getIdentityHash() == lockedHash);
+    locked->getMarkOop()->monitorExit();
+    assert(locked->getMarkOop()->getIdentityHash() == lockedHash);
+    assert(locked->getMarkOop()->getOopType() == oopType::PRIMITIVE_OOP);
+
+    // hashes are spread out
+    std::unordered_set<u4> hashes;
+    for (int i = 0; i < N_OBJECTS; ++i) {
+        hashes.insert((new intOopDesc(i))->getMarkOop()->getIdentityHash());
+    }
+    assert(hashes.size() > N_OBJECTS * 99 / 100);
+
+    // racing threads agree on one hash
+    intOop shared = new intOopDesc(3);
+    std::vector<u4> seen(N_THREADS);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < N_THREADS; ++i) {
+        threads.emplace_back([&seen, shared, i]() {
+            seen[i] = shared->getMarkOop()->getIdentityHash();
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    for (u4 value : seen) {
+        assert(value == seen[0]);
+    }
+
+    // the hash moves with the object
+    typeArrayOop holder = intArray2Klass->newInstance(N_OBJECTS);
+    std::vector<u4> expected;
+    for (int i = 0; i < N_OBJECTS; ++i) {
+        new intOopDesc(-1);
+        typeArrayOop element = intArrayKlass->newInstance(1);
+        expected.push_back(element->getMarkOop()->getIdentityHash());
+        holder->setElementAt(i, element);
+    }
+    std::vector<uintptr_t> addresses;
+    for (int i = 0; i < N_OBJECTS; ++i) {
+        addresses.push_back((uintptr_t) holder->getElementAt(i));
+    }
+    heap->collect();
+    int moved = 0;
+    for (int i = 0; i < N_OBJECTS; ++i) {
+        oop element = holder->getElementAt(i);
+        assert(element->getMarkOop()->getIdentityHash() == expected[i]);
+        if ((uintptr_t) element != addresses[i]) {
+            ++moved;
+        }
+    }
+    assert(moved > 0);
+    assert(mark->getIdentityHash() == hash);
+    return 0;
+}
@@ -0,0 +1,188 @@
+//
+// Created by kiva on 2018/4/25.
+//
+
+#include <cassert>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <zlib.h>
+#include <kivm/classLoader.h>
+#include <kivm/classfile/classPath.h>
+#include <kivm/classfile/zipArchive.h>
+#include <kivm/oop/instanceKlass.h>
+#include <kivm/oop/instanceOop.h>
+#include "classFileBuilder.h"
+
+using namespace kivm;
+
+static const int N_FILLERS = 2000;
+
+// class <name> extends <super> { long f0; ... }
+static std::vector<u1> makeClassFile(const std::string &name, const char *super, int fields) {
+    ClassFileBuilder builder(name, super);
+    int descriptor = builder.utf8("J");
+    for (int i = 0; i < fields; ++i) {
+        builder.addField(ACC_PUBLIC, builder.utf8("f" + std::to_string(i)), descriptor);
+    }
+    return builder.build();
+}
+
+static void putLE2(std::vector<u1> &out, int value) {
+    out.push_back((u1) value);
+    out.push_back((u1) (value >> 8));
+}
+
+static void putLE4(std::vector<u1> &out, u4 value) {
+    putLE2(out, (int) (value & 0xffff));
+    putLE2(out, (int) (value >> 16));
+}
+
+static std::vector<u1> deflateRaw(const std::vector<u1> &input) {
+    z_stream stream{};
+    assert(deflateInit2(&stream, Z_BEST_COMPRESSION, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) == Z_OK);
+    std::vector<u1> output(deflateBound(&stream, (uLong) input.size()));
+    stream.next_in = (Bytef *) input.data();
+    stream.avail_in = (uInt) input.size();
+    stream.next_out = output.data();
+    stream.avail_out = (uInt) output.size();
+    assert(deflate(&stream, Z_FINISH) == Z_STREAM_END);
+    output.resize(stream.total_out);
+    deflateEnd(&stream);
+    return output;
+}
+
+/**
+ * A ZIP archive written the way jar tools do,
+ * with an extra field in local headers which the central directory does not have.
+ */
+class ZipWriter {
+private:
+    std::vector<u1> _out;
+    std::vector<u1> _directory;
+    int _count = 0;
+
+public:
+    void add(const std::string &name, const std::vector<u1> &content, bool deflated) {
+        std::vector<u1> data = deflated ? deflateRaw(content) : content;
+        u4 crc = (u4) crc32(0, content.data(), (uInt) content.size());
+        u4 offset = (u4) _out.size();
+
+        putLE4(_out, 0x04034b50);
+        putLE2(_out, 20);
+        putLE2(_out, 0);
+        putLE2(_out, deflated ? 8 : 0);
+        putLE4(_out, 0);
+        putLE4(_out, crc);
+        putLE4(_out, (u4) data.size());
+        putLE4(_out, (u4) content.size());
+        putLE2(_out, (int) name.size());
+        putLE2(_out, 4);
+        _out.insert(_out.end(), name.begin(), name.end());
+        putLE4(_out, 0xcafe0000);
+        _out.insert(_out.end(), data.begin(), data.end());
+
+        putLE4(_directory, 0x02014b50);
+        putLE2(_directory, 20);
+        putLE2(_directory, 20);
+        putLE2(_directory, 0);
+        putLE2(_directory, deflated ? 8 : 0);
+        putLE4(_directory, 0);
+        putLE4(_directory, crc);
+        putLE4(_directory, (u4) data.size());
+        putLE4(_directory, (u4) content.size());
+        putLE2(_directory, (int) name.size());
+        putLE2(_directory, 0);
+        putLE2(_directory, 0);
+        putLE2(_directory, 0);
+        putLE2(_directory, 0);
+        putLE4(_directory, 0);
+        putLE4(_directory, offset);
+        _directory.insert(_directory.end(), name.begin(), name.end());
+        ++_count;
+    }
+
+    void write(const std::string &path) {
+        u4 directoryOffset = (u4) _out.size();
+        _out.insert(_out.end(), _directory.begin(), _directory.end());
+        putLE4(_out, 0x06054b50);
+        putLE2(_out, 0);
+        putLE2(_out, 0);
+        putLE2(_out, _count);
+        putLE2(_out, _count);
+        putLE4(_out, (u4) _directory.size());
+        putLE4(_out, directoryOffset);
+        std::string comment = "archive comment";
+        putLE2(_out, (int) comment.size());
+        _out.insert(_out.end(), comment.begin(), comment.end());
+
+        writeFile(path, _out);
+    }
+};
+
+static int fieldsOf(const String &className) {
+    auto *klass = (InstanceKlass *) BootstrapClassLoader::get()->loadClass(className);
+    assert(klass != nullptr);
+    return (klass->getInstanceSize() - (int) sizeof(instanceOopDesc)) / (int) sizeof(jlong);
+}
+
+int main() {
+    std::string root = makeTemporaryDirectory("jar-classpath");
+    std::string classes = root + "/classes";
+    std::string jar = root + "/rt.jar";
+    assert(system(("mkdir -p " + classes).c_str()) == 0);
+
+    // loose classes come first and shadow the archive
+    writeFile(classes + "/Loose.class", makeClassFile("Loose", "java/lang/Object", 1));
+    writeFile(classes + "/Shadowed.class", makeClassFile("Shadowed", "java/lang/Object", 2));
+
+    std::vector<u1> stored = makeClassFile("Stored", "java/lang/Object", 3);
+    std::vector<u1> deflated = makeClassFile("Deflated", "java/lang/Object", 40);
+    ZipWriter zip;
+    zip.add("META-INF/MANIFEST.MF", {'M', 'a', 'n', 'i', 'f', 'e', 's', 't'}, false);
+    zip.add("java/lang/Object.class", makeClassFile("java/lang/Object", nullptr, 0), true);
+    zip.add("Stored.class", stored, false);
+    zip.add("Deflated.class", deflated, true);
+    zip.add("Shadowed.class", makeClassFile("Shadowed", "java/lang/Object", 5), true);
+    for (int i = 0; i < N_FILLERS; ++i) {
+        zip.add("filler/F" + std::to_string(i) + ".class", {0}, false);
+    }
+    zip.write(jar);
+
+    // the whole central directory is indexed when opened
+    ZipArchive *archive = ZipArchive::open(jar);
+    assert(archive != nullptr);
+    assert(archive->getEntryCount() == 5 + N_FILLERS);
+    assert(archive->contains("Stored.class"));
+    assert(archive->contains("filler/F1999.class"));
+    assert(!archive->contains("Missing.class"));
+    assert(!archive->contains("Stored"));
+
+    // stored entries are read in place, deflated ones inflated into a new buffer
+    size_t length = 0;
+    bool allocated = true;
+    u1 *bytes = archive->read("Stored.class", &length, &allocated);
+    assert(bytes != nullptr && !allocated);
+    assert(length == stored.size() && memcmp(bytes, stored.data(), length) == 0);
+    bytes = archive->read("Deflated.class", &length, &allocated);
+    assert(bytes != nullptr && allocated);
+    assert(length == deflated.size() && memcmp(bytes, deflated.data(), length) == 0);
+    delete[] bytes;
+    assert(archive->read("Missing.class", &length, &allocated) == nullptr);
+    delete archive;
+
+    // anything else is not an archive
+    assert(ZipArchive::open(classes + "/Loose.class") == nullptr);
+    assert(ZipArchive::open(root + "/missing.jar") == nullptr);
+
+    // missing entries are skipped
+    setenv("KLASSPATH", (classes + ":" + jar + ":" + root + "/missing.jar").c_str(), 1);
+    assert(ClassPath::get()->getEntryCount() == 2);
+    assert(fieldsOf(L"Loose") == 1);
+    assert(fieldsOf(L"Shadowed") == 2);
+    assert(fieldsOf(L"Stored") == 3);
+    assert(fieldsOf(L"Deflated") == 40);
+    assert(BootstrapClassLoader::get()->loadClass(L"Missing") == nullptr);
+    return 0;
+}
@@ -0,0 +1,106 @@
+//
+// Created by kiva on 2018/4/25.
+//
+
+#include <cassert>
+#include <cerrno>
+#include <cstdint>
+#include <vector>
+#include <sys/mman.h>
+#include <kivm/memory/heap.h>
+#include <kivm/oop/arrayKlass.h>
+#include <kivm/oop/arrayOop.h>
+#include <kivm/oop/primitiveOop.h>
+#include <kivm/runtime/runtimeConfig.h>
+#include <shared/memory.h>
+
+using namespace kivm;
+
+static const int N_BYTES = 4 * 1024 * 1024;
+static const int N_GARBAGE = 8;
+static const int N_BOXES = 1024;
+
+static bool isMapped(const void *address) {
+    unsigned char page = 0;
+    void *start = (void *) memory::alignDown((size_t) address, memory::getPageSize());
+    return mincore(start, memory::getPageSize(), &page) == 0 || errno != ENOMEM;
+}
+
+static KIVM_NOINLINE void allocateGarbage(TypeArrayKlass *klass, std::vector<uintptr_t> &addresses) {
+    for (int i = 0; i < N_GARBAGE; ++i) {
+        addresses.push_back((uintptr_t) klass->newInstance(N_BYTES));
+    }
+}
+
+int main() {
+    assert(RuntimeConfig::get().parseOption("-XX:LargeObjectThreshold=256k"));
+    auto *byteArrayKlass = new TypeArrayKlass(nullptr, nullptr, 1, ValueType::BYTE);
+    auto *intArrayKlass = new TypeArrayKlass(nullptr, nullptr, 1, ValueType::INT);
+    auto *intArray2Klass = new TypeArrayKlass(nullptr, intArrayKlass);
+    Heap *heap = Heap::get();
+    MarkCompactSpace *oldSpace = heap->getOldSpace();
+    LargeObjectSpace *largeObjects = heap->getLargeObjectSpace();
+
+    // small arrays stay in the old space
+    typeArrayOop small = byteArrayKlass->newInstance(1024);
+    assert(oldSpace->contains(small));
+    assert(largeObjects->getObjectCount() == 0);
+
+    // a big array gets a zero-filled mapping of its own
+    size_t oldUsed = oldSpace->getUsed();
+    typeArrayOop buffer = byteArrayKlass->newInstance(N_BYTES);
+    assert(!oldSpace->contains(buffer));
+    assert(heap->contains(buffer));
+    assert(heap->contains(buffer->getValues<jbyte>() + N_BYTES - 1));
+    assert(oldSpace->getUsed() == oldUsed);
+    assert(largeObjects->getObjectCount() == 1);
+    assert(largeObjects->getUsed() >= (size_t) N_BYTES);
+    assert(buffer->getValueAt<jbyte>(N_BYTES - 1) == 0);
+    buffer->setValueAt<jbyte>(N_BYTES - 1, 42);
+
+    // a big reference array, whose small referents move during compaction
+    typeArrayOop boxes = intArray2Klass->newInstance(128 * 1024);
+    std::vector<uintptr_t> boxAddresses;
+    assert(largeObjects->findBlock(boxes) != nullptr);
+    for (int i = 0; i < N_BOXES; ++i) {
+        for (int j = 0; j < 4; ++j) {
+            new intOopDesc(-1);
+        }
+        typeArrayOop box = intArrayKlass->newInstance(1);
+        box->setValueAt<jint>(0, i);
+        boxes->setElementAt(i, box);
+        boxAddresses.push_back((uintptr_t) box);
+    }
+
+    std::vector<uintptr_t> garbage;
+    allocateGarbage(byteArrayKlass, garbage);
+    assert(largeObjects->getObjectCount() == 2 + N_GARBAGE);
+    heap->collect();
+
+    // live large objects stay where they are
+    assert(largeObjects->findBlock(buffer) != nullptr);
+    assert(buffer->getValueAt<jbyte>(N_BYTES - 1) == 42);
+    assert(largeObjects->findBlock(boxes) != nullptr);
+    int moved = 0;
+    for (int i = 0; i < N_BOXES; ++i) {
+        auto box = (typeArrayOop) boxes->getElementAt(i);
+        assert(oldSpace->contains(box));
+        assert(box->getValueAt<jint>(0) == i);
+        if ((uintptr_t) box != boxAddresses[i]) {
+            ++moved;
+        }
+    }
+    assert(moved > 0);
+
+    // dead ones are unmapped, stale words on the stack may keep a few
+    int released = 0;
+    for (uintptr_t address : garbage) {
+        if (largeObjects->findBlock((void *) address) == nullptr) {
+            assert(!isMapped((void *) address));
+            ++released;
+        }
+    }
+    assert(released >= N_GARBAGE / 2);
+    assert(largeObjects->getObjectCount() == 2 + (size_t) (N_GARBAGE - released));
+    return 0;
+}
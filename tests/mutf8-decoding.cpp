@@ -0,0 +1,280 @@
+//
+// Created by kiva on 2018/4/25.
+//
+
+#include <cassert>
+#include <chrono>
+#include <codecvt>
+#include <cstdio>
+#include <cstdlib>
+#include <locale>
+#include <string>
+#include <vector>
+#include <kivm/classfile/classFileParser.h>
+#include <kivm/classfile/zipArchive.h>
+
+using namespace kivm;
+
+static const int N_ROUNDS = 20;
+
+static u4 nextRandom() {
+    static u4 seed = 20180425;
+    seed = seed * 1103515245 + 12345;
+    return seed >> 8;
+}
+
+/**
+ * What {@code strings::fromBytes} used to do, one character at a time.
+ */
+static String referenceFromBytes(const u1 *bytes, size_t length) {
+    std::vector<u2> buffer;
+    for (size_t pos = 0; pos < length;) {
+        if ((bytes[pos] & 0x80) == 0) {
+            buffer.push_back(bytes[pos]);
+            pos += 1;
+        } else if ((bytes[pos] & 0xE0) == 0xC0) {
+            buffer.push_back((u2) (((bytes[pos] & 0x1f) << 6) + (bytes[pos + 1] & 0x3f)));
+            pos += 2;
+        } else {
+            assert((bytes[pos] & 0xF0) == 0xE0);
+            buffer.push_back((u2) (((bytes[pos] & 0xf) << 12) + ((bytes[pos + 1] & 0x3f) << 6)
+                                   + (bytes[pos + 2] & 0x3f)));
+            pos += 3;
+        }
+    }
+    return String(buffer.begin(), buffer.end());
+}
+
+static void putModified(std::string &out, u4 c) {
+    if (c != 0 && c < 0x80) {
+        out += (char) c;
+    } else if (c < 0x800) {
+        out += (char) (0xc0 | (c >> 6));
+        out += (char) (0x80 | (c & 0x3f));
+    } else {
+        out += (char) (0xe0 | (c >> 12));
+        out += (char) (0x80 | ((c >> 6) & 0x3f));
+        out += (char) (0x80 | (c & 0x3f));
+    }
+}
+
+/**
+ * Random modified UTF-8 of up to {@code maxLength} characters,
+ * ASCII mostly, with runs long enough for the vector paths.
+ */
+static std::string randomModifiedUtf8(int maxLength) {
+    std::string out;
+    int length = (int) (nextRandom() % (maxLength + 1));
+    for (int i = 0; i < length; ++i) {
+        switch (nextRandom() % 16) {
+            case 0:
+                putModified(out, 0x80 + nextRandom() % 0x780);
+                break;
+            case 1:
+                putModified(out, 0x800 + nextRandom() % 0xd000);
+                break;
+            case 2: {
+                u4 c = nextRandom() % 0x100000;
+                putModified(out, 0xd800 | (c >> 10));
+                putModified(out, 0xdc00 | (c & 0x3ff));
+                break;
+            }
+            case 3:
+                putModified(out, 0);
+                break;
+            default:
+                putModified(out, 0x20 + nextRandom() % 0x5f);
+                break;
+        }
+    }
+    return out;
+}
+
+/**
+ * Constants shaped like those of the class library:
+ * class names, descriptors, member names and a few string literals.
+ */
+static std::vector<std::string> makeCorpus() {
+    static const char *PACKAGES[] = {"java/lang/", "java/util/", "java/util/concurrent/",
+                                     "java/io/", "sun/nio/cs/", "javax/swing/plaf/basic/"};
+    static const char *WORDS[] = {"Object", "String", "Hash", "Map", "Concurrent", "Abstract",
+                                  "List", "Node", "Tree", "Bin", "Reader", "Buffered", "Input",
+                                  "Stream", "Char", "Set", "Entry", "Factory", "UI", "Border"};
+    static const char *LITERALS[] = {"Code", "LineNumberTable", "<init>", "()V", "I", "this",
+                                     "caf\xc3\xa9", "\xe4\xb8\xad\xe6\x96\x87", "a\xc0\x80z"};
+
+    auto word = []() {
+        return std::string(WORDS[nextRandom() % (sizeof(WORDS) / sizeof(WORDS[0]))]);
+    };
+    auto className = [&]() {
+        std::string name = PACKAGES[nextRandom() % (sizeof(PACKAGES) / sizeof(PACKAGES[0]))];
+        for (u4 i = 1 + nextRandom() % 3; i > 0; --i) {
+            name += word();
+        }
+        if (nextRandom() % 4 == 0) {
+            name += "$" + word();
+        }
+        return name;
+    };
+
+    std::vector<std::string> corpus;
+    for (int i = 0; i < 20000; ++i) {
+        switch (nextRandom() % 5) {
+            case 0:
+                corpus.push_back(className());
+                break;
+            case 1: {
+                std::string descriptor = "(";
+                for (u4 n = nextRandom() % 4; n > 0; --n) {
+                    descriptor += nextRandom() % 2 ? "I" : "L" + className() + ";";
+                }
+                corpus.push_back(descriptor + ")L" + className() + ";");
+                break;
+            }
+            case 2: {
+                std::string name = word();
+                name[0] = (char) (name[0] - 'A' + 'a');
+                corpus.push_back(name + word());
+                break;
+            }
+            default:
+                corpus.push_back(LITERALS[nextRandom() % (sizeof(LITERALS) / sizeof(LITERALS[0]))]);
+                break;
+        }
+    }
+    return corpus;
+}
+
+static void deleteContent(u1 *content, size_t) {
+    delete[] content;
+}
+
+/**
+ * Every UTF-8 constant of every class in a jar.
+ */
+static std::vector<std::string> readCorpus(const char *jar) {
+    std::vector<std::string> corpus;
+    ZipArchive *archive = ZipArchive::open(jar);
+    assert(archive != nullptr);
+    archive->iterateEntries([&](const char *name, size_t length) {
+        std::string entry(name, length);
+        if (entry.size() < 6 || entry.compare(entry.size() - 6, 6, ".class") != 0) {
+            return;
+        }
+        size_t contentLength = 0;
+        bool allocated = false;
+        u1 *content = archive->read(entry, &contentLength, &allocated);
+        assert(content != nullptr);
+        ClassFileParser parser(entry.c_str(), content, contentLength,
+                               allocated ? deleteContent : nullptr);
+        ClassFile *classFile = parser.getParsedClassFile();
+        assert(classFile != nullptr);
+        for (int i = 1; i < classFile->constant_pool_count; ++i) {
+            cp_info *info = classFile->constant_pool[i];
+            if (info->tag == CONSTANT_Utf8) {
+                auto *utf8 = (CONSTANT_Utf8_info *) info;
+                corpus.emplace_back((const char *) utf8->bytes, utf8->length);
+            } else if (info->tag == CONSTANT_Long || info->tag == CONSTANT_Double) {
+                ++i;
+            }
+        }
+        ClassFileParser::dealloc(classFile);
+    });
+    delete archive;
+    return corpus;
+}
+
+/**
+ * @return nanoseconds to decode the whole corpus once
+ */
+template<typename Decode>
+static double measure(const std::vector<std::string> &corpus, Decode decode) {
+    size_t characters = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int round = 0; round < N_ROUNDS; ++round) {
+        for (const std::string &each : corpus) {
+            characters += decode((const u1 *) each.data(), each.size()).size();
+        }
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    assert(characters > 0);
+    return (double) std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count() / N_ROUNDS;
+}
+
+int main() {
+    std::wstring_convert<std::codecvt_utf8<wchar_t>> convert;
+
+    // decoding agrees with the one character at a time decoder
+    for (int i = 0; i < 20000; ++i) {
+        std::string bytes = randomModifiedUtf8(i % 10 == 0 ? 300 : 40);
+        const auto *data = (const u1 *) bytes.data();
+        String decoded = strings::fromBytes(data, bytes.size());
+        assert(decoded == referenceFromBytes(data, bytes.size()));
+    }
+    assert(strings::fromBytes(nullptr, 0).empty());
+
+    // standard UTF-8 converts like std::wstring_convert does
+    for (int i = 0; i < 20000; ++i) {
+        String string;
+        int length = (int) (nextRandom() % (i % 10 == 0 ? 300 : 40));
+        for (int j = 0; j < length; ++j) {
+            u4 c = nextRandom() % 8 != 0 ? 0x20 + nextRandom() % 0x5f : 1 + nextRandom() % 0xd7ff;
+            string += (wchar_t) c;
+        }
+        std::string bytes = strings::toStdString(string);
+        assert(bytes == convert.to_bytes(string));
+        assert(strings::fromStdString(bytes) == string);
+    }
+    if (sizeof(wchar_t) == 4) {
+        String outside(1, (wchar_t) 0x1f600);
+        assert(strings::toStdString(outside) == "\xf0\x9f\x98\x80");
+        assert(strings::fromStdString("\xf0\x9f\x98\x80") == outside);
+    }
+    // surrogates from class files are paired up again
+    String surrogates = strings::fromBytes((const u1 *) "\xed\xa0\xbd\xed\xb8\x80", 6);
+    assert(surrogates.size() == 2);
+    assert(strings::toStdString(surrogates) == "\xf0\x9f\x98\x80");
+
+    // every UTF-8 constant of a class library if there is one, a look-alike otherwise
+    const char *jar = getenv("KIVM_BENCH_JAR");
+    std::vector<std::string> corpus = jar != nullptr ? readCorpus(jar) : makeCorpus();
+    size_t bytes = 0;
+    for (const std::string &each : corpus) {
+        bytes += each.size();
+    }
+
+    double before = measure(corpus, referenceFromBytes);
+    double after = measure(corpus, strings::fromBytes);
+    printf("%zd UTF-8 constants, %zd bytes from %s: %.1f us before, %.1f us after (%.1fx)\n",
+           corpus.size(), bytes, jar != nullptr ? jar : "a synthetic corpus",
+           before / 1e3, after / 1e3, before / after);
+
+    std::vector<String> strings;
+    for (const std::string &each : corpus) {
+        strings.push_back(strings::fromBytes((const u1 *) each.data(), each.size()));
+    }
+    size_t converted = 0;
+    size_t narrowed = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int round = 0; round < N_ROUNDS; ++round) {
+        for (const String &each : strings) {
+            converted += convert.to_bytes(each).size();
+        }
+    }
+    auto middle = std::chrono::steady_clock::now();
+    for (int round = 0; round < N_ROUNDS; ++round) {
+        for (const String &each : strings) {
+            narrowed += strings::toStdString(each).size();
+        }
+    }
+    auto end = std::chrono::steady_clock::now();
+    // surrogate pairs take four bytes rather than six
+    assert(narrowed <= converted);
+
+    using std::chrono::duration_cast;
+    using std::chrono::nanoseconds;
+    printf("toStdString: %.1f us with std::wstring_convert, %.1f us now\n",
+           (double) duration_cast<nanoseconds>(middle - start).count() / 1e3 / N_ROUNDS,
+           (double) duration_cast<nanoseconds>(end - middle).count() / 1e3 / N_ROUNDS);
+    return 0;
+}
@@ -0,0 +1,77 @@
+//
+// Created by kiva on 2018/4/24.
+//
+
+#include <cassert>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <kivm/classLoader.h>
+#include <kivm/memory/heap.h>
+#include <kivm/oop/instanceKlass.h>
+#include <kivm/oop/instanceOop.h>
+#include "classFileBuilder.h"
+
+using namespace kivm;
+
+static const int SMALL_FIELDS = 2;
+static const int LARGE_FIELDS = 64;
+
+// class <name> extends <super> { long f0; ... }
+static std::vector<u1> makeClassFile(const char *name, const char *super, int fields) {
+    ClassFileBuilder builder(name, super);
+    int descriptor = builder.utf8("J");
+    for (int i = 0; i < fields; ++i) {
+        builder.addField(ACC_PUBLIC, builder.utf8("f" + std::to_string(i)), descriptor);
+    }
+    return builder.build();
+}
+
+static void writeClassFiles() {
+    std::string root = makeClassPath("new-instance");
+    writeClassFile(root, "java/lang/Object", makeClassFile("java/lang/Object", nullptr, 0));
+    writeClassFile(root, "Small", makeClassFile("Small", "java/lang/Object", SMALL_FIELDS));
+    writeClassFile(root, "Large", makeClassFile("Large", "java/lang/Object", LARGE_FIELDS));
+}
+
+/**
+ * Allocate {@code n} instances, dirtying every field of each one.
+ * @return nanoseconds per instance
+ */
+static KIVM_NOINLINE double allocate(InstanceKlass *klass, int fields, int n) {
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < n; ++i) {
+        instanceOop object = klass->newInstance();
+        for (int j = 0; j < fields; ++j) {
+            int offset = (int) sizeof(instanceOopDesc) + j * (int) sizeof(jlong);
+            assert(object->getFieldAt<jlong>(offset) == 0);
+            object->setFieldAt<jlong>(offset, -1);
+        }
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    return (double) std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count() / n;
+}
+
+int main() {
+    writeClassFiles();
+    auto *small = (InstanceKlass *) BootstrapClassLoader::get()->loadClass(L"Small");
+    auto *large = (InstanceKlass *) BootstrapClassLoader::get()->loadClass(L"Large");
+    assert(small != nullptr && large != nullptr);
+    assert(small->getInstanceSize() == sizeof(instanceOopDesc) + SMALL_FIELDS * sizeof(jlong));
+    assert(large->getInstanceSize() == sizeof(instanceOopDesc) + LARGE_FIELDS * sizeof(jlong));
+
+    // Memory given back by the collector is reused without clearing,
+    // so every round checks that new objects still start zeroed.
+    Heap *heap = Heap::get();
+    for (int round = 0; round < 3; ++round) {
+        double smallCost = allocate(small, SMALL_FIELDS, 100000);
+        double largeCost = allocate(large, LARGE_FIELDS, 10000);
+        printf("NEW %d bytes: %.1f ns, NEW %d bytes: %.1f ns\n",
+               small->getInstanceSize(), smallCost,
+               large->getInstanceSize(), largeCost);
+        heap->collect();
+    }
+    assert(heap->getCollections() == 3);
+    return 0;
+}
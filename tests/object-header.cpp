@@ -0,0 +1,55 @@
+//
+// Created by kiva on 2018/4/23.
+//
+
+#include <cassert>
+#include <kivm/memory/heap.h>
+#include <kivm/oop/primitiveOop.h>
+#include <kivm/runtime/monitorTable.h>
+
+using namespace kivm;
+
+static KIVM_NOINLINE void lockGarbage() {
+    for (int i = 0; i < 8; ++i) {
+        intOop garbage = new intOopDesc(i);
+        garbage->getMarkOop()->monitorEnter();
+        garbage->getMarkOop()->wait(1);
+        garbage->getMarkOop()->monitorExit();
+    }
+}
+
+int main() {
+    // mark word and klass pointer only
+    static_assert(sizeof(oopDesc) == sizeof(u8) + sizeof(Klass *), "oop header is not compact");
+    assert(sizeof(intOopDesc) <= sizeof(oopDesc) + sizeof(u8));
+
+    intOop object = new intOopDesc(42);
+    markOop mark = object->getMarkOop();
+    assert(mark->getOopType() == oopType::PRIMITIVE_OOP);
+    assert(mark->getLockState() == markOopDesc::UNLOCKED);
+    assert(mark->getAge() == 0);
+
+    mark->setAge(markOopDesc::MAX_AGE);
+    assert(mark->getAge() == markOopDesc::MAX_AGE);
+    assert(mark->getOopType() == oopType::PRIMITIVE_OOP);
+
+    // waiting inflates the monitor
+    MonitorTable *table = MonitorTable::get();
+    u4 inUse = table->getInUseCount();
+    mark->monitorEnter();
+    mark->wait(1);
+    mark->monitorExit();
+    assert(mark->isInflated());
+    assert(mark->getMonitorIndex() != 0);
+    assert(mark->getOopType() == oopType::PRIMITIVE_OOP);
+    assert(mark->getAge() == markOopDesc::MAX_AGE);
+    assert(table->getInUseCount() == inUse + 1);
+
+    // monitors of dead objects go back to the table
+    lockGarbage();
+    assert(table->getInUseCount() > inUse + 1);
+    Heap::get()->collect();
+    assert(table->getInUseCount() < inUse + 1 + 8);
+    assert(object->getValue() == 42);
+    return 0;
+}
@@ -0,0 +1,174 @@
+//
+// Created by kiva on 2018/4/25.
+//
+
+#include <algorithm>
+#include <cassert>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <kivm/classLoader.h>
+#include <kivm/method.h>
+#include <kivm/oop/instanceKlass.h>
+#include <kivm/bytecode/oopMap.h>
+#include <kivm/bytecode/oopMapStore.h>
+#include <shared/files.h>
+#include "classFileBuilder.h"
+
+using namespace kivm;
+
+static const char *DESCRIPTOR = "(ILjava/lang/Object;)Ljava/lang/Object;";
+
+// the method of tests/oop-map.cpp
+static const std::vector<u1> CODE = {
+    0x2b,               // 0: aload_1
+    0x4d,               // 1: astore_2
+    0x1a,               // 2: iload_0
+    0x3e,               // 3: istore_3
+    0x1d,               // 4: iload_3
+    0x2c,               // 5: aload_2
+    0xb8, 0x00, 0x00,   // 6: invokestatic m
+    0x57,               // 9: pop
+    0x84, 0x03, 0xff,   // 10: iinc 3, -1
+    0x1d,               // 13: iload_3
+    0x9a, 0xff, 0xf6,   // 14: ifne 4
+    0x2c,               // 17: aload_2
+    0xb0,               // 18: areturn
+};
+
+// class <name> extends <super> { static Object m(int, Object) }
+static std::vector<u1> makeClassFile(const std::string &name, const char *super) {
+    ClassFileBuilder builder(name, super);
+    int methodName = builder.utf8("m");
+    int descriptor = builder.utf8(DESCRIPTOR);
+    int self = builder.methodref(builder.getThisClass(), builder.nameAndType(methodName, descriptor));
+    std::vector<u1> code = CODE;
+    code[7] = (u1) (self >> 8);
+    code[8] = (u1) self;
+
+    // append_frame at pc 4 with locals <name>, int
+    std::vector<u1> frames;
+    put2(frames, 1);
+    frames.push_back(253);
+    put2(frames, 4);
+    frames.push_back(ITEM_Object);
+    put2(frames, builder.getThisClass());
+    frames.push_back(ITEM_Integer);
+    auto stackMapTable = ClassFileBuilder::attribute(builder.utf8("StackMapTable"), frames);
+
+    builder.addMethod(ACC_PUBLIC | ACC_STATIC, methodName, descriptor,
+                      {builder.code(2, 4, code, {stackMapTable})});
+    return builder.build();
+}
+
+static std::vector<std::string> listCache(const std::string &directory) {
+    std::vector<files::DirectoryEntry> entries;
+    assert(files::listDirectory(directory, &entries));
+    std::vector<std::string> names;
+    for (const auto &entry : entries) {
+        names.push_back(entry.name);
+    }
+    return names;
+}
+
+static void assertSameMaps(const MethodOopMaps *expected, const MethodOopMaps *actual) {
+    assert(expected->isPrecise() == actual->isPrecise());
+    for (u4 pc = 0; pc < CODE.size(); ++pc) {
+        const OopMap *lhs = expected->find(pc);
+        const OopMap *rhs = actual->find(pc);
+        assert((lhs == nullptr) == (rhs == nullptr));
+        if (lhs == nullptr) {
+            continue;
+        }
+        assert(lhs->getStartPc() == rhs->getStartPc());
+        assert(lhs->getStackDepth() == rhs->getStackDepth());
+        for (int i = 0; i < 4; ++i) {
+            assert(lhs->isLocalReference(i) == rhs->isLocalReference(i));
+        }
+        for (int i = 0; i < lhs->getStackDepth(); ++i) {
+            assert(lhs->isStackReference(i) == rhs->isStackReference(i));
+        }
+    }
+}
+
+int main() {
+    std::string root = makeClassPath("oop-map-cache");
+    writeClassFile(root, "java/lang/Object", makeClassFile("java/lang/Object", nullptr));
+    writeClassFile(root, "Copy", makeClassFile("Copy", "java/lang/Object"));
+
+    auto *klass = (InstanceKlass *) BootstrapClassLoader::get()->loadClass(L"java/lang/Object");
+    assert(klass != nullptr);
+    klass->linkAndInit();
+    Method *method = klass->getStaticMethod(L"m", strings::fromStdString(DESCRIPTOR));
+    assert(method != nullptr);
+
+    // the first run computes the maps and writes them, creating the directory
+    std::string cacheDirectory = root + "/cache";
+    OopMapStore firstStore(cacheDirectory);
+    OopMapCache firstRun(&firstStore);
+    const MethodOopMaps *computed = firstRun.prepare(method);
+    assert(computed->isPrecise());
+    assert(firstStore.getLoadCount() == 0 && firstStore.getStoreCount() == 1);
+    std::vector<std::string> names = listCache(cacheDirectory);
+    assert(names.size() == 1);
+
+    // a later run reads them instead
+    OopMapStore secondStore(cacheDirectory);
+    OopMapCache secondRun(&secondStore);
+    const MethodOopMaps *loaded = secondRun.prepare(method);
+    assert(secondStore.getLoadCount() == 1 && secondStore.getStoreCount() == 0);
+    assert(secondRun.prepare(method) == loaded);
+    assert(secondRun.lookup(method) == loaded);
+    assert(secondStore.getLoadCount() == 1);
+    assertSameMaps(computed, loaded);
+    assertSameMaps(OopMapCache().prepare(method), loaded);
+
+    // another analysis never reads them
+    OopMapStore otherVersion(cacheDirectory, MethodOopMaps::ANALYSIS_VERSION + 1);
+    OopMapCache otherVersionRun(&otherVersion);
+    assertSameMaps(computed, otherVersionRun.prepare(method));
+    assert(otherVersion.getLoadCount() == 0 && otherVersion.getStoreCount() == 1);
+    assert(listCache(cacheDirectory).size() == 2);
+
+    // neither does the same code in another class file
+    auto *copy = (InstanceKlass *) BootstrapClassLoader::get()->loadClass(L"Copy");
+    assert(copy != nullptr);
+    copy->linkAndInit();
+    Method *copied = copy->getStaticMethod(L"m", strings::fromStdString(DESCRIPTOR));
+    assert(copied != nullptr);
+    OopMapStore copyStore(cacheDirectory);
+    OopMapCache copyRun(&copyStore);
+    assertSameMaps(computed, copyRun.prepare(copied));
+    assert(copyStore.getLoadCount() == 0 && copyStore.getStoreCount() == 1);
+    assert(listCache(cacheDirectory).size() == 3);
+
+    // a damaged file is computed and written again
+    std::string path = cacheDirectory + "/" + names[0];
+    std::vector<u1> truncated(40, 0);
+    writeFile(path, truncated);
+    OopMapStore damagedStore(cacheDirectory);
+    OopMapCache damagedRun(&damagedStore);
+    assertSameMaps(computed, damagedRun.prepare(method));
+    assert(damagedStore.getRejectCount() == 1);
+    assert(damagedStore.getLoadCount() == 0 && damagedStore.getStoreCount() == 1);
+
+    OopMapStore repairedStore(cacheDirectory);
+    OopMapCache repairedRun(&repairedStore);
+    assertSameMaps(computed, repairedRun.prepare(method));
+    assert(repairedStore.getLoadCount() == 1 && repairedStore.getRejectCount() == 0);
+    assert(listCache(cacheDirectory).size() == 3);
+
+    // so is one claiming more maps than it holds, the count at byte 40 of the header
+    std::ifstream in(path, std::ios::binary);
+    std::vector<u1> header(48);
+    in.read((char *) header.data(), header.size());
+    assert(in.gcount() == (std::streamsize) header.size());
+    in.close();
+    std::fill(header.begin() + 40, header.begin() + 44, 0xff);
+    writeFile(path, header);
+    OopMapStore oversizedStore(cacheDirectory);
+    OopMapCache oversizedRun(&oversizedStore);
+    assertSameMaps(computed, oversizedRun.prepare(method));
+    assert(oversizedStore.getRejectCount() == 1 && oversizedStore.getStoreCount() == 1);
+    return 0;
+}
@@ -0,0 +1,248 @@
+//
+// Created by kiva on 2018/4/21.
+//
+
+#include <cassert>
+#include <string>
+#include <vector>
+#include <set>
+#include <kivm/classLoader.h>
+#include <kivm/method.h>
+#include <kivm/oop/instanceKlass.h>
+#include <kivm/bytecode/oopMap.h>
+#include <kivm/memory/heap.h>
+#include <kivm/memory/oopClosure.h>
+#include <kivm/runtime/thread.h>
+#include "classFileBuilder.h"
+
+using namespace kivm;
+
+static const char *DESCRIPTOR = "(ILjava/lang/Object;)Ljava/lang/Object;";
+
+/*
+ *  static Object m(int n, Object o) {
+ *      Object p = o;
+ *      int i = n;
+ *      do {
+ *          m(i, p);
+ *      } while (--i != 0);
+ *      return p;
+ *  }
+ */
+static const std::vector<u1> CODE = {
+    0x2b,               // 0: aload_1
+    0x4d,               // 1: astore_2
+    0x1a,               // 2: iload_0
+    0x3e,               // 3: istore_3
+    0x1d,               // 4: iload_3
+    0x2c,               // 5: aload_2
+    0xb8, 0x00, 0x07,   // 6: invokestatic #7
+    0x57,               // 9: pop
+    0x84, 0x03, 0xff,   // 10: iinc 3, -1
+    0x1d,               // 13: iload_3
+    0x9a, 0xff, 0xf6,   // 14: ifne 4
+    0x2c,               // 17: aload_2
+    0xb0,               // 18: areturn
+};
+
+static std::vector<u1> makeClassFile() {
+    ClassFileBuilder builder("java/lang/Object");
+    int name = builder.utf8("m");
+    int descriptor = builder.utf8(DESCRIPTOR);
+    builder.codeName();
+    int self = builder.methodref(builder.getThisClass(), builder.nameAndType(name, descriptor));
+    assert(self == 7);
+
+    // append_frame at pc 4 with locals Object, int
+    std::vector<u1> frames;
+    put2(frames, 1);
+    frames.push_back(253);
+    put2(frames, 4);
+    frames.push_back(ITEM_Object);
+    put2(frames, builder.getThisClass());
+    frames.push_back(ITEM_Integer);
+    auto stackMapTable = ClassFileBuilder::attribute(builder.utf8("StackMapTable"), frames);
+
+    builder.addMethod(ACC_PUBLIC | ACC_STATIC, name, descriptor,
+                      {builder.code(2, 4, CODE, {stackMapTable})});
+    return builder.build();
+}
+
+/*
+ *  class Chain {
+ *      static Object outer() {
+ *          Object a = new Chain();
+ *          int i = 7;
+ *          return middle(a);
+ *      }
+ *
+ *      static Object middle(Object p) {
+ *          Object q = new Chain();
+ *          collect();
+ *          return p;
+ *      }
+ *
+ *      static native void collect();
+ *  }
+ */
+static const std::vector<u1> OUTER_CODE = {
+    0xbb, 0x00, 0x02,   // 0: new #2
+    0x4b,               // 3: astore_0
+    0x10, 0x07,         // 4: bipush 7
+    0x3c,               // 6: istore_1
+    0x2a,               // 7: aload_0
+    0xb8, 0x00, 0x0d,   // 8: invokestatic #13
+    0x4d,               // 11: astore_2
+    0x2c,               // 12: aload_2
+    0xb0,               // 13: areturn
+};
+
+static const std::vector<u1> MIDDLE_CODE = {
+    0xbb, 0x00, 0x02,   // 0: new #2
+    0x4c,               // 3: astore_1
+    0xb8, 0x00, 0x0f,   // 4: invokestatic #15
+    0x2a,               // 7: aload_0
+    0xb0,               // 8: areturn
+};
+
+static std::vector<u1> makeChainClassFile() {
+    ClassFileBuilder builder("Chain", "java/lang/Object");
+    builder.codeName();
+    int outer = builder.utf8("outer");
+    int outerDescriptor = builder.utf8("()Ljava/lang/Object;");
+    int middle = builder.utf8("middle");
+    int middleDescriptor = builder.utf8("(Ljava/lang/Object;)Ljava/lang/Object;");
+    int collect = builder.utf8("collect");
+    int collectDescriptor = builder.utf8("()V");
+    int chain = builder.getThisClass();
+    assert(chain == 2);
+    assert(builder.methodref(chain, builder.nameAndType(middle, middleDescriptor)) == 13);
+    assert(builder.methodref(chain, builder.nameAndType(collect, collectDescriptor)) == 15);
+
+    builder.addMethod(ACC_STATIC, outer, outerDescriptor, {builder.code(1, 3, OUTER_CODE)});
+    builder.addMethod(ACC_STATIC, middle, middleDescriptor, {builder.code(1, 2, MIDDLE_CODE)});
+    builder.addMethod(ACC_STATIC | ACC_NATIVE, collect, collectDescriptor);
+    return builder.build();
+}
+
+static void writeClassFiles() {
+    std::string root = makeClassPath("oop-map");
+    writeClassFile(root, "java/lang/Object", makeClassFile());
+    writeClassFile(root, "Chain", makeChainClassFile());
+}
+
+class RecordingClosure : public RootClosure {
+public:
+    std::multiset<oop> references;
+    int conservativeRoots = 0;
+
+    void doOop(oop *p) override {
+        if (*p != nullptr) {
+            references.insert(*p);
+        }
+    }
+
+    void doConservativeRoot(void *) override {
+        ++conservativeRoots;
+    }
+};
+
+static RecordingClosure *rootsInCollect = nullptr;
+
+// Chain.collect(), called with outer() and middle() on the stack
+extern "C" void Java_Chain_collect() {
+    rootsInCollect = new RecordingClosure;
+    Thread::current()->iterateRoots(rootsInCollect);
+    Heap::get()->collect();
+}
+
+class ChainThread : public JavaThread {
+public:
+    oop result = nullptr;
+
+    explicit ChainThread(Method *outer)
+        : JavaThread(outer, {}) {
+    }
+
+    void join() {
+        _nativeThread->join();
+    }
+
+protected:
+    void start() override {
+        result = runMethod(_method, {});
+    }
+};
+
+int main() {
+    writeClassFiles();
+
+    auto *klass = (InstanceKlass *) BootstrapClassLoader::get()->loadClass(L"java/lang/Object");
+    assert(klass != nullptr);
+    klass->linkAndInit();
+
+    Method *method = klass->getStaticMethod(L"m", strings::fromStdString(DESCRIPTOR));
+    assert(method != nullptr);
+    assert(method->getStackMapTable() != nullptr);
+
+    // maps are only looked up once prepared
+    assert(OopMapCache::get()->lookup(method) == nullptr);
+    const MethodOopMaps *maps = OopMapCache::get()->prepare(method);
+    assert(maps->isPrecise());
+    assert(OopMapCache::get()->lookup(method) == maps);
+    assert(OopMapCache::get()->prepare(method) == maps);
+
+    // method entry: only arguments are live
+    const OopMap *entry = maps->find(0);
+    assert(entry != nullptr);
+    assert(entry->getStackDepth() == 0);
+    assert(!entry->isLocalReference(0));
+    assert(entry->isLocalReference(1));
+    assert(!entry->isLocalReference(2));
+    assert(!entry->isLocalReference(3));
+
+    // loop header is a backward branch target
+    const OopMap *loop = maps->find(4);
+    assert(loop != nullptr);
+    assert(loop->getStackDepth() == 0);
+    assert(!loop->isLocalReference(0));
+    assert(loop->isLocalReference(1));
+    assert(loop->isLocalReference(2));
+    assert(!loop->isLocalReference(3));
+
+    // callers are scanned with the return pc, the end of the invoke
+    const OopMap *call = maps->findEndingAt(9);
+    assert(call != nullptr);
+    assert(call == maps->find(6));
+    assert(call->getEndPc() == 9);
+    assert(call->getStackDepth() == 2);
+    assert(!call->isStackReference(0));
+    assert(call->isStackReference(1));
+    assert(call->isLocalReference(2));
+    assert(maps->findEndingAt(7) == nullptr);
+
+    // not a safepoint
+    assert(maps->find(1) == nullptr);
+    assert(maps->find(14) == nullptr);
+    assert(maps->findEndingAt(10) == nullptr);
+
+    // a collection from a callee scans the frames of its callers precisely
+    auto *chain = (InstanceKlass *) BootstrapClassLoader::get()->loadClass(L"Chain");
+    assert(chain != nullptr);
+    chain->linkAndInit();
+    Method *outer = chain->getStaticMethod(L"outer", L"()Ljava/lang/Object;");
+    assert(outer != nullptr);
+
+    ChainThread thread(outer);
+    thread.create(nullptr);
+    thread.join();
+
+    assert(rootsInCollect != nullptr);
+    assert(rootsInCollect->conservativeRoots == 0);
+    // a in outer(), p and q in middle(), but not i
+    assert(rootsInCollect->references.size() == 3);
+    std::set<oop> objects(rootsInCollect->references.begin(), rootsInCollect->references.end());
+    assert(objects.size() == 2);
+    assert(thread.result != nullptr && thread.result->getClass() == chain);
+    return 0;
+}
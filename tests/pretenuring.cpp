@@ -0,0 +1,141 @@
+//
+// Created by kiva on 2018/4/25.
+//
+
+#include <cassert>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <kivm/classLoader.h>
+#include <kivm/method.h>
+#include <kivm/memory/allocationSite.h>
+#include <kivm/memory/heap.h>
+#include <kivm/oop/arrayKlass.h>
+#include <kivm/oop/arrayOop.h>
+#include <kivm/oop/instanceKlass.h>
+#include <kivm/oop/instanceOop.h>
+#include <kivm/runtime/runtimeConfig.h>
+#include "classFileBuilder.h"
+
+using namespace kivm;
+
+static const int N_OBJECTS = 1000;
+
+// class <name> extends <super> { long value; static native void run(); }
+static std::vector<u1> makeClassFile(const char *name, const char *super, bool withMethod) {
+    ClassFileBuilder builder(name, super);
+    builder.addField(ACC_PUBLIC, "value", "J");
+    if (withMethod) {
+        builder.addMethod(ACC_PUBLIC | ACC_STATIC | ACC_NATIVE, "run", "()V");
+    }
+    return builder.build();
+}
+
+static std::string writeClassFiles() {
+    std::string root = makeClassPath("pretenuring");
+    writeClassFile(root, "java/lang/Object", makeClassFile("java/lang/Object", nullptr, false));
+    writeClassFile(root, "Box", makeClassFile("Box", "java/lang/Object", true));
+    return root;
+}
+
+/**
+ * Allocate {@code n} objects at {@code site}, keeping them in {@code holder} if given.
+ * Addresses go to the heap, so the stack scan does not pin the objects.
+ */
+static KIVM_NOINLINE void allocate(InstanceKlass *klass, AllocationSite *site, int n,
+                                   objectArrayOop holder, std::vector<uintptr_t> &addresses) {
+    for (int i = 0; i < n; ++i) {
+        instanceOop object = klass->newInstance(site);
+        object->setFieldAt<jlong>(sizeof(instanceOopDesc), i);
+        if (holder != nullptr) {
+            holder->setElementAt(i, object);
+        }
+        addresses.push_back((uintptr_t) object);
+    }
+}
+
+int main() {
+    assert(RuntimeConfig::get().parseOption("-XX:+PrintPretenuring"));
+    std::string root = writeClassFiles();
+    auto *box = (InstanceKlass *) BootstrapClassLoader::get()->loadClass(L"Box");
+    assert(box != nullptr);
+    Method *run = box->getThisClassMethod(L"run", L"()V");
+    assert(run != nullptr);
+
+    Heap *heap = Heap::get();
+    MarkCompactSpace *oldSpace = heap->getOldSpace();
+    MarkCompactSpace *tenuredSpace = heap->getTenuredSpace();
+    assert(tenuredSpace != nullptr);
+    assert(!oldSpace->contains(tenuredSpace->getBottom()));
+    assert(oldSpace->getReservedSize() + tenuredSpace->getReservedSize() == heap->getReservedSize());
+
+    // one site per instruction
+    AllocationSiteTable *table = AllocationSiteTable::get();
+    AllocationSite *longLived = table->lookup(run, 0);
+    AllocationSite *shortLived = table->lookup(run, 8);
+    assert(table->lookup(run, 0) == longLived);
+    assert(longLived->getId() != 0 && longLived->getId() != shortLived->getId());
+    assert(!longLived->isTenured() && !shortLived->isTenured());
+
+    // objects of one site are kept, objects of the other one dropped
+    auto *holderKlass = new ObjectArrayKlass(nullptr, nullptr, 1, box);
+    objectArrayOop kept = holderKlass->newInstance(N_OBJECTS);
+    std::vector<uintptr_t> addresses;
+    allocate(box, longLived, N_OBJECTS, kept, addresses);
+    allocate(box, shortLived, N_OBJECTS, nullptr, addresses);
+    for (uintptr_t address : addresses) {
+        assert(oldSpace->contains((void *) address));
+    }
+
+    heap->collect();
+    assert(longLived->getTotalAllocated() == N_OBJECTS);
+    assert(longLived->getTotalSurvived() == N_OBJECTS);
+    assert(shortLived->getTotalAllocated() == N_OBJECTS);
+    assert(shortLived->getTotalSurvived() < N_OBJECTS / 2);
+    assert(longLived->isTenured());
+    assert(!shortLived->isTenured());
+
+    // survivors count once, a second collection changes nothing
+    heap->collect();
+    assert(longLived->getTotalSurvived() == N_OBJECTS);
+
+    // the tenured site allocates out of the churn of the old space
+    objectArrayOop tenured = holderKlass->newInstance(N_OBJECTS);
+    addresses.clear();
+    allocate(box, longLived, N_OBJECTS, tenured, addresses);
+    for (uintptr_t address : addresses) {
+        assert(tenuredSpace->contains((void *) address));
+    }
+    std::vector<uintptr_t> garbage;
+    allocate(box, shortLived, N_OBJECTS, nullptr, garbage);
+    for (uintptr_t address : garbage) {
+        assert(oldSpace->contains((void *) address));
+    }
+
+    // nothing dies in front of tenured objects, so none of them moves
+    heap->collect();
+    for (int i = 0; i < N_OBJECTS; ++i) {
+        auto object = (instanceOop) tenured->getElementAt(i);
+        assert((uintptr_t) object == addresses[i]);
+        assert(object->getFieldAt<jlong>(sizeof(instanceOopDesc)) == i);
+        object = (instanceOop) kept->getElementAt(i);
+        assert(heap->contains(object));
+        assert(object->getFieldAt<jlong>(sizeof(instanceOopDesc)) == i);
+    }
+
+    // decisions are saved for the next run
+    std::string profile = root + "/pretenure.profile";
+    assert(table->save(profile));
+    std::ifstream in(profile);
+    std::string line;
+    assert(std::getline(in, line) && line == "Box run ()V 0");
+    assert(!std::getline(in, line));
+
+    std::ofstream(profile) << "Box run ()V 16\n";
+    assert(table->load(profile));
+    assert(table->lookup(run, 16)->isTenured());
+    assert(!table->lookup(run, 24)->isTenured());
+    assert(!table->load(root + "/missing.profile"));
+    return 0;
+}
@@ -0,0 +1,115 @@
+//
+// Created by kiva on 2018/4/22.
+//
+
+#include <cassert>
+#include <chrono>
+#include <kivm/runtime/safepoint.h>
+#include <kivm/runtime/runtimeConfig.h>
+
+using namespace kivm;
+
+class SpinningThread : public Thread {
+public:
+    std::atomic<long> iterations{0};
+    std::atomic<bool> stopped{false};
+
+    SpinningThread() : Thread(nullptr, {}) {
+    }
+
+    void join() {
+        _nativeThread->join();
+    }
+
+protected:
+    void start() override {
+        ThreadStateTransition inJava(this, ExecutionState::IN_JAVA);
+        while (!stopped) {
+            ++iterations;
+            Safepoint::poll(this);
+        }
+    }
+};
+
+// like the main thread, not counted as an app thread
+class UncountedThread : public SpinningThread {
+protected:
+    bool shouldRecordInThreadTable() override {
+        return false;
+    }
+};
+
+class NativeThread : public Thread {
+public:
+    std::atomic<bool> stopped{false};
+
+    NativeThread() : Thread(nullptr, {}) {
+    }
+
+    void join() {
+        _nativeThread->join();
+    }
+
+protected:
+    void start() override {
+        // never polls, but is stopped already
+        ThreadStateTransition inNative(this, ExecutionState::IN_NATIVE);
+        while (!stopped) {
+            std::this_thread::yield();
+        }
+    }
+};
+
+static void waitUntilRunning(SpinningThread &thread) {
+    long start = thread.iterations;
+    while (thread.iterations == start) {
+        std::this_thread::yield();
+    }
+}
+
+int main() {
+    SpinningThread spinning;
+    UncountedThread uncounted;
+    NativeThread native;
+    spinning.create(nullptr);
+    uncounted.create(nullptr);
+    native.create(nullptr);
+    waitUntilRunning(spinning);
+    waitUntilRunning(uncounted);
+    assert(Threads::getAppThreadCountLocked() == 2);
+    while (native.getExecutionState() != ExecutionState::IN_NATIVE) {
+        std::this_thread::yield();
+    }
+
+    Safepoint::begin();
+    assert(spinning.getExecutionState() == ExecutionState::BLOCKED);
+    assert(uncounted.getExecutionState() == ExecutionState::BLOCKED);
+    assert(native.getExecutionState() == ExecutionState::IN_NATIVE);
+    long iterations = spinning.iterations;
+    long uncountedIterations = uncounted.iterations;
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    assert(spinning.iterations == iterations);
+    assert(uncounted.iterations == uncountedIterations);
+    Safepoint::end();
+
+    waitUntilRunning(spinning);
+    assert(spinning.getExecutionState() == ExecutionState::IN_JAVA);
+
+    SafepointStatistics statistics = Safepoint::getStatistics();
+    assert(statistics.safepoints == 1);
+    assert(statistics.maxTimeToSafepoint <= statistics.totalTimeToSafepoint);
+    assert(statistics.maxPauseTime >= 20 * 1000 * 1000);
+    assert(statistics.totalPauseTime >= statistics.totalTimeToSafepoint);
+    assert(RuntimeConfig::get().parseOption("-XX:+PrintSafepointStatistics"));
+    assert(RuntimeConfig::get().printSafepointStatistics);
+    Safepoint::printStatistics();
+
+    spinning.stopped = true;
+    uncounted.stopped = true;
+    native.stopped = true;
+    spinning.join();
+    uncounted.join();
+    native.join();
+    assert(spinning.getExecutionState() == ExecutionState::TERMINATED);
+    return 0;
+}
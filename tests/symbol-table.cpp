@@ -0,0 +1,144 @@
+//
+// Created by kiva on 2018/4/25.
+//
+
+#include <cassert>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+#include <new>
+#include <kivm/classLoader.h>
+#include <kivm/field.h>
+#include <kivm/method.h>
+#include <kivm/symbol.h>
+#include <kivm/oop/instanceKlass.h>
+#include "classFileBuilder.h"
+
+using namespace kivm;
+
+static const int N_THREADS = 4;
+static const int N_NAMES = 20000;
+static const int N_LOOKUPS = 100000;
+
+static size_t allocations = 0;
+
+void *operator new(size_t size) {
+    ++allocations;
+    void *p = malloc(size);
+    if (p == nullptr) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void *p) noexcept {
+    free(p);
+}
+
+// class <name> extends <super> { int x; static native int getX(); }
+static std::vector<u1> makeClassFile(const char *name, const char *super, bool withMembers) {
+    ClassFileBuilder builder(name, super);
+    if (withMembers) {
+        builder.addField(ACC_PUBLIC, "x", "I");
+        builder.addMethod(ACC_PUBLIC | ACC_STATIC | ACC_NATIVE, "getX", "()I");
+    }
+    return builder.build();
+}
+
+static Symbol *intern(const char *bytes) {
+    return SymbolTable::get()->lookup((const u1 *) bytes, strlen(bytes));
+}
+
+static void internAll(int first, std::vector<Symbol *> *symbols) {
+    symbols->resize(N_NAMES);
+    for (int i = 0; i < N_NAMES; ++i) {
+        int n = (first + i) % N_NAMES;
+        std::string name = "name" + std::to_string(n);
+        (*symbols)[n] = SymbolTable::get()->lookup((const u1 *) name.data(), name.size());
+    }
+}
+
+int main() {
+    SymbolTable *symbolTable = SymbolTable::get();
+
+    // one symbol per string, however it is spelled
+    Symbol *object = intern("java/lang/Object");
+    assert(intern("java/lang/Object") == object);
+    assert(symbolTable->lookup(L"java/lang/Object") == object);
+    assert(symbolTable->probe(L"java/lang/Object") == object);
+    assert(object->toString() == L"java/lang/Object");
+    assert(intern("java/lang/Objec") != object);
+
+    // probing does not intern
+    size_t size = symbolTable->getSize();
+    assert(symbolTable->probe(L"never/Interned") == nullptr);
+    assert(symbolTable->getSize() == size);
+
+    // strings are encoded like class files encode them
+    const char modified[] = "a\xc0\x80" "b\xed\xa0\xbd\xed\xb8\x80";
+    Symbol *special = intern(modified);
+    String decoded = special->toString();
+    assert(decoded.size() == 5 && decoded[1] == 0 && decoded[3] == 0xd83d && decoded[4] == 0xde00);
+    assert(symbolTable->lookup(decoded) == special);
+    assert(symbolTable->lookup(String(L"a") + L'\0' + L"b" + (wchar_t) 0x1f600) == special);
+
+    // threads racing on the same names agree, across growth of the table
+    std::vector<Symbol *> symbols[N_THREADS];
+    std::vector<std::thread> threads;
+    for (int t = 0; t < N_THREADS; ++t) {
+        threads.emplace_back(internAll, t * N_NAMES / N_THREADS, &symbols[t]);
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    for (int i = 0; i < N_NAMES; ++i) {
+        for (int t = 1; t < N_THREADS; ++t) {
+            assert(symbols[t][i] == symbols[0][i]);
+        }
+        assert(symbols[0][i]->toString() == L"name" + std::to_wstring(i));
+    }
+    assert(symbolTable->getSize() >= size + N_NAMES);
+
+    // loaded members are keyed by symbols
+    std::string root = makeClassPath("symbol-table");
+    writeClassFile(root, "java/lang/Object", makeClassFile("java/lang/Object", nullptr, false));
+    writeClassFile(root, "geom/Point", makeClassFile("geom/Point", "java/lang/Object", true));
+
+    auto *point = (InstanceKlass *) BootstrapClassLoader::get()->loadClass(L"geom/Point");
+    assert(point != nullptr);
+    assert(point->getNameSymbol() == intern("geom/Point"));
+    Method *getX = point->getThisClassMethod(intern("getX"), intern("()I"));
+    assert(getX != nullptr && getX->getName() == L"getX");
+    assert(point->getThisClassMethod(L"getX", L"()I") == getX);
+    assert(point->getStaticMethod(L"getX", L"()I") == getX);
+    assert(point->getThisClassMethod(intern("getX"), intern("()J")) == nullptr);
+    assert(point->getThisClassMethod(L"getY", L"()I") == nullptr);
+    FieldID *x = point->getThisClassField(intern("x"), intern("I"));
+    assert(x != nullptr && x->_field->getNameSymbol() == intern("x"));
+    assert(point->getInstanceFieldInfo(L"geom/Point", L"x", L"I") == x);
+    assert(point->getInstanceFieldInfo(L"java/lang/Object", L"x", L"I") == nullptr);
+
+    // and resolving them allocates nothing
+    Symbol *name = intern("getX");
+    Symbol *descriptor = intern("()I");
+    Symbol *fieldName = intern("x");
+    Symbol *fieldDescriptor = intern("I");
+    size_t allocationsBefore = allocations;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < N_LOOKUPS; ++i) {
+        Method *method = point->getThisClassMethod(name, descriptor);
+        FieldID *field = point->getThisClassField(fieldName, fieldDescriptor);
+        assert(method == getX && field == x);
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    assert(allocations == allocationsBefore);
+
+    printf("%zd symbols in %zd bytes, method + field resolution: %.1f ns\n",
+           symbolTable->getSize(), symbolTable->getBytes(),
+           (double) std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count() / N_LOOKUPS);
+    return 0;
+}
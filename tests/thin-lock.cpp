@@ -0,0 +1,91 @@
+//
+// Created by kiva on 2018/4/23.
+//
+
+#include <atomic>
+#include <cassert>
+#include <thread>
+#include <kivm/oop/primitiveOop.h>
+#include <kivm/runtime/monitorTable.h>
+
+using namespace kivm;
+
+static const int N_THREADS = 4;
+static const int N_ITERATIONS = 20000;
+
+int main() {
+    intOop object = new intOopDesc(0);
+    markOop mark = object->getMarkOop();
+    u4 monitors = MonitorTable::get()->getInUseCount();
+
+    // uncontended and nested locking stays in the mark word
+    mark->monitorEnter();
+    assert(mark->getLockState() == markOopDesc::THIN_LOCKED);
+    assert(mark->isLockedByCurrentThread());
+    for (int i = 0; i < 300; ++i) {
+        mark->monitorEnter();
+    }
+    for (int i = 0; i < 300; ++i) {
+        mark->monitorExit();
+    }
+    assert(mark->isLockedByCurrentThread());
+    mark->notifyAll();
+    mark->monitorExit();
+    assert(!mark->isLockedByCurrentThread());
+    assert(mark->getOopType() == oopType::PRIMITIVE_OOP);
+
+    // 300 levels of nesting overflow the recursion count and inflate
+    assert(mark->isInflated());
+    assert(MonitorTable::get()->getInUseCount() == monitors + 1);
+
+    intOop flat = new intOopDesc(0);
+    flat->getMarkOop()->monitorEnter();
+    flat->getMarkOop()->monitorEnter();
+    flat->getMarkOop()->monitorExit();
+    flat->getMarkOop()->monitorExit();
+    assert(flat->getMarkOop()->getLockState() == markOopDesc::UNLOCKED);
+    assert(MonitorTable::get()->getInUseCount() == monitors + 1);
+
+    intOop other = new intOopDesc(0);
+    markOop otherMark = other->getMarkOop();
+    long counter = 0;
+    std::thread threads[N_THREADS];
+    for (auto &thread : threads) {
+        thread = std::thread([&] {
+            for (int i = 0; i < N_ITERATIONS; ++i) {
+                otherMark->monitorEnter();
+                otherMark->monitorEnter();
+                ++counter;
+                otherMark->monitorExit();
+                otherMark->monitorExit();
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    assert(counter == (long) N_THREADS * N_ITERATIONS);
+    assert(!otherMark->isLockedByCurrentThread());
+
+    // wait and notify, the waiter holds the lock until it waits
+    bool ready = false;
+    std::atomic<bool> waiting(false);
+    std::thread waiter([&] {
+        otherMark->monitorEnter();
+        waiting = true;
+        while (!ready) {
+            otherMark->wait();
+        }
+        otherMark->monitorExit();
+    });
+    while (!waiting) {
+        std::this_thread::yield();
+    }
+    otherMark->monitorEnter();
+    ready = true;
+    otherMark->notifyAll();
+    otherMark->monitorExit();
+    waiter.join();
+    assert(otherMark->isInflated());
+    return 0;
+}
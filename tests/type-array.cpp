@@ -0,0 +1,69 @@
+//
+// Created by kiva on 2018/4/24.
+//
+
+#include <cassert>
+#include <kivm/memory/heap.h>
+#include <kivm/oop/arrayKlass.h>
+#include <kivm/oop/arrayOop.h>
+#include <kivm/oop/primitiveOop.h>
+
+using namespace kivm;
+
+static const int N_BYTES = 1000000;
+
+int main() {
+    auto *byteArrayKlass = new TypeArrayKlass(nullptr, nullptr, 1, ValueType::BYTE);
+    auto *charArrayKlass = new TypeArrayKlass(nullptr, nullptr, 1, ValueType::CHAR);
+    auto *longArrayKlass = new TypeArrayKlass(nullptr, nullptr, 1, ValueType::LONG);
+    auto *longArray2Klass = new TypeArrayKlass(nullptr, longArrayKlass);
+    Heap *heap = Heap::get();
+
+    // elements take their real width
+    assert(byteArrayKlass->getElementSize() == 1);
+    assert(charArrayKlass->getElementSize() == 2);
+    assert(longArrayKlass->getElementSize() == 8);
+    assert(longArray2Klass->getElementSize() == sizeof(oop));
+
+    // a byte[1000000] costs about a megabyte, in one allocation
+    size_t used = heap->getUsed();
+    typeArrayOop bytes = byteArrayKlass->newInstance(N_BYTES);
+    size_t cost = heap->getUsed() - used;
+    assert(cost >= N_BYTES && cost < N_BYTES + 64);
+    assert(bytes->getLength() == N_BYTES);
+    assert(!bytes->hasReferenceElements());
+
+    // elements start zeroed and are stored in place
+    assert(bytes->getValueAt<jbyte>(N_BYTES - 1) == 0);
+    bytes->setValueAt<jbyte>(0, -1);
+    bytes->setValueAt<jbyte>(N_BYTES - 1, 127);
+    assert(bytes->getValues<jbyte>()[0] == -1);
+    assert(bytes->getValueAt<jbyte>(1) == 0);
+    assert(bytes->getValueAt<jbyte>(N_BYTES - 1) == 127);
+
+    // boxed accessors convert at the boundary
+    typeArrayOop chars = charArrayKlass->newInstance(2);
+    chars->setElementAt(1, new intOopDesc(0xffff));
+    assert(chars->getValueAt<jchar>(1) == 0xffff);
+    assert(((intOop) chars->getElementAt(1))->getValue() == 0xffff);
+    assert(chars->getValueAt<jchar>(0) == 0);
+
+    // sub-arrays are references and survive collection
+    typeArrayOop matrix = longArray2Klass->newInstance(4);
+    assert(matrix->hasReferenceElements());
+    for (int i = 0; i < matrix->getLength(); ++i) {
+        typeArrayOop row = longArrayKlass->newInstance(3);
+        row->setValueAt<jlong>(2, 0x100000000LL * i);
+        matrix->setElementAt(i, row);
+    }
+    heap->collect();
+    for (int i = 0; i < matrix->getLength(); ++i) {
+        auto row = (typeArrayOop) matrix->getElementAt(i);
+        assert(heap->contains(row));
+        assert(row->getLength() == 3);
+        assert(row->getValueAt<jlong>(0) == 0);
+        assert(row->getValueAt<jlong>(2) == 0x100000000LL * i);
+    }
+    assert(bytes->getValueAt<jbyte>(N_BYTES - 1) == 127);
+    return 0;
+}